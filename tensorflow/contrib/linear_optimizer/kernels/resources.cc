@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/contrib/linear_optimizer/kernels/resources.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -23,7 +25,9 @@ limitations under the License.
 namespace tensorflow {
 
 DataByExample::DataByExample(const string& container, const string& solver_uuid)
-    : container_(container), solver_uuid_(solver_uuid) {}
+    : container_(container), solver_uuid_(solver_uuid), num_entries_(0) {
+  static_assert(sizeof(Entry) == 28, "Entry should be packed");
+}
 
 DataByExample::~DataByExample() {}
 
@@ -45,48 +49,38 @@ DataByExample::Key DataByExample::MakeKey(const string& example_id) {
 }
 
 DataByExample::Data DataByExample::Get(const Key& key) {
-  mutex_lock l(mu_);
-  return data_by_key_[key];
+  Shard* const shard = ShardFor(key);
+  mutex_lock l(shard->mu);
+  return *FindOrInsertLocked(key, shard);
 }
 
 void DataByExample::Set(const Key& key, const Data& data) {
-  mutex_lock l(mu_);
-  data_by_key_[key] = data;
+  Shard* const shard = ShardFor(key);
+  mutex_lock l(shard->mu);
+  *FindOrInsertLocked(key, shard) = data;
 }
 
 Status DataByExample::Visit(
     std::function<void(const Data& data)> visitor) const {
-  struct State {
-    // Snapshoted size of data_by_key_.
-    size_t size;
-
-    // Number of elements visited so far.
-    size_t num_visited = 0;
-
-    // Current element.
-    DataByKey::const_iterator it;
-  };
-
-  auto state = [this] {
-    mutex_lock l(mu_);
-    State result;
-    result.size = data_by_key_.size();
-    result.it = data_by_key_.cbegin();
-    return result;
-  }();
-
-  while (state.num_visited < state.size) {
-    mutex_lock l(mu_);
-    // Since DataByExample is modify-or-append only, a visit will (continue to)
-    // be successful if and only if the size of the backing store hasn't
-    // changed (since the body of this while-loop is under lock).
-    if (data_by_key_.size() != state.size) {
-      return errors::Unavailable("The number of elements for ", solver_uuid_,
-                                 " has changed which nullifies a visit.");
-    }
-    for (size_t i = 0; i < kVisitChunkSize && state.num_visited < state.size;
-         ++i, ++state.num_visited, ++state.it) {
-      visitor(state.it->second);
+  // Snapshoted number of elements.
+  const size_t size = num_entries_.load(std::memory_order_acquire);
+
+  for (Shard& shard : shards_) {
+    for (size_t begin = 0;; begin += kVisitChunkSize) {
+      mutex_lock l(shard.mu);
+      // Since DataByExample is modify-or-append only, a visit will (continue
+      // to) be successful if and only if the number of elements hasn't
+      // changed (and entries are only added under the lock of their shard).
+      if (num_entries_.load(std::memory_order_acquire) != size) {
+        return errors::Unavailable("The number of elements for ", solver_uuid_,
+                                   " has changed which nullifies a visit.");
+      }
+      const size_t end =
+          std::min(shard.entries.size(), begin + kVisitChunkSize);
+      for (size_t i = begin; i < end; ++i) {
+        visitor(shard.entries[i].data);
+      }
+      if (end == shard.entries.size()) break;
     }
   }
   return Status::OK();
@@ -96,9 +90,56 @@ string DataByExample::DebugString() {
   return strings::StrCat("DataByExample(", container_, ", ", solver_uuid_, ")");
 }
 
-size_t DataByExample::KeyHash::operator()(const Key& key) const {
-  // Since key.first is already a Hash64 it suffices.
-  return key.first;
+bool DataByExample::Entry::Matches(const Key& key) const {
+  return key_first_lo == static_cast<uint32>(key.first) &&
+         key_first_hi == static_cast<uint32>(key.first >> 32) &&
+         key_second == key.second;
+}
+
+DataByExample::Shard* DataByExample::ShardFor(const Key& key) const {
+  return &shards_[key.first >> (64 - kNumShardsLog2)];
+}
+
+DataByExample::Data* DataByExample::FindOrInsertLocked(const Key& key,
+                                                       Shard* const shard) {
+  // Since key.first is already a Hash64 its low bits suffice to probe.
+  std::vector<uint32>& slots = shard->slots;
+  std::vector<Entry>& entries = shard->entries;
+  if (!slots.empty()) {
+    const size_t mask = slots.size() - 1;
+    for (size_t i = key.first & mask;; i = (i + 1) & mask) {
+      if (slots[i] == 0) break;
+      Entry& entry = entries[slots[i] - 1];
+      if (entry.Matches(key)) return &entry.data;
+    }
+  }
+
+  // Not found: keep the table at most 3/4 full, rehashing on growth.
+  if (4 * (entries.size() + 1) > 3 * slots.size()) {
+    std::vector<uint32> new_slots(std::max<size_t>(16, 2 * slots.size()), 0);
+    const size_t mask = new_slots.size() - 1;
+    for (size_t e = 0; e < entries.size(); ++e) {
+      const uint64 key_first =
+          (static_cast<uint64>(entries[e].key_first_hi) << 32) |
+          entries[e].key_first_lo;
+      size_t i = key_first & mask;
+      while (new_slots[i] != 0) i = (i + 1) & mask;
+      new_slots[i] = e + 1;
+    }
+    slots.swap(new_slots);
+  }
+  const size_t mask = slots.size() - 1;
+  size_t i = key.first & mask;
+  while (slots[i] != 0) i = (i + 1) & mask;
+
+  Entry entry;
+  entry.key_first_lo = static_cast<uint32>(key.first);
+  entry.key_first_hi = static_cast<uint32>(key.first >> 32);
+  entry.key_second = key.second;
+  entries.push_back(entry);
+  slots[i] = entries.size();
+  num_entries_.fetch_add(1, std::memory_order_release);
+  return &entries.back().data;
 }
 
 }  // namespace tensorflow
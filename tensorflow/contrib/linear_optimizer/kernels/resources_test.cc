@@ -19,7 +19,10 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
@@ -60,7 +63,9 @@ class DataByExampleTest : public ::testing::Test {
   // testing.
   static size_t VisitChunkSize() { return DataByExample::kVisitChunkSize; }
   void InsertReservedEntryUnlocked() NO_THREAD_SAFETY_ANALYSIS {
-    data_by_example_->data_by_key_[{0, 0}];
+    const DataByExample::Key key = {0, 0};
+    data_by_example_->FindOrInsertLocked(key,
+                                         data_by_example_->ShardFor(key));
   }
 
   const string container_ = "TheContainer";
@@ -168,4 +173,94 @@ TEST_F(DataByExampleTest, VisitUnavailable) {
   EXPECT_TRUE(errors::IsUnavailable(status));
 }
 
+TEST_F(DataByExampleTest, ConcurrentAccess) {
+  const int kNumThreads = 8;
+  const int kNumElementsPerThread = 1000;
+  {
+    thread::ThreadPool thread_pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      thread_pool.Schedule([this, t] {
+        for (int i = 0; i < kNumElementsPerThread; ++i) {
+          const DataByExample::Key key =
+              DataByExample::MakeKey(strings::StrCat(t, "_", i));
+          DataByExample::Data data = data_by_example_->Get(key);
+          data.dual += t * kNumElementsPerThread + i;
+          data_by_example_->Set(key, data);
+        }
+      });
+    }
+  }
+  for (int t = 0; t < kNumThreads; ++t) {
+    for (int i = 0; i < kNumElementsPerThread; ++i) {
+      EXPECT_EQ(t * kNumElementsPerThread + i,
+                data_by_example_
+                    ->Get(DataByExample::MakeKey(strings::StrCat(t, "_", i)))
+                    .dual);
+    }
+  }
+  size_t num_elements = 0;
+  ASSERT_TRUE(
+      data_by_example_
+          ->Visit([&](const DataByExample::Data& data) { ++num_elements; })
+          .ok());
+  EXPECT_EQ(kNumThreads * kNumElementsPerThread, num_elements);
+}
+
+// Updates the entries of 1M examples from "num_threads" threads at once, the
+// way the training loop of the SDCA solver does.
+static void BM_GetSet(int iters, int num_threads) {
+  testing::StopTiming();
+  const int kNumExamples = 1 << 20;
+  std::vector<DataByExample::Key> keys;
+  keys.reserve(kNumExamples);
+  for (int i = 0; i < kNumExamples; ++i) {
+    keys.push_back(DataByExample::MakeKey(strings::StrCat(i)));
+  }
+  DataByExample* const data_by_example =
+      new DataByExample("container", "solver");
+  thread::ThreadPool thread_pool(Env::Default(), "bench", num_threads);
+  const int64 per_thread = kNumExamples / num_threads;
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    BlockingCounter done(num_threads);
+    for (int t = 0; t < num_threads; ++t) {
+      thread_pool.Schedule([&, t] {
+        for (int64 k = t * per_thread; k < (t + 1) * per_thread; ++k) {
+          DataByExample::Data data = data_by_example->Get(keys[k]);
+          data.dual += 1;
+          data_by_example->Set(keys[k], data);
+        }
+        done.DecrementCount();
+      });
+    }
+    done.Wait();
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * per_thread *
+                          num_threads);
+  testing::StopTiming();
+  data_by_example->Unref();
+}
+BENCHMARK(BM_GetSet)->Arg(1)->Arg(4)->Arg(16);
+
+static void BM_Visit(int iters) {
+  testing::StopTiming();
+  const int kNumExamples = 1 << 20;
+  DataByExample* const data_by_example =
+      new DataByExample("container", "solver");
+  for (int i = 0; i < kNumExamples; ++i) {
+    data_by_example->Get(DataByExample::MakeKey(strings::StrCat(i)));
+  }
+  testing::StartTiming();
+  double total = 0;
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(data_by_example->Visit(
+        [&](const DataByExample::Data& data) { total += data.dual; }));
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * kNumExamples);
+  testing::StopTiming();
+  CHECK_EQ(0, total);
+  data_by_example->Unref();
+}
+BENCHMARK(BM_Visit);
+
 }  // namespace tensorflow
@@ -331,7 +331,7 @@ Status RunTrainStepsForMiniBatch(
     const DualLossUpdater& loss_updater,
     DeltaWeightsByGroup* const sparse_delta_weights_by_group,
     DeltaWeightsByGroup* const dense_delta_weights_by_group,
-    DataByExample* const data_by_example) {
+    DataByExample* const data_by_example, ShardCost* const train_step_cost) {
   // Process examples in parallel, in a partitioned fashion.
   mutex mu;
   Status train_step_status GUARDED_BY(mu);
@@ -386,12 +386,10 @@ Status RunTrainStepsForMiniBatch(
       data_by_example->Set(example_key, data);
     }
   };
-  // TODO(sibyl-Aix6ihai): Current multiplier 100000 works well empirically
-  // but perhaps we can tune it better.
-  const int64 kCostPerUnit = 100000 * (sparse_examples_by_group.size() +
-                                       dense_features_by_group.size());
-  Shard(worker_threads.num_threads, worker_threads.workers, num_examples,
-        kCostPerUnit, train_step);
+  // The cost of an example depends on its number of features, so it is
+  // measured rather than guessed.
+  AdaptiveShard(worker_threads.num_threads, worker_threads.workers,
+                num_examples, train_step_cost, train_step);
   return train_step_status;
 }
 
@@ -419,7 +417,8 @@ Status ValidateDenseWeights(const WeightsByGroup& weights_by_group) {
 
 class SdcaSolver : public OpKernel {
  public:
-  explicit SdcaSolver(OpKernelConstruction* context) : OpKernel(context) {
+  explicit SdcaSolver(OpKernelConstruction* context)
+      : OpKernel(context), train_step_cost_(kInitialTrainStepCost) {
     string loss_type;
     OP_REQUIRES_OK(context, context->GetAttr("loss_type", &loss_type));
     if (loss_type == "logistic_loss") {
@@ -555,7 +554,7 @@ class SdcaSolver : public OpKernel {
               sparse_examples_by_group, dense_weights_by_group,
               dense_features_by_group, *loss_updater_,
               &sparse_delta_weights_by_group, &dense_delta_weights_by_group,
-              data_by_example));
+              data_by_example, &train_step_cost_));
     }
     AddDeltaWeights(sparse_delta_weights_by_group, &sparse_weights_by_group);
     AddDeltaWeights(dense_delta_weights_by_group, &dense_weights_by_group);
@@ -575,6 +574,10 @@ class SdcaSolver : public OpKernel {
   int num_inner_iterations_;
   string container_;
   string solver_uuid_;
+
+  // Measured cost of a training step on one example, shared by all calls.
+  static const int64 kInitialTrainStepCost = 100000;
+  ShardCost train_step_cost_;
 };
 REGISTER_KERNEL_BUILDER(Name("SdcaSolver").Device(DEVICE_CPU), SdcaSolver);
 
@@ -0,0 +1,323 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/caching_cpu_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/log_memory.h"
+#include "tensorflow/core/framework/tracking_allocator.h"
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Alignment of the buffers in the size classes, which covers every
+// alignment the runtime asks for.
+const size_t kPoolAlignment = 64;
+
+// Size classes run from 64 bytes to kMaxCachedBytes with four classes per
+// power of two: class c holds buffers of (4 + c % 4) << (c / 4 + 4) bytes.
+const int kNumSizeClasses = 65;
+
+// Upper bound on the buffers a thread keeps per size class, however small.
+const int kMaxBlocksPerClass = 64;
+
+// Stored immediately before every buffer handed out.
+struct Header {
+  void* base;      // What the system allocator returned.
+  size_t bytes;    // Usable size of the buffer.
+  int size_class;  // -1 for buffers that are not cached.
+};
+static_assert(sizeof(Header) <= kPoolAlignment,
+              "Header must fit in the alignment padding");
+
+Header* HeaderOf(void* ptr) { return reinterpret_cast<Header*>(ptr) - 1; }
+
+// Allocates a buffer of "bytes" bytes aligned to "alignment" from the
+// system, preceded by its header.
+void* AllocateBlock(size_t alignment, size_t bytes, int size_class) {
+  void* base = port::aligned_malloc(alignment + bytes, alignment);
+  if (base == nullptr) return nullptr;
+  void* ptr = static_cast<char*>(base) + alignment;
+  Header* header = HeaderOf(ptr);
+  header->base = base;
+  header->bytes = bytes;
+  header->size_class = size_class;
+  return ptr;
+}
+
+void FreeBlock(void* ptr) { port::aligned_free(HeaderOf(ptr)->base); }
+
+uint64 NewAllocatorId() {
+  static std::atomic<uint64> next_id(0);
+  return ++next_id;
+}
+
+// Protects the association between allocators and thread caches, and the
+// counters of retired caches.  Only taken when a thread first uses an
+// allocator, when it exits, and by GetStats().
+mutex* RegistryMutex() {
+  static mutex* mu = new mutex;
+  return mu;
+}
+
+// Updates a counter that only the calling thread writes.
+void Add(std::atomic<int64>* counter, int64 delta) {
+  counter->store(counter->load(std::memory_order_relaxed) + delta,
+                 std::memory_order_relaxed);
+}
+
+}  // namespace
+
+// The free buffers and statistics of one thread for one allocator.  Only
+// the owning thread touches the bins; the counters are also read by
+// GetStats().
+struct CachingCPUAllocator::ThreadCache {
+  explicit ThreadCache(CachingCPUAllocator* a)
+      : owner(a), owner_id(a->id_), bins(kNumSizeClasses) {}
+
+  // Cleared, under the registry lock, when the owner is destroyed.
+  CachingCPUAllocator* owner;
+  const uint64 owner_id;
+  std::vector<std::vector<void*>> bins;
+
+  std::atomic<int64> num_allocs{0};
+  std::atomic<int64> bytes_allocated{0};
+  std::atomic<int64> bytes_freed{0};
+  std::atomic<int64> max_alloc_size{0};
+};
+
+// The caches of the calling thread, one per allocator it has used.  When
+// the thread exits, the buffers go back to their allocators.
+struct CachingCPUAllocator::ThreadCaches {
+  ~ThreadCaches() {
+    mutex_lock l(*RegistryMutex());
+    for (ThreadCache* cache : caches) {
+      if (cache->owner != nullptr) cache->owner->RetireThreadCache(cache);
+      delete cache;
+    }
+  }
+
+  std::vector<ThreadCache*> caches;
+};
+
+CachingCPUAllocator::CachingCPUAllocator(const Options& options)
+    : options_(options),
+      id_(NewAllocatorId()),
+      free_lists_(kNumSizeClasses),
+      free_list_bytes_(0) {}
+
+CachingCPUAllocator::~CachingCPUAllocator() {
+  mutex_lock l(*RegistryMutex());
+  for (ThreadCache* cache : thread_caches_) {
+    for (std::vector<void*>& bin : cache->bins) {
+      for (void* ptr : bin) FreeBlock(ptr);
+      bin.clear();
+    }
+    // The thread deletes the cache when it next uses an allocator or
+    // exits.
+    cache->owner = nullptr;
+  }
+  for (FreeList& list : free_lists_) {
+    mutex_lock list_lock(list.mu);
+    for (void* ptr : list.blocks) FreeBlock(ptr);
+  }
+}
+
+const size_t CachingCPUAllocator::kMaxCachedBytes;
+
+int CachingCPUAllocator::SizeClass(size_t num_bytes) {
+  if (num_bytes <= 64) return 0;
+  if (num_bytes > kMaxCachedBytes) return -1;
+  // Find the smallest m << e >= num_bytes with m in [4, 8).
+  const uint64 s = num_bytes - 1;
+  int e = Log2Floor64(s) - 2;
+  uint64 m = (s >> e) + 1;
+  if (m == 8) {
+    m = 4;
+    ++e;
+  }
+  return 4 * (e - 4) + (m - 4);
+}
+
+size_t CachingCPUAllocator::ClassBytes(int size_class) {
+  return static_cast<size_t>(4 + size_class % 4) << (size_class / 4 + 4);
+}
+
+int CachingCPUAllocator::ThreadCacheCapacity(int size_class) const {
+  const size_t blocks =
+      options_.thread_cache_bytes_per_class / ClassBytes(size_class);
+  return std::min<size_t>(kMaxBlocksPerClass, std::max<size_t>(2, blocks));
+}
+
+CachingCPUAllocator::ThreadCache* CachingCPUAllocator::GetThreadCache() {
+  static thread_local ThreadCaches thread_caches;
+  for (ThreadCache* cache : thread_caches.caches) {
+    if (cache->owner_id == id_) return cache;
+  }
+
+  mutex_lock l(*RegistryMutex());
+  // Drop the caches of allocators that have been destroyed.
+  std::vector<ThreadCache*>& caches = thread_caches.caches;
+  for (auto it = caches.begin(); it != caches.end();) {
+    if ((*it)->owner == nullptr) {
+      delete *it;
+      it = caches.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ThreadCache* cache = new ThreadCache(this);
+  caches.push_back(cache);
+  thread_caches_.push_back(cache);
+  return cache;
+}
+
+void* CachingCPUAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  ThreadCache* cache = GetThreadCache();
+  const int size_class =
+      alignment <= kPoolAlignment ? SizeClass(num_bytes) : -1;
+  void* ptr = nullptr;
+  if (size_class < 0) {
+    ptr = AllocateBlock(std::max(alignment, kPoolAlignment), num_bytes, -1);
+  } else {
+    std::vector<void*>* bin = &cache->bins[size_class];
+    if (bin->empty()) {
+      TakeFromFreeList(size_class, ThreadCacheCapacity(size_class) / 2, bin);
+    }
+    if (!bin->empty()) {
+      ptr = bin->back();
+      bin->pop_back();
+    } else {
+      ptr = AllocateBlock(kPoolAlignment, ClassBytes(size_class), size_class);
+    }
+  }
+  if (ptr == nullptr) return nullptr;
+
+  const int64 bytes = HeaderOf(ptr)->bytes;
+  Add(&cache->num_allocs, 1);
+  Add(&cache->bytes_allocated, bytes);
+  if (bytes > cache->max_alloc_size.load(std::memory_order_relaxed)) {
+    cache->max_alloc_size.store(bytes, std::memory_order_relaxed);
+  }
+  return ptr;
+}
+
+void CachingCPUAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  ThreadCache* cache = GetThreadCache();
+  const Header* header = HeaderOf(ptr);
+  Add(&cache->bytes_freed, header->bytes);
+  const int size_class = header->size_class;
+  if (size_class < 0) {
+    FreeBlock(ptr);
+    return;
+  }
+  std::vector<void*>* bin = &cache->bins[size_class];
+  bin->push_back(ptr);
+  if (bin->size() > static_cast<size_t>(ThreadCacheCapacity(size_class))) {
+    // Hand the least recently freed half to the other threads.
+    std::vector<void*> batch(bin->begin(), bin->begin() + bin->size() / 2);
+    bin->erase(bin->begin(), bin->begin() + batch.size());
+    ReturnToFreeList(size_class, &batch);
+  }
+}
+
+void CachingCPUAllocator::TakeFromFreeList(int size_class, int max_blocks,
+                                           std::vector<void*>* blocks) {
+  FreeList& list = free_lists_[size_class];
+  mutex_lock l(list.mu);
+  const int n = std::min<int>(max_blocks, list.blocks.size());
+  blocks->insert(blocks->end(), list.blocks.end() - n, list.blocks.end());
+  list.blocks.resize(list.blocks.size() - n);
+  free_list_bytes_ -= n * ClassBytes(size_class);
+}
+
+void CachingCPUAllocator::ReturnToFreeList(int size_class,
+                                           std::vector<void*>* blocks) {
+  const int64 bytes = ClassBytes(size_class);
+  std::vector<void*> excess;
+  {
+    FreeList& list = free_lists_[size_class];
+    mutex_lock l(list.mu);
+    for (void* ptr : *blocks) {
+      if (free_list_bytes_ + bytes > static_cast<int64>(
+                                         options_.max_cached_bytes)) {
+        excess.push_back(ptr);
+      } else {
+        list.blocks.push_back(ptr);
+        free_list_bytes_ += bytes;
+      }
+    }
+  }
+  blocks->clear();
+  for (void* ptr : excess) FreeBlock(ptr);
+}
+
+void CachingCPUAllocator::RetireThreadCache(ThreadCache* cache) {
+  for (int c = 0; c < kNumSizeClasses; ++c) {
+    ReturnToFreeList(c, &cache->bins[c]);
+  }
+  retired_num_allocs_ += cache->num_allocs;
+  retired_bytes_allocated_ += cache->bytes_allocated;
+  retired_bytes_freed_ += cache->bytes_freed;
+  retired_max_alloc_size_ =
+      std::max<int64>(retired_max_alloc_size_, cache->max_alloc_size);
+  thread_caches_.erase(
+      std::find(thread_caches_.begin(), thread_caches_.end(), cache));
+  cache->owner = nullptr;
+}
+
+size_t CachingCPUAllocator::AllocatedSizeSlow(void* ptr) {
+  return HeaderOf(ptr)->bytes;
+}
+
+void CachingCPUAllocator::GetStats(AllocatorStats* stats) {
+  mutex_lock l(*RegistryMutex());
+  int64 num_allocs = retired_num_allocs_;
+  int64 bytes_allocated = retired_bytes_allocated_;
+  int64 bytes_freed = retired_bytes_freed_;
+  int64 max_alloc_size = retired_max_alloc_size_;
+  for (const ThreadCache* cache : thread_caches_) {
+    num_allocs += cache->num_allocs.load(std::memory_order_relaxed);
+    bytes_allocated += cache->bytes_allocated.load(std::memory_order_relaxed);
+    bytes_freed += cache->bytes_freed.load(std::memory_order_relaxed);
+    max_alloc_size = std::max<int64>(
+        max_alloc_size, cache->max_alloc_size.load(std::memory_order_relaxed));
+  }
+  stats->Clear();
+  stats->num_allocs = num_allocs;
+  stats->bytes_in_use = bytes_allocated - bytes_freed;
+  max_bytes_in_use_ = std::max(max_bytes_in_use_, stats->bytes_in_use);
+  stats->max_bytes_in_use = max_bytes_in_use_;
+  stats->max_alloc_size = max_alloc_size;
+}
+
+Allocator* caching_cpu_allocator() {
+  static Allocator* allocator = [] {
+    Allocator* a = new CachingCPUAllocator;
+    if (LogMemory::IsEnabled()) {
+      a = new TrackingAllocator(a, true);
+    }
+    return a;
+  }();
+  return allocator;
+}
+
+}  // namespace tensorflow
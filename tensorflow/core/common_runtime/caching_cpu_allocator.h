@@ -0,0 +1,136 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_CACHING_CPU_ALLOCATOR_H_
+#define TENSORFLOW_COMMON_RUNTIME_CACHING_CPU_ALLOCATOR_H_
+
+#include <atomic>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A CPU allocator that keeps freed buffers around and hands them out
+// again, instead of going to the system allocator every time.  Steps of
+// the same graph allocate and free the same sizes over and over, so after
+// the first few steps almost every allocation is served from a cache.
+//
+// Requests are rounded up to one of a set of size classes (four per
+// power of two, so at most 25% is wasted).  Each thread keeps a small
+// cache of free buffers per size class that it uses without any locking.
+// When a thread's cache runs empty or overflows, buffers move in batches
+// to or from a process-wide free list per size class, so that buffers
+// freed by one thread can be reused by another.  Requests bigger than
+// the largest size class, or with an alignment above 64 bytes, go
+// straight to the system allocator.
+//
+// Statistics are kept in per-thread counters and only added up when
+// GetStats() is called.  max_bytes_in_use is therefore the largest value
+// of bytes_in_use seen by GetStats(), not the exact peak.
+class CachingCPUAllocator : public Allocator {
+ public:
+  struct Options {
+    // Upper bound on the bytes of free buffers a thread keeps in one
+    // size class.  At least two buffers are always kept.
+    size_t thread_cache_bytes_per_class = 1 << 20;
+    // Upper bound on the bytes of free buffers kept in the process-wide
+    // free lists.  Buffers freed beyond this go back to the system.
+    size_t max_cached_bytes = 256 << 20;
+  };
+
+  CachingCPUAllocator() : CachingCPUAllocator(Options()) {}
+  explicit CachingCPUAllocator(const Options& options);
+
+  // Frees all cached buffers, including those in the caches of other
+  // threads.  REQUIRES: no other thread is using the allocator.
+  ~CachingCPUAllocator() override;
+
+  string Name() override { return "caching_cpu"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+
+  size_t AllocatedSizeSlow(void* ptr) override;
+
+  void GetStats(AllocatorStats* stats) override;
+
+  // Largest request served from the size classes.
+  static const size_t kMaxCachedBytes = 4 << 20;
+
+  // Returns the size class "num_bytes" falls into, or -1 if it is bigger
+  // than kMaxCachedBytes.  Exposed for testing.
+  static int SizeClass(size_t num_bytes);
+  // Returns the size of the buffers of size class "size_class".
+  static size_t ClassBytes(int size_class);
+
+ private:
+  struct ThreadCache;
+  struct ThreadCaches;
+
+  // Returns how many free buffers of "size_class" a thread may keep.
+  int ThreadCacheCapacity(int size_class) const;
+
+  // Returns the calling thread's cache, creating it on first use.
+  ThreadCache* GetThreadCache();
+
+  // Moves up to "max_blocks" free buffers of "size_class" from the
+  // process-wide free list into "blocks".
+  void TakeFromFreeList(int size_class, int max_blocks,
+                        std::vector<void*>* blocks);
+  // Moves the buffers in "blocks", all of "size_class", to the
+  // process-wide free list, or back to the system once the free lists
+  // hold max_cached_bytes.
+  void ReturnToFreeList(int size_class, std::vector<void*>* blocks);
+
+  // Moves everything in "cache" to the free lists and folds its counters
+  // into the retired totals.  REQUIRES: the registry lock is held.
+  void RetireThreadCache(ThreadCache* cache);
+
+  const Options options_;
+  // Distinguishes this allocator from earlier ones at the same address
+  // in the threads' caches.
+  const uint64 id_;
+
+  struct FreeList {
+    mutex mu;
+    std::vector<void*> blocks GUARDED_BY(mu);
+  };
+  std::vector<FreeList> free_lists_;
+  std::atomic<int64> free_list_bytes_;
+
+  // Caches of live threads, and the counters of threads that have
+  // exited.  Guarded by the registry lock.
+  std::vector<ThreadCache*> thread_caches_;
+  int64 retired_num_allocs_ = 0;
+  int64 retired_bytes_allocated_ = 0;
+  int64 retired_bytes_freed_ = 0;
+  int64 retired_max_alloc_size_ = 0;
+  int64 max_bytes_in_use_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CachingCPUAllocator);
+};
+
+// Returns the process-wide CachingCPUAllocator, used by the CPU devices
+// of sessions whose ConfigProto.cpu_options.allocator_type is "caching".
+Allocator* caching_cpu_allocator();
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_CACHING_CPU_ALLOCATOR_H_
@@ -0,0 +1,228 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/caching_cpu_allocator.h"
+
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(CachingCPUAllocatorTest, SizeClasses) {
+  EXPECT_EQ(0, CachingCPUAllocator::SizeClass(0));
+  EXPECT_EQ(0, CachingCPUAllocator::SizeClass(64));
+  EXPECT_EQ(1, CachingCPUAllocator::SizeClass(65));
+  EXPECT_EQ(80, CachingCPUAllocator::ClassBytes(1));
+  EXPECT_EQ(-1, CachingCPUAllocator::SizeClass(
+                    CachingCPUAllocator::kMaxCachedBytes + 1));
+  int prev_class = 0;
+  for (size_t n = 1; n <= CachingCPUAllocator::kMaxCachedBytes;
+       n += 1 + n / 7) {
+    const int c = CachingCPUAllocator::SizeClass(n);
+    const size_t bytes = CachingCPUAllocator::ClassBytes(c);
+    ASSERT_GE(bytes, n);
+    ASSERT_LE(bytes, std::max<size_t>(64, n + n / 4)) << n;
+    if (c > 0) {
+      ASSERT_LT(CachingCPUAllocator::ClassBytes(c - 1), n);
+    }
+    ASSERT_GE(c, prev_class);
+    prev_class = c;
+  }
+  EXPECT_EQ(CachingCPUAllocator::kMaxCachedBytes,
+            CachingCPUAllocator::ClassBytes(CachingCPUAllocator::SizeClass(
+                CachingCPUAllocator::kMaxCachedBytes)));
+}
+
+TEST(CachingCPUAllocatorTest, ReusesBuffers) {
+  CachingCPUAllocator a;
+  void* p = a.AllocateRaw(32, 1000);
+  ASSERT_NE(nullptr, p);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p) % 32);
+  EXPECT_EQ(1024, a.AllocatedSizeSlow(p));
+  memset(p, 0xab, 1000);
+  a.DeallocateRaw(p);
+  // Any size in the same class gets the buffer back.
+  void* q = a.AllocateRaw(32, 1020);
+  EXPECT_EQ(p, q);
+  a.DeallocateRaw(q);
+}
+
+TEST(CachingCPUAllocatorTest, LargeAndOverAligned) {
+  CachingCPUAllocator a;
+  const size_t big = CachingCPUAllocator::kMaxCachedBytes + 1;
+  void* p = a.AllocateRaw(32, big);
+  ASSERT_NE(nullptr, p);
+  EXPECT_EQ(big, a.AllocatedSizeSlow(p));
+  memset(p, 0, big);
+  a.DeallocateRaw(p);
+
+  void* q = a.AllocateRaw(256, 100);
+  ASSERT_NE(nullptr, q);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(q) % 256);
+  a.DeallocateRaw(q);
+}
+
+TEST(CachingCPUAllocatorTest, Stats) {
+  CachingCPUAllocator a;
+  void* p1 = a.AllocateRaw(32, 1000);
+  void* p2 = a.AllocateRaw(32, 5000);
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(2, stats.num_allocs);
+  EXPECT_EQ(1024 + 5120, stats.bytes_in_use);
+  EXPECT_EQ(1024 + 5120, stats.max_bytes_in_use);
+  EXPECT_EQ(5120, stats.max_alloc_size);
+
+  a.DeallocateRaw(p1);
+  a.DeallocateRaw(p2);
+  a.GetStats(&stats);
+  EXPECT_EQ(2, stats.num_allocs);
+  EXPECT_EQ(0, stats.bytes_in_use);
+  EXPECT_EQ(1024 + 5120, stats.max_bytes_in_use);
+}
+
+// Buffers allocated on one thread and freed on another end up in the
+// free lists, and the counters of exited threads are kept.
+TEST(CachingCPUAllocatorTest, ManyThreads) {
+  CachingCPUAllocator::Options options;
+  options.thread_cache_bytes_per_class = 4096;
+  CachingCPUAllocator a(options);
+  const int kThreads = 8;
+  const int kAllocsPerThread = 1000;
+  std::vector<std::vector<void*>> allocated(kThreads);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kThreads);
+    for (int t = 0; t < kThreads; ++t) {
+      pool.Schedule([&a, &allocated, t]() {
+        for (int i = 0; i < kAllocsPerThread; ++i) {
+          const size_t bytes = 64 + (i * 37) % 3000;
+          void* p = a.AllocateRaw(32, bytes);
+          CHECK(p != nullptr);
+          memset(p, t, bytes);
+          allocated[t].push_back(p);
+          if (i % 3 == 0) {
+            a.DeallocateRaw(allocated[t][i / 2]);
+            allocated[t][i / 2] = nullptr;
+          }
+        }
+      });
+    }
+  }
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(kThreads * kAllocsPerThread, stats.num_allocs);
+  EXPECT_GT(stats.bytes_in_use, 0);
+
+  // Free everything from other threads than the ones that allocated.
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kThreads);
+    for (int t = 0; t < kThreads; ++t) {
+      pool.Schedule([&a, &allocated, t]() {
+        for (void* p : allocated[(t + 1) % kThreads]) {
+          if (p != nullptr) a.DeallocateRaw(p);
+        }
+      });
+    }
+  }
+  a.GetStats(&stats);
+  EXPECT_EQ(kThreads * kAllocsPerThread, stats.num_allocs);
+  EXPECT_EQ(0, stats.bytes_in_use);
+}
+
+TEST(CachingCPUAllocatorTest, OutlivedByThreads) {
+  thread::ThreadPool pool(Env::Default(), "test", 2);
+  for (int i = 0; i < 3; ++i) {
+    std::unique_ptr<CachingCPUAllocator> a(new CachingCPUAllocator);
+    BlockingCounter done(2);
+    for (int t = 0; t < 2; ++t) {
+      pool.Schedule([&a, &done]() {
+        a->DeallocateRaw(a->AllocateRaw(32, 100));
+        done.DecrementCount();
+      });
+    }
+    done.Wait();
+  }
+}
+
+TEST(CachingCPUAllocatorTest, SelectedBySessionOptions) {
+  SessionOptions options;
+  options.config.mutable_cpu_options()->set_allocator_type("caching");
+  std::vector<Device*> devices;
+  DeviceFactory::GetFactory("CPU")->CreateDevices(
+      options, "/job:a/replica:0/task:0", &devices);
+  ASSERT_EQ(1, devices.size());
+  EXPECT_EQ(caching_cpu_allocator(),
+            devices[0]->GetAllocator(AllocatorAttributes()));
+  gtl::STLDeleteElements(&devices);
+}
+
+// Allocates and frees the sizes of a typical step from "num_threads"
+// threads at once.
+static void BM_Allocation(int iters, Allocator* a, int num_threads) {
+  testing::StopTiming();
+  const std::vector<int> sizes = {256, 4096, 16384, 524288, 512, 1048576};
+  thread::ThreadPool pool(Env::Default(), "bench", num_threads);
+  testing::StartTiming();
+  BlockingCounter done(num_threads);
+  for (int t = 0; t < num_threads; ++t) {
+    pool.Schedule([a, iters, &sizes, &done]() {
+      std::vector<void*> live(sizes.size());
+      for (int i = 0; i < iters; ++i) {
+        for (size_t s = 0; s < sizes.size(); ++s) {
+          live[s] = a->AllocateRaw(32, sizes[s]);
+        }
+        for (void* p : live) a->DeallocateRaw(p);
+      }
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_threads *
+                          sizes.size());
+}
+
+static void BM_CPUAllocator(int iters, int num_threads) {
+  BM_Allocation(iters, cpu_allocator(), num_threads);
+}
+BENCHMARK(BM_CPUAllocator)->Arg(1)->Arg(8);
+
+static void BM_CPUAllocatorWithStats(int iters, int num_threads) {
+  EnableCPUAllocatorStats(true);
+  BM_Allocation(iters, cpu_allocator(), num_threads);
+  EnableCPUAllocatorStats(false);
+}
+BENCHMARK(BM_CPUAllocatorWithStats)->Arg(1)->Arg(8);
+
+static void BM_CachingCPUAllocator(int iters, int num_threads) {
+  BM_Allocation(iters, caching_cpu_allocator(), num_threads);
+}
+BENCHMARK(BM_CachingCPUAllocator)->Arg(1)->Arg(8);
+
+}  // namespace
+}  // namespace tensorflow
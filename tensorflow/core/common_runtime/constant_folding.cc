@@ -15,8 +15,12 @@ limitations under the License.
 
 #include <algorithm>
 #include <atomic>
+#include <map>
+#include <memory>
 #include <set>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/constant_folding.h"
@@ -29,8 +33,11 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/graph/subgraph.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/host_info.h"
 #include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
@@ -101,14 +108,105 @@ void FindConstantFoldableNodes(const Graph* graph, ConstantFoldingOptions opts,
 
 typedef std::pair<Node*, int> NodeAndOutput;
 
+// Splits the constant foldable nodes in "nodes" into the sets connected by
+// edges between them, keeping the data flow order within each set.
+std::vector<std::vector<Node*>> GetConnectedSubgraphs(
+    const Graph* graph, const std::vector<Node*>& nodes) {
+  // Union-find over the positions in "nodes".
+  std::vector<int> position(graph->num_node_ids(), -1);
+  std::vector<int> parent(nodes.size());
+  for (int i = 0; i < nodes.size(); ++i) {
+    position[nodes[i]->id()] = i;
+    parent[i] = i;
+  }
+  auto find = [&parent](int i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+  for (int i = 0; i < nodes.size(); ++i) {
+    for (const Edge* in_edge : nodes[i]->in_edges()) {
+      const int j = position[in_edge->src()->id()];
+      if (j >= 0) parent[find(i)] = find(j);
+    }
+  }
+  std::vector<std::vector<Node*>> subgraphs;
+  std::unordered_map<int, int> subgraph_of_root;
+  for (int i = 0; i < nodes.size(); ++i) {
+    auto it = subgraph_of_root.insert({find(i), subgraphs.size()}).first;
+    if (it->second == subgraphs.size()) subgraphs.emplace_back();
+    subgraphs[it->second].push_back(nodes[i]);
+  }
+  return subgraphs;
+}
+
+// Returns the outputs of the constant foldable nodes in "nodes" that are
+// consumed outside of "nodes", in the order of "nodes" and then of outputs.
+std::vector<NodeAndOutput> GetTensorsToFetch(const std::vector<Node*>& nodes) {
+  std::unordered_set<const Node*> node_set(nodes.begin(), nodes.end());
+  std::vector<NodeAndOutput> tensors;
+  for (Node* n : nodes) {
+    std::set<int> outputs;
+    for (const Edge* out_edge : n->out_edges()) {
+      if (out_edge->IsControlEdge()) continue;
+      if (node_set.count(out_edge->dst()) == 0) {
+        outputs.insert(out_edge->src_output());
+      }
+    }
+    for (int output : outputs) tensors.push_back({n, output});
+  }
+  return tensors;
+}
+
+// Returns a fingerprint of the subgraph of "nodes" fetching "tensors", made of
+// the ops, attrs and edges of the nodes but not of their names.
+ConstantFoldingCache::Fingerprint FingerprintSubgraph(
+    const std::vector<Node*>& nodes,
+    const std::vector<NodeAndOutput>& tensors) {
+  std::unordered_map<const Node*, int> position;
+  string s;
+  for (int i = 0; i < nodes.size(); ++i) {
+    const Node* n = nodes[i];
+    position[n] = i;
+    strings::StrAppend(&s, n->type_string(), "(");
+    // Edges are identified by the positions of their ends, in an order that
+    // does not depend on the EdgeSet.
+    std::vector<std::tuple<int, int, int>> inputs;
+    for (const Edge* in_edge : n->in_edges()) {
+      const int src =
+          in_edge->src()->IsSource() ? -1 : position.at(in_edge->src());
+      inputs.emplace_back(in_edge->dst_input(), src, in_edge->src_output());
+    }
+    std::sort(inputs.begin(), inputs.end());
+    for (const auto& input : inputs) {
+      strings::StrAppend(&s, std::get<0>(input), "<", std::get<1>(input), ":",
+                         std::get<2>(input), ",");
+    }
+    strings::StrAppend(&s, ")");
+    std::map<string, const AttrValue*> attrs;
+    for (const auto& attr : n->def().attr()) {
+      attrs[attr.first] = &attr.second;
+    }
+    for (const auto& attr : attrs) {
+      string value;
+      attr.second->SerializeToString(&value);
+      strings::StrAppend(&s, attr.first, "=", value.size(), ":", value, ";");
+    }
+  }
+  strings::StrAppend(&s, "->");
+  for (const NodeAndOutput& tensor : tensors) {
+    strings::StrAppend(&s, position.at(tensor.first), ":", tensor.second, ",");
+  }
+  return {Hash64(s.data(), s.size(), 0x6d4f7c1a2b3e5f01ULL),
+          Hash64(s.data(), s.size(), 0x1f2e3d4c5b6a7988ULL)};
+}
+
 // Given the constant foldable nodes in 'nodes', returns a new graph 'g'. 'g'
-// will contain copies of the nodes in 'nodes'. In addition, if there is an edge
-// going from a node 'n' in 'nodes' to another node in 'orig_graph' but not in
-// 'nodes', then 'tensors_to_fetch' will contain the mapping from the
-// corresponding copy of 'n' and the edge number in 'g' to 'n'.
+// will contain copies of the nodes in 'nodes', with the same names.
 Graph* GetConstantGraph(const Graph* orig_graph,
-                        const std::vector<Node*>& nodes,
-                        std::map<NodeAndOutput, Node*>* tensors_to_fetch) {
+                        const std::vector<Node*>& nodes) {
   Graph* constant_graph = new Graph(orig_graph->op_registry());
   std::unordered_map<Node*, Node*> node_map;
   std::set<Node*> already_added;
@@ -130,17 +228,6 @@ Graph* GetConstantGraph(const Graph* orig_graph,
                               in_edge->dst_input());
     }
   }
-
-  for (auto const& added_nodes : node_map) {
-    for (const Edge* out_edge : added_nodes.first->out_edges()) {
-      if (node_map.count(out_edge->dst()) == 0) {
-        if (out_edge->IsControlEdge()) continue;
-        tensors_to_fetch->insert(
-            {{added_nodes.second, out_edge->src_output()}, added_nodes.first});
-      }
-    }
-  }
-
   return constant_graph;
 }
 
@@ -162,9 +249,11 @@ Device* GetCPUDevice() {
   return device;
 }
 
+// The nodes of independent constant subgraphs are run concurrently, on as
+// many threads as there are CPUs.
 thread::ThreadPool* GetThreadPool() {
-  static thread::ThreadPool* thread_pool =
-      new thread::ThreadPool(Env::Default(), "Compute", 1);
+  static thread::ThreadPool* thread_pool = new thread::ThreadPool(
+      Env::Default(), "Compute", port::NumSchedulableCPUs());
   return thread_pool;
 }
 
@@ -215,8 +304,135 @@ class SimpleRendezvous : public Rendezvous {
   Table table_ GUARDED_BY(mu_);
 };
 
+// A connected subgraph of constant foldable nodes, with the tensors it
+// replaces in the original graph and their values.
+struct ConstantSubgraph {
+  std::vector<Node*> nodes;
+  std::vector<NodeAndOutput> tensors_to_replace;
+  ConstantFoldingCache::Fingerprint fingerprint;
+  std::vector<Tensor> values;
+  // The executor and the rendezvous evaluating the subgraph, if not cached.
+  std::unique_ptr<Executor> executor;
+  SimpleRendezvous* rendez = nullptr;
+  std::vector<string> fetch_tensor_names;
+  Status status;
+};
+
+// Prepares an executor for "constant_subgraph" of "graph", which sends the
+// tensors to replace to "constant_subgraph->rendez".
+Status PrepareExecutor(const Graph* graph, Device* device,
+                       ConstantSubgraph* constant_subgraph) {
+  Graph* constant_graph = GetConstantGraph(graph, constant_subgraph->nodes);
+  DumpGraph("Constant graph", constant_graph);
+
+  subgraph::NameIndex name_index;
+  for (Node* n : constant_graph->nodes()) {
+    name_index[n->name()] = n;
+  }
+  std::vector<string> tensors_to_fetch_names;
+  for (const NodeAndOutput& tensor : constant_subgraph->tensors_to_replace) {
+    tensors_to_fetch_names.push_back(
+        strings::StrCat(tensor.first->name(), ":", tensor.second));
+  }
+  // For nodes that need to be fetched back from the constant_graph, attach Send
+  // nodes.
+  std::vector<Node*> fetch_nodes;
+  Status s = subgraph::FetchOutputs(constant_graph, device->attributes(),
+                                    tensors_to_fetch_names, false, &name_index,
+                                    &fetch_nodes);
+  if (!s.ok()) {
+    delete constant_graph;
+    return s;
+  }
+  CHECK_EQ(fetch_nodes.size(), constant_subgraph->tensors_to_replace.size());
+  for (Node* fetch_node : fetch_nodes) {
+    string tensor_name;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(fetch_node->def(), "tensor_name", &tensor_name));
+    constant_subgraph->fetch_tensor_names.push_back(tensor_name);
+  }
+
+  LocalExecutorParams params;
+  params.device = device;
+  params.create_kernel = [device, constant_graph](const NodeDef& ndef,
+                                                  OpKernel** kernel) {
+    return CreateNonCachedKernel(device, nullptr, ndef,
+                                 constant_graph->versions().producer(), kernel);
+  };
+  params.delete_kernel = [](OpKernel* kernel) { delete kernel; };
+  Executor* executor;
+  TF_RETURN_IF_ERROR(NewLocalExecutor(params, constant_graph, &executor));
+  constant_subgraph->executor.reset(executor);
+  constant_subgraph->rendez = new SimpleRendezvous;
+  return Status::OK();
+}
+
+// Fetches the values sent by the executor of "subgraph".
+Status ReceiveValues(ConstantSubgraph* subgraph) {
+  for (const string& tensor_name : subgraph->fetch_tensor_names) {
+    Tensor output;
+    bool is_dead;
+    TF_RETURN_IF_ERROR(subgraph->rendez->Recv(tensor_name, Rendezvous::Args(),
+                                              &output, &is_dead));
+    if (is_dead) {
+      return errors::Internal("Constant ", tensor_name, " is dead");
+    }
+    subgraph->values.push_back(output);
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
+ConstantFoldingCache::ConstantFoldingCache(int64 capacity_bytes)
+    : capacity_bytes_(capacity_bytes) {}
+
+ConstantFoldingCache* ConstantFoldingCache::Global() {
+  static ConstantFoldingCache* cache =
+      new ConstantFoldingCache(256 * 1024 * 1024);
+  return cache;
+}
+
+bool ConstantFoldingCache::Lookup(const Fingerprint& fp,
+                                  std::vector<Tensor>* values) {
+  mutex_lock l(mu_);
+  auto it = entries_.find(fp);
+  if (it == entries_.end()) return false;
+  *values = it->second.values;
+  ++hits_;
+  return true;
+}
+
+void ConstantFoldingCache::Insert(const Fingerprint& fp,
+                                  const std::vector<Tensor>& values) {
+  int64 bytes = 0;
+  for (const Tensor& t : values) bytes += t.TotalBytes();
+  if (bytes > capacity_bytes_) return;
+  mutex_lock l(mu_);
+  if (entries_.count(fp) > 0) return;
+  while (bytes_ + bytes > capacity_bytes_) {
+    auto oldest = entries_.find(order_.front());
+    bytes_ -= oldest->second.bytes;
+    entries_.erase(oldest);
+    order_.pop_front();
+  }
+  entries_[fp] = {values, bytes};
+  order_.push_back(fp);
+  bytes_ += bytes;
+}
+
+void ConstantFoldingCache::Clear() {
+  mutex_lock l(mu_);
+  entries_.clear();
+  order_.clear();
+  bytes_ = 0;
+}
+
+int64 ConstantFoldingCache::hits() {
+  mutex_lock l(mu_);
+  return hits_;
+}
+
 void ReplaceTensorWithConstant(Graph* graph, NodeAndOutput tensor,
                                const Tensor& constant) {
   Node* n = tensor.first;
@@ -258,115 +474,92 @@ bool DoConstantFolding(const ConstantFoldingOptions& opts, Graph* graph) {
     return false;
   }
 
-  std::map<NodeAndOutput, Node*> tensors_to_fetch;
-  Graph* constant_graph =
-      GetConstantGraph(graph, constant_foldable_nodes, &tensors_to_fetch);
-  DumpGraph("Constant graph", constant_graph);
-
-  if (tensors_to_fetch.empty()) {
-    VLOG(1) << "No constant nodes found that feed into the original graph.";
-    delete constant_graph;
-    return false;
-  }
-  VLOG(1) << "Constant foldable " << constant_graph->num_node_ids() << " : "
-          << graph->num_node_ids();
-
-  // Create a local executor and evaluate the constant foldable nodes.
-  subgraph::NameIndex name_index;
-  for (Node* n : constant_graph->nodes()) {
-    name_index[n->name()] = n;
-  }
-
-  std::vector<Node*> fetch_nodes;
-  std::vector<string> tensors_to_fetch_names;
-  std::vector<NodeAndOutput> tensors_to_replace;
-  for (auto n : tensors_to_fetch) {
-    tensors_to_fetch_names.push_back(
-        strings::StrCat(n.first.first->name(), ":", n.first.second));
-    tensors_to_replace.push_back({n.second, n.first.second});
+  // Looks up the values of each connected subgraph that has something to
+  // compute, and prepares executors for those not in the cache.
+  ConstantFoldingCache* cache = ConstantFoldingCache::Global();
+  std::vector<std::unique_ptr<ConstantSubgraph>> subgraphs;
+  std::vector<ConstantSubgraph*> to_run;
+  for (std::vector<Node*>& nodes :
+       GetConnectedSubgraphs(graph, constant_foldable_nodes)) {
+    if (nodes.size() == 1 && nodes[0]->IsConstant()) continue;
+    std::unique_ptr<ConstantSubgraph> subgraph(new ConstantSubgraph);
+    subgraph->tensors_to_replace = GetTensorsToFetch(nodes);
+    if (subgraph->tensors_to_replace.empty()) continue;
+    subgraph->nodes.swap(nodes);
+    subgraph->fingerprint =
+        FingerprintSubgraph(subgraph->nodes, subgraph->tensors_to_replace);
+    if (!cache->Lookup(subgraph->fingerprint, &subgraph->values)) {
+      Status s = PrepareExecutor(graph, device, subgraph.get());
+      if (!s.ok()) {
+        VLOG(1) << "Could not prepare to fold constants: " << s;
+        continue;
+      }
+      to_run.push_back(subgraph.get());
+    }
+    subgraphs.push_back(std::move(subgraph));
   }
-  // For nodes that need to be fetched back from the constant_graph, attach Send
-  // nodes.
-  Status s =
-      subgraph::FetchOutputs(constant_graph, device->attributes(),
-                             tensors_to_fetch_names, &name_index, &fetch_nodes);
-  if (!s.ok()) {
-    delete constant_graph;
-    VLOG(1) << "Could not fetch constants: " << s;
+  if (subgraphs.empty()) {
+    VLOG(1) << "No constant nodes found that feed into the original graph.";
     return false;
   }
+  VLOG(1) << "Constant foldable " << constant_foldable_nodes.size() << " : "
+          << graph->num_node_ids() << " in " << subgraphs.size()
+          << " subgraphs, " << to_run.size() << " not cached";
 
-  CHECK_EQ(fetch_nodes.size(), tensors_to_fetch.size());
-
-  // Create the local executor and the Rendezvous for fetching back the
-  // constants.
+  // Runs the executors of all the subgraphs not in the cache at once.
   auto runner = [thread_pool](Executor::Args::Closure c) {
     thread_pool->Schedule(c);
   };
-  LocalExecutorParams params;
-  params.device = device;
-  params.create_kernel = [device, constant_graph](const NodeDef& ndef,
-                                                  OpKernel** kernel) {
-    return CreateNonCachedKernel(device, nullptr, ndef,
-                                 constant_graph->versions().producer(), kernel);
-  };
-  params.delete_kernel = [](OpKernel* kernel) { delete kernel; };
-  Executor* executor;
-  if (!NewLocalExecutor(params, constant_graph, &executor).ok()) {
-    return false;
+  BlockingCounter executors_done(to_run.size());
+  for (ConstantSubgraph* subgraph : to_run) {
+    Executor::Args args;
+    args.step_id = LogMemory::CONSTANT_FOLDING_STEP_ID;
+    args.runner = runner;
+    args.rendezvous = subgraph->rendez;
+    subgraph->executor->RunAsync(
+        args, [subgraph, &executors_done](const Status& s) {
+          subgraph->status = s;
+          executors_done.DecrementCount();
+        });
   }
-
-  std::unique_ptr<Executor> executor_unref(executor);
-
-  SimpleRendezvous* rendez = new SimpleRendezvous;
-  core::ScopedUnref rendez_unref(rendez);
-
-  Executor::Args args;
-  args.step_id = LogMemory::CONSTANT_FOLDING_STEP_ID;
-  args.runner = runner;
-  args.rendezvous = rendez;
-
-  // Run the constant_graph.
-  Notification executor_done;
-  Status executor_done_status;
-  ExecutorBarrier* barrier = new ExecutorBarrier(
-      1, rendez, [&executor_done, &executor_done_status](const Status& ret) {
-        executor_done_status = ret;
-        executor_done.Notify();
-      });
-
-  executor->RunAsync(args, barrier->Get());
-
-  executor_done.WaitForNotification();
-
-  if (!executor_done_status.ok()) {
-    return false;
+  executors_done.Wait();
+  for (ConstantSubgraph* subgraph : to_run) {
+    if (subgraph->status.ok()) subgraph->status = ReceiveValues(subgraph);
+    subgraph->rendez->Unref();
+    subgraph->executor.reset();
+    if (subgraph->status.ok()) {
+      cache->Insert(subgraph->fingerprint, subgraph->values);
+    } else {
+      VLOG(1) << "Could not fold constants: " << subgraph->status;
+    }
   }
 
-  // Fetch the constant tensors and replace the corresponding tensors in the
-  // original graph with those constants.
-  for (size_t c = 0; c < fetch_nodes.size(); ++c) {
-    Tensor output;
-    bool is_dead;
-    string tensor_name;
-    if (!GetNodeAttr(fetch_nodes[c]->def(), "tensor_name", &tensor_name).ok()) {
-      // We successfully replaced some nodes previously, but had a problem with
-      // this node. Don't bother processing the rest of the nodes.
-      return c > 0;
-    }
-    Status s = rendez->Recv(tensor_name, Rendezvous::Args(), &output, &is_dead);
-    if (!s.ok() || is_dead) {
-      return c > 0;
+  // Replaces the tensors in the original graph with constants holding the
+  // values of the subgraphs that were evaluated.
+  bool changed = false;
+  for (const auto& subgraph : subgraphs) {
+    if (!subgraph->status.ok()) continue;
+    CHECK_EQ(subgraph->values.size(), subgraph->tensors_to_replace.size());
+    for (size_t c = 0; c < subgraph->values.size(); ++c) {
+      const NodeAndOutput& tensor = subgraph->tensors_to_replace[c];
+      const Tensor& value = subgraph->values[c];
+      if (value.TotalBytes() > opts.max_constant_size_in_bytes) {
+        VLOG(1) << "Not replacing " << tensor.first->DebugString()
+                << " :: " << tensor.second << " with a constant of "
+                << value.TotalBytes() << " bytes";
+        continue;
+      }
+      VLOG(1) << "Replacing " << tensor.first->DebugString()
+              << " :: " << tensor.second << " with constant "
+              << value.DebugString();
+      ReplaceTensorWithConstant(graph, tensor, value);
+      changed = true;
     }
-    VLOG(1) << "Replacing " << tensors_to_replace[c].first->DebugString()
-            << " :: " << tensors_to_replace[c].second << " with constant "
-            << output.DebugString();
-    ReplaceTensorWithConstant(graph, tensors_to_replace[c], output);
   }
 
   DumpGraph("After", graph);
 
-  return true;
+  return changed;
 }
 
 }  // namespace tensorflow
@@ -16,9 +16,18 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_CONSTANT_FOLDING_H_
 #define TENSORFLOW_COMMON_RUNTIME_CONSTANT_FOLDING_H_
 
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 
@@ -27,8 +36,60 @@ namespace tensorflow {
 // that are only dependent on constants. Evaluates those nodes on a CPU device
 // and replaces those nodes with the result of the evaluation.
 // Returns true if and only if "graph" has been mutated.
+//
+// The constant nodes are split into connected subgraphs, which are evaluated
+// concurrently. Their values are kept in ConstantFoldingCache::Global(), so a
+// subgraph seen before, e.g. in an earlier rebuild of the same graph by a
+// session, is not evaluated again.
 bool DoConstantFolding(const ConstantFoldingOptions& opts, Graph* graph);
 
+// Values of constant subgraphs, keyed by a fingerprint of their ops, attrs,
+// edges and fetched outputs. Node names are left out of the fingerprint, so
+// that the copies of a subgraph in differently pruned graphs share an entry.
+//
+// This class is thread-safe.
+class ConstantFoldingCache {
+ public:
+  typedef std::pair<uint64, uint64> Fingerprint;
+
+  // Holds at most "capacity_bytes" of tensor data, dropping the oldest
+  // entries first.
+  explicit ConstantFoldingCache(int64 capacity_bytes);
+
+  // Returns the cache used by DoConstantFolding.
+  static ConstantFoldingCache* Global();
+
+  // Sets "*values" to the values stored for "fp" and returns true, or
+  // returns false if there are none.
+  bool Lookup(const Fingerprint& fp, std::vector<Tensor>* values);
+
+  // Stores "values" for "fp", unless they take more than the capacity.
+  void Insert(const Fingerprint& fp, const std::vector<Tensor>& values);
+
+  // Drops all the entries.
+  void Clear();
+
+  // Returns the number of successful calls to Lookup().
+  int64 hits();
+
+ private:
+  struct Entry {
+    std::vector<Tensor> values;
+    int64 bytes;
+  };
+
+  const int64 capacity_bytes_;
+
+  mutex mu_;
+  std::map<Fingerprint, Entry> entries_ GUARDED_BY(mu_);
+  // The keys of "entries_" from the oldest to the newest.
+  std::list<Fingerprint> order_ GUARDED_BY(mu_);
+  int64 bytes_ GUARDED_BY(mu_) = 0;
+  int64 hits_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ConstantFoldingCache);
+};
+
 typedef std::pair<Node*, int> NodeAndOutput;
 
 // Replaces the identified Tensor in 'graph' by a 'Const' node with
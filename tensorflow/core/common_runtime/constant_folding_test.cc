@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
@@ -187,5 +188,141 @@ TEST_F(ConstantFoldingTest, TwoOutputsFoldOneOutput) {
   ExpectNodeEqual<int>(*(b1_ident->in_nodes().begin()), {}, {0});
 }
 
+TEST_F(ConstantFoldingTest, IndependentSubgraphs) {
+  Reset();
+  Graph* g = g_.get();
+  std::vector<Node*> sends;
+  for (int i = 0; i < 4; ++i) {
+    Node* a = Constant<float>({1.0, 0.0, 0.0, 1.0}, {2, 2});
+    Node* b = Constant<float>({1.0f * i, 2.0, 3.0, 4.0}, {2, 2});
+    g->AddControlEdge(g->source_node(), a);
+    g->AddControlEdge(g->source_node(), b);
+    Node* m = test::graph::Matmul(g, a, b, false, false);
+    Node* s = test::graph::Send(g, m, strings::StrCat("m", i), "sender", 0,
+                                "receiver");
+    g->AddControlEdge(s, g->sink_node());
+    sends.push_back(s);
+  }
+  EXPECT_TRUE(DoConstantFolding(ConstantFoldingOptions{}, g));
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(1, sends[i]->num_inputs());
+    ExpectNodeClose<float>(*(sends[i]->in_nodes().begin()),
+                           {1.0f * i, 2.0, 3.0, 4.0}, {2, 2});
+  }
+}
+
+// Builds a graph which sends a * b, where a and b are 2x2 constants.
+#define MATMUL_GRAPH                                               \
+  Reset();                                                         \
+  Graph* g = g_.get();                                             \
+  Node* a = Constant<float>({1.0, 2.0, 3.0, 4.0}, {2, 2});         \
+  Node* b = Constant<float>({1.0, 1.0, 1.0, 2.0}, {2, 2});         \
+  g->AddControlEdge(g->source_node(), a);                          \
+  g->AddControlEdge(g->source_node(), b);                          \
+  Node* m = test::graph::Matmul(g, a, b, false, false);            \
+  Node* s = test::graph::Send(g, m, "m", "sender", 0, "receiver"); \
+  g->AddControlEdge(s, g->sink_node());
+
+TEST_F(ConstantFoldingTest, CachedValues) {
+  ConstantFoldingCache* cache = ConstantFoldingCache::Global();
+  cache->Clear();
+  const int64 hits = cache->hits();
+  {
+    MATMUL_GRAPH;
+    EXPECT_TRUE(DoConstantFolding(ConstantFoldingOptions{}, g));
+    EXPECT_EQ(hits, cache->hits());
+  }
+  // The same subgraph in a new graph is folded from the cache, even though
+  // its nodes have different names.
+  {
+    MATMUL_GRAPH;
+    EXPECT_TRUE(DoConstantFolding(ConstantFoldingOptions{}, g));
+    EXPECT_EQ(hits + 1, cache->hits());
+    EXPECT_EQ(1, s->num_inputs());
+    ExpectNodeClose<float>(*(s->in_nodes().begin()), {3.0, 5.0, 7.0, 11.0},
+                           {2, 2});
+  }
+  // Different constants make a different subgraph.
+  {
+    Reset();
+    Graph* g = g_.get();
+    Node* a = Constant<float>({1.0, 2.0, 3.0, 4.0}, {2, 2});
+    Node* b = Constant<float>({1.0, 0.0, 0.0, 1.0}, {2, 2});
+    g->AddControlEdge(g->source_node(), a);
+    g->AddControlEdge(g->source_node(), b);
+    Node* m = test::graph::Matmul(g, a, b, false, false);
+    Node* s = test::graph::Send(g, m, "m", "sender", 0, "receiver");
+    g->AddControlEdge(s, g->sink_node());
+    EXPECT_TRUE(DoConstantFolding(ConstantFoldingOptions{}, g));
+    EXPECT_EQ(hits + 1, cache->hits());
+    ExpectNodeClose<float>(*(s->in_nodes().begin()), {1.0, 2.0, 3.0, 4.0},
+                           {2, 2});
+  }
+}
+
+TEST_F(ConstantFoldingTest, MaxConstantSize) {
+  MATMUL_GRAPH;
+  ConstantFoldingOptions opts;
+  // The product takes 16 bytes.
+  opts.max_constant_size_in_bytes = 15;
+  EXPECT_FALSE(DoConstantFolding(opts, g));
+  EXPECT_EQ(1, s->num_inputs());
+  EXPECT_EQ(*(s->in_nodes().begin()), m);
+
+  opts.max_constant_size_in_bytes = 16;
+  EXPECT_TRUE(DoConstantFolding(opts, g));
+  EXPECT_EQ(1, s->num_inputs());
+  ExpectNodeClose<float>(*(s->in_nodes().begin()), {3.0, 5.0, 7.0, 11.0},
+                         {2, 2});
+}
+#undef MATMUL_GRAPH
+
+// Builds a graph of "num_subgraphs" independent chains of matmuls of 256x256
+// constants, as a large inference graph would have for preprocessing.
+static Graph* IndependentMatmulChains(int num_subgraphs) {
+  Graph* g = new Graph(OpRegistry::Global());
+  // The same values in every graph, as in rebuilds of one graph.
+  Tensor t(DT_FLOAT, TensorShape({256, 256}));
+  auto values = t.flat<float>();
+  for (int i = 0; i < values.size(); ++i) values(i) = (i % 7) / 256.0f;
+  for (int i = 0; i < num_subgraphs; ++i) {
+    Node* x = test::graph::Constant(g, t);
+    g->AddControlEdge(g->source_node(), x);
+    for (int j = 0; j < 4; ++j) {
+      x = test::graph::Matmul(g, x, x, false, false);
+    }
+    Node* s = test::graph::Send(g, x, strings::StrCat("m", i), "sender", 0,
+                                "receiver");
+    g->AddControlEdge(s, g->sink_node());
+  }
+  return g;
+}
+
+// Folds graphs as a session does each time it builds executors for new
+// feeds and fetches, with or without the values of earlier builds.
+static void BM_ConstantFoldingRebuild(int iters, int num_subgraphs,
+                                      bool cached) {
+  testing::StopTiming();
+  ConstantFoldingCache::Global()->Clear();
+  for (int i = 0; i < iters; ++i) {
+    std::unique_ptr<Graph> g(IndependentMatmulChains(num_subgraphs));
+    if (!cached) ConstantFoldingCache::Global()->Clear();
+    testing::StartTiming();
+    CHECK(DoConstantFolding(ConstantFoldingOptions{}, g.get()));
+    testing::StopTiming();
+  }
+}
+
+static void BM_ConstantFoldingRebuildUncached(int iters, int num_subgraphs) {
+  BM_ConstantFoldingRebuild(iters, num_subgraphs, false);
+}
+BENCHMARK(BM_ConstantFoldingRebuildUncached)->Arg(1)->Arg(8)->Arg(32);
+
+static void BM_ConstantFoldingRebuildCached(int iters, int num_subgraphs) {
+  BM_ConstantFoldingRebuild(iters, num_subgraphs, true);
+}
+BENCHMARK(BM_ConstantFoldingRebuildCached)->Arg(1)->Arg(8)->Arg(32);
+
 }  // namespace
 }  // namespace tensorflow
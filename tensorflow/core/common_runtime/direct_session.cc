@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/graph_optimizer.h"
+#include "tensorflow/core/common_runtime/measured_costs.h"
 #include "tensorflow/core/common_runtime/memory_types.h"
 #include "tensorflow/core/common_runtime/session_factory.h"
 #include "tensorflow/core/common_runtime/simple_placer.h"
@@ -34,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/graph_partition.h"
@@ -163,6 +165,7 @@ DirectSession::DirectSession(const SessionOptions& options,
 }
 
 DirectSession::~DirectSession() {
+  callables_.clear();
   for (auto& it : partial_runs_) {
     delete it.second;
   }
@@ -297,45 +300,16 @@ Status DirectSession::Run(const RunOptions& run_options,
   // Send inputs.
   TF_RETURN_IF_ERROR(SendInputs(inputs, executors_and_keys, run_state.rendez));
 
-  // Start parallel Executors.
-  const int num_executors = executors_and_keys->items.size();
-  ExecutorBarrier* barrier = new ExecutorBarrier(
-      num_executors, run_state.rendez, [&run_state](const Status& ret) {
-        {
-          mutex_lock l(run_state.mu_);
-          run_state.status.Update(ret);
-        }
-        run_state.executors_done.Notify();
-      });
-
-  Executor::Args args;
-  args.step_id = step_id_counter_.fetch_add(1);
-  args.rendezvous = run_state.rendez;
-  args.cancellation_manager = cancellation_manager_;
-  args.runner = [this](Executor::Args::Closure c) { SchedClosure(c); };
-  if (LogMemory::IsEnabled()) {
-    LogMemory::RecordStep(args.step_id, run_state_args.handle);
-  }
-
+  StepStats* step_stats = nullptr;
   if (run_options.trace_level() == RunOptions::FULL_TRACE ||
       options_.config.graph_options().build_cost_model()) {
-    args.stats_collector = new StepStatsCollector(
-        run_metadata->mutable_step_stats(), &cost_models_);
-    run_state.collector = args.stats_collector;
-  }
-
-  for (const auto& item : executors_and_keys->items) {
-    item.executor->RunAsync(args, barrier->Get());
-  }
-
-  WaitForNotification(&run_state, run_options.timeout_in_ms() > 0
-                                      ? run_options.timeout_in_ms()
-                                      : operation_timeout_in_ms_);
-
-  {
-    mutex_lock l(run_state.mu_);
-    TF_RETURN_IF_ERROR(run_state.status);
+    step_stats = run_metadata->mutable_step_stats();
   }
+  TF_RETURN_IF_ERROR(RunExecutors(
+      executors_and_keys, run_state_args.handle, nullptr,
+      run_options.timeout_in_ms() > 0 ? run_options.timeout_in_ms()
+                                      : operation_timeout_in_ms_,
+      step_stats, &run_state));
 
   // Receive outputs.
   TF_RETURN_IF_ERROR(
@@ -401,8 +375,12 @@ Status DirectSession::PRunSetup(const std::vector<string>& input_names,
     LogMemory::RecordStep(args.step_id, run_state_args.handle);
   }
 
-  if (options_.config.graph_options().build_cost_model()) {
-    run_state->collector = new StepStatsCollector(nullptr, &cost_models_);
+  const bool build_cost_model =
+      options_.config.graph_options().build_cost_model();
+  MeasuredCosts* measured_costs = executors_and_keys->MeasureStep();
+  if (build_cost_model || measured_costs != nullptr) {
+    run_state->collector = new StepStatsCollector(
+        nullptr, build_cost_model ? &cost_models_ : nullptr, measured_costs);
     args.stats_collector = run_state->collector;
   }
 
@@ -499,6 +477,154 @@ Status DirectSession::PRun(const string& handle, const NamedTensorList& inputs,
   return s;
 }
 
+Status DirectSession::MakeCallable(const std::vector<string>& feed_names,
+                                   const std::vector<string>& fetch_names,
+                                   const std::vector<string>& target_nodes,
+                                   CallableHandle* handle) {
+  {
+    mutex_lock l(graph_def_lock_);
+    if (!graph_created_) {
+      return errors::InvalidArgument(
+          "Session was not created with a graph before MakeCallable()!");
+    }
+  }
+
+  // Bind the feeds and fetches to the call frame, so that running the
+  // callable does no lookups by name.
+  std::shared_ptr<Callable> callable(new Callable);
+  RunStateArgs run_state_args;
+  run_state_args.use_function_convention = true;
+  TF_RETURN_IF_ERROR(GetOrCreateExecutors(feed_names, fetch_names,
+                                          target_nodes,
+                                          &callable->executors_and_keys,
+                                          &run_state_args));
+
+  mutex_lock l(callables_lock_);
+  *handle = next_callable_handle_++;
+  callables_[*handle] = std::move(callable);
+  return Status::OK();
+}
+
+Status DirectSession::RunCallable(CallableHandle handle,
+                                  const std::vector<Tensor>& feed_tensors,
+                                  std::vector<Tensor>* fetch_tensors) {
+  std::shared_ptr<Callable> callable;
+  {
+    mutex_lock l(callables_lock_);
+    auto it = callables_.find(handle);
+    if (it == callables_.end()) {
+      return errors::InvalidArgument("No such callable handle: ", handle);
+    }
+    callable = it->second;
+  }
+  const ExecutorsAndKeys* executors_and_keys = callable->executors_and_keys;
+  if (feed_tensors.size() != executors_and_keys->input_types.size()) {
+    return errors::InvalidArgument(
+        "Expected ", executors_and_keys->input_types.size(),
+        " feed tensors, but got ", feed_tensors.size());
+  }
+  FunctionCallFrame call_frame(executors_and_keys->input_types,
+                               executors_and_keys->output_types);
+  TF_RETURN_IF_ERROR(call_frame.SetArgs(feed_tensors));
+
+  // The executors of a single partition send no tensors through the
+  // rendezvous, so a step may reuse one that an earlier step left intact.
+  const bool reuse_rendez = executors_and_keys->items.size() == 1;
+  IntraProcessRendezvous* rendez = nullptr;
+  if (reuse_rendez) {
+    mutex_lock l(callable->mu);
+    if (!callable->rendez_pool.empty()) {
+      rendez = callable->rendez_pool.back();
+      callable->rendez_pool.pop_back();
+    }
+  }
+  if (rendez == nullptr) {
+    rendez = new IntraProcessRendezvous(device_mgr_.get());
+  }
+
+  // run_state owns the rendezvous, and waits for the executors when it is
+  // destroyed, before call_frame is.
+  RunState run_state({}, {});
+  run_state.rendez = rendez;
+  Status s = RunExecutors(executors_and_keys,
+                          strings::StrCat("callable_", handle), &call_frame,
+                          operation_timeout_in_ms_, nullptr, &run_state);
+  // A failed step aborts the rendezvous, so only one of a successful step
+  // goes back to the pool.
+  if (s.ok() && reuse_rendez) {
+    rendez->Ref();
+    mutex_lock l(callable->mu);
+    callable->rendez_pool.push_back(rendez);
+  }
+  TF_RETURN_IF_ERROR(s);
+
+  // Receive outputs. A fetch that was not set was dead.
+  s = call_frame.GetRetvals(fetch_tensors);
+  if (!s.ok()) {
+    fetch_tensors->clear();
+    return errors::InvalidArgument("A tensor returned by callable ", handle,
+                                   " was not valid: ", s.error_message());
+  }
+  return Status::OK();
+}
+
+Status DirectSession::ReleaseCallable(CallableHandle handle) {
+  mutex_lock l(callables_lock_);
+  if (callables_.erase(handle) == 0) {
+    return errors::InvalidArgument("No such callable handle: ", handle);
+  }
+  return Status::OK();
+}
+
+Status DirectSession::RunExecutors(const ExecutorsAndKeys* executors_and_keys,
+                                   const string& step_handle,
+                                   FunctionCallFrame* call_frame,
+                                   int64 timeout_in_ms, StepStats* step_stats,
+                                   RunState* run_state) {
+  // Start parallel Executors.
+  const int num_executors = executors_and_keys->items.size();
+  ExecutorBarrier* barrier = new ExecutorBarrier(
+      num_executors, run_state->rendez, [run_state](const Status& ret) {
+        {
+          mutex_lock l(run_state->mu_);
+          run_state->status.Update(ret);
+        }
+        run_state->executors_done.Notify();
+      });
+
+  Executor::Args args;
+  args.step_id = step_id_counter_.fetch_add(1);
+  args.rendezvous = run_state->rendez;
+  args.call_frame = call_frame;
+  args.cancellation_manager = cancellation_manager_;
+  args.runner = [this](Executor::Args::Closure c) { SchedClosure(c); };
+  if (LogMemory::IsEnabled()) {
+    LogMemory::RecordStep(args.step_id, step_handle);
+  }
+
+  const bool build_cost_model =
+      options_.config.graph_options().build_cost_model();
+  MeasuredCosts* measured_costs = executors_and_keys->MeasureStep();
+  if (step_stats != nullptr) {
+    args.stats_collector =
+        new StepStatsCollector(step_stats, &cost_models_, measured_costs);
+  } else if (build_cost_model || measured_costs != nullptr) {
+    // Only the costs of the nodes are collected.
+    args.stats_collector = new StepStatsCollector(
+        nullptr, build_cost_model ? &cost_models_ : nullptr, measured_costs);
+  }
+  run_state->collector = args.stats_collector;
+
+  for (const auto& item : executors_and_keys->items) {
+    item.executor->RunAsync(args, barrier->Get());
+  }
+
+  WaitForNotification(run_state, timeout_in_ms);
+
+  mutex_lock l(run_state->mu_);
+  return run_state->status;
+}
+
 Status DirectSession::SendInputs(const NamedTensorList& inputs,
                                  const ExecutorsAndKeys* executors_and_keys,
                                  IntraProcessRendezvous* rendez) {
@@ -628,20 +754,26 @@ Status DirectSession::GetOrCreateExecutors(
     RunStateArgs* run_state_args) {
   // Sort the inputs and outputs, so we don't create separate
   // executors when a user passes in the same inputs/outputs in
-  // different orders.
+  // different orders. The inputs and outputs bound to a call frame
+  // keep their order, which is that of the frame.
   //
   // We could consider some other signature instead of sorting that
   // preserves the same property to avoid the sort in the future.
+  const bool use_function_convention =
+      run_state_args->use_function_convention;
   std::vector<string> inputs_sorted(inputs.begin(), inputs.end());
   std::vector<string> outputs_sorted(outputs.begin(), outputs.end());
   std::vector<string> tn_sorted(target_nodes.begin(), target_nodes.end());
-  std::sort(inputs_sorted.begin(), inputs_sorted.end());
-  std::sort(outputs_sorted.begin(), outputs_sorted.end());
+  if (!use_function_convention) {
+    std::sort(inputs_sorted.begin(), inputs_sorted.end());
+    std::sort(outputs_sorted.begin(), outputs_sorted.end());
+  }
   std::sort(tn_sorted.begin(), tn_sorted.end());
 
-  const string key = strings::StrCat(str_util::Join(inputs_sorted, ","), "->",
-                                     str_util::Join(outputs_sorted, ","), "/",
-                                     str_util::Join(tn_sorted, ","));
+  const string key = strings::StrCat(
+      use_function_convention ? "callable:" : "",
+      str_util::Join(inputs_sorted, ","), "->",
+      str_util::Join(outputs_sorted, ","), "/", str_util::Join(tn_sorted, ","));
 
   // Set the handle.
   {
@@ -669,6 +801,8 @@ Status DirectSession::GetOrCreateExecutors(
 
   std::unique_ptr<ExecutorsAndKeys> ek(new ExecutorsAndKeys);
   ek->func_defs = fdefs;
+  ek->input_types = run_state_args->input_types;
+  ek->output_types = run_state_args->output_types;
   if (run_state_args->is_partial_run) {
     ek->graph = run_state_args->graph;
     ek->name_to_node = new NameNodeMap;
@@ -688,6 +822,12 @@ Status DirectSession::GetOrCreateExecutors(
     }
   }
   ek->items.reserve(graphs.size());
+  const GraphOptions& graph_options = options_.config.graph_options();
+  if (graph_options.build_cost_model() ||
+      graph_options.schedule_with_cost_model()) {
+    mutex_lock l(graph_def_lock_);
+    ek->measured_costs = MeasuredCosts::ForGraph(graph_def_);
+  }
   auto runner = [this](Executor::Args::Closure c) { SchedClosure(c); };
   const auto& optimizer_opts =
       options_.config.graph_options().optimizer_options();
@@ -709,6 +849,7 @@ Status DirectSession::GetOrCreateExecutors(
     LocalExecutorParams params;
     params.device = device;
     params.function_library = item->flib;
+    params.plan_memory = options_.config.graph_options().plan_memory();
     auto lib = item->flib;
     auto opseg = device->op_segment();
     params.create_kernel = [this, lib, opseg](const NodeDef& ndef,
@@ -733,12 +874,18 @@ Status DirectSession::GetOrCreateExecutors(
       }
     };
 
-    optimizer.Optimize(lib, &partition_graph);
-    s = ValidateMemoryTypes(DeviceType(device->device_type()), partition_graph);
+    s = optimizer.Optimize(lib, &partition_graph);
+    if (s.ok()) {
+      s = ValidateMemoryTypes(DeviceType(device->device_type()),
+                              partition_graph);
+    }
     if (!s.ok()) {
       delete partition_graph;
       return s;
     }
+    if (graph_options.schedule_with_cost_model()) {
+      params.measured_costs = ek->measured_costs;
+    }
     // NewLocalExecutor takes ownership of *partition_graph.
     s = NewLocalExecutor(params, partition_graph, &item->executor);
     if (!s.ok()) {
@@ -750,13 +897,17 @@ Status DirectSession::GetOrCreateExecutors(
   //
   // We always use the first device as the device name portion of the
   // key, even if we're feeding another graph.
-  for (const string& input : inputs) {
-    ek->input_keys[input] = GetRendezvousKey(
-        input, device_set_.client_device()->attributes(), FrameAndIter(0, 0));
-  }
-  for (const string& output : outputs) {
-    ek->output_keys[output] = GetRendezvousKey(
-        output, device_set_.client_device()->attributes(), FrameAndIter(0, 0));
+  if (!use_function_convention) {
+    for (const string& input : inputs) {
+      ek->input_keys[input] =
+          GetRendezvousKey(input, device_set_.client_device()->attributes(),
+                           FrameAndIter(0, 0));
+    }
+    for (const string& output : outputs) {
+      ek->output_keys[output] =
+          GetRendezvousKey(output, device_set_.client_device()->attributes(),
+                           FrameAndIter(0, 0));
+    }
   }
 
   // Reacquire the lock, try to insert into the map.
@@ -817,9 +968,35 @@ Status DirectSession::CreateGraphs(gtl::ArraySlice<string> feeds,
     CopyGraph(*graph.get(), run_state_args->graph);
   }
 
+  // Record the types of the feeds and fetches bound to the call frame.
+  // Names that are not found are left DT_INVALID, for
+  // RewriteGraphForExecution() to report.
+  if (run_state_args->use_function_convention) {
+    NameNodeMap name_to_node;
+    for (Node* n : graph->nodes()) {
+      name_to_node[n->name()] = n;
+    }
+    auto tensor_type = [&name_to_node](const string& name) {
+      TensorId id(ParseTensorName(name));
+      auto it = name_to_node.find(id.first);
+      if (it == name_to_node.end() || id.second < 0 ||
+          id.second >= it->second->num_outputs()) {
+        return DT_INVALID;
+      }
+      return BaseType(it->second->output_type(id.second));
+    };
+    for (const string& feed : feeds) {
+      run_state_args->input_types.push_back(tensor_type(feed));
+    }
+    for (const string& fetch : fetches) {
+      run_state_args->output_types.push_back(tensor_type(fetch));
+    }
+  }
+
   TF_RETURN_IF_ERROR(subgraph::RewriteGraphForExecution(
       graph.get(), feeds, fetches, target_nodes,
-      device_set_.client_device()->attributes()));
+      device_set_.client_device()->attributes(),
+      run_state_args->use_function_convention));
 
   // Run the simple placer after rewriting the graph.
   std::unordered_map<string, int32> node_name_to_cost_map;
@@ -918,6 +1095,16 @@ Status DirectSession::CreateGraphs(gtl::ArraySlice<string> feeds,
   return ::tensorflow::Status::OK();
 }
 
+MeasuredCosts* DirectSession::ExecutorsAndKeys::MeasureStep() const {
+  if (measured_costs == nullptr) return nullptr;
+  const int64 step = num_steps.fetch_add(1, std::memory_order_relaxed);
+  if (step < MeasuredCosts::kMeasuredSteps ||
+      step % MeasuredCosts::kMeasureInterval == 0) {
+    return measured_costs;
+  }
+  return nullptr;
+}
+
 DirectSession::RunState::~RunState() {
   if (rendez != nullptr) {
     if (!executors_done.HasBeenNotified()) {
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -41,6 +42,7 @@ limitations under the License.
 namespace tensorflow {
 
 class CostModel;
+class MeasuredCosts;
 class Device;
 class ThreadPool;
 
@@ -78,6 +80,17 @@ class DirectSession : public Session {
   ::tensorflow::Status PRun(const string& handle, const NamedTensorList& inputs,
                             const std::vector<string>& output_names,
                             std::vector<Tensor>* outputs) override;
+
+  // NOTE: Callables are experimental and subject to change.
+  ::tensorflow::Status MakeCallable(const std::vector<string>& feed_names,
+                                    const std::vector<string>& fetch_names,
+                                    const std::vector<string>& target_nodes,
+                                    CallableHandle* handle) override;
+  ::tensorflow::Status RunCallable(CallableHandle handle,
+                                   const std::vector<Tensor>& feed_tensors,
+                                   std::vector<Tensor>* fetch_tensors) override;
+  ::tensorflow::Status ReleaseCallable(CallableHandle handle) override;
+
   ::tensorflow::Status Close() override;
 
   // NOTE: This is a temporary api that is only meant to enable testing.
@@ -104,6 +117,9 @@ class DirectSession : public Session {
   // 'items' is the executor for a partition of the graph bundled with
   // its dependent library runtime. 'input_keys' are the rendezvous keys
   // for the feeds and 'output_keys' are rendezvous keys for the fetches.
+  // The executors of callables instead exchange their feeds and fetches
+  // through a FunctionCallFrame, whose argument and return value types
+  // are 'input_types' and 'output_types'.
   struct ExecutorsAndKeys {
     FunctionLibraryDefinition* func_defs = nullptr;
     Graph* graph = nullptr;
@@ -111,6 +127,17 @@ class DirectSession : public Session {
     std::vector<PerPartitionExecutorsAndLib> items;
     std::unordered_map<string, string> input_keys;
     std::unordered_map<string, string> output_keys;
+    DataTypeVector input_types;
+    DataTypeVector output_types;
+    // The measured costs of the nodes of the session's graph, if they are
+    // built or used for scheduling.  Not owned.
+    MeasuredCosts* measured_costs = nullptr;
+    // The number of steps started, to choose the ones measured.
+    mutable std::atomic<int64> num_steps{0};
+
+    // Returns the costs to record the node times of a new step in, or
+    // null if the step is not measured.
+    MeasuredCosts* MeasureStep() const;
 
     ~ExecutorsAndKeys() {
       for (auto item : items) {
@@ -149,10 +176,33 @@ class DirectSession : public Session {
     ~RunState();
   };
 
+  // If 'use_function_convention' is true, the feeds and fetches are bound
+  // to the call frame of each step, in the order they are passed, and
+  // their types are returned in 'input_types' and 'output_types'.
   struct RunStateArgs {
     bool is_partial_run = false;
+    bool use_function_convention = false;
     string handle;
     Graph* graph = nullptr;
+    DataTypeVector input_types;
+    DataTypeVector output_types;
+  };
+
+  // A Callable holds everything RunCallable() needs that does not change
+  // from one step to the next: the executors, which take the feeds and
+  // fetches from the call frame, and the rendezvous objects that later
+  // steps may reuse.
+  struct Callable {
+    ExecutorsAndKeys* executors_and_keys = nullptr;  // Owned by executors_.
+    mutex mu;
+    // Holds a reference to each rendezvous.
+    std::vector<IntraProcessRendezvous*> rendez_pool GUARDED_BY(mu);
+
+    ~Callable() {
+      for (IntraProcessRendezvous* rendez : rendez_pool) {
+        rendez->Unref();
+      }
+    }
   };
 
   // Retrieves an already existing set of executors to run 'inputs' and
@@ -171,6 +221,17 @@ class DirectSession : public Session {
                                     std::unordered_map<string, Graph*>* outputs,
                                     RunStateArgs* run_state_args);
 
+  // Runs one step of the executors in 'executors_and_keys', which
+  // exchange tensors through 'run_state->rendez' and, for callables,
+  // 'call_frame', and waits for them to finish or for 'timeout_in_ms' to
+  // pass. Records the stats of the nodes in 'step_stats' if it is not
+  // null.
+  ::tensorflow::Status RunExecutors(const ExecutorsAndKeys* executors_and_keys,
+                                    const string& step_handle,
+                                    FunctionCallFrame* call_frame,
+                                    int64 timeout_in_ms, StepStats* step_stats,
+                                    RunState* run_state);
+
   ::tensorflow::Status ExtendLocked(const GraphDef& graph)
       EXCLUSIVE_LOCKS_REQUIRED(graph_def_lock_);
 
@@ -228,6 +289,13 @@ class DirectSession : public Session {
   std::unordered_map<string, RunState*> partial_runs_
       GUARDED_BY(executor_lock_);
 
+  mutex callables_lock_;  // protects callables_
+  // Holds mappings from callable handle to callable. A RunCallable() holds
+  // a reference to the callable, so that it may be released concurrently.
+  std::unordered_map<CallableHandle, std::shared_ptr<Callable>> callables_
+      GUARDED_BY(callables_lock_);
+  CallableHandle next_callable_handle_ GUARDED_BY(callables_lock_) = 0;
+
   CancellationManager* cancellation_manager_;
 
   // Saves and restores device placements for stateful nodes.
@@ -21,6 +21,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/measured_costs.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -36,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/device_name_utils.h"
@@ -166,6 +168,146 @@ TEST_F(DirectSessionMinusAXTest, TestConcurrency) {
   delete tp;
 }
 
+TEST_F(DirectSessionMinusAXTest, RunCallable) {
+  Initialize({1, 2, 3, 4});
+  std::unique_ptr<Session> session(CreateSession());
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(
+      session->MakeCallable({x_}, {y_ + ":0", y_neg_ + ":0"}, {}, &handle));
+
+  // Run it several times with different feeds.
+  for (int i = 0; i < 3; ++i) {
+    Tensor t(DT_FLOAT, TensorShape({2, 1}));
+    test::FillValues<float>(&t, {5, 6 + static_cast<float>(i)});
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->RunCallable(handle, {t}, &outputs));
+    ASSERT_EQ(2, outputs.size());
+    // Expect outputs to be; 1*5 + 2*(6+i), 3*5 + 4*(6+i)
+    test::ExpectTensorEqual<float>(
+        test::AsTensor<float>({17.0f + 2 * i, 39.0f + 4 * i}, {2, 1}),
+        outputs[0]);
+    test::ExpectTensorEqual<float>(
+        test::AsTensor<float>({-17.0f - 2 * i, -39.0f - 4 * i}, {2, 1}),
+        outputs[1]);
+  }
+
+  // Wrong number of feeds.
+  std::vector<Tensor> outputs;
+  Status s = session->RunCallable(handle, {}, &outputs);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+  s = session->RunCallable(handle, {Tensor(DT_FLOAT, TensorShape({2, 1}))},
+                           &outputs);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  EXPECT_TRUE(errors::IsInvalidArgument(session->ReleaseCallable(handle)));
+}
+
+TEST_F(DirectSessionMinusAXTest, RunCallableConcurrently) {
+  Initialize({1, 2, 3, 4});
+  std::unique_ptr<Session> session(CreateSession());
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable({x_}, {y_ + ":0"}, {}, &handle));
+
+  // Run the callable 1000 times in 4 different threads concurrently, each
+  // with its own feed.
+  thread::ThreadPool* tp = new thread::ThreadPool(Env::Default(), "test", 4);
+  auto fn = [&session, handle](float v) {
+    for (int i = 0; i < 1000; ++i) {
+      std::vector<Tensor> outputs;
+      TF_ASSERT_OK(session->RunCallable(
+          handle, {test::AsTensor<float>({v, v}, {2, 1})}, &outputs));
+      ASSERT_EQ(1, outputs.size());
+      auto mat = outputs[0].matrix<float>();
+      EXPECT_FLOAT_EQ(3 * v, mat(0, 0));
+      EXPECT_FLOAT_EQ(7 * v, mat(1, 0));
+    }
+  };
+  for (int i = 0; i < 4; ++i) {
+    tp->Schedule([fn, i]() { fn(i); });
+  }
+  delete tp;
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
+TEST_F(DirectSessionMinusAXTest, RunCallableWithError) {
+  Initialize({1, 2, 3, 4});
+  std::unique_ptr<Session> session(CreateSession());
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable({x_}, {y_ + ":0"}, {}, &handle));
+
+  // A feed of the wrong shape makes the MatMul fail, after which the
+  // callable still works.
+  std::vector<Tensor> outputs;
+  Status s = session->RunCallable(
+      handle, {test::AsTensor<float>({1, 1, 1}, {3, 1})}, &outputs);
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+  TF_ASSERT_OK(session->RunCallable(
+      handle, {test::AsTensor<float>({1, 1}, {2, 1})}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_FLOAT_EQ(3.0, outputs[0].matrix<float>()(0, 0));
+}
+
+TEST(DirectSessionTest, RunCallableOnOneDevice) {
+  Graph g(OpRegistry::Global());
+  Node* a =
+      test::graph::Constant(&g, test::AsTensor<float>({0, 0, 0, 0}, {2, 2}));
+  Node* x = test::graph::Constant(&g, test::AsTensor<float>({0, 0}, {2, 1}));
+  Node* y = test::graph::Matmul(&g, a, x, false, false);
+  Node* y_neg = test::graph::Unary(&g, "Neg", y);
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 1;
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  // The feeds and fetches are not in sorted order.
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable({x->name(), a->name()},
+                                     {y_neg->name() + ":0", y->name() + ":0"},
+                                     {}, &handle));
+  const Tensor a_tensor = test::AsTensor<float>({1, 2, 3, 4}, {2, 2});
+  std::vector<Tensor> outputs;
+  for (int i = 0; i < 3; ++i) {
+    // A failed step does not affect the ones after it.
+    Status s = session->RunCallable(
+        handle, {test::AsTensor<float>({1, 1, 1}, {3, 1}), a_tensor},
+        &outputs);
+    EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+    // Nor does a feed of the wrong type.
+    s = session->RunCallable(
+        handle, {test::AsTensor<int32>({5, 6}, {2, 1}), a_tensor}, &outputs);
+    EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+
+    for (int j = 0; j < 2; ++j) {
+      const Tensor x_tensor =
+          test::AsTensor<float>({5, 6 + static_cast<float>(i)}, {2, 1});
+      TF_ASSERT_OK(
+          session->RunCallable(handle, {x_tensor, a_tensor}, &outputs));
+      ASSERT_EQ(2, outputs.size());
+      test::ExpectTensorEqual<float>(
+          test::AsTensor<float>({-17.0f - 2 * i, -39.0f - 4 * i}, {2, 1}),
+          outputs[0]);
+      test::ExpectTensorEqual<float>(
+          test::AsTensor<float>({17.0f + 2 * i, 39.0f + 4 * i}, {2, 1}),
+          outputs[1]);
+    }
+  }
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
 TEST_F(DirectSessionMinusAXTest, TestPerSessionThreads) {
   Initialize({1, 2, 3, 4});
 
@@ -716,5 +858,194 @@ TEST(DirectSessionTest, CostModelTest) {
   }
 }
 
+TEST(DirectSessionTest, PlanMemory) {
+  // y = (x * x + x) * (x * x), whose intermediate values can share buffers.
+  Graph g(OpRegistry::Global());
+  Node* x = test::graph::Constant(&g, test::AsTensor<float>({0, 0, 0}));
+  Node* square = test::graph::Binary(&g, "Mul", x, x);
+  Node* sum = test::graph::Binary(&g, "Add", square, x);
+  Node* y = test::graph::Binary(&g, "Mul", sum, square);
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 1;
+  options.config.mutable_graph_options()->set_plan_memory(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  TF_ASSERT_OK(session->Create(def));
+
+  // The first run records the sizes of the buffers and the later ones use
+  // the plan, including a run with larger buffers than planned.
+  const std::vector<std::vector<float>> feeds = {
+      {1, 2, 3}, {-1, 0, 4}, {2, 2, 2}, {1, 2, 3, 4, 5}, {3, 1, 0}};
+  for (const std::vector<float>& feed : feeds) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({{x->name(), test::AsTensor<float>(feed)}},
+                              {y->name() + ":0"}, {}, &outputs));
+    std::vector<float> expected;
+    for (float v : feed) expected.push_back((v * v + v) * (v * v));
+    test::ExpectTensorEqual<float>(test::AsTensor<float>(expected), outputs[0]);
+  }
+}
+
+// Returns the output of an Inception-style network on a [batch, 256] input.
+// Each module runs branches of different depths side by side, one of them
+// a chain of scalar ops, and adds them up.
+static Node* InceptionStyle(Graph* g, int batch, int num_modules) {
+  auto random = [g](std::initializer_list<int64> dims) {
+    Tensor t(DT_FLOAT, TensorShape(dims));
+    t.flat<float>().setRandom();
+    t.flat<float>() = t.flat<float>() * 0.1f;
+    return test::graph::Constant(g, t);
+  };
+  Node* x = random({batch, 256});
+  for (int i = 0; i < num_modules; ++i) {
+    Node* wide = test::graph::Matmul(g, x, random({256, 256}), false, false);
+    Node* deep = test::graph::Matmul(
+        g, test::graph::Matmul(g, x, random({256, 64}), false, false),
+        random({64, 256}), false, false);
+    Node* scale = random({});
+    for (int j = 0; j < 8; ++j) {
+      scale = test::graph::Binary(g, j % 2 ? "Add" : "Mul", scale, random({}));
+    }
+    x = test::graph::Binary(
+        g, "Add", test::graph::Binary(g, "Add", wide, deep),
+        test::graph::Binary(g, "Mul", x, scale));
+  }
+  return x;
+}
+
+TEST(DirectSessionTest, ScheduleWithCostModelOfEarlierSession) {
+  Graph g(OpRegistry::Global());
+  const string fetch = InceptionStyle(&g, 4, 2)->name() + ":0";
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  auto run = [&def, &fetch](const SessionOptions& options, int steps) {
+    std::unique_ptr<Session> session(NewSession(options));
+    TF_CHECK_OK(session->Create(def));
+    std::vector<Tensor> outputs;
+    for (int i = 0; i < steps; ++i) {
+      TF_CHECK_OK(session->Run({}, {fetch}, {}, &outputs));
+    }
+    return outputs[0];
+  };
+  const Tensor expected = run(SessionOptions(), 1);
+
+  SessionOptions measure;
+  measure.config.mutable_graph_options()->set_build_cost_model(true);
+  run(measure, 3);
+  // The measurements outlive the session.
+  int num_ops = 0;
+  for (Node* n : g.nodes()) {
+    n->set_assigned_device_name("/job:localhost/replica:0/task:0/cpu:0");
+    if (n->IsOp()) ++num_ops;
+  }
+  CostModel cm(false);
+  cm.InitFromGraph(g);
+  EXPECT_EQ(num_ops, MeasuredCosts::ForGraph(def)->AddTo(g, &cm));
+
+  SessionOptions schedule;
+  schedule.config.mutable_graph_options()->set_schedule_with_cost_model(true);
+  test::ExpectTensorNear<float>(expected, run(schedule, 3), 1e-5);
+}
+
+TEST(DirectSessionTest, ScheduleWithCostModelMeasuresOwnSteps) {
+  Graph g(OpRegistry::Global());
+  const string fetch = InceptionStyle(&g, 2, 3)->name() + ":0";
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  std::vector<Tensor> expected;
+  {
+    std::unique_ptr<Session> session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(session->Create(def));
+    TF_ASSERT_OK(session->Run({}, {fetch}, {}, &expected));
+  }
+  EXPECT_EQ(0, MeasuredCosts::ForGraph(def)->num_steps());
+
+  // Without build_cost_model, the session measures the first steps itself
+  // and its executors schedule the later ones with the measurements.
+  SessionOptions options;
+  options.config.mutable_graph_options()->set_schedule_with_cost_model(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  TF_ASSERT_OK(session->Create(def));
+  const int num_steps = MeasuredCosts::kMeasuredSteps + 5;
+  for (int i = 0; i < num_steps; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {fetch}, {}, &outputs));
+    test::ExpectTensorNear<float>(expected[0], outputs[0], 1e-5);
+  }
+  EXPECT_EQ(MeasuredCosts::kMeasuredSteps,
+            MeasuredCosts::ForGraph(def)->num_steps());
+}
+
+// Runs InceptionStyle() in a session scheduling with the costs measured
+// by an earlier session if "schedule_with_cost_model" is true.
+static void BM_InceptionStyle(int iters, int schedule_with_cost_model) {
+  testing::StopTiming();
+  Graph g(OpRegistry::Global());
+  const string fetch = InceptionStyle(&g, 32, 4)->name() + ":0";
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+  std::vector<Tensor> outputs;
+  if (schedule_with_cost_model) {
+    SessionOptions options;
+    options.config.mutable_graph_options()->set_build_cost_model(true);
+    std::unique_ptr<Session> session(NewSession(options));
+    TF_CHECK_OK(session->Create(def));
+    for (int i = 0; i < 10; ++i) {
+      TF_CHECK_OK(session->Run({}, {fetch}, {}, &outputs));
+    }
+  }
+  SessionOptions options;
+  options.config.mutable_graph_options()->set_schedule_with_cost_model(
+      schedule_with_cost_model);
+  std::unique_ptr<Session> session(NewSession(options));
+  TF_CHECK_OK(session->Create(def));
+  TF_CHECK_OK(session->Run({}, {fetch}, {}, &outputs));
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(session->Run({}, {fetch}, {}, &outputs));
+  }
+  testing::StopTiming();
+}
+BENCHMARK(BM_InceptionStyle)->Arg(0)->Arg(1);
+
+// Feeds a scalar to a single Neg node and fetches the result, through
+// Run() if "use_callable" is false and through RunCallable() otherwise.
+static void BM_FeedFetch(int iters, bool use_callable) {
+  testing::StopTiming();
+  Graph g(OpRegistry::Global());
+  Node* x = test::graph::Constant(&g, test::AsScalar<float>(0));
+  Node* y = test::graph::Unary(&g, "Neg", x);
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 1;
+  std::unique_ptr<Session> session(NewSession(options));
+  TF_CHECK_OK(session->Create(def));
+  const string fetch = y->name() + ":0";
+  Session::CallableHandle handle;
+  TF_CHECK_OK(session->MakeCallable({x->name()}, {fetch}, {}, &handle));
+  const Tensor feed = test::AsScalar<float>(1);
+  std::vector<Tensor> outputs;
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    if (use_callable) {
+      TF_CHECK_OK(session->RunCallable(handle, {feed}, &outputs));
+    } else {
+      TF_CHECK_OK(session->Run({{x->name(), feed}}, {fetch}, {}, &outputs));
+    }
+  }
+  testing::StopTiming();
+}
+
+static void BM_FeedFetchRun(int iters) { BM_FeedFetch(iters, false); }
+BENCHMARK(BM_FeedFetchRun);
+
+static void BM_FeedFetchCallable(int iters) { BM_FeedFetch(iters, true); }
+BENCHMARK(BM_FeedFetchCallable);
+
 }  // namespace
 }  // namespace tensorflow
@@ -22,6 +22,8 @@ limitations under the License.
 #include <unordered_map>
 #include <vector>
 
+#include "tensorflow/core/common_runtime/measured_costs.h"
+#include "tensorflow/core/common_runtime/memory_planner.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
@@ -39,6 +41,8 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
@@ -220,7 +224,10 @@ typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 class ExecutorImpl : public Executor {
  public:
   ExecutorImpl(const LocalExecutorParams& p, const Graph* g)
-      : params_(p), graph_(g), initial_pending_counts_(graph_->num_node_ids()) {
+      : params_(p),
+        graph_(g),
+        initial_pending_counts_(graph_->num_node_ids()),
+        initial_atomic_pending_counts_(graph_->num_node_ids()) {
     CHECK(p.create_kernel != nullptr);
     CHECK(p.delete_kernel != nullptr);
   }
@@ -249,12 +256,39 @@ class ExecutorImpl : public Executor {
   // a tensor buffer.
   Status SetAllocAttrs();
 
+  // Creates memory_planner_ for the outputs of the nodes that are
+  // allocated with the default attributes, live from the node that
+  // produces them to their last consumer in reverse post order.
+  void CreateMemoryPlanner();
+
+  // How ready nodes are ordered and dispatched, derived from measured
+  // times.  Immutable, so that running steps keep using the one they
+  // started with while a newer one replaces it.
+  struct CostSchedule {
+    // By node id, the measured time of the longest path from the node to
+    // the sink, including the node.
+    std::vector<int64> critical_path_micros;
+    // By node id, whether the node is expensive: from its measured time
+    // if it was measured, and from its kernel otherwise.
+    std::vector<bool> is_expensive;
+  };
+
+  // Returns the schedule derived from the times measured in "cm".
+  std::shared_ptr<const CostSchedule> BuildCostSchedule(
+      const CostModel& cm) const;
+
+  // Returns the schedule for a new step, or null if the nodes should be
+  // scheduled without measured costs.  Rebuilds it first if enough steps
+  // have been measured since it was built.
+  std::shared_ptr<const CostSchedule> GetCostSchedule();
+
   void RunAsync(const Args& args, DoneCallback done) override;
 
  private:
   friend class ExecutorState;
 
-  static void InitializePending(const Graph* graph, PendingCounts* counts);
+  static void InitializePending(const Graph* graph, PendingCounts* counts,
+                                AtomicPendingCounts* atomic_counts);
 
   // Owned.
   LocalExecutorParams params_;
@@ -271,12 +305,31 @@ class ExecutorImpl : public Executor {
 
   PendingCounts initial_pending_counts_;
 
+  // True iff the graph has no Merge, Enter, Exit or NextIteration nodes.
+  // Such a graph only ever runs in iteration 0 of the root frame and every
+  // node becomes ready exactly when all its inputs have arrived, so
+  // ExecutorState propagates outputs through "initial_atomic_pending_counts_"
+  // without taking its mutex.
+  bool lock_free_propagation_ = false;
+  AtomicPendingCounts initial_atomic_pending_counts_;
+
+  // The schedule returned by GetCostSchedule(), and the number of steps
+  // measured in params_.measured_costs when it was built.
+  mutex cost_schedule_mu_;
+  std::shared_ptr<const CostSchedule> cost_schedule_
+      GUARDED_BY(cost_schedule_mu_);
+  int64 cost_schedule_steps_ GUARDED_BY(cost_schedule_mu_) = 0;
+
   // The number of inputs for each frame in this graph. This is static
   // information of the graph.
   std::unordered_map<string, int> frame_input_count_;
 
   std::vector<AllocatorAttributes> output_attrs_;
 
+  // Plans the outputs of each step into one arena if
+  // params_.plan_memory, indexed as output_attrs_.
+  std::unique_ptr<MemoryPlanner> memory_planner_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
 
@@ -289,18 +342,25 @@ Status ExecutorImpl::Initialize() {
   total_input_tensors_ = 0;
   total_output_tensors_ = 0;
 
-  InitializePending(graph_, &initial_pending_counts_);
+  InitializePending(graph_, &initial_pending_counts_,
+                    &initial_atomic_pending_counts_);
 
   // Cache this value so we make this virtual function call once, rather
   // that O(# steps * # nodes per step) times.
   device_record_tensor_accesses_ =
       params_.device->RequiresRecordingAccessedTensors();
 
+  lock_free_propagation_ = true;
+
   // Preprocess every node in the graph to create an instance of op
   // kernel for each node;
   for (const Node* n : graph_->nodes()) {
     const int id = n->id();
 
+    if (IsMerge(n) || IsEnter(n) || IsExit(n) || IsNextIteration(n)) {
+      lock_free_propagation_ = false;
+    }
+
     // See if this node is a root node, and if so, add to root_nodes_
     const int num_in_edges = n->in_edges().size();
     if (num_in_edges == 0) {
@@ -346,7 +406,102 @@ Status ExecutorImpl::Initialize() {
     }
   }
   if (!s.ok()) return s;
-  return SetAllocAttrs();
+  s = SetAllocAttrs();
+  if (!s.ok()) return s;
+  // Graphs with control flow run nodes more than once per step, and other
+  // devices may still be using a buffer after it is freed.
+  if (params_.plan_memory && lock_free_propagation_ &&
+      params_.device->device_type() == DEVICE_CPU) {
+    CreateMemoryPlanner();
+  }
+  return s;
+}
+
+std::shared_ptr<const ExecutorImpl::CostSchedule>
+ExecutorImpl::BuildCostSchedule(const CostModel& cm) const {
+  // Nodes measured to take less time than this are cheaper to run on the
+  // thread that made them ready than to hand to another thread.
+  static const int64 kExpensiveMicros = 10;
+
+  const int num_nodes = graph_->num_node_ids();
+  CostSchedule* schedule = new CostSchedule;
+  schedule->critical_path_micros.resize(num_nodes, 0);
+  schedule->is_expensive.resize(num_nodes, false);
+  // In post order every node comes after the nodes its out edges lead to,
+  // except for the back edges of loops, which are ignored.
+  std::vector<Node*> order;
+  GetPostOrder(*graph_, &order);
+  for (const Node* n : order) {
+    const int id = n->id();
+    const NodeItem& item = nodes_[id];
+    schedule->is_expensive[id] = item.kernel_is_expensive;
+    // The measured time of an asynchronous kernel includes the time it
+    // waits for other devices, so it is not counted.
+    int64 micros = 0;
+    if (n->IsOp() && !item.kernel_is_async && cm.TotalCount(n) > 0) {
+      micros = cm.TimeEstimate(n).value();
+      schedule->is_expensive[id] = micros >= kExpensiveMicros;
+    }
+    int64 longest_after = 0;
+    for (const Edge* e : n->out_edges()) {
+      longest_after = std::max(
+          longest_after, schedule->critical_path_micros[e->dst()->id()]);
+    }
+    schedule->critical_path_micros[id] = micros + longest_after;
+  }
+  return std::shared_ptr<const CostSchedule>(schedule);
+}
+
+std::shared_ptr<const ExecutorImpl::CostSchedule>
+ExecutorImpl::GetCostSchedule() {
+  const MeasuredCosts* costs = params_.measured_costs;
+  if (costs == nullptr) return nullptr;
+  const int64 num_steps = costs->num_steps();
+  mutex_lock l(cost_schedule_mu_);
+  // The first schedule is built as soon as one step has been measured.
+  const int64 min_new_steps =
+      cost_schedule_steps_ == 0 ? 1 : MeasuredCosts::kMeasuredSteps;
+  if (num_steps - cost_schedule_steps_ >= min_new_steps) {
+    CostModel cm(false);
+    cm.InitFromGraph(*graph_);
+    if (costs->AddTo(*graph_, &cm) > 0) {
+      cost_schedule_ = BuildCostSchedule(cm);
+    }
+    cost_schedule_steps_ = num_steps;
+  }
+  return cost_schedule_;
+}
+
+void ExecutorImpl::CreateMemoryPlanner() {
+  std::vector<Node*> order;
+  GetReversePostOrder(*graph_, &order);
+  std::vector<int> position(graph_->num_node_ids(), -1);
+  for (int i = 0; i < order.size(); ++i) position[order[i]->id()] = i;
+
+  std::vector<std::pair<int, int>> live_ranges(total_output_tensors_,
+                                               std::make_pair(-1, -1));
+  for (const Node* n : graph_->nodes()) {
+    const NodeItem& item = nodes_[n->id()];
+    for (int i = 0; i < item.num_outputs; ++i) {
+      if (!IsRefType(item.output_type(i)) &&
+          output_attrs_[item.output_attr_start + i].value == 0) {
+        live_ranges[item.output_attr_start + i] =
+            std::make_pair(position[n->id()], position[n->id()]);
+      }
+    }
+  }
+  for (const Edge* e : graph_->edges()) {
+    if (e->IsControlEdge()) continue;
+    const int index =
+        nodes_[e->src()->id()].output_attr_start + e->src_output();
+    if (live_ranges[index].first >= 0) {
+      live_ranges[index].second =
+          std::max(live_ranges[index].second, position[e->dst()->id()]);
+    }
+  }
+  memory_planner_.reset(new MemoryPlanner(
+      params_.device->GetAllocator(AllocatorAttributes()),
+      std::move(live_ranges)));
 }
 
 Status ExecutorImpl::SetAllocAttrs() {
@@ -484,6 +639,11 @@ class ExecutorState {
           outstanding_frame_count(0),
           counts_(impl->graph_->num_node_ids()) {
       counts_.InitializeFrom(impl->initial_pending_counts_);
+      if (impl->lock_free_propagation_) {
+        atomic_counts.reset(
+            new AtomicPendingCounts(impl->graph_->num_node_ids()));
+        atomic_counts->InitializeFrom(impl->initial_atomic_pending_counts_);
+      }
     }
 
     // The state of an iteration.
@@ -503,6 +663,11 @@ class ExecutorState {
 
     // The number of outstanding frames for each iteration.
     int outstanding_frame_count;
+
+    // Set iff ExecutorImpl::lock_free_propagation_.  Replaces counts_, and
+    // may be updated without holding ExecutorState::mu_.
+    std::unique_ptr<AtomicPendingCounts> atomic_counts;
+
     int pending(int id) { return counts_.pending(id); }
     int decrement_pending(int id, int v) {
       return counts_.decrement_pending(id, v);
@@ -653,6 +818,8 @@ class ExecutorState {
   const ExecutorImpl* impl_;
   CancellationManager* cancellation_manager_;
   Executor::Args::Runner runner_;
+  // If not null, ready nodes are scheduled by ScheduleReadyByCost().
+  const std::shared_ptr<const ExecutorImpl::CostSchedule> cost_schedule_;
 
   // Owned.
 
@@ -663,6 +830,10 @@ class ExecutorState {
   // dumped for diagnostic purposes.
   bool dumped_on_error_ = false;
 
+  // The allocators of the outputs of this step, if the executor plans
+  // them.
+  StepMemory* step_memory_ = nullptr;
+
   // The root frame in which the execution of this step is started.
   FrameState* root_frame_;
 
@@ -733,6 +904,12 @@ class ExecutorState {
                     int64 iter, const EntryVector& outputs,
                     TaggedNodeSeq* ready) EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Same as ActivateNode() for iteration 0 of the root frame, using
+  // atomic pending counts instead of mu_.
+  // REQUIRES: impl_->lock_free_propagation_
+  void ActivateNodeLockFree(const Node* node, const bool is_dead,
+                            const EntryVector& outputs, TaggedNodeSeq* ready);
+
   // Process a ready node in current thread.
   void Process(TaggedNode node, int64 scheduled_usec);
 
@@ -764,6 +941,13 @@ class ExecutorState {
   void ScheduleReady(const TaggedNodeSeq& ready,
                      std::deque<TaggedNode>* inline_ready);
 
+  // ScheduleReady() for steps with a cost schedule.  Nodes are started in
+  // decreasing order of their critical paths.  If 'inline_ready' is null,
+  // the inexpensive nodes run together in one closure.
+  void ScheduleReadyByCost(const TaggedNodeSeq& ready,
+                           std::deque<TaggedNode>* inline_ready,
+                           int64 scheduled_usec);
+
   // Provide debugging output about an outstanding node in the executor.
   void DumpCompletedNodeState(const int node_id, const Entry* input_vector);
   void DumpPendingNodeState(const int node_id, const Entry* input_vector,
@@ -799,6 +983,7 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       impl_(impl),
       cancellation_manager_(args.cancellation_manager),
       runner_(args.runner),
+      cost_schedule_(impl->GetCostSchedule()),
       num_outstanding_ops_(0) {
   // We start the entire execution in iteration 0 of the root frame
   // so let us create the root frame and the state for iteration 0.
@@ -813,6 +998,10 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
 
   VLOG(2) << "Create frame: " << root_frame_->frame_name;
 
+  if (impl->memory_planner_ != nullptr) {
+    step_memory_ = impl->memory_planner_->NewStep();
+  }
+
   // Initialize the iteration.
   IterationState* iter_state = new IterationState(impl);
   root_frame_->iterations[0] = iter_state;
@@ -831,10 +1020,13 @@ ExecutorState::~ExecutorState() {
   }
 
   delete slice_reader_cache_;
+
+  if (step_memory_ != nullptr) step_memory_->Done();
 }
 
 void ExecutorImpl::InitializePending(const Graph* graph,
-                                     PendingCounts* counts) {
+                                     PendingCounts* counts,
+                                     AtomicPendingCounts* atomic_counts) {
   for (int id = 0; id < graph->num_node_ids(); id++) {
     counts->set_initial_count(id, 0, 0);  // Make sure everything is initialized
   }
@@ -857,6 +1049,7 @@ void ExecutorImpl::InitializePending(const Graph* graph,
       initial_count = num_in_edges;
     }
     counts->set_initial_count(id, initial_count, num_in_edges);
+    atomic_counts->set_initial_count(id, num_in_edges);
   }
 }
 
@@ -964,7 +1157,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
 
     // TODO(misard) Replace with a finer-grain enabling flag once we
     // add better optional debugging support.
-    if (VLOG_IS_ON(1)) {
+    if (VLOG_IS_ON(1) && !impl_->lock_free_propagation_) {
       mutex_lock l(mu_);
 
       IterationState* iter_state = input_frame->GetIteration(input_iter);
@@ -1012,7 +1205,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         }
         // TODO(misard) Replace with a finer-grain enabling flag once we
         // add better optional debugging support.
-        if (VLOG_IS_ON(1)) {
+        if (VLOG_IS_ON(1) && !impl_->lock_free_propagation_) {
           mutex_lock l(mu_);
           IterationState* iter_state = input_frame->GetIteration(input_iter);
           iter_state->mark_completed(id);
@@ -1029,6 +1222,10 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       params.is_input_dead = is_input_dead;
       params.output_attr_array =
           gtl::vector_as_array(&impl_->output_attrs_) + item.output_attr_start;
+      if (step_memory_ != nullptr) {
+        params.output_allocator_array =
+            step_memory_->allocators() + item.output_attr_start;
+      }
 
       if (item.kernel_is_async) {
         // Asynchronous computes.
@@ -1052,7 +1249,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
           }
           // TODO(misard) Replace with a finer-grain enabling flag once we
           // add better optional debugging support.
-          if (VLOG_IS_ON(1)) {
+          if (VLOG_IS_ON(1) && !impl_->lock_free_propagation_) {
             mutex_lock l(mu_);
             tagged_node.input_frame->GetIteration(tagged_node.input_iter)
                 ->mark_completed(tagged_node.node->id());
@@ -1113,7 +1310,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       }
       // TODO(misard) Replace with a finer-grain enabling flag once we
       // add better optional debugging support.
-      if (VLOG_IS_ON(1)) {
+      if (VLOG_IS_ON(1) && !impl_->lock_free_propagation_) {
         mutex_lock l(mu_);
         IterationState* iter_state = input_frame->GetIteration(input_iter);
         iter_state->mark_completed(id);
@@ -1307,6 +1504,16 @@ void ExecutorState::PropagateOutputs(const TaggedNode& tagged_node,
   // Propagates outputs along out edges, and puts newly ready nodes
   // into the ready queue.
   ready->clear();
+  if (impl_->lock_free_propagation_) {
+    // There is only the root frame with a single iteration, whose
+    // lifetime is the step's, so there is no frame or iteration
+    // bookkeeping to do.
+    DCHECK_EQ(input_frame, root_frame_);
+    DCHECK_EQ(input_iter, 0);
+    ActivateNodeLockFree(tagged_node.node, tagged_node.is_dead, outputs,
+                         ready);
+    return;
+  }
   {
     FrameState* output_frame = input_frame;
     int64 output_iter = input_iter;
@@ -1414,6 +1621,38 @@ void ExecutorState::ActivateNode(const Node* node, const bool is_dead,
   }
 }
 
+void ExecutorState::ActivateNodeLockFree(const Node* node,
+                                         const bool is_dead,
+                                         const EntryVector& outputs,
+                                         TaggedNodeSeq* ready) {
+  const NodeItem* nodes = impl_->nodes_;
+  IterationState* iter_state = root_frame_->GetIteration(0);
+  AtomicPendingCounts* counts = iter_state->atomic_counts.get();
+  Entry* input_tensors = iter_state->input_tensors;
+  for (const Edge* e : node->out_edges()) {
+    const Node* dst_node = e->dst();
+    const int dst_id = dst_node->id();
+    const int src_slot = e->src_output();
+    const bool is_control_edge = e->IsControlEdge();
+
+    // As in ActivateNode(), a non-merge node waits for all of its inputs
+    // even if it already knows it is dead, so that every input tensor is
+    // cleaned up.  The input must be stored before the pending count is
+    // decremented: whoever takes the count to zero reads it.
+    if (!is_control_edge) {
+      const int dst_loc = nodes[dst_id].input_start + e->dst_input();
+      input_tensors[dst_loc] = outputs[src_slot];
+    }
+    const bool edge_dead =
+        is_dead || (!is_control_edge && !outputs[src_slot].has_value);
+    bool dst_dead = false;
+    if (counts->decrement_pending(dst_id, edge_dead, &dst_dead)) {
+      dst_dead = dst_dead && !IsControlTrigger(dst_node);
+      ready->push_back(TaggedNode(dst_node, root_frame_, 0, dst_dead));
+    }
+  }
+}
+
 void ExecutorState::ActivateNexts(FrameState* frame, int64 iter,
                                   TaggedNodeSeq* ready) {
   // Propagate the deferred NextIteration nodes to the new iteration.
@@ -1515,6 +1754,10 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
   if (stats_collector_) {
     scheduled_usec = nodestats::NowInUsec();
   }
+  if (cost_schedule_ != nullptr) {
+    ScheduleReadyByCost(ready, inline_ready, scheduled_usec);
+    return;
+  }
   if (inline_ready == nullptr) {
     // Schedule to run all the ready ops in thread pool.
     for (auto& tagged_node : ready) {
@@ -1552,6 +1795,47 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
   }
 }
 
+void ExecutorState::ScheduleReadyByCost(const TaggedNodeSeq& ready,
+                                        std::deque<TaggedNode>* inline_ready,
+                                        int64 scheduled_usec) {
+  const ExecutorImpl::CostSchedule& schedule = *cost_schedule_;
+  std::deque<TaggedNode> inexpensive;
+  TaggedNodeSeq expensive;
+  for (auto& tagged_node : ready) {
+    if (tagged_node.is_dead ||
+        !schedule.is_expensive[tagged_node.node->id()]) {
+      inexpensive.push_back(tagged_node);
+    } else {
+      expensive.push_back(tagged_node);
+    }
+  }
+  const std::vector<int64>& path = schedule.critical_path_micros;
+  auto longer_path = [&path](const TaggedNode& a, const TaggedNode& b) {
+    return path[a.node->id()] > path[b.node->id()];
+  };
+  std::stable_sort(inexpensive.begin(), inexpensive.end(), longer_path);
+  std::stable_sort(expensive.begin(), expensive.end(), longer_path);
+
+  // This thread runs the most critical expensive node itself if it has
+  // nothing else to do.
+  size_t first_dispatched = 0;
+  if (inline_ready != nullptr && inline_ready->empty() &&
+      inexpensive.empty() && !expensive.empty()) {
+    inline_ready->push_back(expensive[0]);
+    first_dispatched = 1;
+  }
+  for (size_t i = first_dispatched; i < expensive.size(); ++i) {
+    runner_(std::bind(&ME::Process, this, expensive[i], scheduled_usec));
+  }
+  if (inexpensive.empty()) return;
+  if (inline_ready != nullptr) {
+    inline_ready->insert(inline_ready->end(), inexpensive.begin(),
+                         inexpensive.end());
+  } else {
+    runner_(std::bind(&ME::ProcessInline, this, std::move(inexpensive)));
+  }
+}
+
 void ExecutorState::DumpCompletedNodeState(const int node_id,
                                            const Entry* input_vector) {
   const NodeItem& node_item = impl_->nodes_[node_id];
@@ -1635,17 +1919,26 @@ void ExecutorState::DumpActiveNodeState(const int node_id,
 }
 
 void ExecutorState::DumpIterationState(IterationState* iteration) {
-  // Dump any waiting nodes that are holding on to tensors.
-  for (int i = 0; i < impl_->graph_->num_node_ids(); ++i) {
-    if (iteration->node_state(i) == PendingCounts::PENDING_NOTREADY ||
-        iteration->node_state(i) == PendingCounts::PENDING_READY) {
-      DumpPendingNodeState(i, iteration->input_tensors, false);
+  if (iteration->atomic_counts != nullptr) {
+    // Only pending counts are tracked in this mode, not node states.
+    for (int i = 0; i < impl_->graph_->num_node_ids(); ++i) {
+      if (iteration->atomic_counts->pending(i) > 0) {
+        DumpPendingNodeState(i, iteration->input_tensors, false);
+      }
     }
-  }
-  // Then the active nodes.
-  for (int i = 0; i < impl_->graph_->num_node_ids(); ++i) {
-    if (iteration->node_state(i) == PendingCounts::STARTED) {
-      DumpActiveNodeState(i, iteration->input_tensors);
+  } else {
+    // Dump any waiting nodes that are holding on to tensors.
+    for (int i = 0; i < impl_->graph_->num_node_ids(); ++i) {
+      if (iteration->node_state(i) == PendingCounts::PENDING_NOTREADY ||
+          iteration->node_state(i) == PendingCounts::PENDING_READY) {
+        DumpPendingNodeState(i, iteration->input_tensors, false);
+      }
+    }
+    // Then the active nodes.
+    for (int i = 0; i < impl_->graph_->num_node_ids(); ++i) {
+      if (iteration->node_state(i) == PendingCounts::STARTED) {
+        DumpActiveNodeState(i, iteration->input_tensors);
+      }
     }
   }
   // Show all input tensors in use.
@@ -27,6 +27,7 @@ limitations under the License.
 
 namespace tensorflow {
 
+class MeasuredCosts;
 class StepStatsCollector;
 
 // Executor runs a graph computation.
@@ -125,6 +126,17 @@ struct LocalExecutorParams {
   // when the executor is deleted.
   std::function<Status(const NodeDef&, OpKernel**)> create_kernel;
   std::function<void(OpKernel*)> delete_kernel;
+
+  // If true and the device is a CPU, the outputs of each step after the
+  // first are placed in one arena planned from the sizes and lifetimes of
+  // the outputs of the first step.  See MemoryPlanner.
+  bool plan_memory = false;
+
+  // If not null, the execution times of the nodes of the graph measured
+  // so far.  Nodes with the longest measured paths after them are started
+  // first, and nodes measured as cheap are not dispatched on threads of
+  // their own.  The times are re-read as more steps are measured.
+  MeasuredCosts* measured_costs = nullptr;
 };
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
                                       const Graph* graph, Executor** executor);
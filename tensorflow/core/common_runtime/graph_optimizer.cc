@@ -18,7 +18,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/constant_folding.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/elementwise_fusion.h"
 #include "tensorflow/core/graph/optimizer_cse.h"
+#include "tensorflow/core/lib/core/errors.h"
 
 namespace tensorflow {
 
@@ -29,11 +31,15 @@ GraphOptimizer::GraphOptimizer(const OptimizerOptions& opts) : opts_(opts) {
   if (opts_.opt_level() >= OptimizerOptions::L2) {
     opts_.set_do_constant_folding(true);
   }
+  if (opts_.opt_level() >= OptimizerOptions::L3) {
+    opts_.set_do_elementwise_fusion(true);
+  }
 }
 
 GraphOptimizer::~GraphOptimizer() {}
 
-void GraphOptimizer::Optimize(FunctionLibraryRuntime* runtime, Graph** graph) {
+Status GraphOptimizer::Optimize(FunctionLibraryRuntime* runtime,
+                                Graph** graph) {
   Graph* g = *graph;
   for (const Node* n : g->nodes()) {
     if (n->IsControlFlow()) {
@@ -75,6 +81,14 @@ void GraphOptimizer::Optimize(FunctionLibraryRuntime* runtime, Graph** graph) {
       DumpGraph("OptimizeCSE", g);
       changed = true;
     }
+    if (opts_.do_elementwise_fusion()) {
+      bool fused = false;
+      TF_RETURN_IF_ERROR(FuseElementwiseOps(g, nullptr, &fused));
+      if (fused) {
+        DumpGraph("FuseElementwiseOps", g);
+        changed = true;
+      }
+    }
     if (opts_.do_function_inlining() && ExpandInlineFunctions(runtime, g)) {
       DumpGraph("ExpandInlineFunctions", g);
       changed = true;
@@ -87,6 +101,7 @@ void GraphOptimizer::Optimize(FunctionLibraryRuntime* runtime, Graph** graph) {
   delete g;
   *graph = copy;
   DumpGraph("ReCopy", *graph);
+  return Status::OK();
 }
 
 }  // end namespace tensorflow
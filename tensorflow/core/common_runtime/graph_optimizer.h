@@ -29,8 +29,9 @@ class GraphOptimizer {
   ~GraphOptimizer();
 
   // Applies optimization passes specified in 'opts' to 'graph'.
-  // Maybe replace *graph with a new graph object.
-  void Optimize(FunctionLibraryRuntime* runtime, Graph** graph);
+  // Maybe replace *graph with a new graph object.  Returns an error, leaving
+  // a valid but possibly partly optimized graph in *graph, if a pass fails.
+  Status Optimize(FunctionLibraryRuntime* runtime, Graph** graph);
 
  private:
   OptimizerOptions opts_;
@@ -73,6 +73,7 @@ Benchmark::Benchmark(const string& device, Graph* g,
   params.delete_kernel = [](OpKernel* kernel) {
     DeleteNonCachedKernel(kernel);
   };
+  params.plan_memory = options->config.graph_options().plan_memory();
 
   if (init) {
     Executor* init_exec;
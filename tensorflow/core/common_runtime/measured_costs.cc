@@ -0,0 +1,88 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/measured_costs.h"
+
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+
+namespace {
+
+string CostKey(const Node* node) {
+  return strings::StrCat(node->assigned_device_name(), ";", node->name());
+}
+
+}  // namespace
+
+MeasuredCosts* MeasuredCosts::ForGraph(const GraphDef& graph_def) {
+  static mutex mu;
+  static std::unordered_map<uint64, MeasuredCosts*>* costs =
+      new std::unordered_map<uint64, MeasuredCosts*>;
+  // Sessions add default attributes to the graph, and the attributes
+  // need not serialize in the same order, so only the structure of the
+  // graph is used.
+  uint64 fingerprint = 0;
+  for (const NodeDef& node : graph_def.node()) {
+    string key = strings::StrCat(node.name(), ";", node.op(), ";",
+                                 node.device());
+    for (const string& input : node.input()) {
+      strings::StrAppend(&key, ";", input);
+    }
+    fingerprint = Hash64(key.data(), key.size(), fingerprint);
+  }
+  mutex_lock l(mu);
+  MeasuredCosts*& graph_costs = (*costs)[fingerprint];
+  if (graph_costs == nullptr) graph_costs = new MeasuredCosts;
+  return graph_costs;
+}
+
+const int64 MeasuredCosts::kMeasuredSteps;
+const int64 MeasuredCosts::kMeasureInterval;
+
+void MeasuredCosts::RecordStep(
+    const std::vector<std::pair<const Node*, Microseconds>>& node_times) {
+  std::vector<string> keys;
+  keys.reserve(node_times.size());
+  for (const auto& node_time : node_times) {
+    keys.push_back(CostKey(node_time.first));
+  }
+  {
+    mutex_lock l(mu_);
+    for (size_t i = 0; i < node_times.size(); ++i) {
+      Cost& cost = costs_[keys[i]];
+      ++cost.count;
+      cost.time += node_times[i].second;
+    }
+  }
+  num_steps_.fetch_add(1, std::memory_order_relaxed);
+}
+
+int MeasuredCosts::AddTo(const Graph& g, CostModel* cm) const {
+  int num_measured = 0;
+  mutex_lock l(mu_);
+  for (const Node* n : g.nodes()) {
+    if (!n->IsOp()) continue;
+    auto it = costs_.find(CostKey(n));
+    if (it == costs_.end()) continue;
+    cm->RecordCount(n, it->second.count);
+    cm->RecordTime(n, it->second.time);
+    ++num_measured;
+  }
+  return num_measured;
+}
+
+}  // namespace tensorflow
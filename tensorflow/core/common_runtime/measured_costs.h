@@ -0,0 +1,85 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_MEASURED_COSTS_H_
+#define TENSORFLOW_COMMON_RUNTIME_MEASURED_COSTS_H_
+
+#include <atomic>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/graph/costmodel.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/types.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The measured execution times of the nodes of one graph, by device and
+// node name, so that they outlive the partition graphs and sessions they
+// were measured in.  Thread-safe.
+class MeasuredCosts {
+ public:
+  // Returns the costs of the nodes of "graph_def", shared by every session
+  // of this process that runs a graph with the same nodes, ops, devices
+  // and inputs.  Never deleted.
+  static MeasuredCosts* ForGraph(const GraphDef& graph_def);
+
+  MeasuredCosts() {}
+
+  // Sessions measure the node times of the first kMeasuredSteps steps of
+  // a graph, and of one in kMeasureInterval steps after that to follow
+  // changes.  Executors scheduling with the measurements re-read them
+  // once kMeasuredSteps more steps have been measured.
+  static const int64 kMeasuredSteps = 10;
+  static const int64 kMeasureInterval = 100;
+
+  // Records the execution times of the nodes measured in one step, a
+  // node and its time each.
+  void RecordStep(const std::vector<std::pair<const Node*, Microseconds>>&
+                      node_times);
+
+  // Returns the number of steps recorded by RecordStep().
+  int64 num_steps() const {
+    return num_steps_.load(std::memory_order_relaxed);
+  }
+
+  // Records the number of measured executions and their total time of
+  // each node of "g" in "cm", which must have been initialized from "g".
+  // Returns the number of nodes with measurements.
+  int AddTo(const Graph& g, CostModel* cm) const;
+
+ private:
+  struct Cost {
+    int32 count = 0;
+    Microseconds time = Microseconds(0);
+  };
+
+  std::atomic<int64> num_steps_{0};
+  mutable mutex mu_;
+  // Keyed by the assigned device and the name of the node.
+  std::unordered_map<string, Cost> costs_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MeasuredCosts);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_MEASURED_COSTS_H_
@@ -0,0 +1,79 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/measured_costs.h"
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/costmodel.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+const char kCpu0[] = "/job:localhost/replica:0/task:0/cpu:0";
+const char kCpu1[] = "/job:localhost/replica:0/task:0/cpu:1";
+
+class MeasuredCostsTest : public ::testing::Test {
+ protected:
+  MeasuredCostsTest() : g_(OpRegistry::Global()) {
+    a_ = test::graph::Constant(&g_, test::AsScalar<float>(1));
+    b_ = test::graph::Identity(&g_, a_);
+    a_->set_assigned_device_name(kCpu0);
+    b_->set_assigned_device_name(kCpu0);
+    test::graph::ToGraphDef(&g_, &def_);
+  }
+
+  Graph g_;
+  Node* a_;
+  Node* b_;
+  GraphDef def_;
+};
+
+TEST_F(MeasuredCostsTest, SharedBySameGraph) {
+  MeasuredCosts* costs = MeasuredCosts::ForGraph(def_);
+  EXPECT_EQ(costs, MeasuredCosts::ForGraph(def_));
+  GraphDef other = def_;
+  other.mutable_node(0)->set_name("other");
+  EXPECT_NE(costs, MeasuredCosts::ForGraph(other));
+}
+
+TEST_F(MeasuredCostsTest, AddToAveragesMeasurements) {
+  MeasuredCosts costs;
+  costs.RecordStep({{a_, Microseconds(10)}});
+  costs.RecordStep({{a_, Microseconds(30)}});
+  EXPECT_EQ(2, costs.num_steps());
+  CostModel cm(false);
+  cm.InitFromGraph(g_);
+  EXPECT_EQ(1, costs.AddTo(g_, &cm));
+  EXPECT_EQ(2, cm.TotalCount(a_));
+  EXPECT_EQ(Microseconds(20), cm.TimeEstimate(a_));
+  EXPECT_EQ(0, cm.TotalCount(b_));
+}
+
+TEST_F(MeasuredCostsTest, KeyedByDevice) {
+  MeasuredCosts costs;
+  costs.RecordStep({{b_, Microseconds(5)}});
+  // The same node on another device has not been measured.
+  b_->set_assigned_device_name(kCpu1);
+  CostModel cm(false);
+  cm.InitFromGraph(g_);
+  EXPECT_EQ(0, costs.AddTo(g_, &cm));
+}
+
+}  // namespace
+}  // namespace tensorflow
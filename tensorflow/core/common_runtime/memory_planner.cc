@@ -0,0 +1,267 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Alignment of the arena and of the slices, a multiple of the 32 bytes
+// tensors ask for and of the cache line size.
+const int64 kAlignment = 64;
+
+int64 AlignedSize(int64 num_bytes) {
+  return (num_bytes + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+bool Overlap(const std::pair<int, int>& a, const std::pair<int, int>& b) {
+  return a.first <= b.second && b.first <= a.second;
+}
+
+}  // namespace
+
+// Hands out the buffer of one output of a step.
+class StepMemory::BufferAllocator : public Allocator {
+ public:
+  string Name() override { return "step_memory"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return step_->Allocate(index_, alignment, num_bytes);
+  }
+
+  void DeallocateRaw(void* ptr) override { step_->Deallocate(ptr); }
+
+  StepMemory* step_ = nullptr;
+  int index_ = -1;
+};
+
+MemoryPlanner::MemoryPlanner(Allocator* allocator,
+                             std::vector<std::pair<int, int>> live_ranges)
+    : allocator_(allocator), live_ranges_(std::move(live_ranges)) {}
+
+MemoryPlanner::~MemoryPlanner() {}
+
+StepMemory* MemoryPlanner::NewStep() {
+  mutex_lock l(mu_);
+  if (plan_ != nullptr) {
+    if (plan_->arena_bytes == 0) return nullptr;
+    return new StepMemory(this, plan_, false);
+  }
+  if (recording_) return nullptr;
+  recording_ = true;
+  return new StepMemory(this, nullptr, true);
+}
+
+bool MemoryPlanner::planned() const {
+  mutex_lock l(mu_);
+  return plan_ != nullptr;
+}
+
+int64 MemoryPlanner::planned_bytes() const {
+  mutex_lock l(mu_);
+  return plan_ == nullptr ? 0 : plan_->arena_bytes;
+}
+
+int64 MemoryPlanner::unplanned_peak_bytes() const {
+  mutex_lock l(mu_);
+  return unplanned_peak_bytes_;
+}
+
+void MemoryPlanner::SetSizes(const std::vector<int64>& sizes,
+                             int64 peak_bytes) {
+  std::shared_ptr<Plan> plan(new Plan);
+  plan->sizes = sizes;
+  plan->arena_bytes = AssignOffsets(sizes, live_ranges_, &plan->offsets);
+  int num_planned = 0;
+  for (int64 offset : plan->offsets) {
+    if (offset >= 0) ++num_planned;
+  }
+  VLOG(1) << "Planned " << num_planned << " of " << live_ranges_.size()
+          << " outputs into an arena of " << plan->arena_bytes
+          << " bytes; they took at most " << peak_bytes
+          << " bytes at once without planning";
+  mutex_lock l(mu_);
+  plan_ = plan;
+  unplanned_peak_bytes_ = peak_bytes;
+}
+
+int64 MemoryPlanner::AssignOffsets(
+    const std::vector<int64>& sizes,
+    const std::vector<std::pair<int, int>>& live_ranges,
+    std::vector<int64>* offsets) {
+  offsets->assign(sizes.size(), -1);
+  std::vector<int> order;
+  for (int i = 0; i < sizes.size(); ++i) {
+    if (sizes[i] > 0 && live_ranges[i].first >= 0) order.push_back(i);
+  }
+  std::sort(order.begin(), order.end(), [&sizes, &live_ranges](int a, int b) {
+    if (sizes[a] != sizes[b]) return sizes[a] > sizes[b];
+    if (live_ranges[a].first != live_ranges[b].first) {
+      return live_ranges[a].first < live_ranges[b].first;
+    }
+    return a < b;
+  });
+
+  int64 arena_bytes = 0;
+  std::vector<int> placed;
+  std::vector<std::pair<int64, int64>> taken;
+  for (int i : order) {
+    const int64 size = AlignedSize(sizes[i]);
+    // The byte ranges of the placed buffers alive at the same time as i.
+    taken.clear();
+    for (int j : placed) {
+      if (Overlap(live_ranges[i], live_ranges[j])) {
+        taken.emplace_back((*offsets)[j],
+                           (*offsets)[j] + AlignedSize(sizes[j]));
+      }
+    }
+    std::sort(taken.begin(), taken.end());
+    int64 offset = 0;
+    for (const auto& range : taken) {
+      if (offset + size <= range.first) break;
+      offset = std::max(offset, range.second);
+    }
+    (*offsets)[i] = offset;
+    arena_bytes = std::max(arena_bytes, offset + size);
+    placed.push_back(i);
+  }
+  return arena_bytes;
+}
+
+StepMemory::StepMemory(MemoryPlanner* planner,
+                       std::shared_ptr<const MemoryPlanner::Plan> plan,
+                       bool record_sizes)
+    : planner_(planner),
+      allocator_(planner->allocator_),
+      plan_(std::move(plan)),
+      record_sizes_(record_sizes) {
+  const int num_buffers = planner->live_ranges_.size();
+  buffer_allocators_.reset(new BufferAllocator[num_buffers]);
+  allocator_ptrs_.resize(num_buffers, nullptr);
+  for (int i = 0; i < num_buffers; ++i) {
+    if (record_sizes_ ? planner->live_ranges_[i].first >= 0
+                      : plan_->offsets[i] >= 0) {
+      buffer_allocators_[i].step_ = this;
+      buffer_allocators_[i].index_ = i;
+      allocator_ptrs_[i] = &buffer_allocators_[i];
+    }
+  }
+  if (record_sizes_) {
+    sizes_.resize(num_buffers, 0);
+  } else {
+    arena_ = static_cast<char*>(
+        allocator_->AllocateRaw(kAlignment, plan_->arena_bytes));
+  }
+}
+
+StepMemory::~StepMemory() {
+  DCHECK(live_slices_.empty());
+  DCHECK(live_fallbacks_.empty());
+  if (arena_ != nullptr) allocator_->DeallocateRaw(arena_);
+}
+
+void StepMemory::Done() {
+  if (record_sizes_) {
+    std::vector<int64> sizes;
+    int64 peak_bytes;
+    {
+      mutex_lock l(mu_);
+      sizes = sizes_;
+      peak_bytes = peak_bytes_;
+    }
+    planner_->SetSizes(sizes, peak_bytes);
+  } else if (VLOG_IS_ON(2)) {
+    mutex_lock l(mu_);
+    VLOG(2) << "Step took at most " << peak_bytes_ << " bytes in an arena of "
+            << plan_->arena_bytes << " bytes, with " << num_fallbacks_
+            << " outputs not in the arena";
+  }
+  planner_ = nullptr;
+  Unref();
+}
+
+int64 StepMemory::num_fallbacks() const {
+  mutex_lock l(mu_);
+  return num_fallbacks_;
+}
+
+int64 StepMemory::peak_bytes() const {
+  mutex_lock l(mu_);
+  return peak_bytes_;
+}
+
+void* StepMemory::Allocate(int index, size_t alignment, size_t num_bytes) {
+  void* ptr = nullptr;
+  if (arena_ != nullptr && num_bytes > 0 && num_bytes <= plan_->sizes[index] &&
+      alignment <= kAlignment) {
+    // The slice is free if the live slice starting at or after it starts
+    // after its end, and the one before it ends before its start.
+    const int64 begin = plan_->offsets[index];
+    const int64 end = begin + num_bytes;
+    mutex_lock l(mu_);
+    auto next = live_slices_.lower_bound(begin);
+    if ((next == live_slices_.end() || next->first >= end) &&
+        (next == live_slices_.begin() || std::prev(next)->second <= begin)) {
+      live_slices_.emplace(begin, end);
+      ptr = arena_ + begin;
+      live_bytes_ += num_bytes;
+      peak_bytes_ = std::max(peak_bytes_, live_bytes_);
+    }
+  }
+  if (ptr == nullptr) {
+    ptr = allocator_->AllocateRaw(alignment, num_bytes);
+    if (ptr == nullptr) return nullptr;
+    mutex_lock l(mu_);
+    live_fallbacks_.emplace(ptr, num_bytes);
+    live_bytes_ += num_bytes;
+    peak_bytes_ = std::max(peak_bytes_, live_bytes_);
+    if (record_sizes_) {
+      sizes_[index] = std::max<int64>(sizes_[index], num_bytes);
+    } else {
+      ++num_fallbacks_;
+    }
+  }
+  Ref();
+  return ptr;
+}
+
+void StepMemory::Deallocate(void* ptr) {
+  char* p = static_cast<char*>(ptr);
+  if (arena_ != nullptr && p >= arena_ && p < arena_ + plan_->arena_bytes) {
+    mutex_lock l(mu_);
+    auto it = live_slices_.find(p - arena_);
+    DCHECK(it != live_slices_.end());
+    live_bytes_ -= it->second - it->first;
+    live_slices_.erase(it);
+  } else {
+    {
+      mutex_lock l(mu_);
+      auto it = live_fallbacks_.find(ptr);
+      DCHECK(it != live_fallbacks_.end());
+      live_bytes_ -= it->second;
+      live_fallbacks_.erase(it);
+    }
+    allocator_->DeallocateRaw(ptr);
+  }
+  Unref();
+}
+
+}  // namespace tensorflow
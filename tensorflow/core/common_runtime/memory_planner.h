@@ -0,0 +1,162 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_MEMORY_PLANNER_H_
+#define TENSORFLOW_COMMON_RUNTIME_MEMORY_PLANNER_H_
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class StepMemory;
+
+// Plans the buffers of the outputs of a graph into one arena per step.
+//
+// Each buffer has a live range, the first and last positions in an
+// execution order of the graph at which it is in use.  The first step runs
+// with the device allocator while the size of every buffer is recorded.
+// The buffers are then given offsets in an arena so that buffers with
+// overlapping live ranges do not overlap in memory, and every later step
+// allocates one arena and hands out slices of it.
+//
+// The plan is only a prediction: a slice is handed out only if it is as
+// large as the request and none of the buffers sharing its bytes is still
+// alive, which happens when the steps do not follow the execution order
+// or a buffer outlives its last use.  Other requests go to the device
+// allocator, so planning never changes results.
+class MemoryPlanner {
+ public:
+  // "live_ranges[i]" is the range of positions in which buffer i is in
+  // use, or (-1, -1) if buffer i is never planned.  Arenas and buffers
+  // that are not planned come from "allocator".
+  MemoryPlanner(Allocator* allocator,
+                std::vector<std::pair<int, int>> live_ranges);
+  ~MemoryPlanner();
+
+  // Returns the allocators of one step, or nullptr if the step should use
+  // the device allocator because another step is recording the sizes.  The
+  // caller must call Done() on the result when the step has finished.
+  StepMemory* NewStep();
+
+  // Returns true once the sizes have been recorded and the plan made.
+  bool planned() const;
+  // The size of the arena of each step, once planned.
+  int64 planned_bytes() const;
+  // The largest number of bytes the buffers took at once in the step the
+  // sizes were recorded in, with the device allocator.
+  int64 unplanned_peak_bytes() const;
+
+  // Sets "*offsets" to the offsets of buffers of "sizes" and "live_ranges"
+  // in an arena, packing the largest buffers first at the lowest offset
+  // that does not overlap a placed buffer with an overlapping live range.
+  // Buffers of size 0 get offset -1.  Returns the size of the arena.
+  // Exposed for testing.
+  static int64 AssignOffsets(
+      const std::vector<int64>& sizes,
+      const std::vector<std::pair<int, int>>& live_ranges,
+      std::vector<int64>* offsets);
+
+ private:
+  friend class StepMemory;
+
+  struct Plan {
+    std::vector<int64> sizes;
+    std::vector<int64> offsets;
+    int64 arena_bytes = 0;
+  };
+
+  // Makes the plan from the sizes recorded by a step.
+  void SetSizes(const std::vector<int64>& sizes, int64 peak_bytes);
+
+  Allocator* const allocator_;
+  const std::vector<std::pair<int, int>> live_ranges_;
+
+  mutable mutex mu_;
+  std::shared_ptr<const Plan> plan_ GUARDED_BY(mu_);
+  int64 unplanned_peak_bytes_ GUARDED_BY(mu_) = 0;
+  // Set once a step has started recording sizes.
+  bool recording_ GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryPlanner);
+};
+
+// The allocators of the buffers of one step of a MemoryPlanner.  Kept
+// alive by the executor until Done() and by every buffer allocated from
+// it, since buffers may outlive the step.
+class StepMemory : public core::RefCounted {
+ public:
+  // Returns an array of the allocator of each buffer, nullptr for those
+  // that are not planned.
+  Allocator* const* allocators() const { return allocator_ptrs_.data(); }
+
+  // Called by the executor when the step has finished.  If the step
+  // recorded the sizes of the buffers, makes the plan.
+  void Done();
+
+  // The number of requests of this step that were not served from the
+  // arena.
+  int64 num_fallbacks() const;
+  // The largest number of bytes the buffers took at once, including those
+  // not served from the arena.
+  int64 peak_bytes() const;
+
+ private:
+  friend class MemoryPlanner;
+  class BufferAllocator;
+
+  StepMemory(MemoryPlanner* planner,
+             std::shared_ptr<const MemoryPlanner::Plan> plan,
+             bool record_sizes);
+  ~StepMemory() override;
+
+  void* Allocate(int index, size_t alignment, size_t num_bytes);
+  void Deallocate(void* ptr);
+
+  MemoryPlanner* planner_;  // Not owned; nullptr after Done().
+  Allocator* const allocator_;
+  const std::shared_ptr<const MemoryPlanner::Plan> plan_;
+  const bool record_sizes_;
+  char* arena_ = nullptr;
+
+  std::unique_ptr<BufferAllocator[]> buffer_allocators_;
+  std::vector<Allocator*> allocator_ptrs_;
+
+  mutable mutex mu_;
+  // Offset to end of the slices of the arena in use.
+  std::map<int64, int64> live_slices_ GUARDED_BY(mu_);
+  // Size of the buffers in use that are not in the arena.
+  std::unordered_map<void*, int64> live_fallbacks_ GUARDED_BY(mu_);
+  std::vector<int64> sizes_ GUARDED_BY(mu_);
+  int64 live_bytes_ GUARDED_BY(mu_) = 0;
+  int64 peak_bytes_ GUARDED_BY(mu_) = 0;
+  int64 num_fallbacks_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepMemory);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_MEMORY_PLANNER_H_
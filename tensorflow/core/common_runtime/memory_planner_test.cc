@@ -0,0 +1,155 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+typedef std::vector<std::pair<int, int>> LiveRanges;
+
+TEST(MemoryPlannerTest, AssignOffsetsReusesDisjointRanges) {
+  std::vector<int64> offsets;
+  // 0 and 2 are never alive together, and 1 overlaps both.
+  EXPECT_EQ(192, MemoryPlanner::AssignOffsets({128, 64, 100},
+                                              {{0, 1}, {1, 2}, {2, 3}},
+                                              &offsets));
+  EXPECT_EQ(std::vector<int64>({0, 128, 0}), offsets);
+}
+
+TEST(MemoryPlannerTest, AssignOffsetsFillsGaps) {
+  std::vector<int64> offsets;
+  // 0 and 1 are placed first; 2 fits in the bytes of 0, which is dead by
+  // then, but not below 1.
+  EXPECT_EQ(192, MemoryPlanner::AssignOffsets({128, 64, 32},
+                                              {{0, 1}, {0, 3}, {2, 3}},
+                                              &offsets));
+  EXPECT_EQ(std::vector<int64>({0, 128, 0}), offsets);
+}
+
+TEST(MemoryPlannerTest, AssignOffsetsSkipsUnplanned) {
+  std::vector<int64> offsets;
+  EXPECT_EQ(64, MemoryPlanner::AssignOffsets({10, 0, 1000},
+                                             {{0, 0}, {0, 0}, {-1, -1}},
+                                             &offsets));
+  EXPECT_EQ(std::vector<int64>({0, -1, -1}), offsets);
+}
+
+// Runs one step that allocates and frees a buffer of each size in turn,
+// each freed before the next is allocated.
+void RunSequentialStep(StepMemory* step, const std::vector<int64>& sizes) {
+  for (int i = 0; i < sizes.size(); ++i) {
+    Allocator* a = step->allocators()[i];
+    ASSERT_TRUE(a != nullptr);
+    void* p = a->AllocateRaw(32, sizes[i]);
+    ASSERT_TRUE(p != nullptr);
+    a->DeallocateRaw(p);
+  }
+}
+
+TEST(MemoryPlannerTest, PlansFromFirstStep) {
+  MemoryPlanner planner(cpu_allocator(), {{0, 0}, {1, 1}, {-1, -1}});
+  EXPECT_FALSE(planner.planned());
+  StepMemory* first = planner.NewStep();
+  ASSERT_TRUE(first != nullptr);
+  EXPECT_EQ(nullptr, first->allocators()[2]);
+  // Other steps use the device allocator while the sizes are recorded.
+  EXPECT_EQ(nullptr, planner.NewStep());
+  RunSequentialStep(first, {400, 1000});
+  EXPECT_EQ(1000, first->peak_bytes());
+  first->Done();
+
+  EXPECT_TRUE(planner.planned());
+  EXPECT_EQ(1024, planner.planned_bytes());
+  EXPECT_EQ(1000, planner.unplanned_peak_bytes());
+
+  StepMemory* step = planner.NewStep();
+  ASSERT_TRUE(step != nullptr);
+  void* p0 = step->allocators()[0]->AllocateRaw(32, 400);
+  step->allocators()[0]->DeallocateRaw(p0);
+  void* p1 = step->allocators()[1]->AllocateRaw(32, 1000);
+  // Both buffers are at offset 0 of the arena.
+  EXPECT_EQ(p0, p1);
+  step->allocators()[1]->DeallocateRaw(p1);
+  EXPECT_EQ(0, step->num_fallbacks());
+  step->Done();
+}
+
+TEST(MemoryPlannerTest, FallsBackWhenSliceDoesNotFit) {
+  MemoryPlanner planner(cpu_allocator(), {{0, 0}, {1, 1}});
+  StepMemory* first = planner.NewStep();
+  RunSequentialStep(first, {256, 256});
+  first->Done();
+
+  StepMemory* step = planner.NewStep();
+  Allocator* const* allocators = step->allocators();
+  // Larger than recorded.
+  void* big = allocators[0]->AllocateRaw(32, 512);
+  EXPECT_EQ(1, step->num_fallbacks());
+  // Buffer 0 outlives its range, so buffer 1 cannot share its slice.
+  void* p0 = allocators[0]->AllocateRaw(32, 256);
+  void* p1 = allocators[1]->AllocateRaw(32, 256);
+  EXPECT_NE(p0, p1);
+  EXPECT_EQ(2, step->num_fallbacks());
+  // Alignment larger than the arena's.
+  void* aligned = allocators[1]->AllocateRaw(4096, 8);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(aligned) % 4096);
+  EXPECT_EQ(3, step->num_fallbacks());
+  EXPECT_EQ(512 + 256 + 256 + 8, step->peak_bytes());
+  for (void* p : {big, p0, aligned}) allocators[0]->DeallocateRaw(p);
+  allocators[1]->DeallocateRaw(p1);
+  step->Done();
+}
+
+TEST(MemoryPlannerTest, BuffersOutliveStep) {
+  MemoryPlanner planner(cpu_allocator(), {{0, 0}});
+  StepMemory* first = planner.NewStep();
+  RunSequentialStep(first, {4 * sizeof(float)});
+  first->Done();
+
+  StepMemory* step = planner.NewStep();
+  Tensor t(step->allocators()[0], DT_FLOAT, TensorShape({4}));
+  EXPECT_EQ(0, step->num_fallbacks());
+  step->Done();
+  // The arena is freed with the last buffer in it.
+  test::FillValues<float>(&t, {1, 2, 3, 4});
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 2, 3, 4}), t);
+}
+
+static void BM_AssignOffsets(int iters, int num_buffers) {
+  std::vector<int64> sizes;
+  LiveRanges live_ranges;
+  for (int i = 0; i < num_buffers; ++i) {
+    sizes.push_back(64 << (i % 8));
+    live_ranges.emplace_back(i, i + i % 5);
+  }
+  std::vector<int64> offsets;
+  while (--iters >= 0) {
+    MemoryPlanner::AssignOffsets(sizes, live_ranges, &offsets);
+  }
+}
+BENCHMARK(BM_AssignOffsets)->Arg(100)->Arg(1000);
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,9 +16,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <atomic>
+#include <memory>
 #include <unordered_map>
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/port.h"
 
 namespace tensorflow {
@@ -248,6 +251,79 @@ class PendingCounts {
   TF_DISALLOW_COPY_AND_ASSIGN(PendingCounts);
 };
 
+// A lock-free counterpart of PendingCounts for graphs in which every node
+// becomes ready exactly when all of its inputs have arrived, i.e. graphs
+// without Merge nodes or control-flow frames.  Each node's pending count
+// and dead-input count live in a single atomic word, so concurrent
+// producers can record an input arrival without holding a lock; whichever
+// producer brings the pending count to zero owns the node.
+class AtomicPendingCounts {
+ public:
+  explicit AtomicPendingCounts(int num_nodes)
+      : num_nodes_(num_nodes), counts_(new std::atomic<int64>[num_nodes]) {
+    for (int id = 0; id < num_nodes_; id++) {
+      counts_[id].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void set_initial_count(int id, int pending_count) {
+    DCHECK_GE(id, 0);
+    DCHECK_LT(id, num_nodes_);
+    DCHECK_GE(pending_count, 0);
+    counts_[id].store(pending_count, std::memory_order_relaxed);
+  }
+
+  // Records the arrival of one input of node "id", which is dead iff
+  // "is_dead".  Returns true iff that was the last pending input, in
+  // which case *any_dead is set to whether any input of "id" was dead.
+  //
+  // The update is an acquire-release read-modify-write, so everything a
+  // producer wrote before calling this (e.g. the input tensor it handed
+  // to "id") is visible to the producer that observes the count reach 0.
+  bool decrement_pending(int id, bool is_dead, bool* any_dead) {
+    DCHECK_GE(id, 0);
+    DCHECK_LT(id, num_nodes_);
+    const int64 delta = is_dead ? kOneDead - 1 : -1;
+    const int64 v =
+        counts_[id].fetch_add(delta, std::memory_order_acq_rel) + delta;
+    DCHECK_GE(v & kPendingMask, 0);
+    if ((v & kPendingMask) != 0) return false;
+    *any_dead = (v >> kDeadShift) != 0;
+    return true;
+  }
+
+  int pending(int id) const {
+    return static_cast<int>(counts_[id].load(std::memory_order_relaxed) &
+                            kPendingMask);
+  }
+  int dead_count(int id) const {
+    return static_cast<int>(counts_[id].load(std::memory_order_relaxed) >>
+                            kDeadShift);
+  }
+
+  // Initialize the state from "b".
+  // REQUIRES: "num_nodes_ == b.num_nodes_"
+  void InitializeFrom(const AtomicPendingCounts& b) {
+    DCHECK_EQ(num_nodes_, b.num_nodes_);
+    for (int id = 0; id < num_nodes_; id++) {
+      counts_[id].store(b.counts_[id].load(std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  // The low 32 bits hold the pending count and the high 32 bits the
+  // number of dead inputs seen so far.
+  static const int kDeadShift = 32;
+  static const int64 kPendingMask = (1LL << kDeadShift) - 1;
+  static const int64 kOneDead = 1LL << kDeadShift;
+
+  const int num_nodes_;
+  std::unique_ptr<std::atomic<int64>[]> counts_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AtomicPendingCounts);
+};
+
 }  // end namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_CORE_COMMON_RUNTIME_PENDING_COUNTS_H_
@@ -13,10 +13,13 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -126,4 +129,73 @@ TEST(PendingCounts, StateIsCorrect) {
   }
 }
 
+TEST(AtomicPendingCounts, Simple) {
+  const int C = 300;
+  AtomicPendingCounts c(C);
+  for (int id = 0; id < C; id++) {
+    c.set_initial_count(id, id + 1);
+  }
+  for (int id = 0; id < C; id++) {
+    EXPECT_EQ(c.pending(id), id + 1);
+    EXPECT_EQ(c.dead_count(id), 0);
+  }
+  bool dead = true;
+  EXPECT_TRUE(c.decrement_pending(0, false, &dead));
+  EXPECT_FALSE(dead);
+  EXPECT_FALSE(c.decrement_pending(2, true, &dead));
+  EXPECT_EQ(c.pending(2), 2);
+  EXPECT_EQ(c.dead_count(2), 1);
+  EXPECT_FALSE(c.decrement_pending(2, false, &dead));
+  EXPECT_TRUE(c.decrement_pending(2, false, &dead));
+  EXPECT_TRUE(dead);
+  EXPECT_EQ(c.dead_count(2), 1);
+}
+
+TEST(AtomicPendingCounts, InitializeFrom) {
+  const int C = 300;
+  AtomicPendingCounts c(C);
+  for (int id = 0; id < C; id++) {
+    c.set_initial_count(id, id);
+  }
+  AtomicPendingCounts c2(C);
+  c2.InitializeFrom(c);
+  for (int id = 0; id < C; id++) {
+    EXPECT_EQ(c.pending(id), c2.pending(id));
+    EXPECT_EQ(c.dead_count(id), c2.dead_count(id));
+  }
+}
+
+// Many threads deliver the inputs of the same nodes concurrently; exactly
+// one of them must see each node become ready.
+TEST(AtomicPendingCounts, ConcurrentDecrement) {
+  const int kNodes = 64;
+  const int kInputs = 1000;
+  AtomicPendingCounts c(kNodes);
+  for (int id = 0; id < kNodes; id++) {
+    c.set_initial_count(id, kInputs);
+  }
+  std::atomic<int> num_ready(0);
+  std::atomic<int> num_dead(0);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 8);
+    for (int i = 0; i < kInputs; ++i) {
+      pool.Schedule([&c, &num_ready, &num_dead, i]() {
+        for (int id = 0; id < kNodes; id++) {
+          bool dead = false;
+          // Only the odd nodes ever see a dead input.
+          if (c.decrement_pending(id, (id % 2 == 1) && (i == 7), &dead)) {
+            num_ready++;
+            if (dead) num_dead++;
+          }
+        }
+      });
+    }
+  }
+  EXPECT_EQ(kNodes, num_ready);
+  EXPECT_EQ(kNodes / 2, num_dead);
+  for (int id = 0; id < kNodes; id++) {
+    EXPECT_EQ(0, c.pending(id));
+  }
+}
+
 }  // namespace tensorflow
@@ -51,6 +51,26 @@ Status Session::PRun(const string& handle,
       "Partial run is not supported for this session.");
 }
 
+Status Session::MakeCallable(const std::vector<string>& feed_names,
+                             const std::vector<string>& fetch_names,
+                             const std::vector<string>& target_nodes,
+                             CallableHandle* handle) {
+  return errors::Unimplemented(
+      "Callables are not supported for this session.");
+}
+
+Status Session::RunCallable(CallableHandle handle,
+                            const std::vector<Tensor>& feed_tensors,
+                            std::vector<Tensor>* fetch_tensors) {
+  return errors::Unimplemented(
+      "Callables are not supported for this session.");
+}
+
+Status Session::ReleaseCallable(CallableHandle handle) {
+  return errors::Unimplemented(
+      "Callables are not supported for this session.");
+}
+
 Session* NewSession(const SessionOptions& options) {
   SessionFactory* factory;
   Status s = SessionFactory::GetFactory(options, &factory);
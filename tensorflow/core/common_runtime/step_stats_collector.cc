@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 
+#include "tensorflow/core/common_runtime/measured_costs.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/platform/logging.h"
@@ -21,12 +22,24 @@ limitations under the License.
 namespace tensorflow {
 
 StepStatsCollector::StepStatsCollector(
-    StepStats* ss, std::unordered_map<const Graph*, CostModel*>* cm)
-    : step_stats_(ss), cost_models_(cm) {}
+    StepStats* ss, std::unordered_map<const Graph*, CostModel*>* cm,
+    MeasuredCosts* measured_costs)
+    : step_stats_(ss), cost_models_(cm), measured_costs_(measured_costs) {}
+
+StepStatsCollector::~StepStatsCollector() {
+  mutex_lock l(mu_);
+  if (measured_costs_ != nullptr && !measured_times_.empty()) {
+    measured_costs_->RecordStep(measured_times_);
+  }
+}
 
 void StepStatsCollector::UpdateCostModel(const NodeExecStats* nt,
                                          const Graph* graph, const Node* node) {
+  const Microseconds time(nt->op_end_rel_micros() - nt->op_start_rel_micros());
   mutex_lock l(mu_);
+  if (measured_costs_ != nullptr && node->IsOp()) {
+    measured_times_.emplace_back(node, time);
+  }
   if (!cost_models_) {
     return;
   }
@@ -40,6 +53,11 @@ void StepStatsCollector::UpdateCostModel(const NodeExecStats* nt,
     cm = (*it).second;
   }
 
+  if (node->IsOp()) {
+    cm->RecordCount(node, 1);
+    cm->RecordTime(node, time);
+  }
+
   for (int i = 0; i < nt->output_size(); ++i) {
     cm->RecordMaxSize(node, i, Bytes(nt->output(i)
                                          .tensor_description()
@@ -16,6 +16,9 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_STEP_STATS_COLLECTOR_H_
 
 #include <unordered_map>
+#include <utility>
+#include <vector>
+#include "tensorflow/core/graph/types.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
@@ -24,15 +27,21 @@ namespace tensorflow {
 
 class CostModel;
 class Graph;
+class MeasuredCosts;
 class Node;
 class NodeExecStats;
 class StepStats;
 
 class StepStatsCollector {
  public:
+  // If "measured_costs" is not null, the execution time of every node is
+  // also recorded in it, all at once when the collector is destroyed at
+  // the end of the step.
   explicit StepStatsCollector(
       StepStats* ss,
-      std::unordered_map<const Graph*, CostModel*>* cost_models = nullptr);
+      std::unordered_map<const Graph*, CostModel*>* cost_models = nullptr,
+      MeasuredCosts* measured_costs = nullptr);
+  ~StepStatsCollector();
 
   void UpdateCostModel(const NodeExecStats* nt, const Graph* graph,
                        const Node* node);
@@ -45,6 +54,9 @@ class StepStatsCollector {
   mutex mu_;
   StepStats* step_stats_ GUARDED_BY(mu_);
   std::unordered_map<const Graph*, CostModel*>* cost_models_ GUARDED_BY(mu_);
+  MeasuredCosts* const measured_costs_;
+  std::vector<std::pair<const Node*, Microseconds>> measured_times_
+      GUARDED_BY(mu_);
 };
 
 }  // namespace tensorflow
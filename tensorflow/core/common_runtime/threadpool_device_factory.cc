@@ -17,6 +17,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/threadpool_device.h"
 
 #include <vector>
+#include "tensorflow/core/common_runtime/caching_cpu_allocator.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/public/session_options.h"
@@ -35,12 +36,27 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
     if (iter != options.config.device_count().end()) {
       n = iter->second;
     }
+    Allocator* allocator = GetAllocator(options);
     for (int i = 0; i < n; i++) {
       string name = strings::StrCat(name_prefix, "/cpu:", i);
       devices->push_back(new ThreadPoolDevice(options, name, Bytes(256 << 20),
-                                              BUS_ANY, cpu_allocator()));
+                                              BUS_ANY, allocator));
     }
   }
+
+ private:
+  static Allocator* GetAllocator(const SessionOptions& options) {
+    const string& allocator_type =
+        options.config.cpu_options().allocator_type();
+    if (allocator_type == "caching") {
+      return caching_cpu_allocator();
+    }
+    if (!allocator_type.empty()) {
+      LOG(ERROR) << "Invalid CPU allocator type: " << allocator_type
+                 << ", using the default allocator";
+    }
+    return cpu_allocator();
+  }
 };
 REGISTER_LOCAL_DEVICE_FACTORY("CPU", ThreadPoolDeviceFactory);
 
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 
 #include <algorithm>
+#include <memory>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
@@ -404,4 +406,60 @@ TEST_F(ExecutorTest, RecvInvalidRefDtype) {
   rendez->Unref();
 }
 
+// Runs a graph of "kDepth" layers of "kWidth" NoOps, where each NoOp waits
+// for two NoOps of the previous layer, on a pool of "num_threads" threads.
+// Reports nodes executed per second, so that runs with different thread
+// counts show how well the executor scales on wide graphs of cheap ops.
+static void BM_executor(int iters, int num_threads) {
+  testing::StopTiming();
+  const int kWidth = 512;
+  const int kDepth = 16;
+  Graph* g = new Graph(OpRegistry::Global());
+  std::vector<Node*> prev;
+  for (int i = 0; i < kWidth; ++i) {
+    prev.push_back(test::graph::NoOp(g, {}));
+  }
+  for (int d = 1; d < kDepth; ++d) {
+    std::vector<Node*> curr;
+    for (int i = 0; i < kWidth; ++i) {
+      curr.push_back(
+          test::graph::NoOp(g, {prev[i], prev[(i + 1) % kWidth]}));
+    }
+    prev.swap(curr);
+  }
+  const int num_nodes = g->num_nodes();
+
+  std::unique_ptr<Device> device(DeviceFactory::NewDevice(
+      "CPU", {}, "/job:localhost/replica:0/task:0"));
+  thread::ThreadPool pool(Env::Default(), "executor", num_threads);
+  const int version = g->versions().producer();
+  LocalExecutorParams params;
+  params.device = device.get();
+  params.create_kernel = [&device, version](const NodeDef& ndef,
+                                            OpKernel** kernel) {
+    return CreateNonCachedKernel(device.get(), nullptr, ndef, version, kernel);
+  };
+  params.delete_kernel = [](OpKernel* kernel) {
+    DeleteNonCachedKernel(kernel);
+  };
+  Executor* exec = nullptr;
+  TF_CHECK_OK(NewLocalExecutor(params, g, &exec));
+  Rendezvous* rendez = NewLocalRendezvous();
+  Executor::Args args;
+  args.rendezvous = rendez;
+  args.runner = [&pool](std::function<void()> fn) { pool.Schedule(fn); };
+
+  TF_CHECK_OK(exec->Run(args));  // Warm up.
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(exec->Run(args));
+  }
+  testing::StopTiming();
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_nodes);
+  testing::SetLabel(strings::StrCat(num_threads, " threads"));
+  rendez->Unref();
+  delete exec;
+}
+BENCHMARK(BM_executor)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32);
+
 }  // namespace tensorflow
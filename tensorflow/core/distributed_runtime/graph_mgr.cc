@@ -177,6 +177,7 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
     params.device = unit->device;
     auto lib = unit->lib;
     params.function_library = lib;
+    params.plan_memory = graph_options.plan_memory();
     params.create_kernel = [session, lib, opseg](const NodeDef& ndef,
                                                  OpKernel** kernel) {
       // Caches the kernel only if the node is stateful.
@@ -198,8 +199,11 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
       }
     };
 
-    optimizer.Optimize(lib, &subgraph);
-    s = ValidateMemoryTypes(DeviceType(unit->device->device_type()), subgraph);
+    s = optimizer.Optimize(lib, &subgraph);
+    if (s.ok()) {
+      s = ValidateMemoryTypes(DeviceType(unit->device->device_type()),
+                              subgraph);
+    }
     if (!s.ok()) {
       delete subgraph;
       break;
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/master_session_interface.h"
 #include "tensorflow/core/distributed_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/simple_graph_execution_state.h"
+#include "tensorflow/core/distributed_runtime/wire_encoding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/framework/function.pb.h"
@@ -883,7 +884,28 @@ Status MasterSession::DoRunWithLocalExecution(CallOptions* opts,
     }
   };
   popts.control_flow_added = false;
-  // TODO(mrry): Enable DT_BFLOAT16 casting.
+  // The partitions are split by worker, so every edge between them is
+  // sent over the network, and may be sent in a smaller encoding.
+  const WireOptions& wire_options =
+      session_opts_.config.graph_options().wire_options();
+  if (wire_options.encoding() == WireOptions::BFLOAT16 ||
+      wire_options.lossy_encoding() == WireOptions::BFLOAT16) {
+    popts.should_cast = [wire_options](const Edge* edge) {
+      if (edge->IsControlEdge()) return DT_FLOAT;
+      const DataType dtype = edge->dst()->input_type(edge->dst_input());
+      if (dtype == DT_FLOAT &&
+          EdgeWireEncoding(wire_options, edge) == WireOptions::BFLOAT16) {
+        return DT_BFLOAT16;
+      }
+      return dtype;
+    };
+  }
+  popts.wire_encoding = [wire_options](const Edge* edge) {
+    const WireOptions::Encoding encoding =
+        EdgeWireEncoding(wire_options, edge);
+    // BFLOAT16 is applied by the casts above.
+    return encoding == WireOptions::BFLOAT16 ? WireOptions::RAW : encoding;
+  };
   // TODO(mrry): Enable recv scheduling.
   TF_RETURN_IF_ERROR(rcg->RegisterPartitions(env_, popts, func_def_lib_));
 
@@ -19,6 +19,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache_logger.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -31,12 +33,19 @@ limitations under the License.
 
 namespace tensorflow {
 
+// The name of the RecvTensor method of WorkerService, which is called
+// directly to read its response as a ::grpc::ByteBuffer.
+static const char kRecvTensorMethod[] =
+    "/tensorflow.grpc.WorkerService/RecvTensor";
+
 class GrpcRemoteWorker : public WorkerInterface {
  public:
   explicit GrpcRemoteWorker(SharedGrpcChannelPtr channel,
                             ::grpc::CompletionQueue* completion_queue,
                             WorkerCacheLogger* logger)
-      : stub_(grpc::WorkerService::NewStub(channel)),
+      : channel_(channel),
+        stub_(grpc::WorkerService::NewStub(channel)),
+        recvtensor_(kRecvTensorMethod, ::grpc::RpcMethod::NORMAL_RPC, channel),
         cq_(completion_queue),
         logger_(logger) {}
 
@@ -84,8 +93,7 @@ class GrpcRemoteWorker : public WorkerInterface {
   }
 
   void RecvTensorAsync(CallOptions* call_opts, const RecvTensorRequest* request,
-                       RecvTensorResponse* response,
-                       TensorBufAllocator allocator,
+                       TensorResponse* response,
                        StatusCallback done) override {
     VLOG(1) << "RecvTensorAsync req: " << request->DebugString();
     int64 start_usec = Env::Default()->NowMicros();
@@ -102,12 +110,12 @@ class GrpcRemoteWorker : public WorkerInterface {
       if (logger_->LoggingActive()) {
         int64 end_usec = Env::Default()->NowMicros();
         int64 step_id = request->step_id();
-        int64 bytes = response->tensor().ByteSize();
+        int64 bytes = response->tensor().TotalBytes();
         int64 send_start_usec = start_usec;
         // If a send start time was reported by the other side, use
         // that instead.  Maybe we should mark the display if we're using
         // our local time instead of the remote start time?
-        if (response->send_start_micros()) {
+        if (response->metadata().send_start_micros()) {
           // send_start_micros is the timestamp taken when the remote
           // machine began to send the RecvTensor response.
           // Due to clock skew between source and dest machines, it is
@@ -116,7 +124,8 @@ class GrpcRemoteWorker : public WorkerInterface {
           // To respect causality, we enforce the invariants that the RecvTensor
           // response can not have been sent before the RecvTensor request, and
           // must have been sent before it was received.
-          send_start_usec = std::max(start_usec, response->send_start_micros());
+          send_start_usec =
+              std::max(start_usec, response->metadata().send_start_micros());
           send_start_usec = std::min(send_start_usec, end_usec - 1);
         }
         const string& key = request->rendezvous_key();
@@ -128,18 +137,34 @@ class GrpcRemoteWorker : public WorkerInterface {
                                     key_parts[3],  // tensor name
                                     key_parts[0],  // src_device
                                     key_parts[2],  // dst_device
-                                    bytes);
+                                    bytes, response->wire_bytes());
         }
       }
       VLOG(2) << "done callback, req: " << request->DebugString()
-              << " response " << response->DebugString();
+              << " response " << response->metadata().DebugString();
       delete req_copy;
       done(s);
     };
 
-    IssueRequest(req_copy ? req_copy : request, response,
-                 &grpc::WorkerService::Stub::AsyncRecvTensor, logging_callback,
-                 call_opts);
+    // The response is received as a ::grpc::ByteBuffer, and the tensor
+    // is parsed from its slices straight into a buffer allocated by
+    // "response".
+    ::grpc::ByteBuffer* buffer = new ::grpc::ByteBuffer;
+    StatusCallback parse_callback = [response, buffer,
+                                     logging_callback](Status s) {
+      if (s.ok()) {
+        grpc::GrpcByteBufferSource source(buffer);
+        s = response->ParseFrom(&source);
+      }
+      delete buffer;
+      logging_callback(s);
+    };
+
+    ::grpc::ClientContext* context = NewContext(call_opts);
+    auto rpc = new ::grpc::ClientAsyncResponseReader<::grpc::ByteBuffer>(
+        channel_.get(), cq_, recvtensor_, context,
+        req_copy ? *req_copy : *request);
+    Finish(context, rpc, buffer, parse_callback, call_opts);
   }
 
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
@@ -168,11 +193,27 @@ class GrpcRemoteWorker : public WorkerInterface {
   void IssueRequest(const RequestMessage* request, ResponseMessage* response,
                     AsyncMethod<RequestMessage, ResponseMessage> async_method,
                     StatusCallback done, CallOptions* call_opts = nullptr) {
+    ::grpc::ClientContext* context = NewContext(call_opts);
+    auto rpc = (stub_.get()->*async_method)(context, *request, cq_).release();
+    Finish(context, rpc, response, done, call_opts);
+  }
+
+  // Returns a context for a new call, which is cancelled with "call_opts".
+  ::grpc::ClientContext* NewContext(CallOptions* call_opts) {
     ::grpc::ClientContext* context = new ::grpc::ClientContext;
     if (call_opts) {
       call_opts->SetCancelCallback([context]() { context->TryCancel(); });
     }
-    auto rpc = (stub_.get()->*async_method)(context, *request, cq_).release();
+    return context;
+  }
+
+  // Reads the response of "rpc" into "response", and calls "done" when
+  // the call has completed.  Takes ownership of "context" and "rpc".
+  template <class ResponseMessage>
+  void Finish(::grpc::ClientContext* context,
+              ::grpc::ClientAsyncResponseReader<ResponseMessage>* rpc,
+              ResponseMessage* response, StatusCallback done,
+              CallOptions* call_opts) {
     GrpcClientCQTag* tag =
         new GrpcClientCQTag(context, [rpc, done, call_opts](Status s) {
           if (call_opts) {
@@ -184,7 +225,9 @@ class GrpcRemoteWorker : public WorkerInterface {
     rpc->Finish(response, tag->status(), tag);
   }
 
+  SharedGrpcChannelPtr channel_;
   std::unique_ptr<grpc::WorkerService::Stub> stub_;
+  const ::grpc::RpcMethod recvtensor_;
   ::grpc::CompletionQueue* cq_;
 
   // Support for logging.
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/master.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/util/port.h"
@@ -839,4 +840,70 @@ TEST(SessionTest, RunTimeoutWithRunOptions) {
               error::INTERNAL == status.code());
 }
 
+// Measures RecvTensor between two tasks of a local cluster: each step
+// sends two tensors of "size" floats from task 0 to the MatMul on task 1,
+// encoded on the wire as "encoding".
+static void RecvTensorBenchmark(int iters, int size,
+                                WireOptions::Encoding encoding) {
+  testing::StopTiming();
+  std::unique_ptr<test::TestCluster> cluster;
+  TF_CHECK_OK(test::TestCluster::MakeTestCluster(Devices(1, 0), 2, &cluster));
+
+  Graph graph(OpRegistry::Global());
+  Tensor a_tensor(DT_FLOAT, TensorShape({1, size}));
+  Tensor b_tensor(DT_FLOAT, TensorShape({size, 1}));
+  a_tensor.flat<float>().setConstant(2);
+  b_tensor.flat<float>().setConstant(3);
+  Node* a = test::graph::Constant(&graph, a_tensor);
+  Node* b = test::graph::Constant(&graph, b_tensor);
+  Node* c = test::graph::Matmul(&graph, a, b, false, false);
+  GraphDef def;
+  test::graph::ToGraphDef(&graph, &def);
+  SetDevice(&def, a->name(), cluster->devices()[0].name());
+  SetDevice(&def, b->name(), cluster->devices()[0].name());
+  SetDevice(&def, c->name(), cluster->devices()[1].name());
+
+  SessionOptions options = Options(cluster->targets()[0], 1000);
+  options.config.mutable_graph_options()->mutable_wire_options()->set_encoding(
+      encoding);
+  std::unique_ptr<Session> session(NewRemote(options));
+  TF_CHECK_OK(session->Create(def));
+  std::vector<Tensor> outputs;
+  // Warm up.
+  TF_CHECK_OK(session->Run({}, {c->name()}, {}, &outputs));
+
+  testing::BytesProcessed(static_cast<int64>(iters) * 2 * size *
+                          sizeof(float));
+  testing::UseRealTime();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(session->Run({}, {c->name()}, {}, &outputs));
+  }
+  testing::StopTiming();
+  TF_CHECK_OK(session->Close());
+}
+
+static void BM_RecvTensor(int iters, int size) {
+  RecvTensorBenchmark(iters, size, WireOptions::RAW);
+}
+BENCHMARK(BM_RecvTensor)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+static void BM_RecvTensorSnappy(int iters, int size) {
+  RecvTensorBenchmark(iters, size, WireOptions::SNAPPY);
+}
+BENCHMARK(BM_RecvTensorSnappy)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+static void BM_RecvTensorBfloat16(int iters, int size) {
+  RecvTensorBenchmark(iters, size, WireOptions::BFLOAT16);
+}
+BENCHMARK(BM_RecvTensorBfloat16)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+static void BM_RecvTensorQuantized8Bit(int iters, int size) {
+  RecvTensorBenchmark(iters, size, WireOptions::QUANTIZED_8BIT);
+}
+BENCHMARK(BM_RecvTensorQuantized8Bit)
+    ->Arg(1 << 10)
+    ->Arg(1 << 16)
+    ->Arg(1 << 20);
+
 }  // namespace tensorflow
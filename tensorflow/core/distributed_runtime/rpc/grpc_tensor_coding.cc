@@ -0,0 +1,264 @@
+/* Copyright 2016 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
+
+#include <string.h>
+#include <atomic>
+#include <vector>
+
+#include "grpc/support/slice.h"
+#include "grpc++/support/byte_buffer.h"
+#include "grpc++/support/slice.h"
+
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grpc {
+
+namespace {
+
+using protobuf::io::CodedOutputStream;
+
+// Wire types of the fields written below.
+const uint32 kVarint = 0;
+const uint32 kLengthDelimited = 2;
+
+inline uint32 Tag(int field_number, uint32 wire_type) {
+  return (static_cast<uint32>(field_number) << 3) | wire_type;
+}
+
+inline uint8* WriteVarintField(int field_number, uint64 value, uint8* p) {
+  p = CodedOutputStream::WriteTagToArray(Tag(field_number, kVarint), p);
+  return CodedOutputStream::WriteVarint64ToArray(value, p);
+}
+
+inline uint8* WriteLengthPrefix(int field_number, uint64 length, uint8* p) {
+  p = CodedOutputStream::WriteTagToArray(Tag(field_number, kLengthDelimited),
+                                         p);
+  return CodedOutputStream::WriteVarint64ToArray(length, p);
+}
+
+inline size_t VarintFieldSize(int field_number, uint64 value) {
+  return CodedOutputStream::VarintSize32(Tag(field_number, kVarint)) +
+         CodedOutputStream::VarintSize64(value);
+}
+
+inline size_t LengthPrefixSize(int field_number, uint64 length) {
+  return CodedOutputStream::VarintSize32(Tag(field_number, kLengthDelimited)) +
+         CodedOutputStream::VarintSize64(length);
+}
+
+// Contents smaller than this are copied into the first slice, because a
+// slice of their own costs more than copying them.
+const size_t kLargeTensorBytes = 1024;
+
+// A slice refcount that holds a reference on a TensorBuffer for as long
+// as gRPC holds the slice of its contents.  gRPC calls ref() and unref()
+// with the address of "base", so it must be the first member.
+struct TensorBufferRefcount {
+  gpr_slice_refcount base;
+  std::atomic<int> count;
+  const TensorBuffer* buf;  // One reference is held.
+};
+
+void RefTensorBuffer(void* p) {
+  static_cast<TensorBufferRefcount*>(p)->count.fetch_add(1);
+}
+
+void UnrefTensorBuffer(void* p) {
+  TensorBufferRefcount* r = static_cast<TensorBufferRefcount*>(p);
+  if (r->count.fetch_sub(1) == 1) {
+    r->buf->Unref();
+    delete r;
+  }
+}
+
+// Returns a slice of "contents", which are held by "buf".
+::grpc::Slice TensorBufferSlice(const TensorBuffer* buf,
+                                StringPiece contents) {
+  TensorBufferRefcount* r = new TensorBufferRefcount;
+  r->base.ref = RefTensorBuffer;
+  r->base.unref = UnrefTensorBuffer;
+  r->count = 1;
+  r->buf = buf;
+  buf->Ref();
+  gpr_slice s;
+  s.refcount = &r->base;
+  s.data.refcounted.bytes =
+      reinterpret_cast<uint8_t*>(const_cast<char*>(contents.data()));
+  s.data.refcounted.length = contents.size();
+  return ::grpc::Slice(s, ::grpc::Slice::STEAL_REF);
+}
+
+}  // namespace
+
+void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
+                                          ::grpc::ByteBuffer* result) {
+  const size_t len = proto.ByteSize();
+  gpr_slice s = gpr_slice_malloc(len);
+  proto.SerializeWithCachedSizesToArray(
+      reinterpret_cast<uint8*>(GPR_SLICE_START_PTR(s)));
+  ::grpc::Slice slice(s, ::grpc::Slice::STEAL_REF);
+  ::grpc::ByteBuffer tmp(&slice, 1);
+  result->Swap(&tmp);
+}
+
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
+                              ::grpc::ByteBuffer* result) {
+  const int64 send_start_micros = Env::Default()->NowMicros();
+  if (!DataTypeCanUseMemcpy(val.dtype())) {
+    // The contents of e.g. a string tensor must be serialized anyway.
+    RecvTensorResponse response;
+    response.set_is_dead(is_dead);
+    response.set_send_start_micros(send_start_micros);
+    val.AsProtoTensorContent(response.mutable_tensor());
+    EncodeRecvTensorResponseToByteBuffer(response, result);
+    return;
+  }
+
+  // The encoding is that of a RecvTensorResponse with the tensor written
+  // last, so that its contents end the message:
+  //
+  //   is_dead, send_start_micros,
+  //   tensor { dtype, tensor_shape, tensor_content }
+  TensorProto meta;
+  meta.set_dtype(val.dtype());
+  val.shape().AsProto(meta.mutable_tensor_shape());
+  const string meta_bytes = meta.SerializeAsString();
+  const StringPiece contents = val.tensor_data();
+  const bool copy_contents = contents.size() < kLargeTensorBytes;
+
+  size_t tensor_bytes = meta_bytes.size();
+  if (!contents.empty()) {
+    tensor_bytes += LengthPrefixSize(TensorProto::kTensorContentFieldNumber,
+                                     contents.size()) +
+                    contents.size();
+  }
+  size_t header_bytes = 0;
+  if (is_dead) {
+    header_bytes += VarintFieldSize(RecvTensorResponse::kIsDeadFieldNumber, 1);
+  }
+  header_bytes += VarintFieldSize(
+      RecvTensorResponse::kSendStartMicrosFieldNumber, send_start_micros);
+  header_bytes +=
+      LengthPrefixSize(RecvTensorResponse::kTensorFieldNumber, tensor_bytes) +
+      meta_bytes.size();
+  if (!contents.empty()) {
+    header_bytes += LengthPrefixSize(TensorProto::kTensorContentFieldNumber,
+                                     contents.size());
+    if (copy_contents) header_bytes += contents.size();
+  }
+
+  gpr_slice header = gpr_slice_malloc(header_bytes);
+  uint8* const start = reinterpret_cast<uint8*>(GPR_SLICE_START_PTR(header));
+  uint8* p = start;
+  if (is_dead) {
+    p = WriteVarintField(RecvTensorResponse::kIsDeadFieldNumber, 1, p);
+  }
+  p = WriteVarintField(RecvTensorResponse::kSendStartMicrosFieldNumber,
+                       send_start_micros, p);
+  p = WriteLengthPrefix(RecvTensorResponse::kTensorFieldNumber, tensor_bytes,
+                        p);
+  memcpy(p, meta_bytes.data(), meta_bytes.size());
+  p += meta_bytes.size();
+  if (!contents.empty()) {
+    p = WriteLengthPrefix(TensorProto::kTensorContentFieldNumber,
+                          contents.size(), p);
+    if (copy_contents) {
+      memcpy(p, contents.data(), contents.size());
+      p += contents.size();
+    }
+  }
+  CHECK_EQ(header_bytes, static_cast<size_t>(p - start));
+
+  ::grpc::Slice slices[2];
+  slices[0] = ::grpc::Slice(header, ::grpc::Slice::STEAL_REF);
+  int num_slices = 1;
+  if (!contents.empty() && !copy_contents) {
+    slices[1] = TensorBufferSlice(DMAHelper::buffer(&val), contents);
+    num_slices = 2;
+  }
+  ::grpc::ByteBuffer tmp(&slices[0], num_slices);
+  result->Swap(&tmp);
+}
+
+// Yields the slices of a ByteBuffer in order.
+class GrpcByteBufferSource::Stream : public protobuf::io::ZeroCopyInputStream {
+ public:
+  explicit Stream(const ::grpc::ByteBuffer* buffer) { buffer->Dump(&slices_); }
+
+  bool Next(const void** data, int* size) override {
+    while (left_ == 0) {
+      if (cur_ == slices_.size()) return false;
+      const ::grpc::Slice& s = slices_[cur_++];
+      ptr_ = reinterpret_cast<const char*>(s.begin());
+      left_ = s.size();
+    }
+    *data = ptr_;
+    *size = left_;
+    byte_count_ += left_;
+    ptr_ += left_;
+    left_ = 0;
+    return true;
+  }
+
+  void BackUp(int count) override {
+    ptr_ -= count;
+    left_ += count;
+    byte_count_ -= count;
+  }
+
+  bool Skip(int count) override {
+    const void* data;
+    int size;
+    while (Next(&data, &size)) {
+      if (size >= count) {
+        BackUp(size - count);
+        return true;
+      }
+      count -= size;
+    }
+    return false;
+  }
+
+  protobuf::int64 ByteCount() const override { return byte_count_; }
+
+ private:
+  std::vector<::grpc::Slice> slices_;
+  size_t cur_ = 0;              // Index of the next slice to yield.
+  const char* ptr_ = nullptr;   // Next byte of slices_[cur_ - 1] to yield.
+  int left_ = 0;                // Bytes of slices_[cur_ - 1] left to yield.
+  protobuf::int64 byte_count_ = 0;
+};
+
+GrpcByteBufferSource::GrpcByteBufferSource(const ::grpc::ByteBuffer* buffer)
+    : buffer_(buffer) {}
+
+GrpcByteBufferSource::~GrpcByteBufferSource() {}
+
+protobuf::io::ZeroCopyInputStream* GrpcByteBufferSource::contents() {
+  stream_.reset(new Stream(buffer_));
+  return stream_.get();
+}
+
+}  // namespace grpc
+}  // namespace tensorflow
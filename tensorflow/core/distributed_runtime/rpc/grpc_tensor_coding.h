@@ -0,0 +1,67 @@
+/* Copyright 2016 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
+
+#include <memory>
+
+#include "grpc++/grpc++.h"
+
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+namespace grpc {
+
+// Encodes a RecvTensorResponse holding "val" into "*result", with
+// "is_dead" and the current time as send_start_micros.  The encoding is
+// the serialized proto, so any RecvTensorResponse parser can read it,
+// but the contents of a large tensor are not copied: the last slice of
+// "*result" refers to the buffer of "val", and holds a reference to it
+// until gRPC has sent it.
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
+                              ::grpc::ByteBuffer* result);
+
+// Encodes "proto" into "*result".
+void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
+                                          ::grpc::ByteBuffer* result);
+
+// Provides the contents of a ::grpc::ByteBuffer to TensorResponse without
+// flattening them into one string.
+class GrpcByteBufferSource : public TensorResponse::Source {
+ public:
+  // "buffer" must outlive this object.
+  explicit GrpcByteBufferSource(const ::grpc::ByteBuffer* buffer);
+  ~GrpcByteBufferSource() override;
+
+  protobuf::io::ZeroCopyInputStream* contents() override;
+
+ private:
+  class Stream;
+
+  const ::grpc::ByteBuffer* const buffer_;  // Not owned.
+  std::unique_ptr<Stream> stream_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GrpcByteBufferSource);
+};
+
+}  // namespace grpc
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
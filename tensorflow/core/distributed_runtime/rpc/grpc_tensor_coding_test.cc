@@ -0,0 +1,118 @@
+/* Copyright 2016 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
+
+#include <vector>
+
+#include "grpc++/support/byte_buffer.h"
+#include "grpc++/support/slice.h"
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+string Flatten(const ::grpc::ByteBuffer& buffer) {
+  std::vector<::grpc::Slice> slices;
+  buffer.Dump(&slices);
+  string result;
+  for (const ::grpc::Slice& s : slices) {
+    result.append(reinterpret_cast<const char*>(s.begin()), s.size());
+  }
+  return result;
+}
+
+class GrpcTensorCodingTest : public ::testing::Test {
+ protected:
+  GrpcTensorCodingTest()
+      : device_(DeviceFactory::NewDevice("CPU", {}, "/job:a/replica:0/task:0")) {
+  }
+
+  template <typename T>
+  void Validate(const Tensor& t, bool is_dead) {
+    ::grpc::ByteBuffer buf;
+    grpc::EncodeTensorToByteBuffer(is_dead, t, &buf);
+
+    // The encoding is a RecvTensorResponse to any parser.
+    RecvTensorResponse proto;
+    ASSERT_TRUE(proto.ParseFromString(Flatten(buf)));
+    EXPECT_EQ(is_dead, proto.is_dead());
+    EXPECT_GT(proto.send_start_micros(), 0);
+    Tensor from_proto;
+    ASSERT_TRUE(from_proto.FromProto(proto.tensor()));
+    test::ExpectTensorEqual<T>(t, from_proto);
+
+    TensorResponse response;
+    response.InitAlloc(device_.get(), AllocatorAttributes());
+    grpc::GrpcByteBufferSource source(&buf);
+    TF_ASSERT_OK(response.ParseFrom(&source));
+    EXPECT_EQ(is_dead, response.metadata().is_dead());
+    EXPECT_EQ(proto.send_start_micros(),
+              response.metadata().send_start_micros());
+    test::ExpectTensorEqual<T>(t, response.tensor());
+  }
+
+  std::unique_ptr<Device> device_;
+};
+
+TEST_F(GrpcTensorCodingTest, Small) {
+  Validate<float>(test::AsTensor<float>({1, 2, 3, 4}, {2, 2}), false);
+  Validate<int32>(test::AsTensor<int32>({-1}, {}), true);
+}
+
+TEST_F(GrpcTensorCodingTest, Large) {
+  // Large enough for the contents to be sent from the tensor's buffer.
+  Tensor t(DT_FLOAT, TensorShape({100, 100}));
+  test::FillIota<float>(&t, 0);
+  Validate<float>(t, false);
+}
+
+TEST_F(GrpcTensorCodingTest, Empty) {
+  Validate<float>(Tensor(DT_FLOAT, TensorShape({0, 10})), false);
+  // The value of a dead tensor is uninitialized.
+  Validate<float>(Tensor(DT_FLOAT), true);
+}
+
+TEST_F(GrpcTensorCodingTest, Strings) {
+  Validate<string>(test::AsTensor<string>({"a", "bc", "def"}, {3}), false);
+}
+
+TEST_F(GrpcTensorCodingTest, BufferOutlivesTensor) {
+  ::grpc::ByteBuffer buf;
+  {
+    Tensor t(DT_FLOAT, TensorShape({1000}));
+    test::FillFn<float>(&t, [](int i) -> float { return 2 * i; });
+    grpc::EncodeTensorToByteBuffer(false, t, &buf);
+  }
+  TensorResponse response;
+  response.InitAlloc(device_.get(), AllocatorAttributes());
+  grpc::GrpcByteBufferSource source(&buf);
+  TF_ASSERT_OK(response.ParseFrom(&source));
+  Tensor expected(DT_FLOAT, TensorShape({1000}));
+  test::FillFn<float>(&expected, [](int i) -> float { return 2 * i; });
+  test::ExpectTensorEqual<float>(expected, response.tensor());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -31,7 +31,9 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
 #include "tensorflow/core/distributed_runtime/rpc/async_service_interface.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_call.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/distributed_runtime/wire_encoding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -49,6 +51,29 @@ namespace {
 
 static Tensor empty_tensor(DT_FLOAT);
 
+// The generated WorkerService, plus a RecvTensor method whose response is
+// written as a ::grpc::ByteBuffer.  The buffer holds a serialized
+// RecvTensorResponse, so clients see the same method, but the contents
+// of the tensor are sent from its own buffer rather than copied into a
+// TensorProto.
+class WorkerServiceWithRawRecvTensor
+    : public grpc::WorkerService::AsyncService {
+ public:
+  void RequestRecvTensorRaw(
+      ::grpc::ServerContext* context, RecvTensorRequest* request,
+      ::grpc::ServerAsyncResponseWriter<::grpc::ByteBuffer>* response,
+      ::grpc::CompletionQueue* new_call_cq,
+      ::grpc::ServerCompletionQueue* notification_cq, void* tag) {
+    RequestAsyncUnary(kRecvTensorMethodIndex, context, request, response,
+                      new_call_cq, notification_cq, tag);
+  }
+
+ private:
+  // The index of RecvTensor among the methods of WorkerService in
+  // worker_service.proto.
+  static const int kRecvTensorMethodIndex = 6;
+};
+
 class GrpcWorkerService : public AsyncServiceInterface {
  public:
   GrpcWorkerService(WorkerEnv* env, ::grpc::ServerBuilder* builder)
@@ -99,7 +124,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
   do {                                                                        \
     mutex_lock l(shutdown_mu_);                                               \
     if (!is_shutdown_) {                                                      \
-      Call<GrpcWorkerService, grpc::WorkerService::AsyncService,              \
+      Call<GrpcWorkerService, WorkerServiceWithRawRecvTensor,                 \
            method##Request, method##Response>::                               \
           EnqueueRequest(&worker_service_, cq_,                               \
                          &grpc::WorkerService::AsyncService::Request##method, \
@@ -123,7 +148,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
     ENQUEUE_REQUEST(DeregisterGraph, false);
 
     // TODO(mrry): Consider enqueuing more of these request types.
-    ENQUEUE_REQUEST(RecvTensor, true);
+    EnqueueRecvTensorRequestRaw();
     ENQUEUE_REQUEST(RunGraph, true);
 
     ENQUEUE_REQUEST(CleanupGraph, false);
@@ -151,7 +176,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
   WorkerEnv* env_;                     // Not owned.
   ::grpc::ServerCompletionQueue* cq_;  // Owned.
 
-  grpc::WorkerService::AsyncService worker_service_;
+  WorkerServiceWithRawRecvTensor worker_service_;
 
   mutex mu_;
   CancellationManager* cancellation_manager_ GUARDED_BY(mu_);
@@ -168,7 +193,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
   // `ENQUEUE_REQUEST(Foo)`.
 
   template <class RequestMessage, class ResponseMessage>
-  using WorkerCall = Call<GrpcWorkerService, grpc::WorkerService::AsyncService,
+  using WorkerCall = Call<GrpcWorkerService, WorkerServiceWithRawRecvTensor,
                           RequestMessage, ResponseMessage>;
 
   void GetStatusHandler(WorkerCall<GetStatusRequest, GetStatusResponse>* call) {
@@ -221,10 +246,10 @@ class GrpcWorkerService : public AsyncServiceInterface {
     ENQUEUE_REQUEST(RunGraph, true);
   }
 
-  void RecvTensorHandler(
-      WorkerCall<RecvTensorRequest, RecvTensorResponse>* call) {
-    env_->compute_pool->Schedule([this, call]() { DoRecvTensor(call); });
-    ENQUEUE_REQUEST(RecvTensor, true);
+  void RecvTensorHandlerRaw(
+      WorkerCall<RecvTensorRequest, ::grpc::ByteBuffer>* call) {
+    env_->compute_pool->Schedule([this, call]() { DoRecvTensorRaw(call); });
+    EnqueueRecvTensorRequestRaw();
   }
 
   void CleanupGraphHandler(
@@ -254,6 +279,17 @@ class GrpcWorkerService : public AsyncServiceInterface {
   }
 #undef ENQUEUE_REQUEST
 
+  void EnqueueRecvTensorRequestRaw() {
+    mutex_lock l(shutdown_mu_);
+    if (!is_shutdown_) {
+      WorkerCall<RecvTensorRequest, ::grpc::ByteBuffer>::EnqueueRequest(
+          &worker_service_, cq_,
+          &WorkerServiceWithRawRecvTensor::RequestRecvTensorRaw,
+          &GrpcWorkerService::RecvTensorHandlerRaw,
+          true /* supports cancel*/);
+    }
+  }
+
  private:
   // The following section contains the implementation of RunGraph()
   // RecvTensor(), Logging(), and Tracing(), which are the four
@@ -367,7 +403,8 @@ class GrpcWorkerService : public AsyncServiceInterface {
     return Status::OK();
   }
 
-  void DoRecvTensor(WorkerCall<RecvTensorRequest, RecvTensorResponse>* call) {
+  void DoRecvTensorRaw(
+      WorkerCall<RecvTensorRequest, ::grpc::ByteBuffer>* call) {
     const int64 step_id = call->request.step_id();
     const string& key = call->request.rendezvous_key();
     TRACEPRINTF("RecvTensor: %lld %s", step_id, key.c_str());
@@ -391,6 +428,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
                               const Tensor& val, const bool is_dead) {
           call->ClearCancelCallback();
           Status s = status;
+          const WireOptions::Encoding encoding = call->request.encoding();
           if (s.ok()) {
             // DMA can only be used for Tensors that do not fall into
             // the following three odd edge cases: 1) a zero-size
@@ -401,12 +439,6 @@ class GrpcWorkerService : public AsyncServiceInterface {
             // const size_t bytes = is_dead ? 0 : val.TotalBytes();
             const bool on_host = send_args.alloc_attrs.on_host();
             const DeviceContext* send_dev_context = send_args.device_context;
-            call->response.set_is_dead(is_dead);
-            StatusCallback response_ready = [call](const Status& s) {
-              // The value is now ready to be returned on the wire.
-              call->response.set_send_start_micros(Env::Default()->NowMicros());
-              call->SendResponse(ToGrpcStatus(s));
-            };
             {
               // Non-DMA cases.
               if (src_dev->tensorflow_gpu_device_info() && (!on_host)) {
@@ -414,14 +446,33 @@ class GrpcWorkerService : public AsyncServiceInterface {
                     << "send dev name: " << src_dev->name()
                     << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
                 // "val" is on a GPU. Uses GPUUtil to fill the response proto.
+                RecvTensorResponse* tmp = new RecvTensorResponse;
+                tmp->set_is_dead(is_dead);
+                StatusCallback response_ready = [call, tmp](const Status& s) {
+                  // The value is now ready to be returned on the wire.
+                  tmp->set_send_start_micros(Env::Default()->NowMicros());
+                  grpc::EncodeRecvTensorResponseToByteBuffer(*tmp,
+                                                             &call->response);
+                  call->SendResponse(ToGrpcStatus(s));
+                  delete tmp;
+                };
                 GPUUtil::SetProtoFromGPU(val, src_dev, send_dev_context,
-                                         call->response.mutable_tensor(),
-                                         is_dead, response_ready);
+                                         tmp->mutable_tensor(), is_dead,
+                                         response_ready);
+              } else if (encoding != WireOptions::RAW && !is_dead) {
+                // "val" is in CPU memory, and the receiver asked for its
+                // contents to be encoded.  The response records the
+                // encoding actually used.
+                RecvTensorResponse tmp;
+                EncodeTensorContent(encoding, val, &tmp);
+                tmp.set_send_start_micros(Env::Default()->NowMicros());
+                grpc::EncodeRecvTensorResponseToByteBuffer(tmp,
+                                                           &call->response);
+                call->SendResponse(::grpc::Status::OK);
               } else {
-                // "val" is in CPU memory.
-                TensorProto* proto = call->response.mutable_tensor();
-                val.AsProtoTensorContent(proto);
-                response_ready(Status::OK());
+                // "val" is in CPU memory, and is sent from its own buffer.
+                grpc::EncodeTensorToByteBuffer(is_dead, val, &call->response);
+                call->SendResponse(::grpc::Status::OK);
               }
             }
           } else {
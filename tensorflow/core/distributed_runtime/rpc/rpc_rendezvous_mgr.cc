@@ -58,7 +58,8 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
   RpcRecvTensorCall(WorkerCacheInterface* wc, WorkerInterface* wi,
                        int64 step_id, const string& key,
                        const string& remote_dev, Allocator* allocator,
-                       Device* dst_device)
+                       Device* dst_device,
+                       const Rendezvous::Args& recv_args)
       : wi_(wi),
         wc_(wc),
         remote_dev_(remote_dev),
@@ -66,6 +67,10 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
         dst_(dst_device) {
     req_.set_step_id(step_id);
     req_.set_rendezvous_key(key);
+    req_.set_encoding(recv_args.wire_encoding);
+    // The received tensor is parsed straight into a buffer of the
+    // destination device.
+    resp_.InitAlloc(dst_device, recv_args.alloc_attrs);
   }
 
   ~RpcRecvTensorCall() override { delete wi_; }
@@ -87,17 +92,14 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     return status_;
   }
 
-  const TensorProto& tensor_proto() const { return resp_.tensor(); }
+  const Tensor& tensor() const { return resp_.tensor(); }
 
-  const RecvTensorResponse& response() const { return resp_; }
-
-  bool is_dead() const { return resp_.is_dead(); }
+  bool is_dead() const { return resp_.metadata().is_dead(); }
 
  private:
   // Start the main RecvTensor call, checking for an async abort.
   void StartRTCall(std::function<void()> recv_done) {
     wi_->RecvTensorAsync(&opts_, &req_, &resp_,
-                         nullptr /* TensorBufAllocator */,
                          // done callback
                          [this, recv_done](const Status& s) {
                            {
@@ -115,7 +117,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
   Device* dst_;
   CallOptions opts_;
   RecvTensorRequest req_;
-  RecvTensorResponse resp_;
+  TensorResponse resp_;
 
   mutable mutex mu_;
   Status status_ GUARDED_BY(mu_);
@@ -159,13 +161,14 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
   // Prepare a RecvTensor call that can handle being aborted.
   RpcRecvTensorCall* call =
       new RpcRecvTensorCall(worker_cache, rwi, step_id_, key,
-                               parsed.src_device, allocator, dst_device);
+                               parsed.src_device, allocator, dst_device,
+                               recv_args);
 
   // Record "call" in active_ so that it can be aborted cleanly.
   RegisterCall(call);
 
   // Start "call".
-  call->Start([this, call, parsed, recv_args, done]() {
+  call->Start([this, call, recv_args, done]() {
     // Removes "call" from active_. Prevent StartAbort().
     DeregisterCall(call);
     // If StartAbort was called prior to DeregisterCall, then the
@@ -173,12 +176,7 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
     Status s = call->status();
     Tensor val;
     if (s.ok()) {
-      Device* dst_device;
-      s = env_->device_mgr->LookupDevice(parsed.dst_device, &dst_device);
-      if (s.ok()) {
-        s = dst_device->MakeTensorFromProto(call->tensor_proto(),
-                                            recv_args.alloc_attrs, &val);
-      }
+      val = call->tensor();
     }
     done(s, Args(), recv_args, val, call->is_dead());
     delete call;
@@ -238,7 +238,8 @@ Status SimpleGraphExecutionState::BuildGraph(const BuildGraphOptions& options,
   // ops as needed.
   TF_RETURN_IF_ERROR(subgraph::RewriteGraphForExecution(
       &cgraph->graph, options.feed_endpoints, options.fetch_endpoints,
-      options.target_nodes, device_set_->client_device()->attributes()));
+      options.target_nodes, device_set_->client_device()->attributes(),
+      false));
 
   // Copy the extracted graph in order to make its node ids dense,
   // since the local CostModel used to record its stats is sized by
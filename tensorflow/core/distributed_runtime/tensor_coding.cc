@@ -0,0 +1,195 @@
+/* Copyright 2016 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+
+#include <limits.h>
+
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/distributed_runtime/wire_encoding.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Wire tags, (field number << 3) | wire type, of the fields of
+// RecvTensorResponse and TensorProto read by the fast path.
+enum {
+  kVarint = 0,
+  kLengthDelimited = 2,
+
+  kResponseTensorTag = (1 << 3) | kLengthDelimited,
+  kResponseIsDeadTag = (2 << 3) | kVarint,
+  kResponseSendStartMicrosTag = (3 << 3) | kVarint,
+
+  kTensorDtypeTag = (1 << 3) | kVarint,
+  kTensorShapeTag = (2 << 3) | kLengthDelimited,
+  kTensorContentTag = (4 << 3) | kLengthDelimited,
+};
+
+}  // namespace
+
+TensorResponse::Source::~Source() {}
+
+void TensorResponse::Clear() {
+  device_ = nullptr;
+  alloc_attrs_ = AllocatorAttributes();
+  allocator_ = nullptr;
+  on_host_ = false;
+  tensor_ = Tensor();
+  meta_.Clear();
+  wire_bytes_ = 0;
+}
+
+void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
+  Clear();
+  device_ = d;
+  alloc_attrs_ = aa;
+  allocator_ = device_->GetAllocator(alloc_attrs_);
+  on_host_ =
+      alloc_attrs_.on_host() || device_->tensorflow_gpu_device_info() == nullptr;
+}
+
+Status TensorResponse::ParseFrom(Source* source) {
+  CHECK(device_ != nullptr) << "InitAlloc() has not been called";
+  if (on_host_ && ParseFast(source)) {
+    return Status::OK();
+  }
+  return ParseSlow(source);
+}
+
+bool TensorResponse::ParseTensorSubmessage(
+    protobuf::io::CodedInputStream* input) {
+  DataType dtype = DT_INVALID;
+  TensorShapeProto shape_proto;
+  bool seen_shape = false;
+  bool seen_content = false;
+  while (true) {
+    const uint32 tag = input->ReadTag();
+    if (tag == 0) break;
+    switch (tag) {
+      case kTensorDtypeTag: {
+        uint32 v;
+        if (!input->ReadVarint32(&v)) return false;
+        if (!DataType_IsValid(v) || v == DT_INVALID) return false;
+        dtype = static_cast<DataType>(v);
+        if (!DataTypeCanUseMemcpy(dtype)) return false;
+        break;
+      }
+      case kTensorShapeTag: {
+        string serialized;
+        uint32 length;
+        if (!input->ReadVarint32(&length) ||
+            !input->ReadString(&serialized, length) ||
+            !shape_proto.ParseFromString(serialized) ||
+            !TensorShape::IsValid(shape_proto)) {
+          return false;
+        }
+        seen_shape = true;
+        break;
+      }
+      case kTensorContentTag: {
+        // Serializers write the fields in order, so the type and shape of
+        // the tensor are known before its contents.
+        if (dtype == DT_INVALID || !seen_shape) return false;
+        uint32 length;
+        if (!input->ReadVarint32(&length)) return false;
+        TensorShape shape(shape_proto);
+        if (length != shape.num_elements() * DataTypeSize(dtype)) {
+          return false;
+        }
+        tensor_ = Tensor(allocator_, dtype, shape);
+        if (length > 0 &&
+            !input->ReadRaw(DMAHelper::base(&tensor_), length)) {
+          return false;
+        }
+        seen_content = true;
+        break;
+      }
+      default:
+        // Values stored in the typed repeated fields, or fields this
+        // parser does not know about, are handled by the slow path.
+        return false;
+    }
+  }
+  if (!seen_content) {
+    // An empty tensor is serialized without contents.
+    if (dtype == DT_INVALID) return false;
+    TensorShape shape(shape_proto);
+    if (shape.num_elements() != 0) return false;
+    tensor_ = Tensor(allocator_, dtype, shape);
+  }
+  return true;
+}
+
+bool TensorResponse::ParseFast(Source* source) {
+  protobuf::io::CodedInputStream input(source->contents());
+  input.SetTotalBytesLimit(INT_MAX, INT_MAX);
+  while (true) {
+    const uint32 tag = input.ReadTag();
+    if (tag == 0) break;
+    switch (tag) {
+      case kResponseTensorTag: {
+        uint32 length;
+        if (!input.ReadVarint32(&length)) return false;
+        auto limit = input.PushLimit(length);
+        if (!ParseTensorSubmessage(&input) ||
+            !input.ConsumedEntireMessage()) {
+          return false;
+        }
+        input.PopLimit(limit);
+        break;
+      }
+      case kResponseIsDeadTag: {
+        uint32 v;
+        if (!input.ReadVarint32(&v)) return false;
+        meta_.set_is_dead(v != 0);
+        break;
+      }
+      case kResponseSendStartMicrosTag: {
+        protobuf::uint64 v;
+        if (!input.ReadVarint64(&v)) return false;
+        meta_.set_send_start_micros(static_cast<int64>(v));
+        break;
+      }
+      default:
+        // Including the fields of a response with encoded contents.
+        return false;
+    }
+  }
+  wire_bytes_ = input.CurrentPosition();
+  return input.ConsumedEntireMessage();
+}
+
+Status TensorResponse::ParseSlow(Source* source) {
+  meta_.Clear();
+  protobuf::io::CodedInputStream input(source->contents());
+  input.SetTotalBytesLimit(INT_MAX, INT_MAX);
+  if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
+    return errors::InvalidArgument("Cannot parse RecvTensorResponse");
+  }
+  wire_bytes_ = input.CurrentPosition();
+  TF_RETURN_IF_ERROR(DecodeTensorContent(&meta_));
+  Status s =
+      device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
+  // The contents now live in tensor_.
+  meta_.clear_tensor();
+  return s;
+}
+
+}  // namespace tensorflow
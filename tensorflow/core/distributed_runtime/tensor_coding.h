@@ -0,0 +1,93 @@
+/* Copyright 2016 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+
+// A RecvTensorResponse whose tensor is parsed straight from the
+// serialized response into a buffer allocated once, from the allocator
+// of the receiving device, instead of into a TensorProto that is then
+// copied into a Tensor.
+class TensorResponse {
+ public:
+  TensorResponse() {}
+
+  // Resets to the state before InitAlloc().
+  void Clear();
+
+  // The tensor is allocated on "d" with the attributes "aa".
+  void InitAlloc(DeviceBase* d, const AllocatorAttributes& aa);
+
+  // Provides the serialized bytes of a RecvTensorResponse, e.g. as
+  // received by an RPC implementation.
+  class Source {
+   public:
+    virtual ~Source();
+
+    // Returns a stream over the serialized response, from its
+    // beginning.  May be called more than once.  The stream is owned by
+    // the source.
+    virtual protobuf::io::ZeroCopyInputStream* contents() = 0;
+  };
+
+  // Parses the response in "source".  The contents of a tensor in host
+  // memory whose type can be copied with memcpy are read straight into
+  // the tensor's buffer; other tensors, and contents sent with a
+  // WireOptions encoding, are made by the device from a parsed (and
+  // decoded) TensorProto.
+  //
+  // REQUIRES: InitAlloc() has been called.
+  Status ParseFrom(Source* source);
+
+  // The received tensor.
+  const Tensor& tensor() const { return tensor_; }
+
+  // The fields of the response other than the tensor.
+  const RecvTensorResponse& metadata() const { return meta_; }
+
+  // The size of the parsed response, i.e. the bytes sent on the wire.
+  int64 wire_bytes() const { return wire_bytes_; }
+
+ private:
+  bool ParseFast(Source* source);
+  bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input);
+  Status ParseSlow(Source* source);
+
+  DeviceBase* device_ = nullptr;
+  AllocatorAttributes alloc_attrs_;
+  Allocator* allocator_ = nullptr;
+  // Whether the tensor may be written by the CPU.
+  bool on_host_ = false;
+  Tensor tensor_;
+  RecvTensorResponse meta_;
+  int64 wire_bytes_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(TensorResponse);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
@@ -0,0 +1,197 @@
+/* Copyright 2016 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/distributed_runtime/wire_encoding.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns a serialized string in chunks of at most "chunk_size" bytes, like
+// an RPC system returns a message in the buffers it was received in.
+class StringSource : public TensorResponse::Source {
+ public:
+  StringSource(const string* s, int chunk_size)
+      : s_(s), stream_(nullptr), chunk_size_(chunk_size) {}
+  ~StringSource() override { DeleteStream(); }
+
+  protobuf::io::ZeroCopyInputStream* contents() override {
+    DeleteStream();
+    stream_ = new Stream(s_, chunk_size_);
+    return stream_;
+  }
+
+ private:
+  class Stream : public protobuf::io::ZeroCopyInputStream {
+   public:
+    Stream(const string* s, int chunk_size)
+        : s_(s), pos_(0), chunk_size_(chunk_size) {}
+
+    bool Next(const void** data, int* size) override {
+      if (pos_ == s_->size()) return false;
+      *data = s_->data() + pos_;
+      *size = std::min<int>(chunk_size_, s_->size() - pos_);
+      pos_ += *size;
+      return true;
+    }
+    void BackUp(int count) override { pos_ -= count; }
+    bool Skip(int count) override {
+      if (pos_ + count > s_->size()) {
+        pos_ = s_->size();
+        return false;
+      }
+      pos_ += count;
+      return true;
+    }
+    protobuf::int64 ByteCount() const override { return pos_; }
+
+   private:
+    const string* s_;
+    size_t pos_;
+    const int chunk_size_;
+  };
+
+  void DeleteStream() {
+    delete stream_;
+    stream_ = nullptr;
+  }
+
+  const string* s_;
+  Stream* stream_;
+  const int chunk_size_;
+};
+
+class TensorResponseTest : public ::testing::Test {
+ protected:
+  TensorResponseTest()
+      : device_(DeviceFactory::NewDevice("CPU", {}, "/job:a/replica:0/task:0")) {
+  }
+
+  // Serializes "proto", parses it back and checks that the result holds
+  // "expected".
+  void RoundTrip(const RecvTensorResponse& proto, const Tensor& expected) {
+    string serialized;
+    ASSERT_TRUE(proto.SerializeToString(&serialized));
+    for (int chunk_size : {1, 7, 4096}) {
+      StringSource source(&serialized, chunk_size);
+      TensorResponse response;
+      response.InitAlloc(device_.get(), AllocatorAttributes());
+      TF_ASSERT_OK(response.ParseFrom(&source));
+      test::ExpectTensorEqual<float>(expected, response.tensor());
+      EXPECT_EQ(proto.is_dead(), response.metadata().is_dead());
+      EXPECT_EQ(proto.send_start_micros(),
+                response.metadata().send_start_micros());
+      EXPECT_FALSE(response.metadata().has_tensor());
+    }
+  }
+
+  std::unique_ptr<Device> device_;
+};
+
+TEST_F(TensorResponseTest, TensorContent) {
+  Tensor t = test::AsTensor<float>({1, 2, 3, 4, 5, 6}, {2, 3});
+  RecvTensorResponse proto;
+  t.AsProtoTensorContent(proto.mutable_tensor());
+  proto.set_is_dead(true);
+  proto.set_send_start_micros(12345);
+  RoundTrip(proto, t);
+}
+
+TEST_F(TensorResponseTest, RepeatedFieldValues) {
+  // Values outside tensor_content are parsed into a TensorProto first.
+  Tensor t = test::AsTensor<float>({1, 2, 3}, {3});
+  RecvTensorResponse proto;
+  t.AsProtoField(proto.mutable_tensor());
+  RoundTrip(proto, t);
+}
+
+TEST_F(TensorResponseTest, Empty) {
+  Tensor t(DT_FLOAT, TensorShape({0, 4}));
+  RecvTensorResponse proto;
+  t.AsProtoTensorContent(proto.mutable_tensor());
+  RoundTrip(proto, t);
+}
+
+TEST_F(TensorResponseTest, Strings) {
+  Tensor t = test::AsTensor<string>({"a", "bc", "def"}, {3});
+  RecvTensorResponse proto;
+  t.AsProtoTensorContent(proto.mutable_tensor());
+  string serialized;
+  ASSERT_TRUE(proto.SerializeToString(&serialized));
+  StringSource source(&serialized, 2);
+  TensorResponse response;
+  response.InitAlloc(device_.get(), AllocatorAttributes());
+  TF_ASSERT_OK(response.ParseFrom(&source));
+  test::ExpectTensorEqual<string>(t, response.tensor());
+}
+
+TEST_F(TensorResponseTest, EncodedContent) {
+  Tensor t(DT_FLOAT, TensorShape({1000}));
+  test::FillFn<float>(&t, [](int i) -> float { return 2 * (i % 256); });
+  RecvTensorResponse proto;
+  EncodeTensorContent(WireOptions::QUANTIZED_8BIT, t, &proto);
+  ASSERT_EQ(WireOptions::QUANTIZED_8BIT, proto.encoding());
+  string serialized;
+  ASSERT_TRUE(proto.SerializeToString(&serialized));
+  StringSource source(&serialized, 100);
+  TensorResponse response;
+  response.InitAlloc(device_.get(), AllocatorAttributes());
+  TF_ASSERT_OK(response.ParseFrom(&source));
+  // The values are multiples of the quantization step, so they are exact.
+  test::ExpectTensorEqual<float>(t, response.tensor());
+  EXPECT_EQ(WireOptions::RAW, response.metadata().encoding());
+  EXPECT_EQ(serialized.size(), response.wire_bytes());
+  EXPECT_LT(response.wire_bytes(), t.TotalBytes());
+}
+
+TEST_F(TensorResponseTest, ContentSizeMismatch) {
+  RecvTensorResponse proto;
+  test::AsTensor<float>({1, 2, 3}, {3})
+      .AsProtoTensorContent(proto.mutable_tensor());
+  proto.mutable_tensor()->mutable_tensor_content()->resize(8);
+  string serialized;
+  ASSERT_TRUE(proto.SerializeToString(&serialized));
+  StringSource source(&serialized, 4096);
+  TensorResponse response;
+  response.InitAlloc(device_.get(), AllocatorAttributes());
+  EXPECT_FALSE(response.ParseFrom(&source).ok());
+}
+
+TEST_F(TensorResponseTest, Truncated) {
+  RecvTensorResponse proto;
+  test::AsTensor<float>({1, 2, 3}, {3})
+      .AsProtoTensorContent(proto.mutable_tensor());
+  string serialized;
+  ASSERT_TRUE(proto.SerializeToString(&serialized));
+  serialized.resize(serialized.size() - 1);
+  StringSource source(&serialized, 4096);
+  TensorResponse response;
+  response.InitAlloc(device_.get(), AllocatorAttributes());
+  EXPECT_FALSE(response.ParseFrom(&source).ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,181 @@
+/* Copyright 2016 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/wire_encoding.h"
+
+#include <math.h>
+#include <algorithm>
+
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/snappy.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Contents smaller than this are sent raw: the encoding would save
+// little, and costs the receiver a parse of the response into a proto.
+const size_t kMinEncodedBytes = 1024;
+
+// Stores "contents" compressed in "*out".  Returns false if snappy is
+// not available or the contents do not compress.
+bool SnappyEncode(StringPiece contents, string* out) {
+  return port::Snappy_Compress(contents.data(), contents.size(), out) &&
+         out->size() < contents.size();
+}
+
+// Stores each of the "n" values of "data" in "*out" as one byte, an
+// index into 256 evenly spaced values between their minimum "*min" and
+// maximum "*max".  Returns false if any value, or the range of the
+// values, is not finite.
+bool Quantize8Bit(const float* data, int64 n, string* out, float* min,
+                  float* max) {
+  float lo = data[0];
+  float hi = data[0];
+  for (int64 i = 0; i < n; ++i) {
+    if (!isfinite(data[i])) return false;
+    lo = std::min(lo, data[i]);
+    hi = std::max(hi, data[i]);
+  }
+  // The decoder steps by (hi - lo) / 255, which overflows for values
+  // near both ends of the float range.  The encoder's scale overflows in
+  // turn for ranges narrower than about 1e-36.
+  if (!isfinite(hi - lo)) return false;
+  const float scale = (hi > lo) ? 255.0f / (hi - lo) : 0.0f;
+  if (!isfinite(scale)) return false;
+  out->resize(n);
+  uint8* q = reinterpret_cast<uint8*>(&(*out)[0]);
+  for (int64 i = 0; i < n; ++i) {
+    q[i] = static_cast<uint8>(roundf((data[i] - lo) * scale));
+  }
+  *min = lo;
+  *max = hi;
+  return true;
+}
+
+}  // namespace
+
+WireOptions::Encoding EdgeWireEncoding(const WireOptions& options,
+                                       const Edge* edge) {
+  const string& name = edge->src()->name();
+  for (const string& prefix : options.lossy_name_prefixes()) {
+    if (StringPiece(name).starts_with(prefix)) {
+      return options.lossy_encoding();
+    }
+  }
+  return options.encoding();
+}
+
+void EncodeTensorContent(WireOptions::Encoding encoding, const Tensor& val,
+                         RecvTensorResponse* response) {
+  TensorProto* proto = response->mutable_tensor();
+  response->set_encoding(WireOptions::RAW);
+  const StringPiece contents = val.tensor_data();
+  if (!DataTypeCanUseMemcpy(val.dtype()) ||
+      contents.size() < kMinEncodedBytes) {
+    val.AsProtoTensorContent(proto);
+    return;
+  }
+
+  string encoded;
+  float min = 0;
+  float max = 0;
+  bool ok = false;
+  switch (encoding) {
+    case WireOptions::SNAPPY:
+      ok = SnappyEncode(contents, &encoded);
+      break;
+    case WireOptions::QUANTIZED_8BIT:
+      ok = val.dtype() == DT_FLOAT &&
+           Quantize8Bit(val.flat<float>().data(), val.NumElements(), &encoded,
+                        &min, &max);
+      break;
+    default:
+      break;
+  }
+  if (!ok) {
+    val.AsProtoTensorContent(proto);
+    return;
+  }
+
+  proto->Clear();
+  proto->set_dtype(val.dtype());
+  val.shape().AsProto(proto->mutable_tensor_shape());
+  proto->mutable_tensor_content()->swap(encoded);
+  response->set_encoding(encoding);
+  if (encoding == WireOptions::QUANTIZED_8BIT) {
+    response->set_quantized_min(min);
+    response->set_quantized_max(max);
+  }
+}
+
+Status DecodeTensorContent(RecvTensorResponse* response) {
+  const WireOptions::Encoding encoding = response->encoding();
+  TensorProto* proto = response->mutable_tensor();
+  string* content = proto->mutable_tensor_content();
+  string decoded;
+  switch (encoding) {
+    case WireOptions::RAW:
+    case WireOptions::BFLOAT16:
+      return Status::OK();
+    case WireOptions::SNAPPY: {
+      size_t length;
+      if (!port::Snappy_GetUncompressedLength(content->data(),
+                                              content->size(), &length)) {
+        return errors::InvalidArgument("Cannot decode snappy tensor content");
+      }
+      decoded.resize(length);
+      if (length > 0 &&
+          !port::Snappy_Uncompress(content->data(), content->size(),
+                                   &decoded[0])) {
+        return errors::InvalidArgument("Cannot decode snappy tensor content");
+      }
+      break;
+    }
+    case WireOptions::QUANTIZED_8BIT: {
+      if (proto->dtype() != DT_FLOAT ||
+          !TensorShape::IsValid(proto->tensor_shape())) {
+        return errors::InvalidArgument("Bad quantized tensor");
+      }
+      const int64 n = TensorShape(proto->tensor_shape()).num_elements();
+      if (static_cast<int64>(content->size()) != n) {
+        return errors::InvalidArgument("Quantized tensor has ",
+                                       content->size(), " bytes for ", n,
+                                       " values");
+      }
+      const float min = response->quantized_min();
+      const float scale = (response->quantized_max() - min) / 255.0f;
+      decoded.resize(n * sizeof(float));
+      const uint8* q = reinterpret_cast<const uint8*>(content->data());
+      float* out = reinterpret_cast<float*>(&decoded[0]);
+      for (int64 i = 0; i < n; ++i) {
+        out[i] = min + q[i] * scale;
+      }
+      response->clear_quantized_min();
+      response->clear_quantized_max();
+      break;
+    }
+    default:
+      return errors::InvalidArgument("Unknown wire encoding ", encoding);
+  }
+  content->swap(decoded);
+  response->set_encoding(WireOptions::RAW);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
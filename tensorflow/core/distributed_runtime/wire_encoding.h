@@ -0,0 +1,51 @@
+/* Copyright 2016 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_WIRE_ENCODING_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_WIRE_ENCODING_H_
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+
+// Returns the encoding that "options" selects for the tensors sent
+// along "edge": the lossy encoding if the name of the edge's source
+// node starts with one of the lossy name prefixes, and the default
+// encoding otherwise.
+WireOptions::Encoding EdgeWireEncoding(const WireOptions& options,
+                                       const Edge* edge);
+
+// Stores "val" in the tensor of "*response", with its contents encoded
+// as "encoding" asks if that is possible and makes them smaller.  Sets
+// "response->encoding()" to the encoding actually used, which may be RAW.
+//
+// Only SNAPPY and QUANTIZED_8BIT change the contents; BFLOAT16 is
+// applied by casts added to the graph when it is partitioned.
+void EncodeTensorContent(WireOptions::Encoding encoding, const Tensor& val,
+                         RecvTensorResponse* response);
+
+// Restores the raw tensor_content of "*response" from the encoding
+// recorded in it by EncodeTensorContent(), and resets the encoding to
+// RAW.  QUANTIZED_8BIT is lossy, so the values are only approximately
+// those that were sent.
+Status DecodeTensorContent(RecvTensorResponse* response);
+
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_WIRE_ENCODING_H_
@@ -0,0 +1,157 @@
+/* Copyright 2016 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/wire_encoding.h"
+
+#include <limits>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/snappy.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Encodes "val", checks the encoding used and returns the decoded tensor.
+Tensor RoundTrip(WireOptions::Encoding encoding, const Tensor& val,
+                 WireOptions::Encoding expected_encoding) {
+  RecvTensorResponse response;
+  EncodeTensorContent(encoding, val, &response);
+  EXPECT_EQ(expected_encoding, response.encoding());
+  RecvTensorResponse copy;
+  EXPECT_TRUE(copy.ParseFromString(response.SerializeAsString()));
+  TF_EXPECT_OK(DecodeTensorContent(&copy));
+  EXPECT_EQ(WireOptions::RAW, copy.encoding());
+  Tensor result;
+  EXPECT_TRUE(result.FromProto(copy.tensor()));
+  return result;
+}
+
+TEST(WireEncodingTest, EdgeWireEncoding) {
+  Graph g(OpRegistry::Global());
+  Tensor t = test::AsTensor<float>({1, 2}, {2});
+  Node* grad = test::graph::Constant(&g, t, "gradients/w");
+  Node* act = test::graph::Constant(&g, t, "layer1/relu");
+  Node* sum = test::graph::Add(&g, grad, act);
+  const Edge* grad_edge = nullptr;
+  const Edge* act_edge = nullptr;
+  for (const Edge* e : sum->in_edges()) {
+    if (e->src() == grad) grad_edge = e;
+    if (e->src() == act) act_edge = e;
+  }
+  ASSERT_NE(nullptr, grad_edge);
+  ASSERT_NE(nullptr, act_edge);
+
+  WireOptions options;
+  EXPECT_EQ(WireOptions::RAW, EdgeWireEncoding(options, grad_edge));
+  options.set_encoding(WireOptions::SNAPPY);
+  options.set_lossy_encoding(WireOptions::QUANTIZED_8BIT);
+  options.add_lossy_name_prefixes("gradients/");
+  EXPECT_EQ(WireOptions::QUANTIZED_8BIT, EdgeWireEncoding(options, grad_edge));
+  EXPECT_EQ(WireOptions::SNAPPY, EdgeWireEncoding(options, act_edge));
+}
+
+TEST(WireEncodingTest, SmallTensorsAreRaw) {
+  Tensor t = test::AsTensor<float>({1, 2, 3, 4}, {2, 2});
+  test::ExpectTensorEqual<float>(
+      t, RoundTrip(WireOptions::SNAPPY, t, WireOptions::RAW));
+  test::ExpectTensorEqual<float>(
+      t, RoundTrip(WireOptions::QUANTIZED_8BIT, t, WireOptions::RAW));
+}
+
+TEST(WireEncodingTest, Snappy) {
+  Tensor t(DT_FLOAT, TensorShape({64, 64}));
+  test::FillFn<float>(&t, [](int i) -> float { return i % 8; });
+  string compressed;
+  const bool have_snappy = port::Snappy_Compress("abc", 3, &compressed);
+  test::ExpectTensorEqual<float>(
+      t, RoundTrip(WireOptions::SNAPPY, t,
+                   have_snappy ? WireOptions::SNAPPY : WireOptions::RAW));
+}
+
+TEST(WireEncodingTest, Quantized8Bit) {
+  Tensor t(DT_FLOAT, TensorShape({1000}));
+  test::FillFn<float>(&t, [](int i) -> float { return (i % 511) - 255; });
+  RecvTensorResponse response;
+  EncodeTensorContent(WireOptions::QUANTIZED_8BIT, t, &response);
+  EXPECT_EQ(WireOptions::QUANTIZED_8BIT, response.encoding());
+  EXPECT_EQ(1000, response.tensor().tensor_content().size());
+  EXPECT_EQ(-255, response.quantized_min());
+  EXPECT_EQ(255, response.quantized_max());
+
+  // Each value is within half a step of the original.
+  Tensor result = RoundTrip(WireOptions::QUANTIZED_8BIT, t,
+                            WireOptions::QUANTIZED_8BIT);
+  test::ExpectTensorNear<float>(t, result, 1.0);
+}
+
+TEST(WireEncodingTest, Quantized8BitConstant) {
+  Tensor t(DT_FLOAT, TensorShape({1000}));
+  test::FillFn<float>(&t, [](int i) -> float { return 3.5; });
+  test::ExpectTensorEqual<float>(
+      t, RoundTrip(WireOptions::QUANTIZED_8BIT, t,
+                   WireOptions::QUANTIZED_8BIT));
+}
+
+TEST(WireEncodingTest, Quantized8BitFallsBackToRaw) {
+  // Only finite float values are quantized.
+  Tensor ints(DT_INT32, TensorShape({1000}));
+  test::FillIota<int32>(&ints, 0);
+  test::ExpectTensorEqual<int32>(
+      ints, RoundTrip(WireOptions::QUANTIZED_8BIT, ints, WireOptions::RAW));
+
+  Tensor floats(DT_FLOAT, TensorShape({1000}));
+  test::FillIota<float>(&floats, 0);
+  floats.flat<float>()(7) = std::numeric_limits<float>::infinity();
+  test::ExpectTensorEqual<float>(
+      floats,
+      RoundTrip(WireOptions::QUANTIZED_8BIT, floats, WireOptions::RAW));
+
+  // Nor are finite values whose range overflows.
+  floats.flat<float>()(7) = 2e38f;
+  floats.flat<float>()(8) = -2e38f;
+  test::ExpectTensorEqual<float>(
+      floats,
+      RoundTrip(WireOptions::QUANTIZED_8BIT, floats, WireOptions::RAW));
+
+  // Nor are those whose range is too narrow to scale to 255 steps.
+  floats.flat<float>().setZero();
+  floats.flat<float>()(7) = 1e-38f;
+  test::ExpectTensorEqual<float>(
+      floats,
+      RoundTrip(WireOptions::QUANTIZED_8BIT, floats, WireOptions::RAW));
+}
+
+TEST(WireEncodingTest, Strings) {
+  Tensor t(DT_STRING, TensorShape({100}));
+  test::FillFn<string>(&t, [](int i) -> string { return string(20, 'a'); });
+  test::ExpectTensorEqual<string>(
+      t, RoundTrip(WireOptions::SNAPPY, t, WireOptions::RAW));
+}
+
+TEST(WireEncodingTest, BadQuantizedContent) {
+  RecvTensorResponse response;
+  response.set_encoding(WireOptions::QUANTIZED_8BIT);
+  Tensor t(DT_FLOAT, TensorShape({10}));
+  t.AsProtoTensorContent(response.mutable_tensor());
+  EXPECT_FALSE(DecodeTensorContent(&response).ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -27,6 +27,14 @@ namespace {
 // Maximum number of step_ids for which RPC logs can be maintained.
 // TODO(mrry): Make this configurable if necessary.
 const int32 kWorkerCacheLoggerLimit = 1 << 10;
+
+// Returns "bytes" in a form that is readable in a timeline.
+string ByteString(int64 bytes) {
+  if (bytes >= 0.1 * 1048576.0) {
+    return strings::Printf("%.1fMB", bytes / 1048576.0);
+  }
+  return strings::StrCat(bytes, "B");
+}
 }  // namespace
 
 void WorkerCacheLogger::SetLogging(bool v) {
@@ -85,13 +93,15 @@ void WorkerCacheLogger::RecordRecvTensor(int64 step_id, int64 start_usecs,
                                          const string& tensor_name,
                                          const string& src_device,
                                          const string& dst_device,
-                                         int64 bytes) {
+                                         int64 bytes,
+                                         int64 wire_bytes) {
   NodeExecStats* ns = new NodeExecStats;
   ns->set_node_name("RecvTensor");
-  string byte_string = strings::StrCat("[", bytes, "B] ");
-  if (bytes >= 0.1 * 1048576.0) {
-    byte_string = strings::Printf("[%.1fMB] ", bytes / 1048576.0);
+  string byte_string = strings::StrCat("[", ByteString(bytes));
+  if (wire_bytes > 0 && wire_bytes < bytes) {
+    strings::StrAppend(&byte_string, ", ", ByteString(wire_bytes), " on wire");
   }
+  byte_string.append("] ");
   ns->set_timeline_label(strings::StrCat(byte_string, tensor_name, " from ",
                                          src_device, " to ", dst_device));
   ns->set_all_start_micros(start_usecs);
@@ -55,10 +55,13 @@ class WorkerCacheLogger {
   }
 
   // Generates a NodeExecStats record with the given data, and saves for
-  // later retrieval by RetrieveLogs().
+  // later retrieval by RetrieveLogs().  "bytes" is the size of the
+  // received tensor, and "wire_bytes" the size of the response that
+  // carried it, which is smaller if its contents were encoded.
   void RecordRecvTensor(int64 step_id, int64 start_usecs, int64 end_usecs,
                         const string& tensor_name, const string& src_device,
-                        const string& dst_device, int64 bytes);
+                        const string& dst_device, int64 bytes,
+                        int64 wire_bytes);
 
  private:
   mutex count_mu_;
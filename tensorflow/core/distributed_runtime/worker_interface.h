@@ -19,6 +19,7 @@ limitations under the License.
 #include <functional>
 
 #include "tensorflow/core/distributed_runtime/call_options.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/types.h"
@@ -29,11 +30,6 @@ namespace tensorflow {
 // Status callback.
 typedef std::function<void(const Status&)> StatusCallback;
 
-// Allocator callback for out-of-band transfers.
-class TensorShape;
-typedef std::function<void*(size_t, const DataType&, const TensorShape&)>
-    TensorBufAllocator;
-
 // Interface for talking with the TensorFlow Worker service.
 class WorkerInterface {
  public:
@@ -63,10 +59,11 @@ class WorkerInterface {
                                CleanupAllResponse* response,
                                StatusCallback done) = 0;
 
+  // The tensor in "response" is allocated as set up by
+  // response->InitAlloc(), which must have been called.
   virtual void RecvTensorAsync(CallOptions* opts,
                                const RecvTensorRequest* request,
-                               RecvTensorResponse* response,
-                               TensorBufAllocator allocator,
+                               TensorResponse* response,
                                StatusCallback done) = 0;
 
   virtual void LoggingAsync(const LoggingRequest* request,
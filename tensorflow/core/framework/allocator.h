@@ -194,6 +194,7 @@ class Allocator {
   struct is_simple {
     static const bool value = std::is_trivial<T>::value ||
                               std::is_same<T, Eigen::half>::value ||
+                              std::is_same<T, bfloat16>::value ||
                               std::is_same<T, complex64>::value ||
                               std::is_same<T, complex128>::value ||
                               is_quantized<T>::value;
@@ -208,8 +208,12 @@ OpKernelContext::~OpKernelContext() {
 }
 
 Allocator* OpKernelContext::get_allocator(AllocatorAttributes attr) {
-  Allocator* allocator =
-      params_->device->GetStepAllocator(attr, step_resource_manager());
+  return wrap_allocator(
+      params_->device->GetStepAllocator(attr, step_resource_manager()), attr);
+}
+
+Allocator* OpKernelContext::wrap_allocator(Allocator* allocator,
+                                           AllocatorAttributes attr) {
   if (params_->track_allocations) {
     mutex_lock lock(mu_);
     for (const auto& wrapped : wrapped_allocators_) {
@@ -433,7 +437,13 @@ Status OpKernelContext::allocate_output(StringPiece name,
 Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
     AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+  return allocate_tensor(get_allocator(attr), type, shape, out_tensor,
+                         allocation_attr);
+}
+
+Status OpKernelContext::allocate_tensor(
+    Allocator* a, DataType type, const TensorShape& shape, Tensor* out_tensor,
+    const AllocationAttributes& allocation_attr) {
   AllocationAttributes logged_attr(allocation_attr);
   logged_attr.allocation_will_be_logged = true;
   Tensor new_tensor(a, type, shape, logged_attr);
@@ -460,7 +470,15 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
   DCHECK(!IsRefType(type));
   DCHECK(mutable_output(index) == nullptr);
   Tensor* output_tensor = new Tensor();
-  Status s = allocate_tensor(type, shape, output_tensor, attr);
+  Allocator* planned = nullptr;
+  if (params_->output_allocator_array != nullptr &&
+      attr.value == output_alloc_attr(index).value) {
+    planned = params_->output_allocator_array[index];
+  }
+  Status s = planned == nullptr
+                 ? allocate_tensor(type, shape, output_tensor, attr)
+                 : allocate_tensor(wrap_allocator(planned, attr), type, shape,
+                                   output_tensor, AllocationAttributes());
   if (s.ok()) {
     outputs_[index] = TensorValue(output_tensor);
     *output = outputs_[index].tensor;
@@ -468,6 +486,55 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
   return s;
 }
 
+bool OpKernelContext::forward_input_to_output(int input_index,
+                                              int output_index,
+                                              const TensorShape& output_shape,
+                                              Tensor** output) {
+  DCHECK_GE(input_index, 0);
+  DCHECK_LT(input_index, num_inputs());
+  DCHECK_GE(output_index, 0);
+  DCHECK_LT(output_index, outputs_.size());
+  const TensorValue& value = (*params_->inputs)[input_index];
+  if (value.tensor == nullptr || value.is_ref()) return false;
+  const Tensor& input = *value.tensor;
+  const DataType type = params_->op_kernel->output_type(output_index);
+  DCHECK(!IsRefType(type));
+  DCHECK(mutable_output(output_index) == nullptr);
+  if (input.dtype() != type &&
+      (!DataTypeCanUseMemcpy(input.dtype()) || !DataTypeCanUseMemcpy(type) ||
+       DataTypeSize(input.dtype()) != DataTypeSize(type))) {
+    return false;
+  }
+  if (input.NumElements() != output_shape.num_elements()) return false;
+  if (params_->op_kernel->input_memory_types()[input_index] !=
+      params_->op_kernel->output_memory_types()[output_index]) {
+    return false;
+  }
+  // Callers that do not give the input attributes allocate every input
+  // with the default attributes.
+  const AllocatorAttributes input_attr =
+      params_->input_alloc_attrs == nullptr ? AllocatorAttributes()
+                                            : input_alloc_attr(input_index);
+  if (input_attr.value != output_alloc_attr(output_index).value) return false;
+  if (!input.RefCountIsOne()) return false;
+  outputs_[output_index] =
+      TensorValue(new Tensor(type, output_shape, input.buf_));
+  *output = outputs_[output_index].tensor;
+  return true;
+}
+
+Status OpKernelContext::forward_input_or_allocate_output(
+    gtl::ArraySlice<int> candidate_input_indices, int output_index,
+    const TensorShape& output_shape, Tensor** output) {
+  for (int input_index : candidate_input_indices) {
+    if (forward_input_to_output(input_index, output_index, output_shape,
+                                output)) {
+      return Status::OK();
+    }
+  }
+  return allocate_output(output_index, output_shape, output);
+}
+
 Status OpKernelContext::allocate_temp(
     DataType type, const TensorShape& shape, Tensor* out_temp,
     AllocatorAttributes allocator_attr,
@@ -41,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/framework/unique_tensor_references.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
@@ -492,6 +493,12 @@ class OpKernelContext {
     // Array indexed by output number for this node
     const AllocatorAttributes* output_attr_array = nullptr;
 
+    // If not nullptr, array indexed by output number for this node of the
+    // allocators that outputs allocated with the attributes in
+    // output_attr_array come from, instead of the device's allocator.
+    // Entries may be nullptr.
+    Allocator* const* output_allocator_array = nullptr;
+
     // Shared resources accessible by this op kernel invocation.
     ResourceMgr* resource_manager = nullptr;
 
@@ -727,6 +734,33 @@ class OpKernelContext {
                          Tensor** tensor,
                          AllocatorAttributes attr) TF_MUST_USE_RESULT;
 
+  // Kernels that compute an output elementwise from an input of the same
+  // size may write the output over the input when no other tensor can
+  // observe the input's buffer, e.g. because this kernel is the last
+  // consumer of the input in the step.  The executor holds one reference
+  // on an input's buffer for each pending consumer, so the buffer is
+  // unshared exactly when this kernel is its last consumer.
+  //
+  // Tries to use the buffer of input "input_index" as output
+  // "output_index" with shape "output_shape".  The buffer is forwarded
+  // only if the input is not a reference, its buffer is unshared, it has
+  // the same number of elements as the output and elements of the same
+  // size, and the input and output have the same memory type and
+  // allocator attributes.  Returns true and sets "*output" if the buffer
+  // was forwarded; the output may still hold the values of the input.
+  //
+  // REQUIRES: !IsRefType(expected_output_dtype(output_index))
+  bool forward_input_to_output(int input_index, int output_index,
+                               const TensorShape& output_shape,
+                               Tensor** output);
+
+  // Forwards the first of "candidate_input_indices" that
+  // forward_input_to_output() accepts to output "output_index", or
+  // allocates the output as allocate_output() does if none is accepted.
+  Status forward_input_or_allocate_output(
+      gtl::ArraySlice<int> candidate_input_indices, int output_index,
+      const TensorShape& output_shape, Tensor** output) TF_MUST_USE_RESULT;
+
   // Allocates a temporary Tensor of the specified type and
   // shape. Devices such as GPUs that enqueue Ops for lazy execution
   // may retain references to the temporary tensors after the Op's
@@ -922,6 +956,8 @@ class OpKernelContext {
 
  private:
   Allocator* get_allocator(AllocatorAttributes attr);
+  // Returns "allocator", wrapped to track its allocations if requested.
+  Allocator* wrap_allocator(Allocator* allocator, AllocatorAttributes attr);
 
   // Internal method to add a tensor's buffer to the list of buffers
   // referenced during the execution of the Op, so that GPUs may
@@ -942,6 +978,10 @@ class OpKernelContext {
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
                          const AllocationAttributes& allocation_attr);
 
+  Status allocate_tensor(Allocator* allocator, DataType type,
+                         const TensorShape& shape, Tensor* out_tensor,
+                         const AllocationAttributes& allocation_attr);
+
   // This is called by PersistentTensor::AccessTensor whenever the
   // wrapped tensor is retrieved, to ensure the runtime knows that the
   // Tensor is being accessed within an Op. This is necessary for
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/version.h"
@@ -98,6 +99,15 @@ REGISTER_OP("Test4").Input("i: float").Output("o: float");
 REGISTER_KERNEL_BUILDER(Name("Test4").Device(DEVICE_CPU), DummyKernel);
 REGISTER_KERNEL_BUILDER(Name("Test4").Device(DEVICE_GPU), DummyKernel);
 
+// An Op whose output may reuse the buffer of any of its inputs.
+REGISTER_OP("Test5")
+    .Input("a: float")
+    .Input("b: int32")
+    .Input("c: double")
+    .Input("d: Ref(float)")
+    .Output("o: float");
+REGISTER_KERNEL_BUILDER(Name("Test5").Device(DEVICE_CPU), DummyKernel);
+
 static std::vector<DeviceType> DeviceTypes() {
   return {DeviceType(DEVICE_GPU), DeviceType(DEVICE_CPU)};
 }
@@ -332,6 +342,78 @@ TEST_F(OpKernelTest, SaveTempTrue) {
   delete params.device;
 }
 
+class ForwardInputTest : public OpKernelTest {
+ protected:
+  ForwardInputTest()
+      : a_(DT_FLOAT, TensorShape({2, 3})),
+        b_(DT_INT32, TensorShape({2, 3})),
+        c_(DT_DOUBLE, TensorShape({2, 3})),
+        d_(DT_FLOAT, TensorShape({2, 3})),
+        device_(Env::Default(), false) {
+    Status status;
+    op_ = CreateOpKernel(
+        DEVICE_CPU, &device_, cpu_allocator(),
+        CreateNodeDef("Test5", {DT_FLOAT, DT_INT32, DT_DOUBLE, DT_FLOAT_REF}),
+        TF_GRAPH_DEF_VERSION, &status);
+    TF_CHECK_OK(status);
+    inputs_ = {&a_, &b_, &c_, TensorValue(&mu_, &d_)};
+    params_.device = &device_;
+    params_.op_kernel = op_.get();
+    params_.inputs = &inputs_;
+    params_.output_attr_array = &output_attr_;
+    ctx_.reset(new OpKernelContext(&params_));
+  }
+
+  Tensor a_;
+  Tensor b_;
+  Tensor c_;
+  Tensor d_;
+  mutex mu_;
+  DummyDevice device_;
+  std::unique_ptr<OpKernel> op_;
+  gtl::InlinedVector<TensorValue, 4> inputs_;
+  AllocatorAttributes output_attr_;
+  OpKernelContext::Params params_;
+  std::unique_ptr<OpKernelContext> ctx_;
+};
+
+TEST_F(ForwardInputTest, ForwardsUnsharedInput) {
+  Tensor* output = nullptr;
+  // Different element size.
+  EXPECT_FALSE(ctx_->forward_input_to_output(2, 0, a_.shape(), &output));
+  // Reference input.
+  EXPECT_FALSE(ctx_->forward_input_to_output(3, 0, a_.shape(), &output));
+  // Different number of elements.
+  EXPECT_FALSE(ctx_->forward_input_to_output(0, 0, TensorShape({3}), &output));
+  {
+    Tensor shared = a_;
+    EXPECT_FALSE(ctx_->forward_input_to_output(0, 0, a_.shape(), &output));
+  }
+  EXPECT_TRUE(output == nullptr);
+  EXPECT_TRUE(ctx_->forward_input_to_output(0, 0, TensorShape({6}), &output));
+  ASSERT_TRUE(output != nullptr);
+  EXPECT_TRUE(output->SharesBufferWith(a_));
+  EXPECT_EQ(TensorShape({6}), output->shape());
+  EXPECT_EQ(output, ctx_->mutable_output(0));
+}
+
+TEST_F(ForwardInputTest, ForwardsInputOfSameWidth) {
+  Tensor* output = nullptr;
+  TF_EXPECT_OK(ctx_->forward_input_or_allocate_output({3, 2, 1}, 0,
+                                                      b_.shape(), &output));
+  EXPECT_TRUE(output->SharesBufferWith(b_));
+  EXPECT_EQ(DT_FLOAT, output->dtype());
+}
+
+TEST_F(ForwardInputTest, AllocatesSharedInput) {
+  Tensor shared = a_;
+  Tensor* output = nullptr;
+  TF_EXPECT_OK(
+      ctx_->forward_input_or_allocate_output({0}, 0, a_.shape(), &output));
+  EXPECT_FALSE(output->SharesBufferWith(a_));
+  EXPECT_EQ(a_.shape(), output->shape());
+}
+
 class OpKernelBuilderTest : public ::testing::Test {
  protected:
   // Each attr is described by a "name|type|value".
@@ -94,6 +94,10 @@ limitations under the License.
   m(quint8);                       \
   m(qint32)
 
+// Call "m" on the 16-bit float type, for the CPU kernels that store half
+// and compute in float.
+#define TF_CALL_half(m) m(Eigen::half)
+
 #elif defined(__ANDROID_TYPES_FULL__)
 
 #define TF_CALL_REAL_NUMBER_TYPES(m) \
@@ -122,6 +126,8 @@ limitations under the License.
   m(quint8);                       \
   m(qint32)
 
+#define TF_CALL_half(m)
+
 #else  // defined(__ANDROID__) && !defined(__ANDROID_TYPES_FULL__)
 
 #define TF_CALL_REAL_NUMBER_TYPES(m) \
@@ -143,6 +149,8 @@ limitations under the License.
 
 #define TF_CALL_QUANTIZED_TYPES(m)
 
+#define TF_CALL_half(m)
+
 #endif  // defined(__ANDROID__)
 
 #endif  // TENSORFLOW_FRAMEWORK_REGISTER_TYPES_H_
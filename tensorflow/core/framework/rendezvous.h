@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/util/device_name_utils.h"
 
 namespace tensorflow {
@@ -42,6 +43,9 @@ class Rendezvous : public core::RefCounted {
   struct Args {
     DeviceContext* device_context = nullptr;
     AllocatorAttributes alloc_attrs;
+    // How the contents of the tensor are encoded when it is received
+    // from another task.
+    WireOptions::Encoding wire_encoding = WireOptions::RAW;
   };
 
   // Constructs a rendezvous key for the tensor of "name" sent from
@@ -676,6 +676,13 @@ bool Tensor::SharesBufferWith(const Tensor& b) const {
   return buf_->root_buffer() == b.buf_->root_buffer();
 }
 
+bool Tensor::RefCountIsOne() const {
+  // A sliced tensor holds a ref on the buffer it was sliced from, so both
+  // must be unshared.
+  return buf_ != nullptr && buf_->RefCountIsOne() &&
+         buf_->root_buffer()->RefCountIsOne();
+}
+
 size_t Tensor::BufferHash() const {
   CHECK_NE(nullptr, buf_);
   return std::hash<TensorBuffer*>()(buf_->root_buffer());
@@ -110,6 +110,10 @@ class Tensor {
   // True iff the two tensors use the same underlying refcounted storage
   bool SharesBufferWith(const Tensor& b) const;
 
+  // True iff no other Tensor shares the underlying storage of this one, so
+  // that it may be overwritten without being observed elsewhere.
+  bool RefCountIsOne() const;
+
   // The BufferHash of two tensors are equal when they share the same
   // underlying refcounted storage
   size_t BufferHash() const;
@@ -387,6 +391,7 @@ class Tensor {
   friend class TensorReference;       // For access to buf_
   friend class VariableOp;            // For access to set_shape
   friend class AutoReloadVariableOp;  // For access to set_shape
+  friend class OpKernelContext;       // For access to buf_
 
   // Creates a tensor with the input datatype, shape and buf.
   //
@@ -0,0 +1,236 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A chain n0 -> n1 -> ... -> nk, where each ni is the only consumer of
+// ni-1, becomes
+//
+//   x, args... -> _FusedElementwise (named nk)
+//
+// where x is the input of n0 the chain starts from and args are the other
+// operands of the binary nodes, in chain order.
+
+#include "tensorflow/core/graph/elementwise_fusion.h"
+
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The ops _FusedElementwise computes, and whether they are binary.
+const std::vector<std::pair<string, bool>>& FusableOps() {
+  static const std::vector<std::pair<string, bool>>* ops =
+      new std::vector<std::pair<string, bool>>{
+          {"Neg", false},    {"Square", false},  {"Sqrt", false},
+          {"Rsqrt", false},  {"Exp", false},     {"Log", false},
+          {"Tanh", false},   {"Sigmoid", false}, {"Relu", false},
+          {"Relu6", false},  {"Add", true},      {"Sub", true},
+          {"Mul", true},     {"Div", true},      {"Maximum", true},
+          {"Minimum", true}, {"BiasAdd", true},
+      };
+  return *ops;
+}
+
+// Returns true if "n" can be part of a fused chain.
+bool IsFusable(const Node* n,
+               const std::function<bool(const Node*)>& consider_fn) {
+  if (!n->IsOp() || n->num_outputs() != 1) return false;
+  const std::pair<string, bool>* op = nullptr;
+  for (const auto& candidate : FusableOps()) {
+    if (n->type_string() == candidate.first) op = &candidate;
+  }
+  if (op == nullptr) return false;
+  if (n->num_inputs() != (op->second ? 2 : 1)) return false;
+  DataType dtype;
+  if (!GetNodeAttr(n->def(), "T", &dtype).ok() ||
+      (dtype != DT_FLOAT && dtype != DT_DOUBLE)) {
+    return false;
+  }
+  string data_format;
+  if (GetNodeAttr(n->def(), "data_format", &data_format).ok() &&
+      data_format != "NHWC") {
+    return false;
+  }
+  // _FusedElementwise is only registered on the CPU.
+  const string& device = n->assigned_device_name().empty()
+                             ? n->def().device()
+                             : n->assigned_device_name();
+  DeviceNameUtils::ParsedName parsed;
+  if (!DeviceNameUtils::ParseFullName(device, &parsed) || !parsed.has_type ||
+      parsed.type != DEVICE_CPU) {
+    return false;
+  }
+  if (consider_fn != nullptr && !consider_fn(n)) return false;
+  return true;
+}
+
+// Returns the only edge out of "n", if "n" has one data output consumed
+// once and no control outputs, or nullptr.
+const Edge* SoleOutEdge(const Node* n) {
+  if (n->out_edges().size() != 1) return nullptr;
+  const Edge* e = *n->out_edges().begin();
+  if (e->IsControlEdge()) return nullptr;
+  return e;
+}
+
+// Returns true if "a" and "b" compute on the same device and type.
+bool SameDeviceAndType(const Node* a, const Node* b) {
+  DataType a_type, b_type;
+  return a->def().device() == b->def().device() &&
+         a->assigned_device_name() == b->assigned_device_name() &&
+         GetNodeAttr(a->def(), "T", &a_type).ok() &&
+         GetNodeAttr(b->def(), "T", &b_type).ok() && a_type == b_type;
+}
+
+// Returns the edge into input "index" of "n".
+const Edge* InputEdge(const Node* n, int index) {
+  for (const Edge* e : n->in_edges()) {
+    if (e->dst_input() == index) return e;
+  }
+  return nullptr;
+}
+
+// Replaces the nodes of "chain" by one _FusedElementwise node. Returns an
+// error, leaving "g" unchanged, if an input of the chain is missing or the
+// fused node is invalid.
+Status FuseChain(Graph* g, const std::vector<Node*>& chain,
+                 const std::vector<int>& chain_inputs) {
+  Node* last = chain.back();
+  const Edge* x = InputEdge(chain[0], 0);
+  if (x == nullptr) {
+    return errors::InvalidArgument("Input 0 of ", chain[0]->name(),
+                                   " is missing");
+  }
+  const NodeBuilder::NodeOut x_out(x->src(), x->src_output());
+  std::vector<NodeBuilder::NodeOut> args;
+  std::vector<string> ops;
+  std::vector<Node*> control_inputs;
+  std::set<Node*> control_input_set;
+  for (int i = 0; i < chain.size(); ++i) {
+    Node* n = chain[i];
+    ops.push_back(n->type_string());
+    if (n->num_inputs() == 2) {
+      const Edge* arg = InputEdge(n, 1 - chain_inputs[i]);
+      if (arg == nullptr) {
+        return errors::InvalidArgument("Input ", 1 - chain_inputs[i], " of ",
+                                       n->name(), " is missing");
+      }
+      args.emplace_back(arg->src(), arg->src_output());
+    }
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge() && !e->src()->IsSource() &&
+          control_input_set.insert(e->src()).second) {
+        control_inputs.push_back(e->src());
+      }
+    }
+  }
+  std::vector<std::pair<Node*, int>> consumers;
+  for (const Edge* e : last->out_edges()) {
+    consumers.push_back(std::make_pair(e->dst(), e->dst_input()));
+  }
+
+  // The fused node takes the place of the last node, so that fetches and the
+  // names of the consumers' inputs still refer to the same tensor.  It is
+  // built before the chain is removed, so that "g" is unchanged if it is
+  // invalid.
+  Node* fused;
+  TF_RETURN_IF_ERROR(NodeBuilder(last->name(), "_FusedElementwise")
+                         .Input(x_out)
+                         .Input(args)
+                         .Attr("ops", ops)
+                         .Attr("chain_inputs", chain_inputs)
+                         .ControlInputs(control_inputs)
+                         .Device(last->def().device())
+                         .Finalize(g, &fused));
+  fused->set_assigned_device_name(last->assigned_device_name());
+  for (Node* n : chain) g->RemoveNode(n);
+  for (const auto& consumer : consumers) {
+    if (consumer.second == Graph::kControlSlot) {
+      g->AddControlEdge(fused, consumer.first);
+    } else {
+      g->AddEdge(fused, 0, consumer.first, consumer.second);
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Status FuseElementwiseOps(Graph* g,
+                          std::function<bool(const Node*)> consider_fn,
+                          bool* changed) {
+  *changed = false;
+  // Each fusable node continues the chain of its first input, if that is a
+  // fusable node it is the only consumer of, so that every node is in at
+  // most one chain regardless of the order the nodes are visited in.
+  std::unordered_map<const Node*, const Edge*> chain_edge;
+  std::unordered_set<const Node*> continued;
+  for (Node* n : g->nodes()) {
+    if (!IsFusable(n, consider_fn)) continue;
+    const int num_chain_inputs = n->type_string() == "BiasAdd" ? 1 : 2;
+    for (int i = 0; i < std::min(n->num_inputs(), num_chain_inputs); ++i) {
+      const Edge* e = InputEdge(n, i);
+      if (e != nullptr && e->src_output() == 0 && SoleOutEdge(e->src()) == e &&
+          IsFusable(e->src(), consider_fn) && SameDeviceAndType(e->src(), n)) {
+        chain_edge[n] = e;
+        continued.insert(e->src());
+        break;
+      }
+    }
+  }
+
+  std::vector<std::pair<std::vector<Node*>, std::vector<int>>> chains;
+  for (Node* n : g->nodes()) {
+    // Chains start at the nodes that are continued but continue nothing.
+    if (continued.count(n) == 0 || chain_edge.count(n) > 0) continue;
+    std::vector<Node*> chain = {n};
+    std::vector<int> chain_inputs = {0};
+    while (continued.count(chain.back()) > 0) {
+      const Edge* e = SoleOutEdge(chain.back());
+      chain.push_back(e->dst());
+      chain_inputs.push_back(e->dst_input());
+    }
+    chains.emplace_back(std::move(chain), std::move(chain_inputs));
+  }
+
+  for (const auto& chain : chains) {
+    VLOG(2) << "Fusing " << chain.first.size() << " nodes into "
+            << chain.first.back()->name();
+    Status s = FuseChain(g, chain.first, chain.second);
+    if (!s.ok()) {
+      // The chains fused so far are kept; the graph stays valid.
+      if (*changed) FixupSourceAndSinkEdges(g);
+      return s;
+    }
+    *changed = true;
+  }
+  if (*changed) FixupSourceAndSinkEdges(g);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
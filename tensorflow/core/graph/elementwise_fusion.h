@@ -0,0 +1,52 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A graph rewrite that runs chains of elementwise ops on CPU as single
+// _FusedElementwise nodes, which make one pass over memory instead of one
+// per op and allocate no intermediate tensors.
+
+#ifndef TENSORFLOW_GRAPH_ELEMENTWISE_FUSION_H_
+#define TENSORFLOW_GRAPH_ELEMENTWISE_FUSION_H_
+
+#include <functional>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+
+// Replaces each chain of two or more float or double elementwise nodes of
+// "g" by a _FusedElementwise node.  The fusable ops are the unary Neg,
+// Square, Sqrt, Rsqrt, Exp, Log, Tanh, Sigmoid, Relu and Relu6 and the
+// binary Add, Sub, Mul, Div, Maximum, Minimum and BiasAdd (NHWC).  A node
+// extends the chain of its first input that is a fusable node it is the only
+// consumer of; the other operands of binary nodes become inputs of the fused
+// node.  The fused node takes the name and the consumers of the last node of
+// the chain.
+//
+// Only nodes placed on the CPU, and for which "consider_fn" returns true (if
+// it is not nullptr), are fused.
+//
+// Sets "*changed" to true if and only if "g" is mutated.  Returns an error
+// if a chain cannot be fused, such as when an input of one of its nodes is
+// missing; the chains fused before it stay fused, and the chain and the rest
+// of "g" are left unchanged.
+Status FuseElementwiseOps(Graph* g,
+                          std::function<bool(const Node*)> consider_fn,
+                          bool* changed);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPH_ELEMENTWISE_FUSION_H_
@@ -0,0 +1,290 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/graph/elementwise_fusion.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+const char kCpu[] = "/job:localhost/replica:0/task:0/cpu:0";
+
+// Returns a constant of the given shape with values uniform in [-1, 1).
+Node* Random(Graph* g, const TensorShape& shape) {
+  random::PhiloxRandom philox(301, 17 + g->num_node_ids());
+  random::SimplePhilox rnd(&philox);
+  Tensor t(DT_FLOAT, shape);
+  auto flat = t.flat<float>();
+  for (int64 i = 0; i < flat.size(); ++i) {
+    flat(i) = 2 * rnd.RandFloat() - 1;
+  }
+  return test::graph::Constant(g, t);
+}
+
+// Adds a node of type "op" on the CPU reading "inputs".
+Node* Op(Graph* g, const string& name, const string& op,
+         const std::vector<Node*>& inputs) {
+  NodeBuilder builder(name, op);
+  for (Node* input : inputs) builder.Input(input);
+  Node* n;
+  TF_CHECK_OK(builder.Device(kCpu).Finalize(g, &n));
+  return n;
+}
+
+// Fuses the elementwise chains of "g" and returns true if "g" changed.
+bool Fuse(Graph* g, std::function<bool(const Node*)> consider_fn) {
+  bool changed;
+  TF_CHECK_OK(FuseElementwiseOps(g, consider_fn, &changed));
+  return changed;
+}
+
+// Adds the elementwise part of an LSTM cell, given its gate pre-activations
+// and previous cell state of shape [batch, units]:
+//
+//   new_c = c * Sigmoid(f + 1) + Sigmoid(i) * Tanh(j)
+//   new_h = Tanh(new_c) * Sigmoid(o)
+void LSTMCell(Graph* g, int batch, int units) {
+  const TensorShape shape({batch, units});
+  Node* i = Random(g, shape);
+  Node* j = Random(g, shape);
+  Node* f = Random(g, shape);
+  Node* o = Random(g, shape);
+  Node* c = Random(g, shape);
+  Node* forget = Op(g, "forget", "Sigmoid",
+                    {Op(g, "forget_bias", "Add",
+                        {f, test::graph::Constant(
+                                g, test::AsScalar<float>(1))})});
+  Node* keep = Op(g, "keep", "Mul", {c, forget});
+  Node* input = Op(g, "input", "Mul",
+                   {Op(g, "input_gate", "Sigmoid", {i}),
+                    Op(g, "input_value", "Tanh", {j})});
+  Node* new_c = Op(g, "new_c", "Add", {keep, input});
+  Node* new_h = Op(g, "new_h", "Mul", {Op(g, "new_c_tanh", "Tanh", {new_c}),
+                                       Op(g, "output_gate", "Sigmoid", {o})});
+  // The states are also read by the next step.
+  Op(g, "c_out", "Identity", {new_c});
+  Op(g, "h_out", "Identity", {new_h});
+  FixupSourceAndSinkEdges(g);
+}
+
+class ElementwiseFusionTest : public ::testing::Test {
+ protected:
+  ElementwiseFusionTest() : g_(new Graph(OpRegistry::Global())) {}
+
+  // Returns the number of op nodes of each type, as "Type:count" sorted.
+  std::vector<string> OpCounts() {
+    std::map<string, int> counts;
+    for (const Node* n : g_->nodes()) {
+      if (n->IsOp()) ++counts[n->type_string()];
+    }
+    std::vector<string> result;
+    for (const auto& c : counts) {
+      result.push_back(strings::StrCat(c.first, ":", c.second));
+    }
+    return result;
+  }
+
+  Node* FindNode(const string& name) {
+    for (Node* n : g_->nodes()) {
+      if (n->name() == name) return n;
+    }
+    return nullptr;
+  }
+
+  std::vector<string> FusedOps(const string& name) {
+    std::vector<string> ops;
+    TF_CHECK_OK(GetNodeAttr(FindNode(name)->def(), "ops", &ops));
+    return ops;
+  }
+
+  std::vector<Tensor> Run(const std::vector<string>& fetches) {
+    GraphDef def;
+    g_->ToGraphDef(&def);
+    std::unique_ptr<Session> session(NewSession(SessionOptions()));
+    TF_CHECK_OK(session->Create(def));
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session->Run({}, fetches, {}, &outputs));
+    return outputs;
+  }
+
+  std::unique_ptr<Graph> g_;
+};
+
+TEST_F(ElementwiseFusionTest, FusesLSTMCell) {
+  LSTMCell(g_.get(), 2, 3);
+  EXPECT_TRUE(Fuse(g_.get(), nullptr));
+  // Each node continues the chain of its first fusable input, and new_c,
+  // read by c_out, ends one.
+  const std::vector<string> expected = {"Const:6", "Identity:2", "Sigmoid:1",
+                                        "Tanh:1", "_FusedElementwise:3"};
+  EXPECT_EQ(expected, OpCounts());
+  EXPECT_EQ(std::vector<string>({"Add", "Sigmoid", "Mul", "Add"}),
+            FusedOps("new_c"));
+  EXPECT_EQ(std::vector<string>({"Sigmoid", "Mul"}), FusedOps("input"));
+  EXPECT_EQ(std::vector<string>({"Tanh", "Mul"}), FusedOps("new_h"));
+  std::vector<int32> chain_inputs;
+  TF_ASSERT_OK(
+      GetNodeAttr(FindNode("new_c")->def(), "chain_inputs", &chain_inputs));
+  EXPECT_EQ(std::vector<int32>({0, 0, 1, 0}), chain_inputs);
+  EXPECT_EQ(kCpu, FindNode("new_h")->def().device());
+  // Fusing again finds nothing new.
+  EXPECT_FALSE(Fuse(g_.get(), nullptr));
+}
+
+TEST_F(ElementwiseFusionTest, MatchesUnfusedGraph) {
+  LSTMCell(g_.get(), 4, 5000);
+  const std::vector<Tensor> expected = Run({"new_c:0", "new_h:0"});
+  ASSERT_TRUE(Fuse(g_.get(), nullptr));
+  const std::vector<Tensor> actual = Run({"new_c:0", "new_h:0"});
+  for (int i = 0; i < 2; ++i) {
+    test::ExpectTensorNear<float>(expected[i], actual[i], 1e-5);
+  }
+}
+
+TEST_F(ElementwiseFusionTest, ConsiderFn) {
+  LSTMCell(g_.get(), 2, 3);
+  EXPECT_TRUE(Fuse(g_.get(), [](const Node* n) {
+    return n->name() != "keep";
+  }));
+  EXPECT_EQ("Mul", FindNode("keep")->type_string());
+  EXPECT_EQ("_FusedElementwise", FindNode("forget")->type_string());
+  EXPECT_EQ("_FusedElementwise", FindNode("new_h")->type_string());
+}
+
+TEST_F(ElementwiseFusionTest, SkipsUnsupportedNodes) {
+  Node* a = Random(g_.get(), TensorShape({2, 2}));
+  // No device.
+  test::graph::Unary(g_.get(), "Tanh",
+                     test::graph::Unary(g_.get(), "Sigmoid", a));
+  // On a GPU.
+  Node* gpu_sigmoid;
+  TF_ASSERT_OK(NodeBuilder("gpu_sigmoid", "Sigmoid")
+                   .Input(a)
+                   .Device("/gpu:0")
+                   .Finalize(g_.get(), &gpu_sigmoid));
+  TF_ASSERT_OK(NodeBuilder("gpu_tanh", "Tanh")
+                   .Input(gpu_sigmoid)
+                   .Device("/gpu:0")
+                   .Finalize(g_.get(), nullptr));
+  // Two consumers.
+  Node* shared = Op(g_.get(), "shared", "Sigmoid", {a});
+  Op(g_.get(), "first", "Tanh", {shared});
+  Op(g_.get(), "second", "Tanh", {shared});
+  // NCHW bias.
+  Node* image = Random(g_.get(), TensorShape({1, 2, 2, 2}));
+  Node* nchw_bias;
+  TF_ASSERT_OK(NodeBuilder("nchw_bias", "BiasAdd")
+                   .Input(image)
+                   .Input(Random(g_.get(), TensorShape({2})))
+                   .Attr("data_format", "NCHW")
+                   .Device(kCpu)
+                   .Finalize(g_.get(), &nchw_bias));
+  Op(g_.get(), "nchw_relu", "Relu", {nchw_bias});
+  // Integers.
+  Node* ints = test::graph::Constant(g_.get(), test::AsTensor<int32>({1, 2}));
+  Op(g_.get(), "int_square", "Square",
+     {Op(g_.get(), "int_neg", "Neg", {ints})});
+  FixupSourceAndSinkEdges(g_.get());
+  EXPECT_FALSE(Fuse(g_.get(), nullptr));
+}
+
+TEST_F(ElementwiseFusionTest, KeepsControlEdges) {
+  Node* a = Random(g_.get(), TensorShape({2}));
+  Node* control = Random(g_.get(), TensorShape({2}));
+  Node* neg = Op(g_.get(), "neg", "Neg", {a});
+  g_->AddControlEdge(control, neg);
+  Node* exp = Op(g_.get(), "exp", "Exp", {neg});
+  Node* after = Random(g_.get(), TensorShape({2}));
+  g_->AddControlEdge(exp, after);
+  FixupSourceAndSinkEdges(g_.get());
+  ASSERT_TRUE(Fuse(g_.get(), nullptr));
+  // The control edges of the chain move to the fused node.
+  const Node* fused = FindNode("exp");
+  EXPECT_EQ("_FusedElementwise", fused->type_string());
+  bool has_control_input = false;
+  for (const Edge* e : fused->in_edges()) {
+    if (e->IsControlEdge() && e->src() == control) has_control_input = true;
+  }
+  EXPECT_TRUE(has_control_input);
+  bool has_control_output = false;
+  for (const Edge* e : fused->out_edges()) {
+    if (e->IsControlEdge() && e->dst() == after) has_control_output = true;
+  }
+  EXPECT_TRUE(has_control_output);
+}
+
+TEST_F(ElementwiseFusionTest, MissingInput) {
+  Node* a = Random(g_.get(), TensorShape({2}));
+  Node* b = Random(g_.get(), TensorShape({2}));
+  Node* neg = Op(g_.get(), "neg", "Neg", {a});
+  Node* mul = Op(g_.get(), "mul", "Mul", {neg, b});
+  for (const Edge* e : mul->in_edges()) {
+    if (e->src() == b) {
+      g_->RemoveEdge(e);
+      break;
+    }
+  }
+  FixupSourceAndSinkEdges(g_.get());
+  bool changed = true;
+  EXPECT_FALSE(FuseElementwiseOps(g_.get(), nullptr, &changed).ok());
+  EXPECT_FALSE(changed);
+  // The chain is left as it was.
+  EXPECT_EQ("Neg", FindNode("neg")->type_string());
+  EXPECT_EQ("Mul", FindNode("mul")->type_string());
+  EXPECT_EQ(std::vector<string>({"Const:2", "Mul:1", "Neg:1"}), OpCounts());
+}
+
+static void BM_LSTMCell(int iters, int batch, bool fused) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+  LSTMCell(g, batch, 1024);
+  if (fused) Fuse(g, nullptr);
+  testing::ItemsProcessed(static_cast<int64>(iters) * batch * 1024);
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+static void BM_LSTMCellUnfused(int iters, int batch) {
+  BM_LSTMCell(iters, batch, false);
+}
+static void BM_LSTMCellFused(int iters, int batch) {
+  BM_LSTMCell(iters, batch, true);
+}
+BENCHMARK(BM_LSTMCellUnfused)->Arg(32)->Arg(128)->Arg(512);
+BENCHMARK(BM_LSTMCellFused)->Arg(32)->Arg(128)->Arg(512);
+
+}  // namespace
+}  // namespace tensorflow
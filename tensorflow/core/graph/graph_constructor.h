@@ -28,6 +28,10 @@ struct ConstantFoldingOptions {
   // If "consider" is not a nullptr, then only constant fold a node "n" if
   // consider(n) returns true.
   std::function<bool(const Node*)> consider = nullptr;
+
+  // Folded values of more than this many bytes are left to be computed when
+  // the graph runs, rather than stored in the graph as constants.
+  int64 max_constant_size_in_bytes = 10 * 1024 * 1024;
 };
 
 // Construct a graph *g out of a GraphDef gdef. Returns non-OK on
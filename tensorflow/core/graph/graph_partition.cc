@@ -253,6 +253,12 @@ NodeDef* AddRecv(const PartitionOptions& opts, const GraphInfo& g_info,
   SetSendRecvAttrs(opts, edge, &recv_builder);
   recv_builder.Device(dst->assigned_device_name())
       .Attr("tensor_type", cast_dtype);
+  if (opts.wire_encoding && !edge->IsControlEdge()) {
+    const WireOptions::Encoding encoding = opts.wire_encoding(edge);
+    if (encoding != WireOptions::RAW) {
+      recv_builder.Attr("_wire_encoding", static_cast<int64>(encoding));
+    }
+  }
   NodeDef* recv = gdef->add_node();
   *status = recv_builder.Finalize(recv);
   if (!status->ok()) return nullptr;
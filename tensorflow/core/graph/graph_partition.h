@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
 
@@ -61,6 +62,12 @@ struct PartitionOptions {
   typedef std::function<DataType(const Edge*)> ShouldCastFunc;
   ShouldCastFunc should_cast = nullptr;
 
+  // A function that returns how the contents of the tensor should be
+  // encoded on the wire.  Encodings other than RAW are recorded in the
+  // "_wire_encoding" attr of the recv node.
+  typedef std::function<WireOptions::Encoding(const Edge*)> WireEncodingFunc;
+  WireEncodingFunc wire_encoding = nullptr;
+
   // Schedule the execution of the recvs based on their start times
   // computed by some scheduling algorithm. The recvs are divided into
   // epochs based on their start times. A recv is enabled only when
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/control_flow_ops.h"
 #include "tensorflow/cc/ops/random_ops.h"
 #include "tensorflow/cc/ops/sendrecv_ops.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/graph/equal_graph_def.h"
 #include "tensorflow/core/graph/graph.h"
@@ -53,7 +54,8 @@ string DeviceName(const Node* node) {
 }
 
 void Partition(const GraphDef& graph_def,
-               std::unordered_map<string, GraphDef>* partitions) {
+               std::unordered_map<string, GraphDef>* partitions,
+               PartitionOptions::WireEncodingFunc wire_encoding = nullptr) {
   Graph g(OpRegistry::Global());
   GraphConstructorOptions opts;
   TF_CHECK_OK(ConvertGraphDefToGraph(opts, graph_def, &g));
@@ -71,6 +73,7 @@ void Partition(const GraphDef& graph_def,
     return (name[0] - 'A') + 100;
   };
   popts.control_flow_added = false;
+  popts.wire_encoding = wire_encoding;
   Status s = Partition(popts, &g, partitions);
   CHECK(s.ok()) << s;
 
@@ -219,6 +222,37 @@ TEST_F(GraphPartitionTest, CrossDeviceData) {
   ExpectMatchB();
 }
 
+TEST_F(GraphPartitionTest, CrossDeviceData_WireEncoding) {
+  using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+  Node* a1 = Input(in_.opts().WithName("A1"));
+  Node* a2 = Input(in_.opts().WithName("A2"));
+  Combine(a1, a2, in_.opts().WithName("B1"));
+
+  Partition(ToGraphDef(), &partitions_, [](const Edge* edge) {
+    return edge->src()->name() == "A1" ? WireOptions::SNAPPY
+                                       : WireOptions::RAW;
+  });
+  EXPECT_EQ(2, partitions_.size());
+
+  // Only the recv of the edge that is not sent RAW records its encoding.
+  string b = "/job:a/replica:0/task:0/cpu:1";
+  int num_recvs = 0;
+  for (const NodeDef& ndef : partitions_[b].node()) {
+    if (ndef.op() != "_Recv") continue;
+    ++num_recvs;
+    string tensor_name;
+    TF_ASSERT_OK(GetNodeAttr(ndef, "tensor_name", &tensor_name));
+    if (StringPiece(tensor_name).ends_with("_A1")) {
+      int64 encoding;
+      TF_ASSERT_OK(GetNodeAttr(ndef, "_wire_encoding", &encoding));
+      EXPECT_EQ(WireOptions::SNAPPY, encoding);
+    } else {
+      EXPECT_EQ(0, ndef.attr().count("_wire_encoding"));
+    }
+  }
+  EXPECT_EQ(2, num_recvs);
+}
+
 TEST_F(GraphPartitionTest, CrossDeviceControl) {
   using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
   Node* a1 = Input(in_.opts().WithName("A1"));
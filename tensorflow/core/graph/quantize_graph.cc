@@ -0,0 +1,343 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// The rewrite of each node n is, for two quantized inputs a and b:
+//
+//   a -> Quantize(a, range of a) --+
+//                                  +--> Quantized<Op> -> Dequantize (named n)
+//   b -> Quantize(b, range of b) --+
+//
+// with a QuantizeDownAndShrinkRange before the Dequantize if Quantized<Op>
+// produces qint32.
+// Nodes are visited inputs first, so that when "a" is itself the Dequantize
+// of an earlier rewrite, its quantized tensor and range are used directly.
+
+#include "tensorflow/core/graph/quantize_graph.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+
+namespace {
+
+// How a float op maps to its quantized counterpart.
+struct QuantizedOpInfo {
+  const char* op;
+  const char* quantized_op;
+  // Number of leading float inputs, each followed in the quantized op by
+  // its range after all of them.
+  int num_inputs;
+  // Whether the quantized op produces qint32, to be narrowed to quint8.
+  bool wide_output;
+  // Attributes copied from the float op.
+  std::vector<const char*> attrs;
+};
+
+const std::vector<QuantizedOpInfo>& QuantizedOps() {
+  static const std::vector<QuantizedOpInfo>* ops =
+      new std::vector<QuantizedOpInfo>{
+          {"MatMul", "QuantizedMatMul", 2, true,
+           {"transpose_a", "transpose_b"}},
+          {"Conv2D", "QuantizedConv2D", 2, true, {"strides", "padding"}},
+          {"BiasAdd", "QuantizedBiasAdd", 2, true, {}},
+          {"Relu", "QuantizedRelu", 1, false, {}},
+          {"MaxPool", "QuantizedMaxPool", 1, false,
+           {"ksize", "strides", "padding"}},
+      };
+  return *ops;
+}
+
+const QuantizedOpInfo* FindQuantizedOp(const Node* n) {
+  for (const QuantizedOpInfo& info : QuantizedOps()) {
+    if (n->type_string() == info.op) return &info;
+  }
+  return nullptr;
+}
+
+// Returns true if "list_attr" of "n" is 1 in the batch and depth dimensions,
+// or is missing.
+bool IsSpatial(const Node* n, const char* list_attr) {
+  std::vector<int32> values;
+  if (!GetNodeAttr(n->def(), list_attr, &values).ok()) return true;
+  return values.size() == 4 && values[0] == 1 && values[3] == 1;
+}
+
+// Returns true if the quantized kernels can compute "n".
+bool CanQuantize(const Node* n, const QuantizedOpInfo& info) {
+  for (int i = 0; i < n->num_inputs(); ++i) {
+    if (n->input_type(i) != DT_FLOAT) return false;
+  }
+  if (n->num_inputs() != info.num_inputs) return false;
+  string data_format;
+  if (GetNodeAttr(n->def(), "data_format", &data_format).ok() &&
+      data_format != "NHWC") {
+    return false;
+  }
+  if (!IsSpatial(n, "strides") || !IsSpatial(n, "ksize")) return false;
+  // The quantized kernels are only registered on the CPU.
+  for (const string& device : {n->assigned_device_name(), n->def().device()}) {
+    DeviceNameUtils::ParsedName parsed;
+    if (!device.empty() &&
+        (!DeviceNameUtils::ParseFullName(device, &parsed) ||
+         (parsed.has_type && parsed.type != DEVICE_CPU))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// A quint8 tensor with its range.
+struct QuantizedTensor {
+  NodeBuilder::NodeOut value;
+  NodeBuilder::NodeOut min;
+  NodeBuilder::NodeOut max;
+};
+
+class GraphQuantizer {
+ public:
+  explicit GraphQuantizer(Graph* g) : g_(g) {}
+
+  // Replaces "n", described by "info", by its quantized counterpart.
+  Status Rewrite(Node* n, const QuantizedOpInfo& info);
+
+ private:
+  // Returns a builder for a node computing part of "n", on its device.
+  NodeBuilder Builder(const Node* n, const string& suffix, const string& op);
+  Status Finalize(const Node* n, NodeBuilder* builder, Node** created);
+
+  Status MakeConst(const Node* n, const string& suffix, const Tensor& value,
+                   Node** created);
+
+  // Returns the quantized version of the float tensor "input" read by "n".
+  Status Quantize(const Node* n, const Edge* input, QuantizedTensor* result);
+
+  Graph* const g_;
+  // The quantized tensors the Dequantize nodes added so far read.
+  std::unordered_map<const Node*, QuantizedTensor> dequantized_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GraphQuantizer);
+};
+
+NodeBuilder GraphQuantizer::Builder(const Node* n, const string& suffix,
+                                    const string& op) {
+  return NodeBuilder(g_->NewName(strings::StrCat(n->name(), "/eightbit/",
+                                                 suffix)),
+                     op)
+      .Device(n->def().device());
+}
+
+Status GraphQuantizer::Finalize(const Node* n, NodeBuilder* builder,
+                                Node** created) {
+  TF_RETURN_IF_ERROR(builder->Finalize(g_, created));
+  (*created)->set_assigned_device_name(n->assigned_device_name());
+  return Status::OK();
+}
+
+Status GraphQuantizer::MakeConst(const Node* n, const string& suffix,
+                                 const Tensor& value, Node** created) {
+  NodeBuilder builder = Builder(n, suffix, "Const")
+                            .Attr("dtype", value.dtype())
+                            .Attr("value", value);
+  return Finalize(n, &builder, created);
+}
+
+Status GraphQuantizer::Quantize(const Node* n, const Edge* input,
+                                QuantizedTensor* result) {
+  Node* src = input->src();
+  const int src_output = input->src_output();
+  auto it = dequantized_.find(src);
+  if (it != dequantized_.end()) {
+    *result = it->second;
+    return Status::OK();
+  }
+
+  Node* min_node;
+  Node* max_node;
+  Tensor value;
+  if (src->type_string() == "Const" &&
+      GetNodeAttr(src->def(), "value", &value).ok() &&
+      value.dtype() == DT_FLOAT) {
+    // The range of a constant is known now.
+    Tensor min_value(DT_FLOAT, TensorShape({}));
+    Tensor max_value(DT_FLOAT, TensorShape({}));
+    auto flat = value.flat<float>();
+    float min_float = 0.0f, max_float = 0.0f;
+    for (int64 i = 0; i < flat.size(); ++i) {
+      min_float = std::min(min_float, flat(i));
+      max_float = std::max(max_float, flat(i));
+    }
+    min_value.scalar<float>()() = min_float;
+    max_value.scalar<float>()() = max_float;
+    TF_RETURN_IF_ERROR(MakeConst(n, "min", min_value, &min_node));
+    TF_RETURN_IF_ERROR(MakeConst(n, "max", max_value, &max_node));
+  } else {
+    // The range is computed at run time over the flattened tensor.
+    Tensor flat_shape(DT_INT32, TensorShape({1}));
+    flat_shape.flat<int32>()(0) = -1;
+    Node* shape;
+    TF_RETURN_IF_ERROR(MakeConst(n, "reshape_dims", flat_shape, &shape));
+    Tensor first_dim(DT_INT32, TensorShape({1}));
+    first_dim.flat<int32>()(0) = 0;
+    Node* reduction_dims;
+    TF_RETURN_IF_ERROR(
+        MakeConst(n, "reduction_dims", first_dim, &reduction_dims));
+    Node* reshape;
+    NodeBuilder reshape_builder = Builder(n, "reshape", "Reshape")
+                                      .Input(src, src_output)
+                                      .Input(shape);
+    TF_RETURN_IF_ERROR(Finalize(n, &reshape_builder, &reshape));
+    NodeBuilder min_builder =
+        Builder(n, "min", "Min").Input(reshape).Input(reduction_dims);
+    TF_RETURN_IF_ERROR(Finalize(n, &min_builder, &min_node));
+    NodeBuilder max_builder =
+        Builder(n, "max", "Max").Input(reshape).Input(reduction_dims);
+    TF_RETURN_IF_ERROR(Finalize(n, &max_builder, &max_node));
+  }
+  Node* quantize;
+  NodeBuilder quantize_builder = Builder(n, "quantize", "Quantize")
+                                     .Input(src, src_output)
+                                     .Input(min_node)
+                                     .Input(max_node)
+                                     .Attr("T", DT_QUINT8);
+  TF_RETURN_IF_ERROR(Finalize(n, &quantize_builder, &quantize));
+  *result = {NodeBuilder::NodeOut(quantize, 0),
+             NodeBuilder::NodeOut(quantize, 1),
+             NodeBuilder::NodeOut(quantize, 2)};
+  return Status::OK();
+}
+
+Status GraphQuantizer::Rewrite(Node* n, const QuantizedOpInfo& info) {
+  std::vector<const Edge*> inputs(info.num_inputs, nullptr);
+  std::vector<Node*> control_inputs;
+  for (const Edge* e : n->in_edges()) {
+    if (e->IsControlEdge()) {
+      control_inputs.push_back(e->src());
+    } else {
+      inputs[e->dst_input()] = e;
+    }
+  }
+  std::vector<QuantizedTensor> quantized(info.num_inputs);
+  for (int i = 0; i < info.num_inputs; ++i) {
+    if (inputs[i] == nullptr) {
+      return errors::InvalidArgument("Input ", i, " of ", n->name(),
+                                     " is missing");
+    }
+    TF_RETURN_IF_ERROR(Quantize(n, inputs[i], &quantized[i]));
+  }
+
+  NodeBuilder builder = Builder(n, "op", info.quantized_op);
+  for (const QuantizedTensor& q : quantized) builder.Input(q.value);
+  for (const QuantizedTensor& q : quantized) {
+    builder.Input(q.min);
+    builder.Input(q.max);
+  }
+  for (const char* attr : info.attrs) {
+    const AttrValue* value = n->def().attr().count(attr)
+                                 ? &n->def().attr().at(attr)
+                                 : nullptr;
+    if (value == nullptr) {
+      return errors::InvalidArgument(n->name(), " has no attr ", attr);
+    }
+    builder.Attr(attr, *value);
+  }
+  builder.ControlInputs(control_inputs);
+  Node* op;
+  TF_RETURN_IF_ERROR(Finalize(n, &builder, &op));
+  QuantizedTensor result = {NodeBuilder::NodeOut(op, 0),
+                            NodeBuilder::NodeOut(op, 1),
+                            NodeBuilder::NodeOut(op, 2)};
+  if (info.wide_output) {
+    Node* shrink;
+    NodeBuilder shrink_builder =
+        Builder(n, "requantize", "QuantizeDownAndShrinkRange")
+            .Input(result.value)
+            .Input(result.min)
+            .Input(result.max)
+            .Attr("out_type", DT_QUINT8);
+    TF_RETURN_IF_ERROR(Finalize(n, &shrink_builder, &shrink));
+    result = {NodeBuilder::NodeOut(shrink, 0),
+              NodeBuilder::NodeOut(shrink, 1),
+              NodeBuilder::NodeOut(shrink, 2)};
+  }
+
+  // The Dequantize takes the place of "n", so that fetches and the names of
+  // the consumers' inputs still refer to the same tensor.
+  std::vector<std::pair<Node*, int>> consumers;
+  for (const Edge* e : n->out_edges()) {
+    consumers.push_back(std::make_pair(e->dst(), e->dst_input()));
+  }
+  const string name = n->name();
+  const string device = n->def().device();
+  const string assigned_device = n->assigned_device_name();
+  g_->RemoveNode(n);
+  Node* dequantize;
+  TF_RETURN_IF_ERROR(NodeBuilder(name, "Dequantize")
+                         .Input(result.value)
+                         .Input(result.min)
+                         .Input(result.max)
+                         .Device(device)
+                         .Finalize(g_, &dequantize));
+  dequantize->set_assigned_device_name(assigned_device);
+  for (const auto& consumer : consumers) {
+    if (consumer.second == Graph::kControlSlot) {
+      g_->AddControlEdge(dequantize, consumer.first);
+    } else {
+      g_->AddEdge(dequantize, 0, consumer.first, consumer.second);
+    }
+  }
+  dequantized_[dequantize] = result;
+  return Status::OK();
+}
+
+}  // namespace
+
+Status QuantizeGraph(Graph* g, std::function<bool(const Node*)> consider_fn,
+                     bool* changed) {
+  *changed = false;
+  std::vector<Node*> order;
+  GetReversePostOrder(*g, &order);
+  // Rewriting replaces nodes, so the candidates are picked first.
+  std::vector<std::pair<Node*, const QuantizedOpInfo*>> candidates;
+  for (Node* n : order) {
+    if (!n->IsOp()) continue;
+    const QuantizedOpInfo* info = FindQuantizedOp(n);
+    if (info == nullptr || !CanQuantize(n, *info)) continue;
+    if (consider_fn != nullptr && !consider_fn(n)) continue;
+    candidates.push_back(std::make_pair(n, info));
+  }
+  GraphQuantizer quantizer(g);
+  for (const auto& candidate : candidates) {
+    VLOG(2) << "Quantizing " << candidate.first->name();
+    TF_RETURN_IF_ERROR(quantizer.Rewrite(candidate.first, *candidate.second));
+    *changed = true;
+  }
+  // Connects the new constants to the source node.
+  if (*changed) FixupSourceAndSinkEdges(g);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,52 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A graph rewrite that runs the float MatMul, Conv2D, BiasAdd, Relu and
+// MaxPool nodes of an inference graph as eight-bit quantized ops on CPU.
+
+#ifndef TENSORFLOW_GRAPH_QUANTIZE_GRAPH_H_
+#define TENSORFLOW_GRAPH_QUANTIZE_GRAPH_H_
+
+#include <functional>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+
+// Replaces each float MatMul, Conv2D, BiasAdd, Relu and MaxPool node of
+// "*g" by its quantized counterpart.  Each float input is quantized to
+// quint8 over its range, computed by Min and Max nodes or, for Const
+// inputs, when rewriting.  32-bit results are narrowed back to quint8 with
+// QuantizeDownAndShrinkRange, and a Dequantize node takes the name and the
+// consumers of the original node.  A rewritten node reading the output of
+// another uses the quantized tensor directly, so chains of these ops stay
+// in eight bits; the Dequantize nodes left without consumers are removed
+// when the graph is pruned.
+//
+// Only nodes with NHWC data, placed on the CPU or not placed, and for which
+// "consider_fn" returns true (if it is not nullptr) are rewritten.  The
+// results differ from the float graph by the quantization error, so this
+// is meant for models whose accuracy has been checked with it.  For the
+// same reason no optimizer pass runs it: callers rewrite the graphs they
+// choose to quantize themselves.
+//
+// Sets "*changed" to whether "*g" was mutated.
+Status QuantizeGraph(Graph* g, std::function<bool(const Node*)> consider_fn,
+                     bool* changed);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPH_QUANTIZE_GRAPH_H_
@@ -0,0 +1,240 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/graph/quantize_graph.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+class QuantizeGraphTest : public ::testing::Test {
+ protected:
+  QuantizeGraphTest() : g_(new Graph(OpRegistry::Global())) {}
+
+  // Returns a constant of the given shape with values uniform in
+  // [-scale, scale).
+  Node* Random(const TensorShape& shape, float scale) {
+    random::PhiloxRandom philox(301, 17 + g_->num_node_ids());
+    random::SimplePhilox rnd(&philox);
+    Tensor t(DT_FLOAT, shape);
+    auto flat = t.flat<float>();
+    for (int64 i = 0; i < flat.size(); ++i) {
+      flat(i) = scale * (2 * rnd.RandFloat() - 1);
+    }
+    return test::graph::Constant(g_.get(), t);
+  }
+
+  // Builds input -> Conv2D -> BiasAdd -> Relu -> MaxPool -> Reshape ->
+  // MatMul, where only the Reshape is not quantized.
+  void BuildNet() {
+    Node* input =
+        test::graph::Identity(g_.get(), Random(TensorShape({2, 8, 8, 3}), 1));
+    Node* conv;
+    TF_ASSERT_OK(NodeBuilder("conv", "Conv2D")
+                     .Input(input)
+                     .Input(Random(TensorShape({3, 3, 3, 4}), 0.5))
+                     .Attr("strides", {1, 1, 1, 1})
+                     .Attr("padding", "SAME")
+                     .Finalize(g_.get(), &conv));
+    Node* bias_add;
+    TF_ASSERT_OK(NodeBuilder("bias_add", "BiasAdd")
+                     .Input(conv)
+                     .Input(Random(TensorShape({4}), 0.2))
+                     .Finalize(g_.get(), &bias_add));
+    Node* relu;
+    TF_ASSERT_OK(
+        NodeBuilder("relu", "Relu").Input(bias_add).Finalize(g_.get(), &relu));
+    Node* pool;
+    TF_ASSERT_OK(NodeBuilder("pool", "MaxPool")
+                     .Input(relu)
+                     .Attr("ksize", {1, 2, 2, 1})
+                     .Attr("strides", {1, 2, 2, 1})
+                     .Attr("padding", "VALID")
+                     .Finalize(g_.get(), &pool));
+    Node* reshape;
+    TF_ASSERT_OK(NodeBuilder("reshape", "Reshape")
+                     .Input(pool)
+                     .Input(test::graph::Constant(
+                         g_.get(), test::AsTensor<int32>({2, 64})))
+                     .Finalize(g_.get(), &reshape));
+    Node* matmul;
+    TF_ASSERT_OK(NodeBuilder("matmul", "MatMul")
+                     .Input(reshape)
+                     .Input(Random(TensorShape({64, 5}), 0.3))
+                     .Finalize(g_.get(), &matmul));
+    FixupSourceAndSinkEdges(g_.get());
+  }
+
+  // Returns the number of op nodes of each type, as "Type:count" sorted.
+  std::vector<string> OpCounts() {
+    std::map<string, int> counts;
+    for (const Node* n : g_->nodes()) {
+      if (n->IsOp()) ++counts[n->type_string()];
+    }
+    std::vector<string> result;
+    for (const auto& c : counts) {
+      result.push_back(strings::StrCat(c.first, ":", c.second));
+    }
+    return result;
+  }
+
+  Node* FindNode(const string& name) {
+    for (Node* n : g_->nodes()) {
+      if (n->name() == name) return n;
+    }
+    return nullptr;
+  }
+
+  // Returns the node whose output "n" reads as input "index".
+  static const Node* Input(const Node* n, int index) {
+    for (const Edge* e : n->in_edges()) {
+      if (e->dst_input() == index) return e->src();
+    }
+    return nullptr;
+  }
+
+  Tensor Run(const string& fetch) {
+    GraphDef def;
+    g_->ToGraphDef(&def);
+    std::unique_ptr<Session> session(NewSession(SessionOptions()));
+    TF_CHECK_OK(session->Create(def));
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session->Run({}, {fetch}, {}, &outputs));
+    return outputs[0];
+  }
+
+  Status Quantize(std::function<bool(const Node*)> consider_fn = nullptr) {
+    bool changed;
+    return QuantizeGraph(g_.get(), consider_fn, &changed);
+  }
+
+  std::unique_ptr<Graph> g_;
+};
+
+TEST_F(QuantizeGraphTest, RewritesChain) {
+  BuildNet();
+  bool changed = false;
+  TF_ASSERT_OK(QuantizeGraph(g_.get(), nullptr, &changed));
+  EXPECT_TRUE(changed);
+  const std::vector<string> expected = {
+      "Const:15",
+      "Dequantize:5",
+      "Identity:1",
+      "Max:2",
+      "Min:2",
+      "Quantize:5",
+      "QuantizeDownAndShrinkRange:3",
+      "QuantizedBiasAdd:1",
+      "QuantizedConv2D:1",
+      "QuantizedMatMul:1",
+      "QuantizedMaxPool:1",
+      "QuantizedRelu:1",
+      "Reshape:3"};
+  EXPECT_EQ(expected, OpCounts());
+
+  // The Dequantize nodes take the original names, and the quantized ops
+  // read each other's outputs directly.
+  const Node* relu = FindNode("relu");
+  ASSERT_NE(nullptr, relu);
+  EXPECT_EQ("Dequantize", relu->type_string());
+  const Node* quantized_relu = Input(relu, 0);
+  EXPECT_EQ("QuantizedRelu", quantized_relu->type_string());
+  EXPECT_EQ("QuantizeDownAndShrinkRange",
+            Input(quantized_relu, 0)->type_string());
+  EXPECT_EQ("QuantizedBiasAdd",
+            Input(Input(quantized_relu, 0), 0)->type_string());
+  EXPECT_EQ("Dequantize", FindNode("matmul")->type_string());
+}
+
+TEST_F(QuantizeGraphTest, MatchesFloatGraph) {
+  BuildNet();
+  const Tensor expected = Run("matmul:0");
+  TF_ASSERT_OK(Quantize());
+  const Tensor actual = Run("matmul:0");
+  ASSERT_EQ(expected.shape(), actual.shape());
+  float max_abs = 0;
+  for (int64 i = 0; i < expected.NumElements(); ++i) {
+    max_abs = std::max(max_abs, std::abs(expected.flat<float>()(i)));
+  }
+  for (int64 i = 0; i < expected.NumElements(); ++i) {
+    EXPECT_NEAR(expected.flat<float>()(i), actual.flat<float>()(i),
+                0.05 * max_abs)
+        << i;
+  }
+}
+
+TEST_F(QuantizeGraphTest, ConsiderFn) {
+  BuildNet();
+  TF_ASSERT_OK(
+      Quantize([](const Node* n) { return n->type_string() == "Relu"; }));
+  EXPECT_EQ("Dequantize", FindNode("relu")->type_string());
+  EXPECT_EQ("BiasAdd", FindNode("bias_add")->type_string());
+  EXPECT_EQ("MatMul", FindNode("matmul")->type_string());
+}
+
+TEST_F(QuantizeGraphTest, SkipsUnsupportedNodes) {
+  Node* a = Random(TensorShape({2, 2}), 1);
+  Node* gpu_matmul;
+  TF_ASSERT_OK(NodeBuilder("gpu_matmul", "MatMul")
+                   .Input(a)
+                   .Input(a)
+                   .Device("/gpu:0")
+                   .Finalize(g_.get(), &gpu_matmul));
+  Node* image = Random(TensorShape({1, 3, 4, 4}), 1);
+  Node* nchw_pool;
+  TF_ASSERT_OK(NodeBuilder("nchw_pool", "MaxPool")
+                   .Input(image)
+                   .Attr("ksize", {1, 1, 2, 2})
+                   .Attr("strides", {1, 1, 2, 2})
+                   .Attr("padding", "VALID")
+                   .Attr("data_format", "NCHW")
+                   .Finalize(g_.get(), &nchw_pool));
+  Node* depth_pool;
+  TF_ASSERT_OK(NodeBuilder("depth_pool", "MaxPool")
+                   .Input(image)
+                   .Attr("ksize", {1, 1, 1, 2})
+                   .Attr("strides", {1, 1, 1, 2})
+                   .Attr("padding", "VALID")
+                   .Finalize(g_.get(), &depth_pool));
+  FixupSourceAndSinkEdges(g_.get());
+  bool changed = true;
+  TF_ASSERT_OK(QuantizeGraph(g_.get(), nullptr, &changed));
+  EXPECT_FALSE(changed);
+  EXPECT_EQ("MatMul", FindNode("gpu_matmul")->type_string());
+  EXPECT_EQ("MaxPool", FindNode("nchw_pool")->type_string());
+  EXPECT_EQ("MaxPool", FindNode("depth_pool")->type_string());
+}
+
+}  // namespace
+}  // namespace tensorflow
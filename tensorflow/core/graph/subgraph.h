@@ -43,6 +43,12 @@ namespace subgraph {
 // to every output in "fetch_outputs".  These "_send" nodes are set up
 // to execute on the device described by device_info.
 //
+// If "use_function_convention" is true, the feeds and fetches are
+// "_Arg" and "_Retval" nodes instead, whose "index" is the position of
+// the tensor in "fed_outputs" or "fetch_outputs".  The graph then
+// exchanges them through the FunctionCallFrame of its executors rather
+// than through a rendezvous.
+//
 // On success, returns OK, and sets "*g" to a version of "*g"
 // that represents the portions of the graph necessary for producing
 // the output of all nodes listed in "target_node_names" and fetching the
@@ -56,21 +62,24 @@ Status RewriteGraphForExecution(
     Graph* g, const gtl::ArraySlice<string>& fed_outputs,
     const gtl::ArraySlice<string>& fetch_outputs,
     const gtl::ArraySlice<string>& target_node_names,
-    const DeviceAttributes& device_info);
+    const DeviceAttributes& device_info, bool use_function_convention);
 
 typedef std::unordered_map<StringPiece, Node*, StringPiece::Hasher> NameIndex;
 
 // Augment "*g" by adding special "fetch" nodes that connect to the
 // tensor outputs specified in "fetch_outputs" to retrieve the output
 // of the tensors.  The new nodes added are set up to execute on
-// "client_device_name", and are returned in "*fetch_nodes".
+// "client_device_name", and are returned in "*fetch_nodes".  They are
+// "_Retval" nodes if "use_function_convention" is true, and "_Send"
+// nodes otherwise.
 //
 // Return OK on success.  On error, return false and sets *error to
 // an appropriate error message (and *g is left in an indeterminate
 // state).
 Status FetchOutputs(Graph* g, const DeviceAttributes& device_info,
                     const gtl::ArraySlice<string>& fetch_outputs,
-                    NameIndex* name_index, std::vector<Node*>* fetch_nodes);
+                    bool use_function_convention, NameIndex* name_index,
+                    std::vector<Node*>* fetch_nodes);
 
 }  // namespace subgraph
 }  // namespace tensorflow
@@ -19,6 +19,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
@@ -81,7 +82,8 @@ class SubgraphTest : public ::testing::Test {
     for (const string& s : expected_nodes) {
       Node* n = FindNode(s);
       EXPECT_TRUE(n != nullptr) << s;
-      if (n->def().op() == "_Send" || n->def().op() == "_Recv") {
+      if (n->def().op() == "_Send" || n->def().op() == "_Recv" ||
+          n->def().op() == "_Arg" || n->def().op() == "_Retval") {
         EXPECT_EQ(device_info_.name(), n->assigned_device_name()) << s;
       }
     }
@@ -104,7 +106,8 @@ class SubgraphTest : public ::testing::Test {
   }
 
   string Subgraph(const string& fed_str, const string& fetch_str,
-                  const string& targets_str) {
+                  const string& targets_str,
+                  bool use_function_convention = false) {
     Graph* subgraph = new Graph(OpRegistry::Global());
     CopyGraph(*g_, subgraph);
     std::vector<string> fed =
@@ -114,8 +117,8 @@ class SubgraphTest : public ::testing::Test {
     std::vector<string> targets =
         str_util::Split(targets_str, ',', str_util::SkipEmpty());
 
-    Status s = subgraph::RewriteGraphForExecution(subgraph, fed, fetch, targets,
-                                                  device_info_);
+    Status s = subgraph::RewriteGraphForExecution(
+        subgraph, fed, fetch, targets, device_info_, use_function_convention);
     if (!s.ok()) {
       delete subgraph;
       return s.ToString();
@@ -273,6 +276,29 @@ TEST_F(SubgraphTest, Errors) {
   EXPECT_TRUE(HasSubstr(Subgraph("", "", "foo"), "not found"));
 }
 
+TEST_F(SubgraphTest, FunctionConvention) {
+  ExpectOK(
+      "node { name: 'a' op: 'TestParams' }"
+      "node { name: 'b' op: 'TestRelu' input: 'a'}"
+      "node { name: 'c' op: 'TestRelu' input: 'b'}"
+      "node { name: 'd' op: 'TestRelu' input: 'c'}"
+      "node { name: 'e' op: 'TestRelu' input: 'd'}"
+      "node { name: 'f' op: 'TestRelu' input: 'e'}");
+  EXPECT_EQ("OK", Subgraph("c:0", "e:0,b:0", "", true));
+  ExpectNodes("a,b,_retval_b_0_1,_arg_c_0_0,d,e,_retval_e_0_0");
+  EXPECT_TRUE(HasEdge("b", 0, "_retval_b_0_1", 0));
+  EXPECT_TRUE(HasEdge("_arg_c_0_0", 0, "d", 0));
+  EXPECT_TRUE(HasEdge("e", 0, "_retval_e_0_0", 0));
+  // The indices are the positions of the feeds and fetches.
+  int index;
+  TF_EXPECT_OK(GetNodeAttr(FindNode("_arg_c_0_0")->def(), "index", &index));
+  EXPECT_EQ(0, index);
+  TF_EXPECT_OK(
+      GetNodeAttr(FindNode("_retval_b_0_1")->def(), "index", &index));
+  EXPECT_EQ(1, index);
+  EXPECT_EQ(DT_FLOAT, FindNode("_arg_c_0_0")->output_type(0));
+}
+
 REGISTER_OP("In").Output("o: float");
 REGISTER_OP("Op").Input("i: float").Output("o: float");
 
@@ -308,8 +334,8 @@ static void BM_Subgraph(int iters, int num_nodes) {
   while (--iters > 0) {
     Graph* subgraph = new Graph(OpRegistry::Global());
     CopyGraph(g, subgraph);
-    TF_CHECK_OK(subgraph::RewriteGraphForExecution(subgraph, fed, fetch,
-                                                   targets, device_info));
+    TF_CHECK_OK(subgraph::RewriteGraphForExecution(
+        subgraph, fed, fetch, targets, device_info, false));
     delete subgraph;
   }
 }
@@ -73,8 +73,8 @@ class BiasOp<CPUDevice, T> : public BinaryOp<T> {
             bias.shape().DebugString(), " vs. ", input.shape().DebugString()));
 
     Tensor* output = nullptr;
-    OP_REQUIRES_OK(context,
-                   context->allocate_output(0, input.shape(), &output));
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, input.shape(), &output));
 
     switch (input.shape().dims()) {
       case 2:
@@ -235,8 +235,8 @@ class BiasOp<GPUDevice, T> : public BinaryOp<T> {
                 errors::InvalidArgument("Biases must be 1D: ",
                                         bias.shape().DebugString()));
     Tensor* output = nullptr;
-    OP_REQUIRES_OK(context,
-                   context->allocate_output(0, input.shape(), &output));
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, input.shape(), &output));
     int32 batch, height, width, channel;
     GetBiasValueDims(input, data_format_, &batch, &height, &width, &channel);
     OP_REQUIRES(context, bias.shape().dim_size(0) == channel,
@@ -101,7 +101,9 @@ class CastOpBase : public OpKernel {
       ctx->set_output(0, inp);
     } else {
       Tensor* out = nullptr;
-      OP_REQUIRES_OK(ctx, ctx->allocate_output(0, inp.shape(), &out));
+      // Casts between types of the same size may overwrite the input.
+      OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                              {0}, 0, inp.shape(), &out));
       work_(ctx, inp, out);
     }
   }
@@ -142,6 +144,8 @@ class CpuCastOp : public CastOpBase {
     CURRY_TYPES3(CAST_CASE, CPUDevice, int64);
     CURRY_TYPES3(CAST_CASE, CPUDevice, float);
     CURRY_TYPES3(CAST_CASE, CPUDevice, double);
+    CAST_CASE(CPUDevice, Eigen::half, float);
+    CAST_CASE(CPUDevice, float, Eigen::half);
 
     if (src_dtype_ == DT_BFLOAT16 && dst_dtype_ == DT_FLOAT) {
       work_ = [](OpKernelContext* ctx, const Tensor& inp, Tensor* out) {
@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cmath>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/node_def_builder.h"
@@ -83,6 +86,32 @@ TEST_ALL_CASTS_FROM(double)
 #undef TEST_ALL_CASTS_FROM
 #undef TEST_CAST
 
+// Half values round to nearest even, and overflow to infinity.
+TEST_F(CastOpTest, TestCast_float_half) {
+  MakeOp(DT_FLOAT, DT_HALF);
+  AddInputFromArray<float>(TensorShape({5}),
+                           {1.0f, -2.25f, 1.0f / 3, 65504.0f, 65536.0f});
+  TF_ASSERT_OK(RunOpKernel());
+  auto out = GetOutput(0)->flat<Eigen::half>();
+  EXPECT_EQ(1.0f, static_cast<float>(out(0)));
+  EXPECT_EQ(-2.25f, static_cast<float>(out(1)));
+  EXPECT_EQ(0.333251953125f, static_cast<float>(out(2)));
+  EXPECT_EQ(65504.0f, static_cast<float>(out(3)));
+  EXPECT_TRUE(std::isinf(static_cast<float>(out(4))));
+}
+
+TEST_F(CastOpTest, TestCast_half_float) {
+  MakeOp(DT_HALF, DT_FLOAT);
+  const std::vector<float> values = {1.0f, -2.25f, 0.333251953125f, 65504.0f};
+  std::vector<Eigen::half> halves;
+  for (float v : values) halves.push_back(Eigen::half(v));
+  AddInputFromArray<Eigen::half>(TensorShape({4}), halves);
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({4}));
+  test::FillValues<float>(&expected, values);
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
 // TODO(wicke): check conversions from/to bool, and bfloat16
 
 static void BM_cpu_float_int64(int iters, int num) {
@@ -139,4 +168,22 @@ static void BM_cpu_bfloat16_float(int iters, int num) {
 }
 BENCHMARK(BM_cpu_bfloat16_float)->Arg(64 << 10)->Arg(32 << 20);
 
+static void BM_cpu_float_half(int iters, int num) {
+  testing::ItemsProcessed(static_cast<int64>(iters) * num);
+  testing::BytesProcessed(static_cast<int64>(iters) * num *
+                          (sizeof(float) + sizeof(Eigen::half)));
+  testing::UseRealTime();
+  test::Benchmark("cpu", Cast<float, Eigen::half>(num)).Run(iters);
+}
+BENCHMARK(BM_cpu_float_half)->Arg(64 << 10)->Arg(32 << 20);
+
+static void BM_cpu_half_float(int iters, int num) {
+  testing::ItemsProcessed(static_cast<int64>(iters) * num);
+  testing::BytesProcessed(static_cast<int64>(iters) * num *
+                          (sizeof(float) + sizeof(Eigen::half)));
+  testing::UseRealTime();
+  test::Benchmark("cpu", Cast<Eigen::half, float>(num)).Run(iters);
+}
+BENCHMARK(BM_cpu_half_float)->Arg(64 << 10)->Arg(32 << 20);
+
 }  // end namespace tensorflow
@@ -123,6 +123,7 @@ DEFINE_SETZERO_CPU(float);
 DEFINE_SETZERO_CPU(double);
 DEFINE_SETZERO_CPU(int32);
 DEFINE_SETZERO_CPU(complex64);
+DEFINE_SETZERO_CPU(Eigen::half);
 #undef DEFINE_SETZERO_CPU
 
 }  // end namespace functor
@@ -169,6 +170,7 @@ class FillOp : public OpKernel {
 
 #define REGISTER_CPU_KERNEL(TYPE) REGISTER_KERNEL(CPU, TYPE)
 TF_CALL_ALL_TYPES(REGISTER_CPU_KERNEL);
+TF_CALL_half(REGISTER_CPU_KERNEL);
 #undef REGISTER_CPU_KERNEL
 
 #if GOOGLE_CUDA
@@ -215,6 +217,7 @@ class ZerosLikeOp : public OpKernel {
 
 #define REGISTER_CPU(type) REGISTER_KERNEL(type, CPU)
 TF_CALL_ALL_TYPES(REGISTER_CPU);
+TF_CALL_half(REGISTER_CPU);
 #undef REGISTER_CPU
 
 #if GOOGLE_CUDA
@@ -53,8 +53,10 @@ BinaryOpShared::BinaryOpState::BinaryOpState(OpKernelContext* ctx)
                                            in1.shape().DebugString()));
     return;
   }
-  OP_REQUIRES_OK(ctx,
-                 ctx->allocate_output(0, ToShape(bcast.output_shape()), &out));
+  // An input as large as the output is not broadcast, so the output may
+  // overwrite it.
+  OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                          {0, 1}, 0, ToShape(bcast.output_shape()), &out));
   out_num_elements = out->NumElements();
   in0_num_elements = in0.NumElements();
   in1_num_elements = in1.NumElements();
@@ -14,8 +14,11 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -116,6 +119,57 @@ BM_BIAS_ADD_ALL(gpu);
 #undef BM_BIAS_ADD_ALL
 #undef BM_BIAS_ADD
 
+// Creates a Graph which applies a chain of "length" elementwise ops to a
+// float tensor of "num" elements, so that each op but the first is the last
+// consumer of its input.
+static Graph* ElementwiseChain(int num, int length) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor data(DT_FLOAT, TensorShape({64, num / 64}));
+  data.flat<float>().setRandom();
+  Tensor bias(DT_FLOAT, TensorShape({num / 64}));
+  bias.flat<float>().setRandom();
+  Node* scale = test::graph::Constant(g, test::AsScalar<float>(0.5f));
+  Node* b = test::graph::Constant(g, bias);
+  Node* x = test::graph::Constant(g, data);
+  for (int i = 0; i < length; ++i) {
+    switch (i % 4) {
+      case 0:
+        x = test::graph::Unary(g, "Tanh", x);
+        break;
+      case 1:
+        x = test::graph::Binary(g, "Mul", x, scale);
+        break;
+      case 2:
+        x = test::graph::Binary(g, "BiasAdd", x, b);
+        break;
+      case 3:
+        x = test::graph::Unary(g, "Sigmoid", x);
+        break;
+    }
+  }
+  return g;
+}
+
+// Reports the number of buffers allocated per step: the ops after the
+// first reuse the buffer of their input.
+static void BM_cpu_ElementwiseChain(int iters, int num) {
+  const int kLength = 16;
+  const int64 tot = static_cast<int64>(iters) * num * kLength;
+  testing::ItemsProcessed(tot);
+  testing::BytesProcessed(tot * sizeof(float));
+  EnableCPUAllocatorStats(true);
+  AllocatorStats before;
+  cpu_allocator()->GetStats(&before);
+  test::Benchmark("cpu", ElementwiseChain(num, kLength)).Run(iters);
+  AllocatorStats after;
+  cpu_allocator()->GetStats(&after);
+  EnableCPUAllocatorStats(false);
+  // The benchmark runs three more steps to warm up.
+  testing::SetLabel(strings::StrCat(
+      "allocs/step: ", (after.num_allocs - before.num_allocs) / (iters + 3)));
+}
+BENCHMARK(BM_cpu_ElementwiseChain)->Arg(4 << 10)->Arg(256 << 10)->Arg(1 << 20);
+
 static Graph* BcastAdd(int rows, int cols, int dim) {
   Graph* g = new Graph(OpRegistry::Global());
   Tensor lhs(DT_FLOAT, TensorShape({rows, cols}));
@@ -14,19 +14,40 @@ limitations under the License.
 ==============================================================================*/
 
 // See docs in ../ops/parsing_ops.cc.
+#include <string.h>
 #include <vector>
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
+namespace {
+
+// Parses a float from "s" as safe_strtof() does from a copy of it, but
+// copies short fields to the stack instead of the heap.
+bool ParseFloat(StringPiece s, float* value) {
+  char buf[64];
+  if (s.size() < sizeof(buf)) {
+    memcpy(buf, s.data(), s.size());
+    buf[s.size()] = '\0';
+    return strings::safe_strtof(buf, value);
+  }
+  return strings::safe_strtof(s.ToString().c_str(), value);
+}
+
+}  // namespace
+
 class DecodeCSVOp : public OpKernel {
  public:
-  explicit DecodeCSVOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+  explicit DecodeCSVOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx), cost_(kInitialCostPerRecord) {
     string delim;
 
     OP_REQUIRES_OK(ctx, ctx->GetAttr("OUT_TYPE", &out_type_));
@@ -36,6 +57,10 @@ class DecodeCSVOp : public OpKernel {
                 errors::InvalidArgument("field_delim should be only 1 char"));
 
     delim_ = delim[0];
+    for (int c = 0; c < 256; ++c) {
+      ends_unquoted_[c] = c == static_cast<uint8>(delim_) || c == '"' ||
+                          c == '\n' || c == '\r';
+    }
   }
 
   void Compute(OpKernelContext* ctx) override {
@@ -58,178 +83,207 @@ class DecodeCSVOp : public OpKernel {
     OpOutputList output;
     OP_REQUIRES_OK(ctx, ctx->output_list("output", &output));
 
+    std::vector<Column> columns(out_type_.size());
     for (size_t i = 0; i < out_type_.size(); ++i) {
       Tensor* out = nullptr;
-      output.allocate(i, records->shape(), &out);
+      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &out));
+      columns[i].dtype = out_type_[i];
+      columns[i].out = out;
+      if (record_defaults[i].NumElements() == 1) {
+        columns[i].default_value = &record_defaults[i];
+      }
     }
 
-    for (int64 i = 0; i < records_size; ++i) {
-      const StringPiece record(records_t(i));
-      std::vector<string> fields;
-      ExtractFields(ctx, record, &fields);
-      OP_REQUIRES(ctx, fields.size() == out_type_.size(),
-                  errors::InvalidArgument("Expect ", out_type_.size(),
-                                          " fields but have ", fields.size(),
-                                          " in record ", i));
-
-      // Check each field in the record
-      for (size_t f = 0; f < out_type_.size(); ++f) {
-        const DataType& dtype = out_type_[f];
-        switch (dtype) {
-          case DT_INT32: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
-            } else {
-              int32 value;
-              OP_REQUIRES(ctx, strings::safe_strto32(fields[f], &value),
-                          errors::InvalidArgument("Field ", f, " in record ", i,
-                                                  " is not a valid int32: ",
-                                                  fields[f]));
-              output[f]->flat<int32>()(i) = value;
-            }
-            break;
-          }
-          case DT_INT64: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
-            } else {
-              int64 value;
-              OP_REQUIRES(ctx, strings::safe_strto64(fields[f], &value),
-                          errors::InvalidArgument("Field ", f, " in record ", i,
-                                                  " is not a valid int64: ",
-                                                  fields[f]));
-              output[f]->flat<int64>()(i) = value;
-            }
-            break;
-          }
-          case DT_FLOAT: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
-            } else {
-              float value;
-              OP_REQUIRES(ctx, strings::safe_strtof(fields[f].c_str(), &value),
-                          errors::InvalidArgument("Field ", f, " in record ", i,
-                                                  " is not a valid float: ",
-                                                  fields[f]));
-              output[f]->flat<float>()(i) = value;
-            }
-            break;
-          }
-          case DT_STRING: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<string>()(i) =
-                  record_defaults[f].flat<string>()(0);
-            } else {
-              output[f]->flat<string>()(i) = fields[f];
-            }
-            break;
+    // Records are decoded in parallel, each straight into its row of the
+    // outputs.  The error reported is that of the first bad record, as
+    // if they were decoded in order.
+    mutex mu;
+    int64 first_error = records_size;
+    Status error;
+    auto work = [this, &records_t, &columns, &mu, &first_error, &error](
+        int64 start, int64 limit) {
+      std::vector<StringPiece> fields;
+      string scratch;
+      for (int64 i = start; i < limit; ++i) {
+        Status s = DecodeRecord(records_t(i), i, columns, &fields, &scratch);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          if (i < first_error) {
+            first_error = i;
+            error = s;
           }
-          default:
-            OP_REQUIRES(ctx, false,
-                        errors::InvalidArgument("csv: data type ", dtype,
-                                                " not supported in field ", f));
+          return;
         }
       }
-    }
+    };
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    AdaptiveShard(worker_threads->num_threads, worker_threads->workers,
+                  records_size, &cost_, work);
+    OP_REQUIRES_OK(ctx, error);
   }
 
  private:
+  // A guess of the cost of decoding a record, in ns, until it is measured.
+  static const int64 kInitialCostPerRecord = 1000;
+
+  // An output column and its default value, if it has one.
+  struct Column {
+    DataType dtype = DT_INVALID;
+    Tensor* out = nullptr;
+    const Tensor* default_value = nullptr;
+  };
+
   std::vector<DataType> out_type_;
   char delim_;
+  // Whether a character ends the body of an unquoted field: the
+  // delimiter, or one that may not appear inside it.
+  bool ends_unquoted_[256];
+  ShardCost cost_;
 
-  void ExtractFields(OpKernelContext* ctx, StringPiece input,
-                     std::vector<string>* result) {
-    int64 current_idx = 0;
-    if (!input.empty()) {
-      while (static_cast<size_t>(current_idx) < input.size()) {
-        if (input[current_idx] == '\n' || input[current_idx] == '\r') {
-          current_idx++;
-          continue;
-        }
+  // Decodes record "i", "record", into row "i" of "columns".  "fields"
+  // and "scratch" are reused from record to record.
+  Status DecodeRecord(StringPiece record, int64 i,
+                      const std::vector<Column>& columns,
+                      std::vector<StringPiece>* fields,
+                      string* scratch) const {
+    TF_RETURN_IF_ERROR(ExtractFields(record, fields, scratch));
+    if (fields->size() != columns.size()) {
+      return errors::InvalidArgument("Expect ", columns.size(),
+                                     " fields but have ", fields->size(),
+                                     " in record ", i);
+    }
 
-        bool quoted = false;
-        if (input[current_idx] == '"') {
-          quoted = true;
-          current_idx++;
+    // Check each field in the record
+    for (size_t f = 0; f < columns.size(); ++f) {
+      const Column& column = columns[f];
+      const StringPiece field = (*fields)[f];
+      // If this field is empty, check if default is given:
+      // If yes, use default value; Otherwise report error.
+      if (field.empty() && column.default_value == nullptr) {
+        return errors::InvalidArgument(
+            "Field ", f, " is required but missing in record ", i, "!");
+      }
+      switch (column.dtype) {
+        case DT_INT32: {
+          int32* out = &column.out->flat<int32>()(i);
+          if (field.empty()) {
+            *out = column.default_value->flat<int32>()(0);
+          } else if (!strings::safe_strto32(field, out)) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid int32: ", field);
+          }
+          break;
         }
-
-        // This is the body of the field;
-        string field;
-        if (!quoted) {
-          while (static_cast<size_t>(current_idx) < input.size() &&
-                 input[current_idx] != delim_) {
-            OP_REQUIRES(ctx, input[current_idx] != '"' &&
-                                 input[current_idx] != '\n' &&
-                                 input[current_idx] != '\r',
-                        errors::InvalidArgument(
-                            "Unquoted fields cannot have quotes/CRLFs inside"));
-            field += input[current_idx];
-            current_idx++;
+        case DT_INT64: {
+          int64* out = &column.out->flat<int64>()(i);
+          if (field.empty()) {
+            *out = column.default_value->flat<int64>()(0);
+          } else if (!strings::safe_strto64(field, out)) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid int64: ", field);
           }
-
-          // Go to next field or the end
-          current_idx++;
-        } else {
-          // Quoted field needs to be ended with '"' and delim or end
-          while (
-              (static_cast<size_t>(current_idx) < input.size() - 1) &&
-              (input[current_idx] != '"' || input[current_idx + 1] != delim_)) {
-            if (input[current_idx] != '"') {
-              field += input[current_idx];
-              current_idx++;
-            } else {
-              OP_REQUIRES(
-                  ctx, input[current_idx + 1] == '"',
-                  errors::InvalidArgument("Quote inside a string has to be "
-                                          "escaped by another quote"));
-              field += '"';
-              current_idx += 2;
-            }
+          break;
+        }
+        case DT_FLOAT: {
+          float* out = &column.out->flat<float>()(i);
+          if (field.empty()) {
+            *out = column.default_value->flat<float>()(0);
+          } else if (!ParseFloat(field, out)) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid float: ", field);
           }
+          break;
+        }
+        case DT_STRING: {
+          string* out = &column.out->flat<string>()(i);
+          if (field.empty()) {
+            *out = column.default_value->flat<string>()(0);
+          } else {
+            out->assign(field.data(), field.size());
+          }
+          break;
+        }
+        default:
+          return errors::InvalidArgument("csv: data type ", column.dtype,
+                                         " not supported in field ", f);
+      }
+    }
+    return Status::OK();
+  }
 
-          OP_REQUIRES(
-              ctx, (static_cast<size_t>(current_idx) < input.size() &&
-                    input[current_idx] == '"' &&
-                    (static_cast<size_t>(current_idx) == input.size() - 1 ||
-                     input[current_idx + 1] == delim_)),
-              errors::InvalidArgument("Quoted field has to end with quote "
-                                      "followed by delim or end"));
+  // Splits "input" into "*result".  The fields refer to "input", except
+  // for quoted fields with escaped quotes, which are unescaped into
+  // "*scratch".
+  Status ExtractFields(StringPiece input, std::vector<StringPiece>* result,
+                       string* scratch) const {
+    result->clear();
+    scratch->clear();
+    // Unescaping only removes characters, so "*scratch" is not
+    // reallocated, and the fields that refer to it stay valid.
+    scratch->reserve(input.size());
+    const char* const end = input.data() + input.size();
+    const char* p = input.data();
+    while (p < end) {
+      if (*p == '\n' || *p == '\r') {
+        p++;
+        continue;
+      }
 
-          current_idx += 2;
+      if (*p != '"') {
+        // This is the body of the field;
+        const char* q = p;
+        while (q < end && !ends_unquoted_[static_cast<uint8>(*q)]) q++;
+        if (q < end && *q != delim_) {
+          return errors::InvalidArgument(
+              "Unquoted fields cannot have quotes/CRLFs inside");
         }
+        result->emplace_back(p, q - p);
+
+        // Go to next field or the end
+        p = (q < end) ? q + 1 : end;
+        continue;
+      }
 
-        result->push_back(field);
+      // Quoted field needs to be ended with '"' and delim or end.  A
+      // quote inside it has to be escaped by another quote.
+      p++;
+      const char* run = p;  // Start of the characters not yet unescaped.
+      const size_t unescaped_start = scratch->size();
+      bool unescaped = false;
+      while (true) {
+        const char* q = static_cast<const char*>(memchr(p, '"', end - p));
+        if (q == nullptr) {
+          return errors::InvalidArgument(
+              "Quoted field has to end with quote followed by delim or end");
+        }
+        if (q + 1 == end || q[1] == delim_) {
+          if (unescaped) {
+            scratch->append(run, q - run);
+            result->emplace_back(scratch->data() + unescaped_start,
+                                 scratch->size() - unescaped_start);
+          } else {
+            result->emplace_back(run, q - run);
+          }
+          p = (q + 1 < end) ? q + 2 : end;
+          break;
+        }
+        if (q[1] != '"') {
+          return errors::InvalidArgument(
+              "Quote inside a string has to be escaped by another quote");
+        }
+        // Keep one of the two quotes.
+        scratch->append(run, q + 1 - run);
+        unescaped = true;
+        p = q + 2;
+        run = p;
       }
+    }
 
-      // Check if the last field is missing
-      if (input[input.size() - 1] == delim_) result->push_back(string());
+    // Check if the last field is missing
+    if (!input.empty() && input[input.size() - 1] == delim_) {
+      result->emplace_back();
     }
+    return Status::OK();
   }
 };
 
@@ -0,0 +1,229 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class DecodeCSVOpTest : public OpsTestBase {
+ protected:
+  // Makes a DecodeCSV op with an int32, an int64, a float and a string
+  // column, delimited by "delim".
+  void MakeOp(const string& delim) {
+    TF_ASSERT_OK(NodeDefBuilder("decode", "DecodeCSV")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput({DT_INT32, DT_INT64, DT_FLOAT,
+                                       DT_STRING}))
+                     .Attr("field_delim", delim)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Adds "records" and defaults for the columns, all of which are
+  // required unless "with_defaults".
+  void AddInputs(const std::vector<string>& records, bool with_defaults) {
+    AddInputFromArray<string>(
+        TensorShape({static_cast<int64>(records.size())}), records);
+    const TensorShape shape({with_defaults ? 1 : 0});
+    AddInputFromArray<int32>(shape, with_defaults ? std::vector<int32>{-1}
+                                                  : std::vector<int32>{});
+    AddInputFromArray<int64>(shape, with_defaults ? std::vector<int64>{-2}
+                                                  : std::vector<int64>{});
+    AddInputFromArray<float>(shape, with_defaults ? std::vector<float>{-3}
+                                                  : std::vector<float>{});
+    AddInputFromArray<string>(shape, with_defaults ? std::vector<string>{"d"}
+                                                   : std::vector<string>{});
+  }
+
+  void ExpectOutputs(const std::vector<int32>& ints,
+                     const std::vector<int64>& int64s,
+                     const std::vector<float>& floats,
+                     const std::vector<string>& strings) {
+    const TensorShape shape({static_cast<int64>(ints.size())});
+    test::ExpectTensorEqual<int32>(test::AsTensor<int32>(ints, shape),
+                                   *GetOutput(0));
+    test::ExpectTensorEqual<int64>(test::AsTensor<int64>(int64s, shape),
+                                   *GetOutput(1));
+    test::ExpectTensorEqual<float>(test::AsTensor<float>(floats, shape),
+                                   *GetOutput(2));
+    test::ExpectTensorEqual<string>(test::AsTensor<string>(strings, shape),
+                                    *GetOutput(3));
+  }
+
+  void ExpectError(const std::vector<string>& records, const string& error) {
+    MakeOp(",");
+    AddInputs(records, false);
+    Status s = RunOpKernel();
+    EXPECT_TRUE(StringPiece(s.ToString()).contains(error)) << s;
+  }
+};
+
+TEST_F(DecodeCSVOpTest, Simple) {
+  MakeOp(",");
+  AddInputs({"1,2,3.5,a", " -4 ,5000000000, 6e2 ,bc"}, false);
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectOutputs({1, -4}, {2, 5000000000LL}, {3.5, 600}, {"a", "bc"});
+}
+
+TEST_F(DecodeCSVOpTest, Defaults) {
+  MakeOp(",");
+  AddInputs({",,,", "1,,,x", ",2,3,"}, true);
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectOutputs({-1, 1, -1}, {-2, -2, 2}, {-3, -3, 3}, {"d", "x", "d"});
+}
+
+TEST_F(DecodeCSVOpTest, Quoted) {
+  MakeOp(",");
+  AddInputs({"\"1\",\"2\",\"3\",\"a,\"\"b\"\"\nc\"",
+             "4,5,6,\"\"\"\"", "7,8,9,\"\""},
+            true);
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectOutputs({1, 4, 7}, {2, 5, 8}, {3, 6, 9}, {"a,\"b\"\nc", "\"", "d"});
+}
+
+TEST_F(DecodeCSVOpTest, Delimiter) {
+  MakeOp("|");
+  AddInputs({"1|2|3|a,b"}, false);
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectOutputs({1}, {2}, {3}, {"a,b"});
+}
+
+TEST_F(DecodeCSVOpTest, ManyRecords) {
+  // Enough records to be decoded in parallel.
+  MakeOp(",");
+  std::vector<string> records;
+  std::vector<int32> ints;
+  std::vector<int64> int64s;
+  std::vector<float> floats;
+  std::vector<string> strings;
+  for (int i = 0; i < 10000; ++i) {
+    records.push_back(strings::StrCat(i, ",", -i, ",", i * 0.5, ",s", i));
+    ints.push_back(i);
+    int64s.push_back(-i);
+    floats.push_back(i * 0.5);
+    strings.push_back(strings::StrCat("s", i));
+  }
+  AddInputs(records, false);
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectOutputs(ints, int64s, floats, strings);
+}
+
+TEST_F(DecodeCSVOpTest, MissingRequiredField) {
+  ExpectError({"1,2,3,a", "1,,3,a"},
+              "Field 1 is required but missing in record 1!");
+}
+
+TEST_F(DecodeCSVOpTest, InvalidInt) {
+  ExpectError({"1,2,3,a", "1a,2,3,a"},
+              "Field 0 in record 1 is not a valid int32: 1a");
+}
+
+TEST_F(DecodeCSVOpTest, InvalidFloat) {
+  ExpectError({"1,2,3x,a"}, "Field 2 in record 0 is not a valid float: 3x");
+}
+
+TEST_F(DecodeCSVOpTest, WrongNumberOfFields) {
+  ExpectError({"1,2,3,a,"}, "Expect 4 fields but have 5 in record 0");
+}
+
+TEST_F(DecodeCSVOpTest, QuoteInUnquotedField) {
+  ExpectError({"1,2,3,a\"b"}, "Unquoted fields cannot have quotes/CRLFs");
+}
+
+TEST_F(DecodeCSVOpTest, UnterminatedQuotedField) {
+  ExpectError({"1,2,3,\"a"}, "Quoted field has to end with quote");
+}
+
+TEST_F(DecodeCSVOpTest, UnescapedQuote) {
+  ExpectError({"1,2,3,\"a\"b\""}, "Quote inside a string has to be escaped");
+}
+
+TEST_F(DecodeCSVOpTest, FirstErrorIsReported) {
+  std::vector<string> records(10000, "1,2,3,a");
+  records[5000] = "x,2,3,a";
+  records[9000] = "1,2,3";
+  ExpectError(records, "Field 0 in record 5000 is not a valid int32: x");
+}
+
+// A batch of "batch_size" records of "num_fields" fields each, cycling
+// through int64, float and string columns.
+static Graph* DecodeCSV(int batch_size, int num_fields) {
+  Graph* g = new Graph(OpRegistry::Global());
+  static const DataType kTypes[] = {DT_INT64, DT_FLOAT, DT_STRING};
+  std::vector<NodeBuilder::NodeOut> defaults;
+  std::vector<DataType> types;
+  for (int f = 0; f < num_fields; ++f) {
+    types.push_back(kTypes[f % 3]);
+    defaults.emplace_back(
+        test::graph::Constant(g, Tensor(types.back(), TensorShape({0}))));
+  }
+
+  Tensor records(DT_STRING, TensorShape({batch_size}));
+  for (int b = 0; b < batch_size; ++b) {
+    string* record = &records.vec<string>()(b);
+    for (int f = 0; f < num_fields; ++f) {
+      if (f > 0) record->append(",");
+      switch (types[f]) {
+        case DT_INT64:
+          strings::StrAppend(record, b * 1000 + f);
+          break;
+        case DT_FLOAT:
+          strings::StrAppend(record, b * 0.25 + f);
+          break;
+        default:
+          strings::StrAppend(record, "field_", b, "_", f);
+          break;
+      }
+    }
+  }
+
+  Node* ret;
+  TF_EXPECT_OK(NodeBuilder(g->NewName("n"), "DecodeCSV")
+                   .Input(test::graph::Constant(g, records))
+                   .Input(defaults)
+                   .Attr("OUT_TYPE", types)
+                   .Finalize(g, &ret));
+  return g;
+}
+
+// Reports records (rows) per second.
+#define BM_DecodeCSV(B, F)                                  \
+  static void BM_DecodeCSV##_##B##_##F(int iters) {         \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B); \
+    test::Benchmark("cpu", DecodeCSV(B, F)).Run(iters);     \
+  }                                                         \
+  BENCHMARK(BM_DecodeCSV##_##B##_##F);
+
+BM_DecodeCSV(1, 10);
+BM_DecodeCSV(128, 10);
+BM_DecodeCSV(4096, 10);
+BM_DecodeCSV(4096, 100);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,73 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/array_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/type_traits.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+template <typename T>
+class DequantizeOp : public OpKernel {
+ public:
+  explicit DequantizeOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& input = ctx->input(0);
+    float min_range;
+    float max_range;
+    OP_REQUIRES_OK(ctx, GetQuantizationRange(ctx, 1, &min_range, &max_range));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, input.shape(), &output));
+
+    // Computed as in QuantizedToFloat, with the constants hoisted.
+    const double scale = QuantizationScale<T>(min_range, max_range);
+    const double lowest = static_cast<int64>(Eigen::NumTraits<T>::lowest());
+    const float offset =
+        min_range == max_range
+            ? min_range
+            : round(min_range / scale) * scale - lowest * scale;
+    typedef typename QuantizedRawType<T>::type Raw;
+    auto in = typename TTypes<Raw>::ConstFlat(
+        reinterpret_cast<const Raw*>(input.flat<T>().data()),
+        input.NumElements());
+    output->flat<float>().device(ctx->eigen_device<CPUDevice>()) =
+        in.template cast<float>() * static_cast<float>(scale) + offset;
+  }
+};
+
+#define REGISTER_DEQUANTIZE(type)                                      \
+  REGISTER_KERNEL_BUILDER(                                             \
+      Name("Dequantize").Device(DEVICE_CPU).TypeConstraint<type>("T"), \
+      DequantizeOp<type>)
+
+REGISTER_DEQUANTIZE(qint8);
+REGISTER_DEQUANTIZE(quint8);
+REGISTER_DEQUANTIZE(qint32);
+#undef REGISTER_DEQUANTIZE
+
+}  // namespace tensorflow
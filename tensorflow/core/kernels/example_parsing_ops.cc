@@ -15,6 +15,7 @@ limitations under the License.
 
 // See docs in ../ops/parsing_ops.cc.
 
+#include <atomic>
 #include <unordered_set>
 
 #include <vector>
@@ -22,7 +23,9 @@ limitations under the License.
 #include "tensorflow/core/framework/numeric_op.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/util/example_proto_fast_parsing.h"
 #include "tensorflow/core/util/sparse/sparse_tensor.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #include "tensorflow/core/platform/logging.h"
 
@@ -336,6 +339,17 @@ class ExampleParserOp : public OpKernel {
       dense_values.allocate(d, out_shape, &out);
     }
 
+    if (FastParse(ctx, serialized_t, dense_keys_t, sparse_keys_t, required,
+                  dense_defaults, &dense_values, &sparse_indices,
+                  &sparse_values, &sparse_shapes)) {
+      return;
+    }
+
+    // The fast path gave up on some example, either because it is invalid
+    // or because it uses an encoding the fast path does not handle.  Parse
+    // the batch again with protobuf, which also reports the error, if any.
+    // The dense outputs are overwritten as we go.
+
     // sparse_values_tmp will be num_sparse_ x batch_size, containing
     // the sparse values from the input layer.  after these are all
     // stored, we can allocate properly sized outputs and copy data over.
@@ -445,6 +459,188 @@ class ExampleParserOp : public OpKernel {
   }
 
  protected:
+  // Parses "serialized" straight from the wire format, sharding the batch
+  // over the CPU worker threads.  Dense values are decoded into the
+  // preallocated "dense_values"; the sparse outputs are allocated once the
+  // sizes are known.  Returns false, before any sparse output has been
+  // allocated, if some example is malformed, fails validation or needs
+  // protobuf's handling; the caller then falls back to protobuf parsing.
+  bool FastParse(OpKernelContext* ctx,
+                 const TTypes<string>::ConstVec& serialized,
+                 const std::vector<string>& dense_keys,
+                 const std::vector<string>& sparse_keys,
+                 const std::vector<bool>& required,
+                 const OpInputList& dense_defaults,
+                 OpOutputList* dense_values, OpOutputList* sparse_indices,
+                 OpOutputList* sparse_values, OpOutputList* sparse_shapes) {
+    std::vector<string> keys(dense_keys);
+    keys.insert(keys.end(), sparse_keys.begin(), sparse_keys.end());
+    const example::FeatureKeyMap key_map(keys);
+    const int64 batch_size = serialized.size();
+
+    std::vector<Tensor*> dense_out(num_dense_);
+    for (int d = 0; d < num_dense_; ++d) dense_out[d] = (*dense_values)[d];
+
+    // Scanning dominates, so the cost of an example is roughly
+    // proportional to its size.
+    int64 total_bytes = 0;
+    for (int64 b = 0; b < batch_size; ++b) total_bytes += serialized(b).size();
+    const int64 cost_per_example = 10 * (total_bytes / (batch_size + 1) + 1);
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+
+    // First pass: parse every example, validate and copy the dense
+    // features, and locate and size the sparse ones.  Entry
+    // b * num_sparse_ + s is sparse feature s of example b.
+    std::vector<example::FeatureView> sparse_features(batch_size *
+                                                      num_sparse_);
+    std::vector<int64> sparse_counts(batch_size * num_sparse_, 0);
+    std::atomic<bool> ok(true);
+    auto parse = [&](int64 start, int64 limit) {
+      std::vector<example::FeatureView> features(key_map.num_slots());
+      for (int64 b = start; b < limit && ok; ++b) {
+        if (!ParseExample(serialized(b), key_map, required, dense_defaults,
+                          b, &features, &dense_out,
+                          &sparse_features[b * num_sparse_],
+                          &sparse_counts[b * num_sparse_])) {
+          ok = false;
+        }
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          cost_per_example, parse);
+    if (!ok) return false;
+
+    // Lay out the sparse outputs.  Entry b * num_sparse_ + s of
+    // sparse_offsets is where example b starts in sparse output s.
+    std::vector<int64> sparse_offsets(batch_size * num_sparse_);
+    std::vector<Tensor*> sp_indices(num_sparse_);
+    std::vector<Tensor*> sp_values(num_sparse_);
+    for (int s = 0; s < num_sparse_; ++s) {
+      int64 total_num_features = 0;
+      int64 max_num_features = 0;
+      for (int64 b = 0; b < batch_size; ++b) {
+        const int64 count = sparse_counts[b * num_sparse_ + s];
+        sparse_offsets[b * num_sparse_ + s] = total_num_features;
+        total_num_features += count;
+        max_num_features = std::max(max_num_features, count);
+      }
+      Tensor* sp_shape = nullptr;
+      sparse_indices->allocate(s, TensorShape({total_num_features, 2}),
+                               &sp_indices[s]);
+      sparse_values->allocate(s, TensorShape({total_num_features}),
+                              &sp_values[s]);
+      sparse_shapes->allocate(s, TensorShape({2}), &sp_shape);
+      auto shape_t = sp_shape->vec<int64>();
+      shape_t(0) = batch_size;
+      shape_t(1) = max_num_features;
+    }
+
+    // Second pass: decode the sparse values into place.  The first pass
+    // counted them, which validated the encoding, so this cannot fail.
+    auto fill_sparse = [&](int64 start, int64 limit) {
+      for (int64 b = start; b < limit; ++b) {
+        for (int s = 0; s < num_sparse_; ++s) {
+          const int64 i = b * num_sparse_ + s;
+          const int64 count = sparse_counts[i];
+          if (count == 0) continue;
+          const int64 offset = sparse_offsets[i];
+          int64* ix_p = &sp_indices[s]->matrix<int64>()(offset, 0);
+          for (int64 n = 0; n < count; ++n, ix_p += 2) {
+            ix_p[0] = b;
+            ix_p[1] = n;
+          }
+          const example::FeatureView& f = sparse_features[i];
+          bool decoded = false;
+          switch (sparse_types_[s]) {
+            case DT_INT64:
+              decoded =
+                  f.DecodeInt64s(sp_values[s]->flat<int64>().data() + offset);
+              break;
+            case DT_FLOAT:
+              decoded =
+                  f.DecodeFloats(sp_values[s]->flat<float>().data() + offset);
+              break;
+            case DT_STRING:
+              decoded =
+                  f.DecodeBytes(sp_values[s]->flat<string>().data() + offset);
+              break;
+            default:
+              break;
+          }
+          CHECK(decoded) << "Sparse feature " << s << " of example " << b
+                         << " failed to decode after a successful count";
+        }
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          cost_per_example, fill_sparse);
+    return true;
+  }
+
+  // Parses example "b" for FastParse, using "features" as scratch space.
+  // Dense features are written to row b of "dense_out".  The sparse
+  // features, and how many values each holds, are stored in
+  // sparse_features[0, num_sparse_) and sparse_counts[0, num_sparse_).
+  // Returns false if the example is malformed or fails validation.
+  bool ParseExample(const string& serialized,
+                    const example::FeatureKeyMap& key_map,
+                    const std::vector<bool>& required,
+                    const OpInputList& dense_defaults, int64 b,
+                    std::vector<example::FeatureView>* features,
+                    std::vector<Tensor*>* dense_out,
+                    example::FeatureView* sparse_features,
+                    int64* sparse_counts) {
+    if (!example::ParseExampleFeatures(serialized, key_map,
+                                       features->data())) {
+      return false;
+    }
+
+    for (int d = 0; d < num_dense_; ++d) {
+      const example::FeatureView& f = (*features)[key_map.SlotOf(d)];
+      const DataType dtype = dense_types_[d];
+      Tensor* out = (*dense_out)[d];
+      if (!f.found) {
+        if (required[d]) return false;
+        RowDenseCopy(b, dtype, dense_defaults[d], out);
+        continue;
+      }
+      const int64 num_elements = dense_shapes_[d].num_elements();
+      int64 num_values;
+      if (f.dtype() != dtype || !f.CountValues(&num_values) ||
+          num_values != num_elements) {
+        return false;
+      }
+      const int64 offset = b * num_elements;
+      switch (dtype) {
+        case DT_INT64:
+          f.DecodeInt64s(out->flat<int64>().data() + offset);
+          break;
+        case DT_FLOAT:
+          f.DecodeFloats(out->flat<float>().data() + offset);
+          break;
+        case DT_STRING:
+          f.DecodeBytes(out->flat<string>().data() + offset);
+          break;
+        default:
+          return false;
+      }
+    }
+
+    for (int s = 0; s < num_sparse_; ++s) {
+      const example::FeatureView& f =
+          (*features)[key_map.SlotOf(num_dense_ + s)];
+      sparse_counts[s] = 0;
+      // Like a missing key, an empty Feature gives an empty row.
+      if (f.kind == example::FeatureView::kNone) continue;
+      if (f.dtype() != sparse_types_[s] ||
+          !f.CountValues(&sparse_counts[s])) {
+        return false;
+      }
+      sparse_features[s] = f;
+    }
+    return true;
+  }
+
   int64 num_sparse_;
   int64 num_dense_;
   std::vector<DataType> sparse_types_;
@@ -49,7 +49,7 @@ class FixedLengthRecordReader : public ReaderBase {
     file_pos_limit_ = file_size - footer_bytes_;
 
     RandomAccessFile* file = nullptr;
-    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(current_work(), &file));
+    TF_RETURN_IF_ERROR(NewRandomAccessFile(env_, current_work(), &file));
     input_buffer_.reset(new io::InputBuffer(file, kBufferSize));
     TF_RETURN_IF_ERROR(input_buffer_->SkipNBytes(header_bytes_));
     return Status::OK();
@@ -110,10 +110,17 @@ class FixedLengthRecordReaderOp : public ReaderOpKernel {
     OP_REQUIRES(context, footer_bytes >= 0,
                 errors::InvalidArgument("footer_bytes must be >= 0 not ",
                                         footer_bytes));
+    int readahead_buffers;
+    int64 readahead_buffer_bytes;
+    OP_REQUIRES_OK(context, GetReadaheadAttrs(context, &readahead_buffers,
+                                              &readahead_buffer_bytes));
     Env* env = context->env();
-    SetReaderFactory([this, header_bytes, record_bytes, footer_bytes, env]() {
-      return new FixedLengthRecordReader(name(), header_bytes, record_bytes,
-                                         footer_bytes, env);
+    SetReaderFactory([this, header_bytes, record_bytes, footer_bytes, env,
+                      readahead_buffers, readahead_buffer_bytes]() {
+      FixedLengthRecordReader* reader = new FixedLengthRecordReader(
+          name(), header_bytes, record_bytes, footer_bytes, env);
+      reader->SetReadahead(readahead_buffers, readahead_buffer_bytes);
+      return reader;
     });
   }
 };
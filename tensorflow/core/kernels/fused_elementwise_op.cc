@@ -0,0 +1,467 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/util/bcast.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+enum class FusedOp {
+  kNeg,
+  kSquare,
+  kSqrt,
+  kRsqrt,
+  kExp,
+  kLog,
+  kTanh,
+  kSigmoid,
+  kRelu,
+  kRelu6,
+  kAdd,
+  kSub,
+  kMul,
+  kDiv,
+  kMaximum,
+  kMinimum,
+  kBiasAdd,
+};
+
+struct FusedOpInfo {
+  const char* name;
+  FusedOp op;
+  bool binary;
+};
+
+const FusedOpInfo kFusedOps[] = {
+    {"Neg", FusedOp::kNeg, false},
+    {"Square", FusedOp::kSquare, false},
+    {"Sqrt", FusedOp::kSqrt, false},
+    {"Rsqrt", FusedOp::kRsqrt, false},
+    {"Exp", FusedOp::kExp, false},
+    {"Log", FusedOp::kLog, false},
+    {"Tanh", FusedOp::kTanh, false},
+    {"Sigmoid", FusedOp::kSigmoid, false},
+    {"Relu", FusedOp::kRelu, false},
+    {"Relu6", FusedOp::kRelu6, false},
+    {"Add", FusedOp::kAdd, true},
+    {"Sub", FusedOp::kSub, true},
+    {"Mul", FusedOp::kMul, true},
+    {"Div", FusedOp::kDiv, true},
+    {"Maximum", FusedOp::kMaximum, true},
+    {"Minimum", FusedOp::kMinimum, true},
+    {"BiasAdd", FusedOp::kBiasAdd, true},
+};
+
+// One op of the chain.
+struct Step {
+  FusedOp op;
+  bool binary;
+  // Whether the result of the previous steps is the second operand of a
+  // binary op, rather than the first.
+  bool chain_is_y;
+  // The index in "args" of the other operand of a binary op.
+  int arg;
+};
+
+// How the other operand of a binary step is read for the elements of the
+// chain value, when the step keeps the shape of the chain value.
+enum class ArgLayout {
+  kSame,    // Elementwise.
+  kScalar,  // One value for all elements.
+  kRow,     // A vector along the last dimension.
+};
+
+template <typename T>
+struct StepArg {
+  const T* data;
+  ArgLayout layout;
+  int64 size;
+};
+
+// Number of elements each step is applied to at once, small enough for the
+// block and a block of each operand to stay in L1.
+const int64 kBlockSize = 2048;
+
+template <typename T>
+using Array = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+template <typename T>
+using ConstArray = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+
+template <typename T>
+void ApplyUnary(FusedOp op, Array<T> v) {
+  switch (op) {
+    case FusedOp::kNeg:
+      v = -v;
+      break;
+    case FusedOp::kSquare:
+      v = v.square();
+      break;
+    case FusedOp::kSqrt:
+      v = v.sqrt();
+      break;
+    case FusedOp::kRsqrt:
+      v = v.sqrt().inverse();
+      break;
+    case FusedOp::kExp:
+      v = v.exp();
+      break;
+    case FusedOp::kLog:
+      v = v.log();
+      break;
+    case FusedOp::kTanh:
+      v = v.tanh();
+      break;
+    case FusedOp::kSigmoid:
+      v = (T(1) + (-v).exp()).inverse();
+      break;
+    case FusedOp::kRelu:
+      v = v.max(T(0));
+      break;
+    case FusedOp::kRelu6:
+      v = v.max(T(0)).min(T(6));
+      break;
+    default:
+      LOG(FATAL) << "Not a unary op";
+  }
+}
+
+// Sets "v" to "op" of "v" and "y", or of "y" and "v" if "chain_is_y".
+template <typename T, typename Y>
+void ApplyBinary(FusedOp op, bool chain_is_y, Array<T> v, const Y& y) {
+  switch (op) {
+    case FusedOp::kAdd:
+    case FusedOp::kBiasAdd:
+      v += y;
+      break;
+    case FusedOp::kSub:
+      if (chain_is_y) {
+        v = y - v;
+      } else {
+        v -= y;
+      }
+      break;
+    case FusedOp::kMul:
+      v *= y;
+      break;
+    case FusedOp::kDiv:
+      if (chain_is_y) {
+        v = y / v;
+      } else {
+        v /= y;
+      }
+      break;
+    case FusedOp::kMaximum:
+      v = v.max(y);
+      break;
+    case FusedOp::kMinimum:
+      v = v.min(y);
+      break;
+    default:
+      LOG(FATAL) << "Not a binary op";
+  }
+}
+
+template <typename T>
+T ApplyBinaryScalar(FusedOp op, T x, T y) {
+  switch (op) {
+    case FusedOp::kAdd:
+    case FusedOp::kBiasAdd:
+      return x + y;
+    case FusedOp::kSub:
+      return x - y;
+    case FusedOp::kMul:
+      return x * y;
+    case FusedOp::kDiv:
+      return x / y;
+    case FusedOp::kMaximum:
+      return std::max(x, y);
+    case FusedOp::kMinimum:
+      return std::min(x, y);
+    default:
+      LOG(FATAL) << "Not a binary op";
+      return T();
+  }
+}
+
+// Applies "steps" to elements [start, limit) of "in", writing them to "out".
+template <typename T>
+void ApplySteps(const std::vector<Step>& steps,
+                const std::vector<StepArg<T>>& args, const T* in, T* out,
+                int64 start, int64 limit) {
+  const int64 n = limit - start;
+  std::copy(in + start, in + limit, out + start);
+  Array<T> v(out + start, n);
+  for (int s = 0; s < steps.size(); ++s) {
+    const Step& step = steps[s];
+    if (!step.binary) {
+      ApplyUnary<T>(step.op, v);
+      continue;
+    }
+    const StepArg<T>& arg = args[s];
+    switch (arg.layout) {
+      case ArgLayout::kSame:
+        ApplyBinary<T>(step.op, step.chain_is_y, v,
+                       ConstArray<T>(arg.data + start, n));
+        break;
+      case ArgLayout::kScalar:
+        ApplyBinary<T>(step.op, step.chain_is_y, v,
+                       Eigen::Array<T, Eigen::Dynamic, 1>::Constant(
+                           n, arg.data[0]));
+        break;
+      case ArgLayout::kRow:
+        // The block is split where rows end.
+        for (int64 i = 0; i < n;) {
+          const int64 column = (start + i) % arg.size;
+          const int64 len = std::min(n - i, arg.size - column);
+          ApplyBinary<T>(step.op, step.chain_is_y,
+                         Array<T>(out + start + i, len),
+                         ConstArray<T>(arg.data + column, len));
+          i += len;
+        }
+        break;
+    }
+  }
+}
+
+// Sets "*indices" to the index of the element of an operand reshaped to
+// "reshape" that each element of the broadcast "result" reads.
+void BroadcastIndices(const BCast::Vec& reshape, const BCast::Vec& result,
+                      std::vector<int64>* indices) {
+  int64 size = 1;
+  for (int64 d : result) size *= d;
+  indices->resize(size);
+  const int rank = result.size();
+  gtl::InlinedVector<int64, 4> strides(rank, 0);
+  int64 stride = 1;
+  for (int d = rank - 1; d >= 0; --d) {
+    strides[d] = reshape[d] == 1 ? 0 : stride;
+    stride *= reshape[d];
+  }
+  gtl::InlinedVector<int64, 4> coords(rank, 0);
+  int64 index = 0;
+  for (int64 i = 0; i < size; ++i) {
+    (*indices)[i] = index;
+    for (int d = rank - 1; d >= 0; --d) {
+      index += strides[d];
+      if (++coords[d] < result[d]) break;
+      index -= strides[d] * coords[d];
+      coords[d] = 0;
+    }
+  }
+}
+
+BCast::Vec Dims(const TensorShape& shape) {
+  BCast::Vec dims;
+  for (int d = 0; d < shape.dims(); ++d) dims.push_back(shape.dim_size(d));
+  return dims;
+}
+
+template <typename T>
+class FusedElementwiseOp : public OpKernel {
+ public:
+  explicit FusedElementwiseOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    std::vector<string> ops;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("ops", &ops));
+    std::vector<int32> chain_inputs;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("chain_inputs", &chain_inputs));
+    int num_args;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &num_args));
+    OP_REQUIRES(ctx, !ops.empty(), errors::InvalidArgument("No ops to fuse"));
+    OP_REQUIRES(ctx, ops.size() == chain_inputs.size(),
+                errors::InvalidArgument("Got ", ops.size(), " ops and ",
+                                        chain_inputs.size(), " chain_inputs"));
+    int arg = 0;
+    for (int i = 0; i < ops.size(); ++i) {
+      const FusedOpInfo* info = nullptr;
+      for (const FusedOpInfo& candidate : kFusedOps) {
+        if (ops[i] == candidate.name) info = &candidate;
+      }
+      OP_REQUIRES(ctx, info != nullptr,
+                  errors::InvalidArgument("Cannot fuse op ", ops[i]));
+      OP_REQUIRES(
+          ctx, chain_inputs[i] == 0 ||
+                   (chain_inputs[i] == 1 && info->binary &&
+                    info->op != FusedOp::kBiasAdd),
+          errors::InvalidArgument("Invalid chain input ", chain_inputs[i],
+                                  " for ", ops[i]));
+      steps_.push_back({info->op, info->binary, chain_inputs[i] == 1,
+                        info->binary ? arg : -1});
+      if (info->binary) ++arg;
+    }
+    OP_REQUIRES(ctx, arg == num_args,
+                errors::InvalidArgument("The ops take ", arg, " args, not ",
+                                        num_args));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    OpInputList args;
+    OP_REQUIRES_OK(ctx, ctx->input_list("args", &args));
+    Tensor value = ctx->input(0);
+    // The steps that keep the shape of the chain value are run together,
+    // block by block. A step broadcasting the value to a larger shape is run
+    // on its own.
+    int begin = 0;
+    while (begin < steps_.size()) {
+      std::vector<StepArg<T>> step_args;
+      int end = begin;
+      for (; end < steps_.size(); ++end) {
+        const Step& step = steps_[end];
+        StepArg<T> step_arg = {nullptr, ArgLayout::kSame, 0};
+        if (step.binary) {
+          const Tensor& arg = args[step.arg];
+          if (step.op == FusedOp::kBiasAdd) {
+            OP_REQUIRES(ctx, TensorShapeUtils::IsMatrixOrHigher(value.shape()),
+                        errors::InvalidArgument(
+                            "Input tensor must be at least 2D: ",
+                            value.shape().DebugString()));
+            OP_REQUIRES(
+                ctx, TensorShapeUtils::IsVector(arg.shape()) &&
+                         arg.dim_size(0) ==
+                             value.dim_size(value.dims() - 1),
+                errors::InvalidArgument(
+                    "Must provide as many biases as the last dimension of "
+                    "the input tensor: ",
+                    arg.shape().DebugString(), " vs. ",
+                    value.shape().DebugString()));
+          }
+          if (!GetArgLayout(value.shape(), arg, &step_arg.layout)) break;
+          step_arg.data = arg.flat<T>().data();
+          step_arg.size = arg.NumElements();
+        }
+        step_args.push_back(step_arg);
+      }
+      Tensor result;
+      if (end > begin) {
+        OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                               value.shape(), &result));
+        RunSteps(ctx, begin, end, step_args, value, &result);
+        begin = end;
+      } else {
+        RunBroadcastStep(ctx, steps_[begin], value, args[steps_[begin].arg],
+                         &result);
+        if (!ctx->status().ok()) return;
+        ++begin;
+      }
+      value = result;
+    }
+    ctx->set_output(0, value);
+  }
+
+ private:
+  // Returns whether a binary step with operand "arg" keeps "shape", and how
+  // it reads "arg" if so.
+  static bool GetArgLayout(const TensorShape& shape, const Tensor& arg,
+                           ArgLayout* layout) {
+    if (arg.shape() == shape) {
+      *layout = ArgLayout::kSame;
+      return true;
+    }
+    if (arg.NumElements() == 1 && arg.dims() <= shape.dims()) {
+      *layout = ArgLayout::kScalar;
+      return true;
+    }
+    if (arg.dims() == 1 && shape.dims() >= 1 &&
+        arg.dim_size(0) == shape.dim_size(shape.dims() - 1)) {
+      *layout = ArgLayout::kRow;
+      return true;
+    }
+    return false;
+  }
+
+  // Applies steps [begin, end) to "in", which they keep the shape of,
+  // writing "*out".
+  void RunSteps(OpKernelContext* ctx, int begin, int end,
+                const std::vector<StepArg<T>>& step_args, const Tensor& in,
+                Tensor* out) {
+    const std::vector<Step> steps(steps_.begin() + begin,
+                                  steps_.begin() + end);
+    const T* in_data = in.flat<T>().data();
+    T* out_data = out->flat<T>().data();
+    const int64 size = in.NumElements();
+    const int64 num_blocks = (size + kBlockSize - 1) / kBlockSize;
+    auto work = [&steps, &step_args, in_data, out_data, size](int64 start,
+                                                             int64 limit) {
+      for (int64 b = start; b < limit; ++b) {
+        ApplySteps<T>(steps, step_args, in_data, out_data, b * kBlockSize,
+                      std::min(size, (b + 1) * kBlockSize));
+      }
+    };
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+          kBlockSize * steps.size() * 10, work);
+  }
+
+  // Applies the binary "step" to "value" and "arg", of shapes that broadcast
+  // to a larger one, writing "*out".
+  void RunBroadcastStep(OpKernelContext* ctx, const Step& step,
+                        const Tensor& value, const Tensor& arg, Tensor* out) {
+    const Tensor& x = step.chain_is_y ? arg : value;
+    const Tensor& y = step.chain_is_y ? value : arg;
+    BCast bcast(Dims(x.shape()), Dims(y.shape()));
+    OP_REQUIRES(ctx, bcast.IsValid(),
+                errors::InvalidArgument("Incompatible shapes: ",
+                                        x.shape().DebugString(), " vs. ",
+                                        y.shape().DebugString()));
+    TensorShape out_shape;
+    for (int64 d : bcast.output_shape()) out_shape.AddDim(d);
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                           out_shape, out));
+    std::vector<int64> x_indices;
+    BroadcastIndices(bcast.x_reshape(), bcast.result_shape(), &x_indices);
+    std::vector<int64> y_indices;
+    BroadcastIndices(bcast.y_reshape(), bcast.result_shape(), &y_indices);
+    auto x_flat = x.flat<T>();
+    auto y_flat = y.flat<T>();
+    auto out_flat = out->flat<T>();
+    for (int64 i = 0; i < out_flat.size(); ++i) {
+      out_flat(i) = ApplyBinaryScalar<T>(step.op, x_flat(x_indices[i]),
+                                         y_flat(y_indices[i]));
+    }
+  }
+
+  std::vector<Step> steps_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FusedElementwiseOp);
+};
+
+}  // namespace
+
+#define REGISTER_CPU(T)                                                    \
+  REGISTER_KERNEL_BUILDER(                                                 \
+      Name("_FusedElementwise").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedElementwiseOp<T>)
+
+REGISTER_CPU(float);
+REGISTER_CPU(double);
+
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
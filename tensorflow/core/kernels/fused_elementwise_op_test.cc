@@ -0,0 +1,153 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+
+class FusedElementwiseOpTest : public OpsTestBase {
+ protected:
+  Status MakeOp(const std::vector<string>& ops,
+                const std::vector<int>& chain_inputs, int num_args) {
+    TF_CHECK_OK(NodeDefBuilder("fused", "_FusedElementwise")
+                    .Input(FakeInput(DT_FLOAT))
+                    .Input(FakeInput(num_args, DT_FLOAT))
+                    .Attr("ops", ops)
+                    .Attr("chain_inputs", chain_inputs)
+                    .Finalize(node_def()));
+    return InitOp();
+  }
+};
+
+TEST_F(FusedElementwiseOpTest, UnaryAndBinaryChain) {
+  // Sigmoid(Relu(x * y) + z)
+  TF_ASSERT_OK(MakeOp({"Mul", "Relu", "Add", "Sigmoid"}, {0, 0, 0, 0}, 2));
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, -2, 3, -4});
+  AddInputFromArray<float>(TensorShape({2, 2}), {2, 2, 2, 2});
+  AddInputFromArray<float>(TensorShape({2, 2}), {0, 1, -6, 0});
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 2}));
+  auto sigmoid = [](float v) { return 1 / (1 + std::exp(-v)); };
+  test::FillValues<float>(&expected,
+                          {sigmoid(2), sigmoid(1), sigmoid(0), sigmoid(0)});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-6);
+}
+
+TEST_F(FusedElementwiseOpTest, ChainIsSecondOperand) {
+  // 10 - Square(x), then 1 / that.
+  TF_ASSERT_OK(MakeOp({"Square", "Sub", "Div"}, {0, 1, 1}, 2));
+  AddInputFromArray<float>(TensorShape({3}), {1, 2, 3});
+  AddInputFromArray<float>(TensorShape({}), {10});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({3}));
+  test::FillValues<float>(&expected, {1.0f / 9, 1.0f / 6, 1.0f});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-6);
+}
+
+TEST_F(FusedElementwiseOpTest, BiasAddAndRows) {
+  TF_ASSERT_OK(MakeOp({"BiasAdd", "Relu6", "Mul"}, {0, 0, 0}, 2));
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<float>(TensorShape({3}), {-2, 0, 2});
+  AddInputFromArray<float>(TensorShape({3}), {1, 10, 100});
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&expected, {0, 20, 500, 2, 50, 600});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, BroadcastsChainValue) {
+  // The second operand of Add makes the value larger; the Neg after it runs
+  // on the broadcast shape.
+  TF_ASSERT_OK(MakeOp({"Exp", "Add", "Neg"}, {0, 0, 0}, 1));
+  AddInputFromArray<float>(TensorShape({2, 1}), {0, 0});
+  AddInputFromArray<float>(TensorShape({3}), {1, 2, 3});
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&expected, {-2, -3, -4, -2, -3, -4});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, LargeInput) {
+  // Larger than one block, and not a multiple of the block size.
+  const int size = 10000;
+  TF_ASSERT_OK(MakeOp({"Neg", "Maximum"}, {0, 0}, 1));
+  std::vector<float> x(size);
+  for (int i = 0; i < size; ++i) x[i] = i - size / 2;
+  AddInputFromArray<float>(TensorShape({size}), x);
+  AddInputFromArray<float>(TensorShape({}), {0});
+  TF_ASSERT_OK(RunOpKernel());
+  auto out = GetOutput(0)->flat<float>();
+  for (int i = 0; i < size; ++i) {
+    EXPECT_EQ(std::max(0.0f, -x[i]), out(i)) << i;
+  }
+}
+
+TEST_F(FusedElementwiseOpTest, IncompatibleShapes) {
+  TF_ASSERT_OK(MakeOp({"Neg", "Add"}, {0, 0}, 1));
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<float>(TensorShape({2}), {1, 2});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(StringPiece(s.ToString()).contains("Incompatible shapes"))
+      << s;
+}
+
+TEST_F(FusedElementwiseOpTest, InvalidAttrs) {
+  EXPECT_FALSE(MakeOp({"Neg", "MatMul"}, {0, 0}, 1).ok());
+  EXPECT_FALSE(MakeOp({"Neg", "Add"}, {0, 0}, 2).ok());
+  EXPECT_FALSE(MakeOp({"Neg", "BiasAdd"}, {0, 1}, 1).ok());
+  EXPECT_FALSE(MakeOp({"Neg", "Tanh"}, {0, 1}, 0).ok());
+}
+
+// Sigmoid(Tanh(x * y) + z) on a [batch, 1024] value.
+static Graph* FusedChain(int batch) {
+  Graph* g = new Graph(OpRegistry::Global());
+  std::vector<NodeBuilder::NodeOut> args;
+  Tensor x(DT_FLOAT, TensorShape({batch, 1024}));
+  x.flat<float>().setRandom();
+  for (int i = 0; i < 2; ++i) {
+    Tensor arg(DT_FLOAT, TensorShape({batch, 1024}));
+    arg.flat<float>().setRandom();
+    args.emplace_back(test::graph::Constant(g, arg));
+  }
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "_FusedElementwise")
+                  .Input(test::graph::Constant(g, x))
+                  .Input(args)
+                  .Attr("ops", {"Mul", "Tanh", "Add", "Sigmoid"})
+                  .Attr("chain_inputs", {0, 0, 0, 0})
+                  .Finalize(g, nullptr));
+  return g;
+}
+
+static void BM_FusedChain(int iters, int batch) {
+  testing::ItemsProcessed(static_cast<int64>(iters) * batch * 1024);
+  test::Benchmark("cpu", FusedChain(batch)).Run(iters);
+}
+BENCHMARK(BM_FusedChain)->Arg(32)->Arg(128);
+
+}  // namespace tensorflow
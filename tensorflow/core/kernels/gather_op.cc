@@ -16,20 +16,41 @@ limitations under the License.
 // See docs in ../ops/array_ops.cc.
 
 #include "tensorflow/core/kernels/gather_op.h"
+
+#include <algorithm>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
+namespace functor {
+
+// Runs the Gather functor of "Device". Specialized below for the CPU, which
+// also needs the worker threads of the OpKernelContext.
+template <typename Device, typename T, typename Index>
+struct GatherFunctor {
+  Index operator()(OpKernelContext* c, typename TTypes<T>::ConstMatrix params,
+                   typename TTypes<Index>::ConstFlat indices,
+                   typename TTypes<T>::Matrix out) {
+    functor::Gather<Device, T, Index> functor;
+    return functor(c->eigen_device<Device>(), params, indices, out);
+  }
+};
+
+}  // namespace functor
+
 template <typename Device, typename T, typename Index>
 class GatherOp : public OpKernel {
  public:
@@ -82,9 +103,8 @@ class GatherOp : public OpKernel {
       auto indices_flat = indices.flat<Index>();
       auto out_flat = out->shaped<T, 2>({N, out->NumElements() / N});
 
-      functor::Gather<Device, T, Index> functor;
-      Index bad_i = functor(c->eigen_device<Device>(), params_flat,
-                            indices_flat, out_flat);
+      functor::GatherFunctor<Device, T, Index> functor;
+      Index bad_i = functor(c, params_flat, indices_flat, out_flat);
 
       OP_REQUIRES(
           c, bad_i < 0,
@@ -97,13 +117,13 @@ class GatherOp : public OpKernel {
 
 namespace functor {
 
-// Helper method to copy using memcpy.
+// Helper method to copy rows [start, limit) of the output using memcpy.
+// Returns the first i in that range whose index is out of range, or -1.
 template <typename T, typename Index, int static_slice_elems>
 Index HandleCopies(typename TTypes<T>::ConstMatrix params,
                    typename TTypes<Index>::ConstFlat indices, Index slice_elems,
-                   typename TTypes<T>::Matrix out) {
-  const int first_dim_size = indices.dimension(0);
-  const Index limit = params.dimension(0);
+                   typename TTypes<T>::Matrix out, int start, int limit) {
+  const Index params_rows = params.dimension(0);
   T* out_base = &out(0, 0);
   const T* params_base = &params(0, 0);
   if (static_slice_elems >= 0) {
@@ -113,17 +133,33 @@ Index HandleCopies(typename TTypes<T>::ConstMatrix params,
   }
   // Compute slice_bytes here so that static knowledge is available
   const size_t slice_bytes = slice_elems * sizeof(T);
-  for (int i = 0; i < first_dim_size; i++) {
-    const int j = i + 1;
-    if (j < first_dim_size) {
-      port::prefetch<port::PREFETCH_HINT_T0>(&params(indices(j), 0));
-      port::prefetch<port::PREFETCH_HINT_T0>(&out(j, 0));
+  // The rows of a large table are mostly cache misses, so prefetch about
+  // kPrefetchBytes ahead: many small rows, or a few lines of a large one.
+  // The output is written sequentially, which the hardware handles.
+  static const int kPrefetchBytes = 1024;
+  static const int kCacheLineBytes = 64;
+  const int distance = std::max<int>(
+      1, std::min<int>(16, kPrefetchBytes / std::max<size_t>(1, slice_bytes)));
+  const int lines_per_row = std::min<int>(
+      4, (slice_bytes + kCacheLineBytes - 1) / kCacheLineBytes);
+  for (int i = start; i < limit; i++) {
+    const int j = i + distance;
+    if (j < limit) {
+      // The index is checked below, before it is used to read params.
+      const Index next = indices(j);
+      if (FastBoundsCheck(next, params_rows)) {
+        const char* row =
+            reinterpret_cast<const char*>(params_base + next * slice_elems);
+        for (int line = 0; line < lines_per_row; ++line) {
+          port::prefetch<port::PREFETCH_HINT_T0>(row + line * kCacheLineBytes);
+        }
+      }
     }
     // Grab the index and check its validity.  An earlier version of the
     // code checked it and then grabbed it from memory a second time, which
     // was a security risk since it could have changed in between.
     const Index index = internal::SubtleMustCopy(indices(i));
-    if (!FastBoundsCheck(index, limit)) return i;
+    if (!FastBoundsCheck(index, params_rows)) return i;
     // Copy using memcpy if possible, otherwise an Eigen loop
     if (Allocator::is_simple<T>::value) {
       memcpy(out_base + i * slice_elems, params_base + index * slice_elems,
@@ -135,27 +171,73 @@ Index HandleCopies(typename TTypes<T>::ConstMatrix params,
   return -1;
 }
 
+// Copies rows [start, limit) of the output, dispatching to a HandleCopies
+// specialized for the common slice sizes.
+template <typename T, typename Index>
+Index HandleCopiesRange(typename TTypes<T>::ConstMatrix params,
+                        typename TTypes<Index>::ConstFlat indices,
+                        typename TTypes<T>::Matrix out, int start, int limit) {
+  const int64 slice_size = out.dimension(1);
+#define CALL(elems)                                                       \
+  return HandleCopies<T, Index, elems>(params, indices, slice_size, out, \
+                                       start, limit)
+
+  switch (slice_size) {
+    case 10:
+      CALL(10);
+    case 16:
+      CALL(16);
+    case 20:
+      CALL(20);
+    case 32:
+      CALL(32);
+    case 64:
+      CALL(64);
+    case 128:
+      CALL(128);
+    default:
+      CALL(-1);
+  }
+#undef CALL
+}
+
 // Specialization gather functor for CPU.
 template <typename T, typename Index>
 struct Gather<CPUDevice, T, Index> {
   Index operator()(const CPUDevice& d, typename TTypes<T>::ConstMatrix params,
                    typename TTypes<Index>::ConstFlat indices,
                    typename TTypes<T>::Matrix out) {
-    const int N = indices.size();
-    const int64 slice_size = out.size() / N;
-    Index bad_i;
-
-#define CALL(elems) \
-  bad_i = HandleCopies<T, Index, elems>(params, indices, slice_size, out)
-
-    if (slice_size == 10)
-      CALL(10);
-    else if (slice_size == 20)
-      CALL(20);
-    else
-      CALL(-1);
-#undef CALL
+    return HandleCopiesRange<T, Index>(params, indices, out, 0,
+                                       indices.size());
+  }
+};
 
+// On the CPU, the output rows are sharded over the worker threads.
+template <typename T, typename Index>
+struct GatherFunctor<CPUDevice, T, Index> {
+  Index operator()(OpKernelContext* c, typename TTypes<T>::ConstMatrix params,
+                   typename TTypes<Index>::ConstFlat indices,
+                   typename TTypes<T>::Matrix out) {
+    const int N = indices.size();
+    const int64 slice_bytes = out.dimension(1) * sizeof(T);
+    // Each row costs a likely cache miss on params, plus the copy.
+    const int64 cost_per_unit = 100 + slice_bytes / 4;
+
+    // Each shard stops at its first bad index; report the first overall.
+    mutex mu;
+    Index bad_i = -1;
+    auto work = [&params, &indices, &out, &mu, &bad_i](int64 start,
+                                                       int64 limit) {
+      const Index shard_bad_i =
+          HandleCopiesRange<T, Index>(params, indices, out, start, limit);
+      if (shard_bad_i >= 0) {
+        mutex_lock l(mu);
+        if (bad_i < 0 || shard_bad_i < bad_i) bad_i = shard_bad_i;
+      }
+    };
+    auto worker_threads = c->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, N,
+          cost_per_unit, work);
     return bad_i;
   }
 };
@@ -175,6 +257,9 @@ struct Gather<CPUDevice, T, Index> {
 #define REGISTER_GATHER_CPU(type) REGISTER_GATHER_ALL_INDICES(CPU, type)
 
 TF_CALL_ALL_TYPES(REGISTER_GATHER_CPU);
+// The 16-bit float types are only stored: gathering them copies bytes.
+TF_CALL_half(REGISTER_GATHER_CPU);
+REGISTER_GATHER_CPU(bfloat16);
 
 #undef REGISTER_GATHER_CPU
 
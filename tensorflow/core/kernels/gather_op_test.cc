@@ -40,13 +40,37 @@ namespace {
 
 class GatherOpTest : public OpsTestBase {
  protected:
-  void MakeOp(DataType index_type) {
+  void MakeOp(DataType index_type, DataType params_type = DT_FLOAT) {
     TF_ASSERT_OK(NodeDefBuilder("myop", "Gather")
-                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(params_type))
                      .Input(FakeInput(index_type))
                      .Finalize(node_def()));
     TF_ASSERT_OK(InitOp());
   }
+
+  // Gathers enough rows of size "dim" to be split over threads, and checks
+  // the result.
+  void RunManyIndices(int dim) {
+    const int kRows = 1000;
+    const int kIndices = 20000;
+    std::vector<float> params(kRows * dim);
+    for (int i = 0; i < params.size(); ++i) params[i] = i;
+    std::vector<int64> indices(kIndices);
+    for (int i = 0; i < kIndices; ++i) indices[i] = (i * 7919) % kRows;
+    std::vector<float> expected;
+    for (int64 index : indices) {
+      for (int j = 0; j < dim; ++j) expected.push_back(index * dim + j);
+    }
+
+    MakeOp(DT_INT64);
+    AddInputFromArray<float>(TensorShape({kRows, dim}), params);
+    AddInputFromArray<int64>(TensorShape({kIndices}), indices);
+    TF_ASSERT_OK(RunOpKernel());
+    Tensor expected_tensor(allocator(), DT_FLOAT,
+                           TensorShape({kIndices, dim}));
+    test::FillValues<float>(&expected_tensor, expected);
+    test::ExpectTensorEqual<float>(expected_tensor, *GetOutput(0));
+  }
 };
 
 TEST_F(GatherOpTest, ScalarIndices) {
@@ -93,6 +117,50 @@ TEST_F(GatherOpTest, Simple_TwoD64) {
   test::ExpectTensorEqual<float>(expected, *GetOutput(0));
 }
 
+// The 16-bit float types are gathered as bytes, without conversions.
+TEST_F(GatherOpTest, Simple_TwoD_Half) {
+  MakeOp(DT_INT32, DT_HALF);
+
+  // Feed and run
+  std::vector<Eigen::half> params;
+  for (int i = 0; i < 15; ++i) params.push_back(Eigen::half(i + 0.5f));
+  AddInputFromArray<Eigen::half>(TensorShape({5, 3}), params);
+  AddInputFromArray<int32>(TensorShape({4}), {0, 4, 0, 2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Check the output.
+  const std::vector<int> expected = {0, 1, 2, 12, 13, 14, 0, 1, 2, 6, 7, 8};
+  auto out = GetOutput(0)->flat<Eigen::half>();
+  ASSERT_EQ(expected.size(), out.size());
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i] + 0.5f, static_cast<float>(out(i)));
+  }
+}
+
+TEST_F(GatherOpTest, Simple_TwoD_BFloat16) {
+  MakeOp(DT_INT64, DT_BFLOAT16);
+
+  // Feed and run
+  std::vector<bfloat16> params(15);
+  for (int i = 0; i < 15; ++i) {
+    const float value = i + 0.5f;
+    FloatToBFloat16(&value, &params[i], 1);
+  }
+  AddInputFromArray<bfloat16>(TensorShape({5, 3}), params);
+  AddInputFromArray<int64>(TensorShape({4}), {0, 4, 0, 2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Check the output.
+  const std::vector<int> expected = {0, 1, 2, 12, 13, 14, 0, 1, 2, 6, 7, 8};
+  auto out = GetOutput(0)->flat<bfloat16>();
+  ASSERT_EQ(expected.size(), out.size());
+  for (int i = 0; i < expected.size(); ++i) {
+    float value;
+    BFloat16ToFloat(&out(i), &value, 1);
+    EXPECT_EQ(expected[i] + 0.5f, value);
+  }
+}
+
 TEST_F(GatherOpTest, HighRank) {
   MakeOp(DT_INT32);
 
@@ -120,6 +188,27 @@ TEST_F(GatherOpTest, Error_IndexOutOfRange) {
       << s;
 }
 
+// Slice sizes with a specialized copy, and one without.
+TEST_F(GatherOpTest, ManyIndices_Slice16) { RunManyIndices(16); }
+TEST_F(GatherOpTest, ManyIndices_Slice128) { RunManyIndices(128); }
+TEST_F(GatherOpTest, ManyIndices_Slice100) { RunManyIndices(100); }
+
+TEST_F(GatherOpTest, Error_FirstIndexOutOfRangeIsReported) {
+  MakeOp(DT_INT32);
+  // Enough indices to be sharded, with bad ones far apart.
+  const int kIndices = 100000;
+  std::vector<int32> indices(kIndices, 1);
+  indices[kIndices / 3] = 7;
+  indices[kIndices - 1] = -1;
+  AddInputFromArray<float>(TensorShape({5, 3}),
+                           {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14});
+  AddInputFromArray<int32>(TensorShape({kIndices}), indices);
+  Status s = RunOpKernel();
+  EXPECT_TRUE(StringPiece(s.ToString())
+                  .contains("indices[33333] = 7 is not in [0, 5)"))
+      << s;
+}
+
 constexpr int kLookups = 2000;
 
 template <typename Index>
@@ -168,5 +257,56 @@ BM_GATHER(gpu, int32);
 BM_GATHER(cpu, int64);
 BM_GATHER(gpu, int64);
 
+// Looks up "batch" random rows of a "rows" x "dim" embedding table of T.
+template <typename T = float>
+static Graph* GatherEmbedding(int rows, int batch, int dim) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor params(DataTypeToEnum<T>::value, TensorShape({rows, dim}));
+  params.flat<T>().setRandom();
+
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  Tensor indices(DT_INT64, TensorShape({batch}));
+  for (int i = 0; i < batch; i++) {
+    indices.flat<int64>()(i) = rnd.Uniform(rows);
+  }
+
+  test::graph::Gather(g, test::graph::Constant(g, params),
+                      test::graph::Constant(g, indices));
+  return g;
+}
+
+#define BM_GATHER_EMBEDDING(ROWS, BATCH, DIM)                               \
+  static void BM_cpu_gather_embedding_##ROWS##_##BATCH##_##DIM(int iters) { \
+    const int64 tot = static_cast<int64>(iters) * BATCH * DIM;            \
+    testing::ItemsProcessed(tot);                                          \
+    testing::BytesProcessed(tot * sizeof(float));                          \
+    testing::UseRealTime();                                                \
+    test::Benchmark("cpu", GatherEmbedding(ROWS, BATCH, DIM)).Run(iters);  \
+  }                                                                        \
+  BENCHMARK(BM_cpu_gather_embedding_##ROWS##_##BATCH##_##DIM)
+
+#define BM_GATHER_EMBEDDING_DIMS(ROWS, BATCH) \
+  BM_GATHER_EMBEDDING(ROWS, BATCH, 16);       \
+  BM_GATHER_EMBEDDING(ROWS, BATCH, 32);       \
+  BM_GATHER_EMBEDDING(ROWS, BATCH, 64);       \
+  BM_GATHER_EMBEDDING(ROWS, BATCH, 128)
+
+BM_GATHER_EMBEDDING_DIMS(10000, 1000);
+BM_GATHER_EMBEDDING_DIMS(10000, 100000);
+BM_GATHER_EMBEDDING_DIMS(1000000, 1000);
+BM_GATHER_EMBEDDING_DIMS(1000000, 100000);
+
+// Half tables move half the bytes of float ones for the same lookups.
+static void BM_cpu_gather_embedding_half(int iters, int dim) {
+  const int64 tot = static_cast<int64>(iters) * 100000 * dim;
+  testing::ItemsProcessed(tot);
+  testing::BytesProcessed(tot * sizeof(Eigen::half));
+  testing::UseRealTime();
+  test::Benchmark("cpu", GatherEmbedding<Eigen::half>(1000000, 100000, dim))
+      .Run(iters);
+}
+BENCHMARK(BM_cpu_gather_embedding_half)->Arg(16)->Arg(32)->Arg(64)->Arg(128);
+
 }  // namespace
 }  // namespace tensorflow
@@ -26,6 +26,7 @@ limitations under the License.
 #include <math.h>
 #include <algorithm>
 #include <array>
+#include <utility>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -106,6 +107,29 @@ struct ImageResizerState {
   bool align_corners_;
 };
 
+// Calls F<kChannels, T>()(args...), where kChannels is "channels" if it is
+// 1, 3 or 4, the depths of most images, and 0 otherwise.  A resizer whose
+// per-pixel loop runs over kChannels channels when it is not 0 lets the
+// compiler unroll and vectorize that loop for the common depths, and falls
+// back to the run-time "channels" for the others.
+template <template <int, typename> class F, typename T, typename... Args>
+void DispatchChannels(int64 channels, Args&&... args) {
+  switch (channels) {
+    case 1:
+      F<1, T>()(std::forward<Args>(args)...);
+      break;
+    case 3:
+      F<3, T>()(std::forward<Args>(args)...);
+      break;
+    case 4:
+      F<4, T>()(std::forward<Args>(args)...);
+      break;
+    default:
+      F<0, T>()(std::forward<Args>(args)...);
+      break;
+  }
+}
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_KERNELS_IMAGE_RESIZER_STATE_H_
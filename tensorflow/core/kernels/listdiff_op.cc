@@ -14,7 +14,6 @@ limitations under the License.
 ==============================================================================*/
 
 #include <string>
-#include <unordered_set>
 #include <utility>
 
 #include "tensorflow/core/framework/op_kernel.h"
@@ -22,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
 
 namespace tensorflow {
 template <typename T>
@@ -42,10 +42,9 @@ class ListDiffOp : public OpKernel {
     OP_REQUIRES(context, TensorShapeUtils::IsVector(y.shape()),
                 errors::InvalidArgument("y should be a 1D vector."));
 
-    std::unordered_set<T> y_set;
     const auto Ty = y.vec<T>();
     const int y_size = Ty.size();
-    y_set.reserve(y_size);
+    gtl::FlatSet<T> y_set(y_size);
     for (int i = 0; i < y_size; ++i) {
       y_set.insert(Ty(i));
     }
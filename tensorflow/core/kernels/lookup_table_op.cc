@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/hash/hash.h"
 
@@ -44,7 +45,7 @@ const string& SubtleMustCopyUnlessString(const string& value) { return value; }
 
 }  // namespace
 
-// Lookup table that wraps an unordered_map, where the key and value data type
+// Lookup table that wraps a gtl::FlatMap, where the key and value data type
 // is specified.
 //
 // This table is recommended for any variations to key values.
@@ -55,8 +56,8 @@ const string& SubtleMustCopyUnlessString(const string& value) { return value; }
 // Sample use case:
 //
 // HashTable<int64, int64> table;  // int64 -> int64.
-// table.Prepare(10); // Prepare the underlying data structure, the number of
-//                    // elements is required by interface, but not used.
+// table.Prepare(10); // Prepare the underlying data structure for the
+//                    // expected number of elements.
 // // Populate the table, elements could be added in one or multiple calls.
 // table.Insert(key_tensor, value_tensor); // Populate the table.
 // ...
@@ -81,13 +82,16 @@ class HashTable : public InitializableLookupTable {
   DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
 
  protected:
-  Status DoPrepare(size_t unused) override {
+  Status DoPrepare(size_t expected_num_elements) override {
     if (is_initialized_) {
       return errors::Aborted("HashTable already initialized.");
     }
     if (!table_) {
-      table_ = std::unique_ptr<std::unordered_map<K, V>>(
-          new std::unordered_map<K, V>());
+      table_ = std::unique_ptr<gtl::FlatMap<K, V>>(new gtl::FlatMap<K, V>());
+    }
+    // The initializer passes -1 if it does not know the size.
+    if (static_cast<int64>(expected_num_elements) > 0) {
+      table_->reserve(expected_num_elements);
     }
     return Status::OK();
   };
@@ -126,7 +130,7 @@ class HashTable : public InitializableLookupTable {
   }
 
  private:
-  std::unique_ptr<std::unordered_map<K, V>> table_;
+  std::unique_ptr<gtl::FlatMap<K, V>> table_;
 };
 
 }  // namespace lookup
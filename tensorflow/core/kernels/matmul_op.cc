@@ -21,6 +21,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/fill_functor.h"
 
 #if GOOGLE_CUDA
@@ -195,6 +196,36 @@ struct MatMulFunctor<CPUDevice, T> {
 
 }  // end namespace functor
 
+// Half matrices are only a storage format on CPUs: the operands are widened
+// to float, multiplied in float and the product rounded once on store.
+template <>
+struct LaunchMatMulCPU<Eigen::half> {
+  static void launch(
+      OpKernelContext* ctx, OpKernel* kernel, const Tensor& a, const Tensor& b,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+      Tensor* out) {
+    const CPUDevice& d = ctx->eigen_device<CPUDevice>();
+    Tensor a_float;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, a.shape(), &a_float));
+    Tensor b_float;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, b.shape(), &b_float));
+    Tensor out_float;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_temp(DT_FLOAT, out->shape(), &out_float));
+    a_float.flat<float>().device(d) =
+        a.flat<Eigen::half>().template cast<float>();
+    b_float.flat<float>().device(d) =
+        b.flat<Eigen::half>().template cast<float>();
+    const Tensor& a_in = a_float;
+    const Tensor& b_in = b_float;
+    functor::MatMulFunctor<CPUDevice, float>()(d, out_float.matrix<float>(),
+                                               a_in.matrix<float>(),
+                                               b_in.matrix<float>(), dim_pair);
+    out->flat<Eigen::half>().device(d) =
+        out_float.flat<float>().template cast<Eigen::half>();
+  }
+};
+
 #define REGISTER_CPU(T)                                                        \
   REGISTER_KERNEL_BUILDER(                                                     \
       Name("MatMul").Device(DEVICE_CPU).TypeConstraint<T>("T"),                \
@@ -220,6 +251,7 @@ REGISTER_CPU(float);
 REGISTER_CPU(double);
 REGISTER_CPU(int32);
 REGISTER_CPU(complex64);
+TF_CALL_half(REGISTER_CPU);
 #if GOOGLE_CUDA
 REGISTER_GPU(float);
 // REGISTER_GPU(double);
@@ -0,0 +1,213 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_QUANTIZATION_UTILS_H_
+#define TENSORFLOW_KERNELS_QUANTIZATION_UTILS_H_
+
+// Conversions between float and the quantized types qint8, quint8 and
+// qint32.
+//
+// A quantized tensor is passed between ops together with two float scalars,
+// min and max.  The 2^n values of an n-bit type are spread evenly over
+// [min, max], so that lowest(T) stands for min and highest(T) for max:
+//
+//   scale = (max - min) / (2^n - 1)
+//   quantized = round(value / scale) - round(min / scale) + lowest(T)
+//
+// Rounding min to a multiple of scale makes 0 exactly representable when
+// it is in the range, so padding and ReLU need no special cases.
+
+#include <math.h>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The integer type with the same representation as the quantized type T,
+// for computing on the raw values with Eigen.
+template <class T>
+struct QuantizedRawType {
+  typedef typename std::conditional<
+      sizeof(T) == 4, int32,
+      typename std::conditional<std::is_same<T, qint8>::value, int8,
+                                uint8>::type>::type type;
+};
+
+// Returns the width of one quantization step of T over [range_min,
+// range_max].
+template <class T>
+double QuantizationScale(float range_min, float range_max) {
+  const int64 number_of_bits = sizeof(T) * 8;
+  const int64 number_of_steps = static_cast<int64>(1) << number_of_bits;
+  return (static_cast<double>(range_max) - range_min) / (number_of_steps - 1);
+}
+
+// Returns the quantized value of "input", which may be outside the range of
+// T if "input" is outside [range_min, range_max].
+template <class T>
+int64 FloatToQuantizedUnclamped(float input, float range_min, float range_max) {
+  const int64 lowest_quantized =
+      static_cast<int64>(Eigen::NumTraits<T>::lowest());
+  if (range_min == range_max) {
+    return lowest_quantized;
+  }
+  const double scale = QuantizationScale<T>(range_min, range_max);
+  return static_cast<int64>(round(input / scale)) -
+         static_cast<int64>(round(range_min / scale)) + lowest_quantized;
+}
+
+template <class T>
+T FloatToQuantized(float input, float range_min, float range_max) {
+  const int64 lowest = static_cast<int64>(Eigen::NumTraits<T>::lowest());
+  const int64 highest = static_cast<int64>(Eigen::NumTraits<T>::highest());
+  const int64 quantized =
+      FloatToQuantizedUnclamped<T>(input, range_min, range_max);
+  return static_cast<T>(
+      static_cast<int32>(std::max(lowest, std::min(highest, quantized))));
+}
+
+template <class T>
+float QuantizedToFloat(T input, float range_min, float range_max) {
+  if (range_min == range_max) {
+    return range_min;
+  }
+  const double scale = QuantizationScale<T>(range_min, range_max);
+  const int64 lowest_quantized =
+      static_cast<int64>(Eigen::NumTraits<T>::lowest());
+  const double offset_input =
+      static_cast<double>(input.value) - lowest_quantized;
+  const double range_min_rounded = round(range_min / scale) * scale;
+  return range_min_rounded + offset_input * scale;
+}
+
+// Returns the float range of values of T in steps of "scale", with 0 at 0.
+// The step is rounded to float first, so that min_range is exactly
+// scale * lowest(T) and the zero point survives the float range.
+template <class T>
+void QuantizationRangeForScale(double scale, float* range_min,
+                               float* range_max) {
+  const float float_scale = scale;
+  *range_min = float_scale * static_cast<int64>(Eigen::NumTraits<T>::lowest());
+  *range_max =
+      float_scale * static_cast<int64>(Eigen::NumTraits<T>::highest());
+}
+
+// Returns the float range of the T3 result of multiplying a T1 value in
+// [min_a, max_a] by a T2 value in [min_b, max_b], where T3 holds the
+// product of the values with their zero points subtracted.  One step of T3
+// is the product of the steps of T1 and T2.
+template <class T1, class T2, class T3>
+void QuantizationRangeForMultiplication(float min_a, float max_a, float min_b,
+                                        float max_b, float* min_c,
+                                        float* max_c) {
+  QuantizationRangeForScale<T3>(
+      QuantizationScale<T1>(min_a, max_a) * QuantizationScale<T2>(min_b, max_b),
+      min_c, max_c);
+}
+
+// Converts "n" values of T1 in [min_input, max_input] to T2 in
+// [min_output, max_output], clamping to the range of T2.
+template <class T1, class T2>
+void RequantizeInNewRange(const T1* input, int64 n, float min_input,
+                          float max_input, float min_output, float max_output,
+                          T2* output) {
+  if (std::is_same<T1, T2>::value && min_input == min_output &&
+      max_input == max_output) {
+    for (int64 i = 0; i < n; ++i) output[i] = input[i].value;
+    return;
+  }
+  if (min_input == max_input || min_output == max_output) {
+    const T2 q = FloatToQuantized<T2>(
+        QuantizedToFloat<T1>(input[0], min_input, max_input), min_output,
+        max_output);
+    std::fill(output, output + n, q);
+    return;
+  }
+  // output = input * multiplier + offset, folded from the two affine maps.
+  const double scale_input = QuantizationScale<T1>(min_input, max_input);
+  const double scale_output = QuantizationScale<T2>(min_output, max_output);
+  const double multiplier = scale_input / scale_output;
+  const double offset =
+      round(min_input / scale_input) * multiplier -
+      static_cast<double>(static_cast<int64>(Eigen::NumTraits<T1>::lowest())) *
+          multiplier -
+      round(min_output / scale_output) +
+      static_cast<int64>(Eigen::NumTraits<T2>::lowest());
+  // Clamped in double: the bounds of qint32 are not floats, and a float
+  // bound of 2^31 would wrap around when converted.
+  const double lowest = static_cast<int64>(Eigen::NumTraits<T2>::lowest());
+  const double highest = static_cast<int64>(Eigen::NumTraits<T2>::highest());
+  for (int64 i = 0; i < n; ++i) {
+    const double v = static_cast<double>(input[i].value) * multiplier + offset;
+    output[i] = static_cast<T2>(
+        static_cast<int32>(llrint(std::max(lowest, std::min(highest, v)))));
+  }
+}
+
+// Widens [*min_range, *max_range] to include 0 and to be at least a small
+// fraction of its largest bound wide, so that every range can be quantized.
+inline void AdjustQuantizationRange(float* min_range, float* max_range) {
+  const float epsilon =
+      std::max(1.0f, std::max(fabsf(*min_range), fabsf(*max_range))) / 100.0f;
+  *min_range = std::min(0.0f, *min_range);
+  *max_range = std::max(0.0f, std::max(*max_range, *min_range + epsilon));
+}
+
+// Reads the range of a quantized input of "ctx" from the scalar float
+// inputs "min_index" and "min_index + 1".
+inline Status GetQuantizationRange(OpKernelContext* ctx, int min_index,
+                                   float* range_min, float* range_max) {
+  const Tensor& min_tensor = ctx->input(min_index);
+  const Tensor& max_tensor = ctx->input(min_index + 1);
+  if (!TensorShapeUtils::IsScalar(min_tensor.shape()) ||
+      !TensorShapeUtils::IsScalar(max_tensor.shape())) {
+    return errors::InvalidArgument(
+        "The range of a quantized tensor must be given by two scalars, got ",
+        min_tensor.shape().DebugString(), " and ",
+        max_tensor.shape().DebugString());
+  }
+  *range_min = min_tensor.scalar<float>()();
+  *range_max = max_tensor.scalar<float>()();
+  if (!(*range_min <= *range_max)) {
+    return errors::InvalidArgument("The minimum of a quantization range ",
+                                   *range_min, " is greater than the maximum ",
+                                   *range_max);
+  }
+  return Status::OK();
+}
+
+// Returns an error unless [range_min, range_max] includes 0.  The integer
+// matrix kernels subtract the quantized zero from each 8-bit value and
+// need the difference to stay small.
+inline Status CheckRangeIncludesZero(float range_min, float range_max) {
+  if (range_min > 0.0f || range_max < 0.0f) {
+    return errors::InvalidArgument("The quantization range [", range_min, ", ",
+                                   range_max, "] does not include 0");
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_QUANTIZATION_UTILS_H_
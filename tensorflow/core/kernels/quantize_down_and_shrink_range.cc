@@ -0,0 +1,92 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/type_traits.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+template <typename T2>
+class QuantizeDownAndShrinkRangeOp : public OpKernel {
+ public:
+  explicit QuantizeDownAndShrinkRangeOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& input = ctx->input(0);
+    float input_min_float;
+    float input_max_float;
+    OP_REQUIRES_OK(ctx, GetQuantizationRange(ctx, 1, &input_min_float,
+                                             &input_max_float));
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, input.shape(), &output));
+    Tensor* output_min = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(1, TensorShape({}), &output_min));
+    Tensor* output_max = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({}), &output_max));
+
+    // The range of the values actually present, widened to contain 0.
+    const int64 n = input.NumElements();
+    const qint32* in = input.flat<qint32>().data();
+    int32 min_q = 0;
+    int32 max_q = 0;
+    for (int64 i = 0; i < n; ++i) {
+      min_q = std::min(min_q, in[i].value);
+      max_q = std::max(max_q, in[i].value);
+    }
+    float actual_min_float =
+        QuantizedToFloat<qint32>(min_q, input_min_float, input_max_float);
+    float actual_max_float =
+        QuantizedToFloat<qint32>(max_q, input_min_float, input_max_float);
+    AdjustQuantizationRange(&actual_min_float, &actual_max_float);
+
+    T2* out = output->flat<T2>().data();
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, n, 5,
+          [in, out, input_min_float, input_max_float, actual_min_float,
+           actual_max_float](int64 start, int64 limit) {
+            RequantizeInNewRange<qint32, T2>(
+                in + start, limit - start, input_min_float, input_max_float,
+                actual_min_float, actual_max_float, out + start);
+          });
+    output_min->flat<float>()(0) = actual_min_float;
+    output_max->flat<float>()(0) = actual_max_float;
+  }
+};
+
+#define REGISTER_QUANTIZE_DOWN(type)                             \
+  REGISTER_KERNEL_BUILDER(Name("QuantizeDownAndShrinkRange")     \
+                              .Device(DEVICE_CPU)                \
+                              .TypeConstraint<type>("out_type"), \
+                          QuantizeDownAndShrinkRangeOp<type>)
+
+REGISTER_QUANTIZE_DOWN(qint8);
+REGISTER_QUANTIZE_DOWN(quint8);
+#undef REGISTER_QUANTIZE_DOWN
+
+}  // namespace tensorflow
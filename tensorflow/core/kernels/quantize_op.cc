@@ -0,0 +1,82 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/array_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/type_traits.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+template <typename T>
+class QuantizeOp : public OpKernel {
+ public:
+  explicit QuantizeOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& input = ctx->input(0);
+    float min_range;
+    float max_range;
+    OP_REQUIRES_OK(ctx, GetQuantizationRange(ctx, 1, &min_range, &max_range));
+    AdjustQuantizationRange(&min_range, &max_range);
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, input.shape(), &output));
+
+    // Computed as in FloatToQuantized, with the constants hoisted and in
+    // float so that Eigen vectorizes it.
+    const float scale = QuantizationScale<T>(min_range, max_range);
+    const float offset = static_cast<int64>(Eigen::NumTraits<T>::lowest()) -
+                         roundf(min_range / scale);
+    const float lowest = static_cast<int64>(Eigen::NumTraits<T>::lowest());
+    const float highest = static_cast<int64>(Eigen::NumTraits<T>::highest());
+    typedef typename QuantizedRawType<T>::type Raw;
+    auto out = typename TTypes<Raw>::Flat(
+        reinterpret_cast<Raw*>(output->flat<T>().data()), input.NumElements());
+    out.device(ctx->eigen_device<CPUDevice>()) =
+        ((input.flat<float>() * (1.0f / scale)).round() + offset)
+            .cwiseMax(lowest)
+            .cwiseMin(highest)
+            .template cast<Raw>();
+
+    Tensor* output_min = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(1, TensorShape({}), &output_min));
+    output_min->flat<float>()(0) = min_range;
+    Tensor* output_max = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({}), &output_max));
+    output_max->flat<float>()(0) = max_range;
+  }
+};
+
+#define REGISTER_QUANTIZE(type)                                      \
+  REGISTER_KERNEL_BUILDER(                                           \
+      Name("Quantize").Device(DEVICE_CPU).TypeConstraint<type>("T"), \
+      QuantizeOp<type>)
+
+REGISTER_QUANTIZE(qint8);
+REGISTER_QUANTIZE(quint8);
+#undef REGISTER_QUANTIZE
+
+}  // namespace tensorflow
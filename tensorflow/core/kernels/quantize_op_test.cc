@@ -0,0 +1,225 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns the raw values of the quantized tensor "t".
+template <class T>
+std::vector<int> Values(const Tensor& t) {
+  std::vector<int> values;
+  for (int64 i = 0; i < t.NumElements(); ++i) {
+    values.push_back(t.flat<T>()(i).value);
+  }
+  return values;
+}
+
+class QuantizeOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType type) {
+    TF_ASSERT_OK(NodeDefBuilder("quantize_op", "Quantize")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("T", type)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void ExpectRange(int output_index, float min_range, float max_range) {
+    EXPECT_EQ(min_range, GetOutput(output_index)->scalar<float>()());
+    EXPECT_EQ(max_range, GetOutput(output_index + 1)->scalar<float>()());
+  }
+};
+
+TEST_F(QuantizeOpTest, Quint8) {
+  MakeOp(DT_QUINT8);
+  AddInputFromArray<float>(TensorShape({6}), {0, 1, 127.4, 255, 300, -5});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {255});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ((std::vector<int>{0, 1, 127, 255, 255, 0}),
+            Values<quint8>(*GetOutput(0)));
+  ExpectRange(1, 0, 255);
+}
+
+TEST_F(QuantizeOpTest, Qint8) {
+  MakeOp(DT_QINT8);
+  AddInputFromArray<float>(TensorShape({2, 3}), {-128, -1, 0, 5.6, 127, 200});
+  AddInputFromArray<float>(TensorShape({}), {-128});
+  AddInputFromArray<float>(TensorShape({}), {127});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(TensorShape({2, 3}), GetOutput(0)->shape());
+  EXPECT_EQ((std::vector<int>{-128, -1, 0, 6, 127, 127}),
+            Values<qint8>(*GetOutput(0)));
+  ExpectRange(1, -128, 127);
+}
+
+// The range is widened to include 0 and to be of non-zero width.
+TEST_F(QuantizeOpTest, AdjustsRange) {
+  MakeOp(DT_QUINT8);
+  AddInputFromArray<float>(TensorShape({2}), {3, 3});
+  AddInputFromArray<float>(TensorShape({}), {3});
+  AddInputFromArray<float>(TensorShape({}), {3});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ((std::vector<int>{255, 255}), Values<quint8>(*GetOutput(0)));
+  ExpectRange(1, 0, 3);
+}
+
+TEST_F(QuantizeOpTest, InvalidRange) {
+  MakeOp(DT_QUINT8);
+  AddInputFromArray<float>(TensorShape({1}), {0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  AddInputFromArray<float>(TensorShape({}), {-1});
+  EXPECT_FALSE(RunOpKernel().ok());
+}
+
+class DequantizeOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType type) {
+    TF_ASSERT_OK(NodeDefBuilder("dequantize_op", "Dequantize")
+                     .Input(FakeInput(type))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Dequantizes "values" over [min_range, max_range] and compares with
+  // QuantizedToFloat.
+  template <class T>
+  void Run(const std::vector<int>& values, float min_range, float max_range) {
+    MakeOp(DataTypeToEnum<T>::v());
+    std::vector<T> input;
+    std::vector<float> expected;
+    for (int v : values) {
+      input.push_back(static_cast<T>(v));
+      expected.push_back(
+          QuantizedToFloat<T>(static_cast<T>(v), min_range, max_range));
+    }
+    AddInputFromArray<T>(TensorShape({static_cast<int64>(input.size())}),
+                         input);
+    AddInputFromArray<float>(TensorShape({}), {min_range});
+    AddInputFromArray<float>(TensorShape({}), {max_range});
+    TF_ASSERT_OK(RunOpKernel());
+    Tensor expected_tensor(allocator(), DT_FLOAT, GetOutput(0)->shape());
+    test::FillValues<float>(&expected_tensor, expected);
+    const float scale = QuantizationScale<T>(min_range, max_range);
+    test::ExpectTensorNear<float>(expected_tensor, *GetOutput(0),
+                                  scale * 1e-3);
+  }
+};
+
+TEST_F(DequantizeOpTest, Quint8) {
+  Run<quint8>({0, 1, 128, 255}, 0, 255);
+  test::ExpectTensorNear<float>(
+      test::AsTensor<float>({0, 1, 128, 255}), *GetOutput(0), 1e-5);
+}
+
+TEST_F(DequantizeOpTest, Qint8) { Run<qint8>({-128, -1, 0, 1, 127}, -1, 3); }
+
+TEST_F(DequantizeOpTest, Qint32) {
+  Run<qint32>({-2147483647 - 1, -5, 0, 7, 2147483647}, -1e4, 1e4);
+}
+
+// Quantizing and dequantizing is within half a step of the input.
+TEST_F(QuantizeOpTest, RoundTrip) {
+  const int kSize = 10000;
+  const float kMin = -3, kMax = 5;
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<float> input(kSize);
+  for (float& v : input) v = kMin + (kMax - kMin) * rnd.RandFloat();
+  MakeOp(DT_QUINT8);
+  AddInputFromArray<float>(TensorShape({kSize}), input);
+  AddInputFromArray<float>(TensorShape({}), {kMin});
+  AddInputFromArray<float>(TensorShape({}), {kMax});
+  TF_ASSERT_OK(RunOpKernel());
+  const Tensor& quantized = *GetOutput(0);
+  const float scale = QuantizationScale<quint8>(kMin, kMax);
+  for (int i = 0; i < kSize; ++i) {
+    const float v =
+        QuantizedToFloat<quint8>(quantized.flat<quint8>()(i), kMin, kMax);
+    EXPECT_NEAR(input[i], v, scale * 0.501) << i;
+  }
+}
+
+class QuantizeDownAndShrinkRangeTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType type) {
+    TF_ASSERT_OK(NodeDefBuilder("shrink_op", "QuantizeDownAndShrinkRange")
+                     .Input(FakeInput(DT_QINT32))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("out_type", type)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+// The output range is the range of the values present, not of qint32.
+TEST_F(QuantizeDownAndShrinkRangeTest, Quint8) {
+  MakeOp(DT_QUINT8);
+  // One step of the input is 1 / 65536.
+  const float min_input = -32768.0f;
+  const float max_input = 32768.0f - 1.0f / 65536;
+  AddInputFromArray<qint32>(TensorShape({4}),
+                            {0, 65536, 32768, 2 * 65536});
+  AddInputFromArray<float>(TensorShape({}), {min_input});
+  AddInputFromArray<float>(TensorShape({}), {max_input});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(0.0f, GetOutput(1)->scalar<float>()());
+  EXPECT_NEAR(2.0f, GetOutput(2)->scalar<float>()(), 1e-4);
+  const std::vector<int> values = Values<quint8>(*GetOutput(0));
+  EXPECT_EQ(0, values[0]);
+  EXPECT_NEAR(127.5, values[1], 0.5);
+  EXPECT_NEAR(63.75, values[2], 0.5);
+  EXPECT_EQ(255, values[3]);
+}
+
+TEST_F(QuantizeDownAndShrinkRangeTest, Qint8) {
+  MakeOp(DT_QINT8);
+  const float min_input = -32768.0f;
+  const float max_input = 32768.0f - 1.0f / 65536;
+  AddInputFromArray<qint32>(TensorShape({3}), {-65536, 0, 65536});
+  AddInputFromArray<float>(TensorShape({}), {min_input});
+  AddInputFromArray<float>(TensorShape({}), {max_input});
+  TF_ASSERT_OK(RunOpKernel());
+  const float min_output = GetOutput(1)->scalar<float>()();
+  const float max_output = GetOutput(2)->scalar<float>()();
+  EXPECT_NEAR(-1.0f, min_output, 1e-4);
+  EXPECT_NEAR(1.0f, max_output, 1e-4);
+  const std::vector<int> values = Values<qint8>(*GetOutput(0));
+  EXPECT_EQ(-128, values[0]);
+  EXPECT_EQ(FloatToQuantized<qint8>(0.0f, min_output, max_output).value,
+            values[1]);
+  EXPECT_EQ(127, values[2]);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,75 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+// Clamps the quantized values below the one standing for 0.  The range is
+// unchanged, so the output can be read with the input's min and max.
+template <class T>
+class QuantizedReluOp : public OpKernel {
+ public:
+  explicit QuantizedReluOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& input = ctx->input(0);
+    float min_input, max_input;
+    OP_REQUIRES_OK(ctx, GetQuantizationRange(ctx, 1, &min_input, &max_input));
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, input.shape(), &output));
+    Tensor* min_output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(1, TensorShape({}), &min_output));
+    Tensor* max_output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({}), &max_output));
+    min_output->flat<float>()(0) = min_input;
+    max_output->flat<float>()(0) = max_input;
+
+    typedef typename QuantizedRawType<T>::type Raw;
+    const Raw zero = static_cast<Raw>(
+        FloatToQuantized<T>(0.0f, min_input, max_input).value);
+    typename TTypes<Raw>::ConstFlat in(
+        reinterpret_cast<const Raw*>(input.flat<T>().data()),
+        input.NumElements());
+    typename TTypes<Raw>::Flat out(
+        reinterpret_cast<Raw*>(output->flat<T>().data()),
+        output->NumElements());
+    out.device(ctx->eigen_device<CPUDevice>()) = in.cwiseMax(zero);
+  }
+};
+
+#define REGISTER_QUANTIZED_RELU(T)                                     \
+  REGISTER_KERNEL_BUILDER(                                             \
+      Name("QuantizedRelu").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      QuantizedReluOp<T>)
+
+REGISTER_QUANTIZED_RELU(quint8);
+REGISTER_QUANTIZED_RELU(qint8);
+REGISTER_QUANTIZED_RELU(qint32);
+#undef REGISTER_QUANTIZED_RELU
+
+}  // namespace tensorflow
@@ -0,0 +1,69 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class QuantizedReluTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType type) {
+    TF_ASSERT_OK(NodeDefBuilder("quantized_relu_op", "QuantizedRelu")
+                     .Input(FakeInput(type))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(QuantizedReluTest, Quint8) {
+  MakeOp(DT_QUINT8);
+  // 0 is quantized to 64 over [-64, 191].
+  AddInputFromArray<quint8>(TensorShape({2, 3}), {0, 63, 64, 65, 200, 255});
+  AddInputFromArray<float>(TensorShape({}), {-64});
+  AddInputFromArray<float>(TensorShape({}), {191});
+  TF_ASSERT_OK(RunOpKernel());
+  const std::vector<int> expected = {64, 64, 64, 65, 200, 255};
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], GetOutput(0)->flat<quint8>()(i).value);
+  }
+  EXPECT_EQ(-64, GetOutput(1)->scalar<float>()());
+  EXPECT_EQ(191, GetOutput(2)->scalar<float>()());
+}
+
+TEST_F(QuantizedReluTest, Qint32) {
+  MakeOp(DT_QINT32);
+  AddInputFromArray<qint32>(TensorShape({4}), {-100000, -1, 0, 7});
+  AddInputFromArray<float>(TensorShape({}), {-2147483648.0f});
+  AddInputFromArray<float>(TensorShape({}), {2147483647.0f});
+  TF_ASSERT_OK(RunOpKernel());
+  const std::vector<int> expected = {0, 0, 0, 7};
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], GetOutput(0)->flat<qint32>()(i).value);
+  }
+}
+
+}  // namespace tensorflow
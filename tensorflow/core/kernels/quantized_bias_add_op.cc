@@ -0,0 +1,135 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+template <class T1, class T2>
+class QuantizedBiasAddOp : public OpKernel {
+ public:
+  explicit QuantizedBiasAddOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& input = ctx->input(0);
+    const Tensor& bias = ctx->input(1);
+    float min_input, max_input, min_bias, max_bias;
+    OP_REQUIRES_OK(ctx, GetQuantizationRange(ctx, 2, &min_input, &max_input));
+    OP_REQUIRES_OK(ctx, GetQuantizationRange(ctx, 4, &min_bias, &max_bias));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrixOrHigher(input.shape()),
+                errors::InvalidArgument("Input tensor must be at least 2D: ",
+                                        input.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(bias.shape()),
+                errors::InvalidArgument("Biases must be 1D: ",
+                                        bias.shape().DebugString()));
+    const int64 depth = bias.NumElements();
+    OP_REQUIRES(
+        ctx, input.dim_size(input.dims() - 1) == depth,
+        errors::InvalidArgument(
+            "Must provide as many biases as the last dimension "
+            "of the input tensor: ",
+            bias.shape().DebugString(), " vs. ", input.shape().DebugString()));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, input.shape(), &output));
+    Tensor* min_output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(1, TensorShape({}), &min_output));
+    Tensor* max_output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({}), &max_output));
+
+    // The sum is computed in steps of the finer of the two scales, with 0
+    // at 0 like the outputs of QuantizedMatMul and QuantizedConv2D.  A
+    // zero-width range holds a single value and has no steps, so only the
+    // other range counts; if both are, the steps only need to reach the
+    // constant sum.
+    const double input_scale = QuantizationScale<T1>(min_input, max_input);
+    const double bias_scale = QuantizationScale<T2>(min_bias, max_bias);
+    double scale;
+    if (input_scale == 0 || bias_scale == 0) {
+      scale = std::max(input_scale, bias_scale);
+    } else {
+      scale = std::min(input_scale, bias_scale);
+    }
+    if (scale == 0) {
+      float min_sum = -fabsf(min_input + min_bias);
+      float max_sum = -min_sum;
+      AdjustQuantizationRange(&min_sum, &max_sum);
+      scale = QuantizationScale<qint32>(-max_sum, max_sum);
+    }
+    float min_out, max_out;
+    QuantizationRangeForScale<qint32>(scale, &min_out, &max_out);
+    min_output->flat<float>()(0) = min_out;
+    max_output->flat<float>()(0) = max_out;
+
+    std::vector<qint32> bias_out(depth);
+    RequantizeInNewRange<T2, qint32>(bias.flat<T2>().data(), depth, min_bias,
+                                     max_bias, min_out, max_out,
+                                     bias_out.data());
+    const T1* in = input.flat<T1>().data();
+    qint32* out = output->flat<qint32>().data();
+    const int64 lowest = Eigen::NumTraits<qint32>::lowest();
+    const int64 highest = Eigen::NumTraits<qint32>::highest();
+    auto add_rows = [&bias_out, in, out, depth, min_input, max_input, min_out,
+                     max_out, lowest, highest](int64 start, int64 limit) {
+      RequantizeInNewRange<T1, qint32>(in + start * depth,
+                                       (limit - start) * depth, min_input,
+                                       max_input, min_out, max_out,
+                                       out + start * depth);
+      for (int64 row = start; row < limit; ++row) {
+        qint32* out_row = out + row * depth;
+        for (int64 d = 0; d < depth; ++d) {
+          const int64 sum =
+              static_cast<int64>(out_row[d].value) + bias_out[d].value;
+          out_row[d] =
+              static_cast<int32>(std::max(lowest, std::min(highest, sum)));
+        }
+      }
+    };
+    const int64 rows = depth == 0 ? 0 : input.NumElements() / depth;
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, rows,
+          5 * depth, add_rows);
+  }
+};
+
+#define REGISTER_QUANTIZED_BIAS_ADD(T1, T2)              \
+  REGISTER_KERNEL_BUILDER(Name("QuantizedBiasAdd")       \
+                              .Device(DEVICE_CPU)        \
+                              .TypeConstraint<T1>("T1")  \
+                              .TypeConstraint<T2>("T2"), \
+                          QuantizedBiasAddOp<T1, T2>)
+
+REGISTER_QUANTIZED_BIAS_ADD(quint8, quint8);
+REGISTER_QUANTIZED_BIAS_ADD(quint8, qint8);
+REGISTER_QUANTIZED_BIAS_ADD(qint8, quint8);
+REGISTER_QUANTIZED_BIAS_ADD(qint8, qint8);
+REGISTER_QUANTIZED_BIAS_ADD(qint32, quint8);
+REGISTER_QUANTIZED_BIAS_ADD(qint32, qint8);
+REGISTER_QUANTIZED_BIAS_ADD(qint32, qint32);
+#undef REGISTER_QUANTIZED_BIAS_ADD
+
+}  // namespace tensorflow
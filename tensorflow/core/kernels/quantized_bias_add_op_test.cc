@@ -0,0 +1,148 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class QuantizedBiasAddTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType input_type, DataType bias_type) {
+    TF_ASSERT_OK(NodeDefBuilder("quantized_bias_add_op", "QuantizedBiasAdd")
+                     .Input(FakeInput(input_type))
+                     .Input(FakeInput(bias_type))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Returns the float values of output 0.
+  std::vector<float> Output() {
+    const float min_output = GetOutput(1)->scalar<float>()();
+    const float max_output = GetOutput(2)->scalar<float>()();
+    std::vector<float> values;
+    auto flat = GetOutput(0)->flat<qint32>();
+    for (int64 i = 0; i < flat.size(); ++i) {
+      values.push_back(
+          QuantizedToFloat<qint32>(flat(i), min_output, max_output));
+    }
+    return values;
+  }
+};
+
+TEST_F(QuantizedBiasAddTest, Quint8) {
+  MakeOp(DT_QUINT8, DT_QUINT8);
+  // Steps of 1 / 255 and 2 / 255, both with 0 at 0.
+  AddInputFromArray<quint8>(TensorShape({2, 3}), {0, 51, 102, 153, 204, 255});
+  AddInputFromArray<quint8>(TensorShape({3}), {0, 127, 255});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {2});
+  TF_ASSERT_OK(RunOpKernel());
+  const std::vector<float> expected = {0.0f, 0.2f + 254.0f / 255,
+                                       0.4f + 2.0f, 0.6f, 0.8f + 254.0f / 255,
+                                       1.0f + 2.0f};
+  const std::vector<float> actual = Output();
+  ASSERT_EQ(expected.size(), actual.size());
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(expected[i], actual[i], 1e-3) << i;
+  }
+}
+
+// The output of a QuantizedConv2D plus a quint8 bias.
+TEST_F(QuantizedBiasAddTest, Qint32Input) {
+  MakeOp(DT_QINT32, DT_QUINT8);
+  const float min_input = -2147483648.0f / 1000;
+  const float max_input = 2147483647.0f / 1000;
+  AddInputFromArray<qint32>(TensorShape({2, 2}), {-1500, 0, 2500, 100000});
+  AddInputFromArray<quint8>(TensorShape({2}), {0, 255});
+  AddInputFromArray<float>(TensorShape({}), {min_input});
+  AddInputFromArray<float>(TensorShape({}), {max_input});
+  AddInputFromArray<float>(TensorShape({}), {-1});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  TF_ASSERT_OK(RunOpKernel());
+  // The input steps are the finer ones and carry over to the output.
+  EXPECT_FLOAT_EQ(min_input, GetOutput(1)->scalar<float>()());
+  const std::vector<float> expected = {-1.5f - 1.0f, 0.0f + 1.0f,
+                                       2.5f - 1.0f, 100.0f + 1.0f};
+  const std::vector<float> actual = Output();
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(expected[i], actual[i], 1e-2) << i;
+  }
+}
+
+// Input steps 2^30 times coarser than the bias steps saturate the qint32
+// output instead of wrapping around.
+TEST_F(QuantizedBiasAddTest, SaturatingInput) {
+  MakeOp(DT_QUINT8, DT_QUINT8);
+  AddInputFromArray<quint8>(TensorShape({1, 3}), {0, 2, 255});
+  AddInputFromArray<quint8>(TensorShape({3}), {0, 0, 0});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {255.0f * (1 << 30)});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {255});
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<qint32>(
+      test::AsTensor<qint32>({0, Eigen::NumTraits<qint32>::highest(),
+                              Eigen::NumTraits<qint32>::highest()},
+                             {1, 3}),
+      *GetOutput(0));
+}
+
+// A zero-width bias range does not make the output range zero-width.
+TEST_F(QuantizedBiasAddTest, ConstantBias) {
+  MakeOp(DT_QUINT8, DT_QUINT8);
+  AddInputFromArray<quint8>(TensorShape({1, 3}), {0, 51, 255});
+  AddInputFromArray<quint8>(TensorShape({3}), {0, 0, 0});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_LT(GetOutput(1)->scalar<float>()(), GetOutput(2)->scalar<float>()());
+  const std::vector<float> expected = {0.0f, 0.2f, 1.0f};
+  const std::vector<float> actual = Output();
+  ASSERT_EQ(expected.size(), actual.size());
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(expected[i], actual[i], 1e-3) << i;
+  }
+}
+
+TEST_F(QuantizedBiasAddTest, WrongBiasSize) {
+  MakeOp(DT_QUINT8, DT_QUINT8);
+  AddInputFromArray<quint8>(TensorShape({2, 3}), {0, 1, 2, 3, 4, 5});
+  AddInputFromArray<quint8>(TensorShape({2}), {0, 1});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  EXPECT_FALSE(RunOpKernel().ok());
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,187 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/kernels/quantized_gemm.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/padding.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Number of output pixels whose patches are packed at a time.
+const int64 kPixelsPerChunk = 32;
+
+}  // namespace
+
+// Computes the convolution as a matrix product of the image patches, one
+// row of filter_rows * filter_cols * in_depth values per output pixel, with
+// the filter reshaped to [filter_rows * filter_cols * in_depth, out_depth].
+// Patches are packed a chunk of pixels at a time, so the im2col buffer
+// stays small and in cache.
+template <class T1, class T2>
+class QuantizedConv2DOp : public OpKernel {
+ public:
+  explicit QuantizedConv2DOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("strides", &strides_));
+    OP_REQUIRES(ctx, strides_.size() == 4,
+                errors::InvalidArgument("Sliding window strides field must "
+                                        "specify 4 dimensions"));
+    OP_REQUIRES(ctx, strides_[0] == 1 && strides_[3] == 1,
+                errors::InvalidArgument(
+                    "Current implementation does not yet support "
+                    "strides in the batch and depth dimensions."));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("padding", &padding_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& input = ctx->input(0);
+    const Tensor& filter = ctx->input(1);
+    float min_input, max_input, min_filter, max_filter;
+    OP_REQUIRES_OK(ctx, GetQuantizationRange(ctx, 2, &min_input, &max_input));
+    OP_REQUIRES_OK(ctx,
+                   GetQuantizationRange(ctx, 4, &min_filter, &max_filter));
+    OP_REQUIRES_OK(ctx, CheckRangeIncludesZero(min_input, max_input));
+    OP_REQUIRES_OK(ctx, CheckRangeIncludesZero(min_filter, max_filter));
+
+    OP_REQUIRES(ctx, input.dims() == 4,
+                errors::InvalidArgument("input must be 4-dimensional",
+                                        input.shape().DebugString()));
+    OP_REQUIRES(ctx, filter.dims() == 4,
+                errors::InvalidArgument("filter must be 4-dimensional: ",
+                                        filter.shape().DebugString()));
+    const int64 in_depth = input.dim_size(3);
+    OP_REQUIRES(
+        ctx, in_depth == filter.dim_size(2),
+        errors::InvalidArgument("input and filter must have the same depth: ",
+                                in_depth, " vs ", filter.dim_size(2)));
+    const int64 batch = input.dim_size(0);
+    const int64 in_rows = input.dim_size(1);
+    const int64 in_cols = input.dim_size(2);
+    const int64 filter_rows = filter.dim_size(0);
+    const int64 filter_cols = filter.dim_size(1);
+    const int64 out_depth = filter.dim_size(3);
+    const int64 depth = filter_rows * filter_cols * in_depth;
+    OP_REQUIRES(ctx, depth <= quantized_gemm::kMaxDepth,
+                errors::InvalidArgument(
+                    "Filter size ", depth, " exceeds ",
+                    quantized_gemm::kMaxDepth,
+                    ", above which the int32 output may overflow"));
+    const int stride_rows = strides_[1];
+    const int stride_cols = strides_[2];
+
+    int out_rows = 0, out_cols = 0, pad_rows = 0, pad_cols = 0;
+    OP_REQUIRES_OK(ctx,
+                   Get2dOutputSize(in_rows, in_cols, filter_rows, filter_cols,
+                                   stride_rows, stride_cols, padding_,
+                                   &out_rows, &out_cols, &pad_rows, &pad_cols));
+    const TensorShape out_shape({batch, out_rows, out_cols, out_depth});
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, out_shape, &output));
+    Tensor* min_output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(1, TensorShape({}), &min_output));
+    Tensor* max_output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({}), &max_output));
+    float min_c, max_c;
+    QuantizationRangeForMultiplication<T1, T2, qint32>(
+        min_input, max_input, min_filter, max_filter, &min_c, &max_c);
+    min_output->flat<float>()(0) = min_c;
+    max_output->flat<float>()(0) = max_c;
+    if (output->NumElements() == 0) return;
+
+    const int32 offset_input =
+        FloatToQuantizedUnclamped<T1>(0.0f, min_input, max_input);
+    const int32 offset_filter =
+        FloatToQuantizedUnclamped<T2>(0.0f, min_filter, max_filter);
+    const int64 packed_depth = quantized_gemm::PackedDepth(depth);
+    std::vector<int16> packed_filter(
+        quantized_gemm::PackedColumns(out_depth) * packed_depth, 0);
+    quantized_gemm::PackRows(filter.flat<T2>().data(), true, out_depth, depth,
+                             offset_filter, 0, out_depth, packed_depth,
+                             packed_filter.data());
+
+    const T1* in = input.flat<T1>().data();
+    qint32* out = output->flat<qint32>().data();
+    const int64 num_pixels = batch * out_rows * out_cols;
+    // Padding is filled with the quantized zero of the input, which is 0
+    // once the offset is subtracted.
+    auto conv_pixels = [&, in, out](int64 start, int64 limit) {
+      std::vector<int16> patches(kPixelsPerChunk * packed_depth, 0);
+      for (int64 p0 = start; p0 < limit; p0 += kPixelsPerChunk) {
+        const int64 p1 = std::min(limit, p0 + kPixelsPerChunk);
+        for (int64 p = p0; p < p1; ++p) {
+          const int64 b = p / (out_rows * out_cols);
+          const int64 out_y = p / out_cols % out_rows;
+          const int64 out_x = p % out_cols;
+          int16* patch = &patches[(p - p0) * packed_depth];
+          for (int64 fy = 0; fy < filter_rows; ++fy) {
+            const int64 in_y = out_y * stride_rows - pad_rows + fy;
+            for (int64 fx = 0; fx < filter_cols; ++fx) {
+              const int64 in_x = out_x * stride_cols - pad_cols + fx;
+              int16* dst = patch + (fy * filter_cols + fx) * in_depth;
+              if (in_y < 0 || in_y >= in_rows || in_x < 0 || in_x >= in_cols) {
+                std::fill(dst, dst + in_depth, 0);
+                continue;
+              }
+              const T1* src =
+                  in + ((b * in_rows + in_y) * in_cols + in_x) * in_depth;
+              for (int64 d = 0; d < in_depth; ++d) {
+                dst[d] = src[d].value - offset_input;
+              }
+            }
+          }
+        }
+        quantized_gemm::MultiplyPacked(patches.data(), p1 - p0,
+                                       packed_filter.data(), out_depth,
+                                       packed_depth, out + p0 * out_depth);
+      }
+    };
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, num_pixels,
+          depth + std::max<int64>(1, out_depth * depth / 8), conv_pixels);
+  }
+
+ private:
+  std::vector<int32> strides_;
+  Padding padding_;
+};
+
+#define REGISTER_QUANTIZED_CONV2D(T1, T2)                     \
+  REGISTER_KERNEL_BUILDER(Name("QuantizedConv2D")             \
+                              .Device(DEVICE_CPU)             \
+                              .TypeConstraint<T1>("Tinput")   \
+                              .TypeConstraint<T2>("Tfilter"), \
+                          QuantizedConv2DOp<T1, T2>)
+
+REGISTER_QUANTIZED_CONV2D(quint8, quint8);
+REGISTER_QUANTIZED_CONV2D(quint8, qint8);
+REGISTER_QUANTIZED_CONV2D(qint8, quint8);
+REGISTER_QUANTIZED_CONV2D(qint8, qint8);
+#undef REGISTER_QUANTIZED_CONV2D
+
+}  // namespace tensorflow
@@ -0,0 +1,244 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/kernels/quantized_gemm.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/util/padding.h"
+
+namespace tensorflow {
+
+class QuantizedConv2DTest : public OpsTestBase {
+ protected:
+  // Convolves a random quint8 image with a random filter of type T2 and
+  // checks the result against a direct convolution of the values with their
+  // zero points subtracted, which the kernel computes exactly.
+  template <class T2>
+  void RunRandom(int batch, int rows, int cols, int in_depth, int filter_rows,
+                 int filter_cols, int out_depth, int stride, Padding padding) {
+    TF_ASSERT_OK(NodeDefBuilder("quantized_conv_op", "QuantizedConv2D")
+                     .Input(FakeInput(DT_QUINT8))
+                     .Input(FakeInput(DataTypeToEnum<T2>::v()))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("strides", {1, stride, stride, 1})
+                     .Attr("padding", padding == VALID ? "VALID" : "SAME")
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    const float min_input = -1, max_input = 4;
+    const float min_filter = -2, max_filter = 1;
+    random::PhiloxRandom philox(301, 17);
+    random::SimplePhilox rnd(&philox);
+    std::vector<quint8> input(batch * rows * cols * in_depth);
+    for (quint8& v : input) v = static_cast<quint8>(rnd.Uniform(256));
+    std::vector<T2> filter(filter_rows * filter_cols * in_depth * out_depth);
+    for (T2& v : filter) {
+      v = static_cast<T2>(static_cast<int32>(rnd.Uniform(256)) +
+                          Eigen::NumTraits<T2>::lowest());
+    }
+    AddInputFromArray<quint8>(TensorShape({batch, rows, cols, in_depth}),
+                              input);
+    AddInputFromArray<T2>(
+        TensorShape({filter_rows, filter_cols, in_depth, out_depth}), filter);
+    AddInputFromArray<float>(TensorShape({}), {min_input});
+    AddInputFromArray<float>(TensorShape({}), {max_input});
+    AddInputFromArray<float>(TensorShape({}), {min_filter});
+    AddInputFromArray<float>(TensorShape({}), {max_filter});
+    TF_ASSERT_OK(RunOpKernel());
+
+    int out_rows, out_cols, pad_rows, pad_cols;
+    TF_ASSERT_OK(Get2dOutputSize(rows, cols, filter_rows, filter_cols, stride,
+                                 stride, padding, &out_rows, &out_cols,
+                                 &pad_rows, &pad_cols));
+    const Tensor& output = *GetOutput(0);
+    ASSERT_EQ(TensorShape({batch, out_rows, out_cols, out_depth}),
+              output.shape());
+    const double scale_output =
+        QuantizationScale<quint8>(min_input, max_input) *
+        QuantizationScale<T2>(min_filter, max_filter);
+    EXPECT_FLOAT_EQ(scale_output * -2147483648.0,
+                    GetOutput(1)->scalar<float>()());
+    const int64 zero_input =
+        FloatToQuantizedUnclamped<quint8>(0.0f, min_input, max_input);
+    const int64 zero_filter =
+        FloatToQuantizedUnclamped<T2>(0.0f, min_filter, max_filter);
+    auto out = output.tensor<qint32, 4>();
+    for (int b = 0; b < batch; ++b) {
+      for (int y = 0; y < out_rows; ++y) {
+        for (int x = 0; x < out_cols; ++x) {
+          for (int od = 0; od < out_depth; ++od) {
+            int64 expected = 0;
+            for (int fy = 0; fy < filter_rows; ++fy) {
+              for (int fx = 0; fx < filter_cols; ++fx) {
+                const int in_y = y * stride - pad_rows + fy;
+                const int in_x = x * stride - pad_cols + fx;
+                if (in_y < 0 || in_y >= rows || in_x < 0 || in_x >= cols) {
+                  continue;
+                }
+                for (int id = 0; id < in_depth; ++id) {
+                  const int64 v =
+                      input[((b * rows + in_y) * cols + in_x) * in_depth + id]
+                          .value;
+                  const int64 f =
+                      filter[((fy * filter_cols + fx) * in_depth + id) *
+                                 out_depth +
+                             od]
+                          .value;
+                  expected += (v - zero_input) * (f - zero_filter);
+                }
+              }
+            }
+            ASSERT_EQ(expected, out(b, y, x, od).value)
+                << b << ", " << y << ", " << x << ", " << od;
+          }
+        }
+      }
+    }
+  }
+};
+
+TEST_F(QuantizedConv2DTest, Valid) {
+  RunRandom<quint8>(2, 7, 9, 5, 3, 3, 4, 1, VALID);
+}
+
+TEST_F(QuantizedConv2DTest, Same) {
+  RunRandom<quint8>(2, 7, 9, 5, 3, 3, 4, 1, SAME);
+}
+
+TEST_F(QuantizedConv2DTest, SameStride2) {
+  RunRandom<quint8>(1, 10, 11, 3, 5, 4, 7, 2, SAME);
+}
+
+// More output pixels than are packed at a time, and a depth that is not a
+// multiple of the packing alignment.
+TEST_F(QuantizedConv2DTest, ManyPixels) {
+  RunRandom<qint8>(3, 16, 15, 19, 3, 3, 9, 1, SAME);
+}
+
+TEST_F(QuantizedConv2DTest, OneByOne) {
+  RunRandom<qint8>(1, 4, 4, 33, 1, 1, 6, 1, VALID);
+}
+
+TEST_F(QuantizedConv2DTest, TooDeep) {
+  // A 3x3 filter over enough channels that the products of 255 * 255 summed
+  // for one output overflow int32.
+  const int64 in_depth = quantized_gemm::kMaxDepth / 9 + 1;
+  TF_ASSERT_OK(NodeDefBuilder("quantized_conv_op", "QuantizedConv2D")
+                   .Input(FakeInput(DT_QUINT8))
+                   .Input(FakeInput(DT_QUINT8))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("strides", {1, 1, 1, 1})
+                   .Attr("padding", "VALID")
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<quint8>(TensorShape({1, 3, 3, in_depth}),
+                            std::vector<quint8>(9 * in_depth, quint8(255)));
+  AddInputFromArray<quint8>(TensorShape({3, 3, in_depth, 1}),
+                            std::vector<quint8>(9 * in_depth, quint8(255)));
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  EXPECT_FALSE(RunOpKernel().ok());
+}
+
+// Benchmarks QuantizedConv2D of a quint8 image with a quint8 filter against
+// Conv2D of the same shapes in float.
+static Graph* QuantizedConv2D(int batch, int rows, int cols, int in_depth,
+                              int filter_size, int out_depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(DT_QUINT8, TensorShape({batch, rows, cols, in_depth}));
+  input.flat<quint8>() = input.flat<quint8>().constant(quint8(100));
+  Tensor filter(DT_QUINT8,
+                TensorShape({filter_size, filter_size, in_depth, out_depth}));
+  filter.flat<quint8>() = filter.flat<quint8>().constant(quint8(140));
+  Tensor min_range(DT_FLOAT, TensorShape({}));
+  min_range.scalar<float>()() = -1;
+  Tensor max_range(DT_FLOAT, TensorShape({}));
+  max_range.scalar<float>()() = 1;
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "QuantizedConv2D")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, filter))
+                  .Input(test::graph::Constant(g, min_range))
+                  .Input(test::graph::Constant(g, max_range))
+                  .Input(test::graph::Constant(g, min_range))
+                  .Input(test::graph::Constant(g, max_range))
+                  .Attr("strides", {1, 1, 1, 1})
+                  .Attr("padding", "SAME")
+                  .Finalize(g, &ret));
+  return g;
+}
+
+static Graph* FloatConv2D(int batch, int rows, int cols, int in_depth,
+                          int filter_size, int out_depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(DT_FLOAT, TensorShape({batch, rows, cols, in_depth}));
+  input.flat<float>().setRandom();
+  Tensor filter(DT_FLOAT,
+                TensorShape({filter_size, filter_size, in_depth, out_depth}));
+  filter.flat<float>().setRandom();
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Conv2D")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, filter))
+                  .Attr("T", DT_FLOAT)
+                  .Attr("strides", {1, 1, 1, 1})
+                  .Attr("padding", "SAME")
+                  .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_QuantizedConv2DDev(B, R, C, ID, FS, OD, KIND)                  \
+  static void BM_##KIND##Conv2D_##B##_##R##_##C##_##ID##_##FS##_##OD(     \
+      int iters) {                                                        \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B * R * C * ID *  \
+                            FS * FS * OD * 2);                            \
+    test::Benchmark("cpu", KIND##Conv2D(B, R, C, ID, FS, OD)).Run(iters); \
+  }                                                                       \
+  BENCHMARK(BM_##KIND##Conv2D_##B##_##R##_##C##_##ID##_##FS##_##OD);
+
+#define BM_QuantizedConv2D(B, R, C, ID, FS, OD)          \
+  BM_QuantizedConv2DDev(B, R, C, ID, FS, OD, Quantized); \
+  BM_QuantizedConv2DDev(B, R, C, ID, FS, OD, Float);
+
+// Layers of an Inception-style network at batch 1.
+BM_QuantizedConv2D(1, 56, 56, 64, 3, 192);
+BM_QuantizedConv2D(1, 28, 28, 192, 1, 64);
+BM_QuantizedConv2D(1, 28, 28, 96, 3, 128);
+BM_QuantizedConv2D(1, 14, 14, 480, 1, 192);
+
+}  // namespace tensorflow
@@ -0,0 +1,245 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_QUANTIZED_GEMM_H_
+#define TENSORFLOW_KERNELS_QUANTIZED_GEMM_H_
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace quantized_gemm {
+
+// The packed rows are padded with zeros to a multiple of this many values,
+// one AVX2 register of int16.
+const int kDepthAlignment = 16;
+
+// The largest depth for which the int32 dot products cannot overflow: the
+// 8-bit values minus their zero points are at most 255 in magnitude, so
+// each product is at most 255^2.
+const int64 kMaxDepth = 2147483647LL / (255 * 255);
+
+// Number of columns of the result computed together, sharing the loads of
+// a row of the left-hand side.
+const int kColumnBlock = 4;
+
+// Returns the dot products of "a" with "b0" .. "b3", all of "depth" int16
+// values, "depth" being a multiple of kDepthAlignment.
+inline void Dot4(const int16* a, const int16* b0, const int16* b1,
+                 const int16* b2, const int16* b3, int64 depth, int32* out) {
+#if defined(__AVX2__)
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+  __m256i acc2 = _mm256_setzero_si256();
+  __m256i acc3 = _mm256_setzero_si256();
+  for (int64 d = 0; d < depth; d += 16) {
+    const __m256i va =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + d));
+    const __m256i vb0 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b0 + d));
+    acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(va, vb0));
+    const __m256i vb1 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b1 + d));
+    acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(va, vb1));
+    const __m256i vb2 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b2 + d));
+    acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(va, vb2));
+    const __m256i vb3 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b3 + d));
+    acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(va, vb3));
+  }
+  // Sums the lanes of each accumulator into one int32.
+  const __m256i s01 = _mm256_hadd_epi32(acc0, acc1);
+  const __m256i s23 = _mm256_hadd_epi32(acc2, acc3);
+  const __m256i s = _mm256_hadd_epi32(s01, s23);
+  const __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(s),
+                                    _mm256_extracti128_si256(s, 1));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), sum);
+#elif defined(__SSE2__)
+  __m128i acc0 = _mm_setzero_si128();
+  __m128i acc1 = _mm_setzero_si128();
+  __m128i acc2 = _mm_setzero_si128();
+  __m128i acc3 = _mm_setzero_si128();
+  for (int64 d = 0; d < depth; d += 8) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + d));
+    const __m128i vb0 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(b0 + d));
+    acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(va, vb0));
+    const __m128i vb1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(b1 + d));
+    acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(va, vb1));
+    const __m128i vb2 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(b2 + d));
+    acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(va, vb2));
+    const __m128i vb3 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(b3 + d));
+    acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(va, vb3));
+  }
+  // Transposes the four accumulators and adds them up, leaving the sum of
+  // acc<j> in lane j.
+  const __m128i t0 = _mm_unpacklo_epi32(acc0, acc1);
+  const __m128i t1 = _mm_unpackhi_epi32(acc0, acc1);
+  const __m128i t2 = _mm_unpacklo_epi32(acc2, acc3);
+  const __m128i t3 = _mm_unpackhi_epi32(acc2, acc3);
+  const __m128i sum = _mm_add_epi32(
+      _mm_add_epi32(_mm_unpacklo_epi64(t0, t2), _mm_unpackhi_epi64(t0, t2)),
+      _mm_add_epi32(_mm_unpacklo_epi64(t1, t3), _mm_unpackhi_epi64(t1, t3)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), sum);
+#else
+  int32 s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  for (int64 d = 0; d < depth; ++d) {
+    const int32 va = a[d];
+    s0 += va * b0[d];
+    s1 += va * b1[d];
+    s2 += va * b2[d];
+    s3 += va * b3[d];
+  }
+  out[0] = s0;
+  out[1] = s1;
+  out[2] = s2;
+  out[3] = s3;
+#endif
+}
+
+// Returns the number of int16s a packed row of "depth" values takes.
+inline int64 PackedDepth(int64 depth) {
+  return (depth + kDepthAlignment - 1) / kDepthAlignment * kDepthAlignment;
+}
+
+// Widens rows [start, limit) of the [rows, depth] matrix "src", or of the
+// transpose of the [depth, rows] matrix "src" if "transposed", to int16
+// minus "offset", at a stride of "packed_depth" in "packed".
+template <class T>
+void PackRows(const T* src, bool transposed, int64 rows, int64 depth,
+              int32 offset, int64 start, int64 limit, int64 packed_depth,
+              int16* packed) {
+  if (!transposed) {
+    for (int64 i = start; i < limit; ++i) {
+      const T* in = src + i * depth;
+      int16* out = packed + i * packed_depth;
+      for (int64 d = 0; d < depth; ++d) out[d] = in[d].value - offset;
+    }
+  } else {
+    // Reads "src" in order and writes to limit - start rows at a time.
+    for (int64 d = 0; d < depth; ++d) {
+      const T* in = src + d * rows;
+      for (int64 i = start; i < limit; ++i) {
+        packed[i * packed_depth + d] = in[i].value - offset;
+      }
+    }
+  }
+}
+
+// Returns the number of columns PackRows writes for a matrix with "n"
+// columns, padded with zero vectors to a multiple of kColumnBlock.
+inline int64 PackedColumns(int64 n) {
+  return (n + kColumnBlock - 1) / kColumnBlock * kColumnBlock;
+}
+
+// Sets the [rows, n] matrix "c" to the products of the packed rows in
+// "packed_a" with the PackedColumns(n) packed columns in "packed_b".
+inline void MultiplyPacked(const int16* packed_a, int64 rows,
+                           const int16* packed_b, int64 n, int64 packed_depth,
+                           qint32* c) {
+  // Columns are taken in blocks whose packed vectors fit in L2 together,
+  // so that they stay in cache across the rows.
+  const int64 kL2Bytes = 256 * 1024;
+  const int64 packed_n = PackedColumns(n);
+  const int64 columns_per_block = std::max<int64>(
+      kColumnBlock,
+      kL2Bytes / (packed_depth * sizeof(int16)) / kColumnBlock * kColumnBlock);
+  int32 dots[kColumnBlock];
+  for (int64 j0 = 0; j0 < packed_n; j0 += columns_per_block) {
+    const int64 j1 = std::min(packed_n, j0 + columns_per_block);
+    for (int64 i = 0; i < rows; ++i) {
+      const int16* row = packed_a + i * packed_depth;
+      qint32* out = c + i * n;
+      for (int64 j = j0; j < j1; j += kColumnBlock) {
+        const int16* col = packed_b + j * packed_depth;
+        Dot4(row, col, col + packed_depth, col + 2 * packed_depth,
+             col + 3 * packed_depth, packed_depth, dots);
+        const int64 num_columns = std::min<int64>(kColumnBlock, n - j);
+        for (int64 jj = 0; jj < num_columns; ++jj) out[j + jj] = dots[jj];
+      }
+    }
+  }
+}
+
+}  // namespace quantized_gemm
+
+// Computes c = (a - offset_a) * (b - offset_b) in int32, where "a" is
+// [m, depth] (or [depth, m] if "transpose_a") and "b" is [depth, n] (or
+// [n, depth] if "transpose_b"), all row-major, and "c" is [m, n].  The
+// offsets are the quantized values of 0, so the result holds the products
+// of the represented values in units of the product of the two scales.
+//
+// Both operands are first widened to int16 with the offsets subtracted, "a"
+// row by row and "b" column by column, so that every output is a dot
+// product of two contiguous vectors computed with pmaddwd (8 products per
+// instruction with SSE2, 16 with AVX2).  The int32 accumulators cannot
+// overflow for depth up to quantized_gemm::kMaxDepth, which callers must
+// check.  Rows of "c" are spread over "worker_threads".
+template <class T1, class T2>
+void QuantizedGemm(const DeviceBase::CpuWorkerThreads& worker_threads,
+                   bool transpose_a, bool transpose_b, int64 m, int64 n,
+                   int64 depth, const T1* a, int32 offset_a, const T2* b,
+                   int32 offset_b, qint32* c) {
+  if (depth == 0) {
+    std::fill(c, c + m * n, qint32(0));
+    return;
+  }
+  const int64 packed_depth = quantized_gemm::PackedDepth(depth);
+  std::vector<int16> packed_a(m * packed_depth, 0);
+  std::vector<int16> packed_b(
+      quantized_gemm::PackedColumns(n) * packed_depth, 0);
+
+  const int num_threads = worker_threads.num_threads;
+  thread::ThreadPool* workers = worker_threads.workers;
+  Shard(num_threads, workers, m, depth,
+        [&packed_a, transpose_a, m, depth, a, offset_a, packed_depth](
+            int64 start, int64 limit) {
+          quantized_gemm::PackRows(a, transpose_a, m, depth, offset_a, start,
+                                   limit, packed_depth, packed_a.data());
+        });
+  Shard(num_threads, workers, n, depth,
+        [&packed_b, transpose_b, n, depth, b, offset_b, packed_depth](
+            int64 start, int64 limit) {
+          quantized_gemm::PackRows(b, !transpose_b, n, depth, offset_b, start,
+                                   limit, packed_depth, packed_b.data());
+        });
+
+  Shard(num_threads, workers, m, std::max<int64>(1, n * depth / 8),
+        [&packed_a, &packed_b, packed_depth, n, c](int64 start, int64 limit) {
+          quantized_gemm::MultiplyPacked(&packed_a[start * packed_depth],
+                                         limit - start, packed_b.data(), n,
+                                         packed_depth, c + start * n);
+        });
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_QUANTIZED_GEMM_H_
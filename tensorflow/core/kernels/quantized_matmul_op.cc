@@ -0,0 +1,106 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/kernels/quantized_gemm.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+template <class T1, class T2>
+class QuantizedMatMulOp : public OpKernel {
+ public:
+  explicit QuantizedMatMulOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("transpose_a", &transpose_a_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("transpose_b", &transpose_b_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& a = ctx->input(0);
+    const Tensor& b = ctx->input(1);
+    float min_a, max_a, min_b, max_b;
+    OP_REQUIRES_OK(ctx, GetQuantizationRange(ctx, 2, &min_a, &max_a));
+    OP_REQUIRES_OK(ctx, GetQuantizationRange(ctx, 4, &min_b, &max_b));
+    OP_REQUIRES_OK(ctx, CheckRangeIncludesZero(min_a, max_a));
+    OP_REQUIRES_OK(ctx, CheckRangeIncludesZero(min_b, max_b));
+
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(a.shape()),
+                errors::InvalidArgument("In[0] is not a matrix"));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(b.shape()),
+                errors::InvalidArgument("In[1] is not a matrix"));
+    const int64 m = a.dim_size(transpose_a_ ? 1 : 0);
+    const int64 depth = a.dim_size(transpose_a_ ? 0 : 1);
+    const int64 n = b.dim_size(transpose_b_ ? 0 : 1);
+    OP_REQUIRES(ctx, depth == b.dim_size(transpose_b_ ? 1 : 0),
+                errors::InvalidArgument("Matrix size-compatible: In[0]: ",
+                                        a.shape().DebugString(), ", In[1]: ",
+                                        b.shape().DebugString()));
+    OP_REQUIRES(ctx, depth <= quantized_gemm::kMaxDepth,
+                errors::InvalidArgument(
+                    "Inner dimension ", depth, " of the matrices exceeds ",
+                    quantized_gemm::kMaxDepth,
+                    ", above which the int32 result may overflow"));
+
+    Tensor* c = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({m, n}), &c));
+    Tensor* min_c_tensor = nullptr;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(1, TensorShape({}), &min_c_tensor));
+    Tensor* max_c_tensor = nullptr;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(2, TensorShape({}), &max_c_tensor));
+
+    // The products are taken of the values minus the quantized zeros, so
+    // that each unit of the result is one step of a times one step of b.
+    const int32 offset_a = FloatToQuantizedUnclamped<T1>(0.0f, min_a, max_a);
+    const int32 offset_b = FloatToQuantizedUnclamped<T2>(0.0f, min_b, max_b);
+    QuantizedGemm<T1, T2>(*ctx->device()->tensorflow_cpu_worker_threads(),
+                          transpose_a_, transpose_b_, m, n, depth,
+                          a.flat<T1>().data(), offset_a, b.flat<T2>().data(),
+                          offset_b, c->flat<qint32>().data());
+
+    float min_c, max_c;
+    QuantizationRangeForMultiplication<T1, T2, qint32>(min_a, max_a, min_b,
+                                                       max_b, &min_c, &max_c);
+    min_c_tensor->flat<float>()(0) = min_c;
+    max_c_tensor->flat<float>()(0) = max_c;
+  }
+
+ private:
+  bool transpose_a_;
+  bool transpose_b_;
+};
+
+#define REGISTER_QUANTIZED_MATMUL(T1, T2)                \
+  REGISTER_KERNEL_BUILDER(Name("QuantizedMatMul")        \
+                              .Device(DEVICE_CPU)        \
+                              .TypeConstraint<T1>("T1")  \
+                              .TypeConstraint<T2>("T2"), \
+                          QuantizedMatMulOp<T1, T2>)
+
+REGISTER_QUANTIZED_MATMUL(quint8, quint8);
+REGISTER_QUANTIZED_MATMUL(quint8, qint8);
+REGISTER_QUANTIZED_MATMUL(qint8, quint8);
+REGISTER_QUANTIZED_MATMUL(qint8, qint8);
+#undef REGISTER_QUANTIZED_MATMUL
+
+}  // namespace tensorflow
@@ -0,0 +1,241 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/kernels/quantized_gemm.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+
+class QuantizedMatMulTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType type_a, DataType type_b, bool transpose_a,
+              bool transpose_b) {
+    TF_ASSERT_OK(NodeDefBuilder("quantized_mat_mul_op", "QuantizedMatMul")
+                     .Input(FakeInput(type_a))
+                     .Input(FakeInput(type_b))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("transpose_a", transpose_a)
+                     .Attr("transpose_b", transpose_b)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Multiplies random matrices quantized over the given ranges and checks
+  // the result against the product of the values with their zero points
+  // subtracted, which the kernel computes exactly.
+  template <class T1, class T2>
+  void RunRandom(int64 m, int64 k, int64 n, bool transpose_a,
+                 bool transpose_b, float min_a, float max_a, float min_b,
+                 float max_b) {
+    MakeOp(DataTypeToEnum<T1>::v(), DataTypeToEnum<T2>::v(), transpose_a,
+           transpose_b);
+    random::PhiloxRandom philox(301, 17);
+    random::SimplePhilox rnd(&philox);
+    std::vector<T1> a(m * k);
+    for (T1& v : a) v = static_cast<T1>(static_cast<int32>(rnd.Uniform(256)) +
+                                        Eigen::NumTraits<T1>::lowest());
+    std::vector<T2> b(k * n);
+    for (T2& v : b) v = static_cast<T2>(static_cast<int32>(rnd.Uniform(256)) +
+                                        Eigen::NumTraits<T2>::lowest());
+    AddInputFromArray<T1>(
+        transpose_a ? TensorShape({k, m}) : TensorShape({m, k}), a);
+    AddInputFromArray<T2>(
+        transpose_b ? TensorShape({n, k}) : TensorShape({k, n}), b);
+    AddInputFromArray<float>(TensorShape({}), {min_a});
+    AddInputFromArray<float>(TensorShape({}), {max_a});
+    AddInputFromArray<float>(TensorShape({}), {min_b});
+    AddInputFromArray<float>(TensorShape({}), {max_b});
+    TF_ASSERT_OK(RunOpKernel());
+
+    const Tensor& c = *GetOutput(0);
+    ASSERT_EQ(TensorShape({m, n}), c.shape());
+    const double scale_c = QuantizationScale<T1>(min_a, max_a) *
+                           QuantizationScale<T2>(min_b, max_b);
+    EXPECT_FLOAT_EQ(scale_c * 2147483647.0, GetOutput(2)->scalar<float>()());
+    const int64 zero_a = FloatToQuantizedUnclamped<T1>(0.0f, min_a, max_a);
+    const int64 zero_b = FloatToQuantizedUnclamped<T2>(0.0f, min_b, max_b);
+    for (int64 i = 0; i < m; ++i) {
+      for (int64 j = 0; j < n; ++j) {
+        int64 expected = 0;
+        for (int64 l = 0; l < k; ++l) {
+          const int64 va = (transpose_a ? a[l * m + i] : a[i * k + l]).value;
+          const int64 vb = (transpose_b ? b[j * k + l] : b[l * n + j]).value;
+          expected += (va - zero_a) * (vb - zero_b);
+        }
+        ASSERT_EQ(expected, c.matrix<qint32>()(i, j).value) << i << ", " << j;
+      }
+    }
+  }
+};
+
+// With a step of 1 and 0 at the lowest value, the result is the integer
+// product.
+TEST_F(QuantizedMatMulTest, Small) {
+  MakeOp(DT_QUINT8, DT_QUINT8, false, false);
+  AddInputFromArray<quint8>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<quint8>(TensorShape({3, 2}), {7, 8, 9, 10, 11, 12});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {255});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {255});
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_QINT32, TensorShape({2, 2}));
+  test::FillValues<qint32>(&expected, {58, 64, 139, 154});
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(expected.flat<qint32>()(i).value,
+              GetOutput(0)->flat<qint32>()(i).value);
+  }
+  EXPECT_NEAR(-2147483648.0f, GetOutput(1)->scalar<float>()(), 1e3);
+  EXPECT_NEAR(2147483647.0f, GetOutput(2)->scalar<float>()(), 1e3);
+}
+
+TEST_F(QuantizedMatMulTest, RandomQuint8) {
+  RunRandom<quint8, quint8>(37, 53, 29, false, false, -1, 3, -2, 2);
+}
+
+TEST_F(QuantizedMatMulTest, RandomQuint8Qint8) {
+  RunRandom<quint8, qint8>(31, 100, 17, false, false, 0, 6, -0.5, 0.5);
+}
+
+TEST_F(QuantizedMatMulTest, RandomQint8Quint8) {
+  RunRandom<qint8, quint8>(5, 16, 8, false, false, -4, 4, -1, 0);
+}
+
+TEST_F(QuantizedMatMulTest, RandomQint8) {
+  RunRandom<qint8, qint8>(16, 17, 19, false, false, -3, 1, -1, 1);
+}
+
+TEST_F(QuantizedMatMulTest, TransposeA) {
+  RunRandom<quint8, quint8>(13, 40, 22, true, false, -1, 3, -2, 2);
+}
+
+TEST_F(QuantizedMatMulTest, TransposeB) {
+  RunRandom<quint8, quint8>(13, 40, 22, false, true, -1, 3, -2, 2);
+}
+
+TEST_F(QuantizedMatMulTest, TransposeBoth) {
+  RunRandom<quint8, quint8>(13, 40, 22, true, true, -1, 3, -2, 2);
+}
+
+TEST_F(QuantizedMatMulTest, EmptyDepth) {
+  MakeOp(DT_QUINT8, DT_QUINT8, false, false);
+  AddInputFromArray<quint8>(TensorShape({2, 0}), {});
+  AddInputFromArray<quint8>(TensorShape({0, 3}), {});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  TF_ASSERT_OK(RunOpKernel());
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(0, GetOutput(0)->flat<qint32>()(i).value);
+  }
+}
+
+TEST_F(QuantizedMatMulTest, RangeWithoutZero) {
+  MakeOp(DT_QUINT8, DT_QUINT8, false, false);
+  AddInputFromArray<quint8>(TensorShape({1, 1}), {1});
+  AddInputFromArray<quint8>(TensorShape({1, 1}), {1});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  AddInputFromArray<float>(TensorShape({}), {2});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  EXPECT_FALSE(RunOpKernel().ok());
+}
+
+TEST_F(QuantizedMatMulTest, TooDeep) {
+  // One more product of 255 * 255 than the int32 result can hold.
+  const int64 depth = quantized_gemm::kMaxDepth + 1;
+  MakeOp(DT_QUINT8, DT_QUINT8, false, false);
+  AddInputFromArray<quint8>(TensorShape({1, depth}),
+                            std::vector<quint8>(depth, quint8(255)));
+  AddInputFromArray<quint8>(TensorShape({depth, 1}),
+                            std::vector<quint8>(depth, quint8(255)));
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  EXPECT_FALSE(RunOpKernel().ok());
+}
+
+// Benchmarks QuantizedMatMul of two quint8 matrices against MatMul of the
+// same shapes in float.
+static Graph* QuantizedMatmul(int m, int k, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor a(DT_QUINT8, TensorShape({m, k}));
+  a.flat<quint8>() = a.flat<quint8>().constant(quint8(128));
+  Tensor b(DT_QUINT8, TensorShape({k, n}));
+  b.flat<quint8>() = b.flat<quint8>().constant(quint8(130));
+  Tensor min_range(DT_FLOAT, TensorShape({}));
+  min_range.scalar<float>()() = -1;
+  Tensor max_range(DT_FLOAT, TensorShape({}));
+  max_range.scalar<float>()() = 1;
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "QuantizedMatMul")
+                  .Input(test::graph::Constant(g, a))
+                  .Input(test::graph::Constant(g, b))
+                  .Input(test::graph::Constant(g, min_range))
+                  .Input(test::graph::Constant(g, max_range))
+                  .Input(test::graph::Constant(g, min_range))
+                  .Input(test::graph::Constant(g, max_range))
+                  .Finalize(g, &ret));
+  return g;
+}
+
+static Graph* FloatMatmul(int m, int k, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor a(DT_FLOAT, TensorShape({m, k}));
+  a.flat<float>().setRandom();
+  Tensor b(DT_FLOAT, TensorShape({k, n}));
+  b.flat<float>().setRandom();
+  test::graph::Matmul(g, test::graph::Constant(g, a),
+                      test::graph::Constant(g, b), false, false);
+  return g;
+}
+
+#define BM_QuantizedMatmulDev(M, K, N, KIND)                            \
+  static void BM_##KIND##Matmul##_##M##_##K##_##N(int iters) {          \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2); \
+    test::Benchmark("cpu", KIND##Matmul(M, K, N)).Run(iters);           \
+  }                                                                     \
+  BENCHMARK(BM_##KIND##Matmul##_##M##_##K##_##N);
+
+#define BM_QuantizedMatmul(M, K, N)          \
+  BM_QuantizedMatmulDev(M, K, N, Quantized); \
+  BM_QuantizedMatmulDev(M, K, N, Float);
+
+BM_QuantizedMatmul(16, 1024, 1024);
+BM_QuantizedMatmul(128, 1024, 1024);
+BM_QuantizedMatmul(512, 512, 512);
+BM_QuantizedMatmul(1024, 1024, 1024);
+
+}  // namespace tensorflow
@@ -0,0 +1,135 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/padding.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+// Max pooling commutes with the quantization, which is monotonic, so the
+// raw values are pooled and the range is passed through.  Padding is
+// ignored, as in MaxPool.
+template <class T>
+class QuantizedMaxPoolOp : public OpKernel {
+ public:
+  explicit QuantizedMaxPoolOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("ksize", &ksize_));
+    OP_REQUIRES(ctx, ksize_.size() == 4,
+                errors::InvalidArgument("Sliding window ksize field must "
+                                        "specify 4 dimensions"));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("strides", &strides_));
+    OP_REQUIRES(ctx, strides_.size() == 4,
+                errors::InvalidArgument("Sliding window stride field must "
+                                        "specify 4 dimensions"));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("padding", &padding_));
+    OP_REQUIRES(ctx, ksize_[0] == 1 && strides_[0] == 1 && ksize_[3] == 1 &&
+                         strides_[3] == 1,
+                errors::Unimplemented(
+                    "Pooling is only supported on the spatial dimensions."));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& input = ctx->input(0);
+    float min_input, max_input;
+    OP_REQUIRES_OK(ctx, GetQuantizationRange(ctx, 1, &min_input, &max_input));
+    OP_REQUIRES(ctx, input.dims() == 4,
+                errors::InvalidArgument("input must be 4-dimensional: ",
+                                        input.shape().DebugString()));
+    const int64 batch = input.dim_size(0);
+    const int64 in_rows = input.dim_size(1);
+    const int64 in_cols = input.dim_size(2);
+    const int64 depth = input.dim_size(3);
+    const int window_rows = ksize_[1];
+    const int window_cols = ksize_[2];
+    const int stride_rows = strides_[1];
+    const int stride_cols = strides_[2];
+    int out_rows = 0, out_cols = 0, pad_rows = 0, pad_cols = 0;
+    OP_REQUIRES_OK(ctx,
+                   Get2dOutputSize(in_rows, in_cols, window_rows, window_cols,
+                                   stride_rows, stride_cols, padding_,
+                                   &out_rows, &out_cols, &pad_rows, &pad_cols));
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_output(
+                 0, TensorShape({batch, out_rows, out_cols, depth}), &output));
+    Tensor* min_output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(1, TensorShape({}), &min_output));
+    Tensor* max_output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({}), &max_output));
+    min_output->flat<float>()(0) = min_input;
+    max_output->flat<float>()(0) = max_input;
+
+    typedef typename QuantizedRawType<T>::type Raw;
+    const Raw* in = reinterpret_cast<const Raw*>(input.flat<T>().data());
+    Raw* out = reinterpret_cast<Raw*>(output->flat<T>().data());
+    auto pool_pixels = [&, in, out](int64 start, int64 limit) {
+      for (int64 p = start; p < limit; ++p) {
+        const int64 b = p / (out_rows * out_cols);
+        const int64 out_y = p / out_cols % out_rows;
+        const int64 out_x = p % out_cols;
+        const int64 y_origin = out_y * stride_rows - pad_rows;
+        const int64 x_origin = out_x * stride_cols - pad_cols;
+        const int64 y_start = std::max<int64>(0, y_origin);
+        const int64 y_end = std::min<int64>(in_rows, y_origin + window_rows);
+        const int64 x_start = std::max<int64>(0, x_origin);
+        const int64 x_end = std::min<int64>(in_cols, x_origin + window_cols);
+        Raw* dst = out + p * depth;
+        std::fill(dst, dst + depth, std::numeric_limits<Raw>::lowest());
+        for (int64 y = y_start; y < y_end; ++y) {
+          for (int64 x = x_start; x < x_end; ++x) {
+            const Raw* src = in + ((b * in_rows + y) * in_cols + x) * depth;
+            for (int64 d = 0; d < depth; ++d) {
+              dst[d] = std::max(dst[d], src[d]);
+            }
+          }
+        }
+      }
+    };
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          batch * out_rows * out_cols, window_rows * window_cols * depth,
+          pool_pixels);
+  }
+
+ private:
+  std::vector<int32> ksize_;
+  std::vector<int32> strides_;
+  Padding padding_;
+};
+
+#define REGISTER_QUANTIZED_MAX_POOL(T)                                    \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("QuantizedMaxPool").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      QuantizedMaxPoolOp<T>)
+
+REGISTER_QUANTIZED_MAX_POOL(quint8);
+REGISTER_QUANTIZED_MAX_POOL(qint8);
+#undef REGISTER_QUANTIZED_MAX_POOL
+
+}  // namespace tensorflow
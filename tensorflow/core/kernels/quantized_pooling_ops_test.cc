@@ -0,0 +1,85 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class QuantizedMaxPoolTest : public OpsTestBase {
+ protected:
+  void MakeOp(int ksize, int stride, const string& padding) {
+    TF_ASSERT_OK(NodeDefBuilder("quantized_max_pool_op", "QuantizedMaxPool")
+                     .Input(FakeInput(DT_QUINT8))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("ksize", {1, ksize, ksize, 1})
+                     .Attr("strides", {1, stride, stride, 1})
+                     .Attr("padding", padding)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void ExpectOutput(const TensorShape& shape,
+                    const std::vector<int>& expected) {
+    const Tensor& output = *GetOutput(0);
+    ASSERT_EQ(shape, output.shape());
+    for (int i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(expected[i], output.flat<quint8>()(i).value) << i;
+    }
+    EXPECT_EQ(-1, GetOutput(1)->scalar<float>()());
+    EXPECT_EQ(1, GetOutput(2)->scalar<float>()());
+  }
+
+  void AddImage() {
+    // One 4x4 image with 2 channels, the second the negative of the first.
+    std::vector<quint8> image;
+    for (int i = 0; i < 16; ++i) {
+      image.push_back(static_cast<quint8>(i * 10));
+      image.push_back(static_cast<quint8>(255 - i * 10));
+    }
+    AddInputFromArray<quint8>(TensorShape({1, 4, 4, 2}), image);
+    AddInputFromArray<float>(TensorShape({}), {-1});
+    AddInputFromArray<float>(TensorShape({}), {1});
+  }
+};
+
+TEST_F(QuantizedMaxPoolTest, Valid) {
+  MakeOp(2, 2, "VALID");
+  AddImage();
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectOutput(TensorShape({1, 2, 2, 2}),
+               {50, 255, 70, 235, 130, 175, 150, 155});
+}
+
+// Padding is not part of the windows.
+TEST_F(QuantizedMaxPoolTest, Same) {
+  MakeOp(3, 2, "SAME");
+  AddImage();
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectOutput(TensorShape({1, 2, 2, 2}),
+               {100, 255, 110, 235, 140, 175, 150, 155});
+}
+
+}  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/io/readahead_file.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 
@@ -29,6 +30,24 @@ namespace tensorflow {
 
 ReaderBase::ReaderBase(const string& name) : name_(name) {}
 
+void ReaderBase::SetReadahead(int num_buffers, int64 buffer_bytes) {
+  mutex_lock lock(mu_);
+  readahead_buffers_ = num_buffers;
+  readahead_buffer_bytes_ = buffer_bytes;
+}
+
+Status ReaderBase::NewRandomAccessFile(Env* env, const string& fname,
+                                       RandomAccessFile** result) const {
+  RandomAccessFile* file = nullptr;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(fname, &file));
+  if (readahead_buffers_ > 0) {
+    file = new io::ReadaheadFile(env, file, readahead_buffers_,
+                                 readahead_buffer_bytes_);
+  }
+  *result = file;
+  return Status::OK();
+}
+
 int64 ReaderBase::NumRecordsProduced() {
   mutex_lock lock(mu_);
   return num_records_produced_;
@@ -142,6 +161,21 @@ void ReaderBase::GetNextWorkLocked(QueueInterface* queue,
   n.WaitForNotification();
 }
 
+Status GetReadaheadAttrs(OpKernelConstruction* context, int* num_buffers,
+                         int64* buffer_bytes) {
+  TF_RETURN_IF_ERROR(context->GetAttr("readahead_buffers", num_buffers));
+  TF_RETURN_IF_ERROR(context->GetAttr("readahead_buffer_bytes", buffer_bytes));
+  if (*num_buffers < 0) {
+    return errors::InvalidArgument("readahead_buffers must be >= 0 not ",
+                                   *num_buffers);
+  }
+  if (*buffer_bytes <= 0) {
+    return errors::InvalidArgument("readahead_buffer_bytes must be > 0 not ",
+                                   *buffer_bytes);
+  }
+  return Status::OK();
+}
+
 void ReaderBase::SaveBaseState(ReaderBaseState* state) const {
   state->Clear();
   state->set_work_started(work_started_);
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/framework/reader_interface.h"
 #include "tensorflow/core/kernels/reader_base.pb.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 
@@ -32,6 +33,14 @@ class ReaderBase : public ReaderInterface {
   // the op and the node.
   explicit ReaderBase(const string& name);
 
+  // Enables readahead for files opened with NewRandomAccessFile(): a
+  // background thread reads each file ahead of ReadLocked() into
+  // "num_buffers" buffers of "buffer_bytes" bytes each, so that
+  // ReadLocked() normally only copies from memory.  num_buffers == 0
+  // (the default) disables readahead.  Must be called before the first
+  // Read().
+  void SetReadahead(int num_buffers, int64 buffer_bytes);
+
   // Note that methods with names ending in "Locked" are called while
   // the ReaderBase's mutex is held.
 
@@ -68,6 +77,13 @@ class ReaderBase : public ReaderInterface {
   virtual Status SerializeStateLocked(string* state);
   virtual Status RestoreStateLocked(const string& state);
 
+  // Helpers ------------------------------------------------------------------
+
+  // Like env->NewRandomAccessFile(), but wraps the file in an
+  // io::ReadaheadFile if readahead is enabled (see SetReadahead()).
+  Status NewRandomAccessFile(Env* env, const string& fname,
+                             RandomAccessFile** result) const;
+
   // Accessors ----------------------------------------------------------------
 
   // Always true during a call to ReadLocked().
@@ -114,8 +130,15 @@ class ReaderBase : public ReaderInterface {
   int64 work_finished_ = 0;
   int64 num_records_produced_ = 0;
   string work_;
+  int readahead_buffers_ = 0;
+  int64 readahead_buffer_bytes_ = 0;
 };
 
+// Reads the "readahead_buffers" and "readahead_buffer_bytes" attrs shared by
+// the file reader ops.
+Status GetReadaheadAttrs(OpKernelConstruction* context, int* num_buffers,
+                         int64* buffer_bytes);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_KERNELS_READER_BASE_H_
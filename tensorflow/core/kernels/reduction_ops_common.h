@@ -244,6 +244,30 @@ struct ReduceFunctor<CPUDevice, Reducer> {
   }
 };
 
+// Sums and means of half are accumulated in float, so that long reductions
+// keep their precision and only the result is rounded to 16 bits.
+template <typename Reducer, typename FloatReducer>
+struct ReduceHalfInFloat {
+  template <typename OUT_T, typename IN_T, typename ReductionAxes>
+  static void Reduce(const CPUDevice& d, OUT_T out, IN_T in,
+                     const ReductionAxes& reduction_axes,
+                     const Reducer& reducer) {
+    out.device(d) = in.template cast<float>()
+                        .reduce(reduction_axes, FloatReducer())
+                        .template cast<Eigen::half>();
+  }
+};
+
+template <>
+struct ReduceFunctor<CPUDevice, Eigen::internal::SumReducer<Eigen::half>>
+    : ReduceHalfInFloat<Eigen::internal::SumReducer<Eigen::half>,
+                        Eigen::internal::SumReducer<float>> {};
+
+template <>
+struct ReduceFunctor<CPUDevice, Eigen::internal::MeanReducer<Eigen::half>>
+    : ReduceHalfInFloat<Eigen::internal::MeanReducer<Eigen::half>,
+                        Eigen::internal::MeanReducer<float>> {};
+
 }  // namespace functor
 }  // namespace tensorflow
 
@@ -22,6 +22,7 @@ namespace tensorflow {
       Name("Mean").Device(DEVICE_CPU).TypeConstraint<type>("T"), \
       ReductionOp<CPUDevice, type, Eigen::internal::MeanReducer<type>>);
 TF_CALL_REAL_NUMBER_TYPES(REGISTER_CPU_KERNELS);
+TF_CALL_half(REGISTER_CPU_KERNELS);
 #undef REGISTER_CPU_KERNELS
 
 #if GOOGLE_CUDA
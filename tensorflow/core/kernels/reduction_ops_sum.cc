@@ -22,6 +22,7 @@ namespace tensorflow {
       Name("Sum").Device(DEVICE_CPU).TypeConstraint<type>("T"), \
       ReductionOp<CPUDevice, type, Eigen::internal::SumReducer<type>>);
 TF_CALL_REAL_NUMBER_TYPES(REGISTER_CPU_KERNELS);
+TF_CALL_half(REGISTER_CPU_KERNELS);
 #undef REGISTER_CPU_KERNELS
 
 // NOTE: We should have mean(complex64,int32), too. But that needs to
@@ -20,12 +20,13 @@ limitations under the License.
 
 namespace tensorflow {
 
-// Creates a Graph which "reduce"s a 3D float tensor of "num" elements
+// Creates a Graph which "reduce"s a 3D tensor of T of "num" elements
 // into a scalar.
+template <typename T = float>
 static Graph* ToScalar(const string& reduce, int num) {
   Graph* g = new Graph(OpRegistry::Global());
-  Tensor data(DT_FLOAT, TensorShape({64, 64, num / (64 * 64)}));
-  data.flat<float>().setRandom();
+  Tensor data(DataTypeToEnum<T>::value, TensorShape({64, 64, num / (64 * 64)}));
+  data.flat<T>().setRandom();
   Tensor axes(DT_INT32, TensorShape({3}));
   axes.flat<int32>()(0) = 0;
   axes.flat<int32>()(1) = 1;
@@ -49,6 +50,15 @@ static void BM_Sum3DToScalarCPU(int iters, int num) {
 }
 BENCHMARK(BM_Sum3DToScalarCPU)->Range(1 << 13, 1 << 20);
 
+// Half sums are accumulated in float.
+static void BM_Sum3DToScalarCPUHalf(int iters, int num) {
+  testing::ItemsProcessed(static_cast<int64>(iters) * num);
+  testing::BytesProcessed(static_cast<int64>(iters) * num *
+                          sizeof(Eigen::half));
+  test::Benchmark("cpu", ToScalar<Eigen::half>("Sum", num)).Run(iters);
+}
+BENCHMARK(BM_Sum3DToScalarCPUHalf)->Range(1 << 13, 1 << 20);
+
 static void BM_Max3DToScalarCPU(int iters, int num) {
   ReduceToScalar(iters, "cpu", "Max", num);
 }
@@ -18,6 +18,8 @@ limitations under the License.
 
 #include <algorithm>
 #include <memory>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -27,35 +29,87 @@ limitations under the License.
 #include "tensorflow/core/kernels/image_resizer_state.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
-typedef Eigen::ThreadPoolDevice CPUDevice;
-
-template <typename Device, typename T>
-class ResizeAreaOp : public OpKernel {
- public:
-  explicit ResizeAreaOp(OpKernelConstruction* context) : OpKernel(context) {
-    OP_REQUIRES_OK(context, context->GetAttr("align_corners", &align_corners_));
-  }
+namespace {
 
-  void Compute(OpKernelContext* context) override {
-    const Tensor& input = context->input(0);
-    ImageResizerState st(align_corners_);
-    st.ValidateAndCreateOutput(context, input);
-
-    if (!context->status().ok()) return;
-
-    typename TTypes<T, 4>::ConstTensor input_data = input.tensor<T, 4>();
-    typename TTypes<float, 4>::Tensor output_data =
-        st.output->tensor<float, 4>();
+// The source cells that contribute to each output row or column, and
+// the fraction of each cell that does, computed once per row and column
+// instead of once per pixel.  The cells of output coordinate i are
+// [begin[i], begin[i + 1]) in "offsets" and "weights".
+struct CachedArea {
+  std::vector<int64> begin;
+  std::vector<int64> offsets;  // Source offsets, clamped to the input.
+  std::vector<float> weights;
+};
 
-    // A temporary tensor for computing the sum.
-    Tensor sum_tensor;
-    OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<float>::value,
-                                                   TensorShape({st.channels}),
-                                                   &sum_tensor));
-    typename TTypes<float, 1>::Tensor sum_data = sum_tensor.vec<float>();
+// Returns the cells of "out_size" output coordinates over "in_size"
+// input coordinates, with the source offsets in units of "stride"
+// elements.
+CachedArea ComputeArea(int64 out_size, int64 in_size, float scale,
+                       int64 stride) {
+  CachedArea area;
+  area.begin.reserve(out_size + 1);
+  for (int64 i = 0; i < out_size; ++i) {
+    area.begin.push_back(area.offsets.size());
+    const float in = i * scale;
+    const float in1 = (i + 1) * scale;
+    // The start and end indices of all the cells that could contribute
+    // to the target cell.
+    const int64 start = floor(in);
+    const int64 end = ceil(in1);
+    for (int64 j = start; j < end; ++j) {
+      const float weight =
+          j < in ? j + 1 - in : (j + 1 > in1 ? in1 - j : 1.0);
+      const int64 bounded = std::min<int64>(in_size - 1, std::max<int64>(0, j));
+      area.offsets.push_back(bounded * stride);
+      area.weights.push_back(weight);
+    }
+  }
+  area.begin.push_back(area.offsets.size());
+  return area;
+}
+
+// Computes output row "y" of "image".  kChannels is as passed by
+// DispatchChannels().
+template <int kChannels, typename T>
+void ResizeRow(const T* image, const CachedArea& ys, int64 y,
+               const CachedArea& xs, int64 channels, float scale,
+               float* out) {
+  if (kChannels > 0) channels = kChannels;
+  const int64 out_width = xs.begin.size() - 1;
+  for (int64 x = 0; x < out_width; ++x) {
+    for (int64 c = 0; c < channels; ++c) {
+      out[c] = 0;
+    }
+    for (int64 i = ys.begin[y]; i < ys.begin[y + 1]; ++i) {
+      const T* row = image + ys.offsets[i];
+      const float scale_y = ys.weights[i];
+      for (int64 j = xs.begin[x]; j < xs.begin[x + 1]; ++j) {
+        const T* pixel = row + xs.offsets[j];
+        const float scale_x = xs.weights[j];
+        for (int64 c = 0; c < channels; ++c) {
+          out[c] += pixel[c] * scale_y * scale_x * scale;
+        }
+      }
+    }
+    out += channels;
+  }
+}
+
+// Resizes "input" into "st.output", sharding the output rows of all the
+// images among the CPU worker threads.
+template <int kChannels, typename T>
+struct ResizeImage {
+  void operator()(OpKernelContext* context, const ImageResizerState& st,
+                  const Tensor& input) const {
+    const CachedArea ys =
+        ComputeArea(st.out_height, st.in_height, st.height_scale,
+                    st.in_width * st.channels);
+    const CachedArea xs =
+        ComputeArea(st.out_width, st.in_width, st.width_scale, st.channels);
 
     // When using this algorithm for downsizing, the target pixel value is the
     // weighted average of all the source pixels. The weight is determined by
@@ -76,46 +130,52 @@ class ResizeAreaOp : public OpKernel {
     //   out[0] = (in[0] * 1.0 + in[1] * 1/3) * scale
     //   out[1] = (in[1] * 2/3 + in[2] * 2/3 * scale
     //   out[2] = (in[3] * 1/3 + in[3] * 1.0) * scale
-    float scale = 1.0 / (st.height_scale * st.width_scale);
-    for (int64 b = 0; b < st.batch_size; ++b) {
-      for (int64 y = 0; y < st.out_height; ++y) {
-        const float in_y = y * st.height_scale;
-        const float in_y1 = (y + 1) * st.height_scale;
-        // The start and end height indices of all the cells that could
-        // contribute to the target cell.
-        int64 y_start = floor(in_y);
-        int64 y_end = ceil(in_y1);
-
-        for (int64 x = 0; x < st.out_width; ++x) {
-          const float in_x = x * st.width_scale;
-          const float in_x1 = (x + 1) * st.width_scale;
-          // The start and end width indices of all the cells that could
-          // contribute to the target cell.
-          int64 x_start = floor(in_x);
-          int64 x_end = ceil(in_x1);
-
-          sum_data.setConstant(0.0);
-          for (int64 i = y_start; i < y_end; ++i) {
-            float scale_y =
-                i < in_y ? i + 1 - in_y : (i + 1 > in_y1 ? in_y1 - i : 1.0);
-            for (int64 j = x_start; j < x_end; ++j) {
-              float scale_x =
-                  j < in_x ? j + 1 - in_x : (j + 1 > in_x1 ? in_x1 - j : 1.0);
-              for (int64 c = 0; c < st.channels; ++c) {
-#define BOUND(val, limit) std::min(((limit)-1ll), (std::max(0ll, (val))))
-                sum_data(c) += input_data(b, BOUND(i, st.in_height),
-                                          BOUND(j, st.in_width), c) *
-                               scale_y * scale_x * scale;
-#undef BOUND
-              }
-            }
-          }
-          for (int64 c = 0; c < st.channels; ++c) {
-            output_data(b, y, x, c) = sum_data(c);
-          }
-        }
+    const float scale = 1.0 / (st.height_scale * st.width_scale);
+
+    const T* input_data = input.flat<T>().data();
+    float* output_data = st.output->flat<float>().data();
+    const int64 in_image_size = st.in_height * st.in_width * st.channels;
+    const int64 out_row_size = st.out_width * st.channels;
+    auto work = [&](int64 start, int64 limit) {
+      for (int64 row = start; row < limit; ++row) {
+        const int64 b = row / st.out_height;
+        ResizeRow<kChannels>(input_data + b * in_image_size, ys,
+                             row % st.out_height, xs, st.channels, scale,
+                             output_data + row * out_row_size);
       }
-    }
+    };
+    // Each output value sums the cells of about ys.offsets.size() /
+    // st.out_height input rows and xs.offsets.size() / st.out_width
+    // input columns.
+    const int64 cells_per_value =
+        (ys.offsets.size() / st.out_height + 1) *
+        (xs.offsets.size() / st.out_width + 1);
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          st.batch_size * st.out_height, out_row_size * cells_per_value * 5,
+          work);
+  }
+};
+
+}  // namespace
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+template <typename Device, typename T>
+class ResizeAreaOp : public OpKernel {
+ public:
+  explicit ResizeAreaOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("align_corners", &align_corners_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    ImageResizerState st(align_corners_);
+    st.ValidateAndCreateOutput(context, input);
+
+    if (!context->status().ok()) return;
+
+    DispatchChannels<ResizeImage, T>(st.channels, context, st, input);
   }
 
  private:
@@ -19,6 +19,7 @@ limitations under the License.
 #include <math.h>
 #include <algorithm>
 #include <array>
+#include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/image_resizer_state.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -80,6 +82,90 @@ inline float Interpolate1D(const std::array<float, 4>& weights,
          values[2] * weights[2] + values[3] * weights[3];
 }
 
+// The weights and source offsets of one output row or column, computed
+// once per row and column instead of once per pixel.
+struct CachedInterpolation {
+  std::array<float, 4> weights;
+  std::array<int64, 4> offsets;
+};
+
+// Returns the interpolation of each of "out_size" output coordinates
+// from "in_size" input coordinates, with the source offsets in units of
+// "stride" elements.
+std::vector<CachedInterpolation> ComputeInterpolation(int64 out_size,
+                                                      int64 in_size,
+                                                      float scale,
+                                                      int64 stride) {
+  std::vector<CachedInterpolation> interpolation(out_size);
+  for (int64 i = 0; i < out_size; ++i) {
+    std::array<int64, 4> indices;
+    GetWeightsAndIndices(scale, i, in_size, &interpolation[i].weights,
+                         &indices);
+    for (int k = 0; k < 4; ++k) {
+      interpolation[i].offsets[k] = indices[k] * stride;
+    }
+  }
+  return interpolation;
+}
+
+// Computes one output row, interpolated from the input rows at "y"'s
+// offsets in "image".  kChannels is as passed by DispatchChannels().
+template <int kChannels, typename T>
+void ResizeRow(const T* image, const CachedInterpolation& y,
+               const std::vector<CachedInterpolation>& xs, int64 channels,
+               float* out) {
+  if (kChannels > 0) channels = kChannels;
+  const T* rows[4] = {image + y.offsets[0], image + y.offsets[1],
+                      image + y.offsets[2], image + y.offsets[3]};
+  std::array<float, 4> coeff;
+  for (const CachedInterpolation& x : xs) {
+    for (int64 c = 0; c < channels; ++c) {
+      // Use a 4x4 patch to compute the interpolated output value.
+      for (int i = 0; i < 4; ++i) {
+        const T* row = rows[i] + c;
+        const std::array<float, 4> values = {
+            {static_cast<float>(row[x.offsets[0]]),
+             static_cast<float>(row[x.offsets[1]]),
+             static_cast<float>(row[x.offsets[2]]),
+             static_cast<float>(row[x.offsets[3]])}};
+        coeff[i] = Interpolate1D(x.weights, values);
+      }
+      out[c] = Interpolate1D(y.weights, coeff);
+    }
+    out += channels;
+  }
+}
+
+// Resizes "input" into "st.output", sharding the output rows of all the
+// images among the CPU worker threads.
+template <int kChannels, typename T>
+struct ResizeImage {
+  void operator()(OpKernelContext* context, const ImageResizerState& st,
+                  const Tensor& input) const {
+    const std::vector<CachedInterpolation> ys =
+        ComputeInterpolation(st.out_height, st.in_height, st.height_scale,
+                             st.in_width * st.channels);
+    const std::vector<CachedInterpolation> xs = ComputeInterpolation(
+        st.out_width, st.in_width, st.width_scale, st.channels);
+
+    const T* input_data = input.flat<T>().data();
+    float* output_data = st.output->flat<float>().data();
+    const int64 in_image_size = st.in_height * st.in_width * st.channels;
+    const int64 out_row_size = st.out_width * st.channels;
+    auto work = [&](int64 start, int64 limit) {
+      for (int64 row = start; row < limit; ++row) {
+        const int64 b = row / st.out_height;
+        ResizeRow<kChannels>(input_data + b * in_image_size,
+                             ys[row % st.out_height], xs, st.channels,
+                             output_data + row * out_row_size);
+      }
+    };
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          st.batch_size * st.out_height, out_row_size * 50, work);
+  }
+};
+
 }  // namespace
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
@@ -98,42 +184,7 @@ class ResizeBicubicOp : public OpKernel {
 
     if (!context->status().ok()) return;
 
-    typename TTypes<T, 4>::ConstTensor input_data = input.tensor<T, 4>();
-    typename TTypes<float, 4>::Tensor output_data =
-        st.output->tensor<float, 4>();
-
-    std::array<float, 4> coeff = {{0.0, 0.0, 0.0, 0.0}};
-    for (int64 b = 0; b < st.batch_size; ++b) {
-      for (int64 y = 0; y < st.out_height; ++y) {
-        std::array<float, 4> y_weights;
-        std::array<int64, 4> y_indices;
-        GetWeightsAndIndices(st.height_scale, y, st.in_height, &y_weights,
-                             &y_indices);
-        for (int64 x = 0; x < st.out_width; ++x) {
-          std::array<float, 4> x_weights;
-          std::array<int64, 4> x_indices;
-          GetWeightsAndIndices(st.width_scale, x, st.in_width, &x_weights,
-                               &x_indices);
-          for (int64 c = 0; c < st.channels; ++c) {
-            // Use a 4x4 patch to compute the interpolated output value at
-            // (b, y, x, c).
-            for (int64 i = 0; i < 4; ++i) {
-              const std::array<float, 4> values = {
-                  {static_cast<float>(
-                       input_data(b, y_indices[i], x_indices[0], c)),
-                   static_cast<float>(
-                       input_data(b, y_indices[i], x_indices[1], c)),
-                   static_cast<float>(
-                       input_data(b, y_indices[i], x_indices[2], c)),
-                   static_cast<float>(
-                       input_data(b, y_indices[i], x_indices[3], c))}};
-              coeff[i] = Interpolate1D(x_weights, values);
-            }
-            output_data(b, y, x, c) = Interpolate1D(y_weights, coeff);
-          }
-        }
-      }
-    }
+    DispatchChannels<ResizeImage, T>(st.channels, context, st, input);
   }
 
  private:
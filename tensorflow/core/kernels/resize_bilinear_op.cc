@@ -17,6 +17,8 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include <memory>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -26,9 +28,97 @@ limitations under the License.
 #include "tensorflow/core/kernels/image_resizer_state.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
+namespace {
+
+// The source indices and weight of one output row or column, computed
+// once per row and column instead of once per pixel.
+struct CachedInterpolation {
+  int64 lower;  // Offset of the lower source row or column.
+  int64 upper;  // Offset of the upper source row or column.
+  float lerp;   // Weight of the upper one.
+};
+
+// Returns the interpolation of each of "out_size" output coordinates
+// from "in_size" input coordinates, with the source offsets in units of
+// "stride" elements.
+std::vector<CachedInterpolation> ComputeInterpolation(int64 out_size,
+                                                      int64 in_size,
+                                                      float scale,
+                                                      int64 stride) {
+  std::vector<CachedInterpolation> interpolation(out_size);
+  for (int64 i = 0; i < out_size; ++i) {
+    const float in = i * scale;
+    const int64 lower = static_cast<int64>(floorf(in));
+    interpolation[i].lower = lower * stride;
+    interpolation[i].upper =
+        std::min(static_cast<int64>(ceilf(in)), in_size - 1) * stride;
+    interpolation[i].lerp = in - lower;
+  }
+  return interpolation;
+}
+
+// Computes one output row between the input rows "top" and "bottom".
+// kChannels is as passed by DispatchChannels().
+template <int kChannels, typename T>
+void ResizeRow(const T* top, const T* bottom,
+               const std::vector<CachedInterpolation>& xs, int64 channels,
+               float y_lerp, float* out) {
+  if (kChannels > 0) channels = kChannels;
+  for (const CachedInterpolation& x : xs) {
+    const T* top_left = top + x.lower;
+    const T* top_right = top + x.upper;
+    const T* bottom_left = bottom + x.lower;
+    const T* bottom_right = bottom + x.upper;
+    for (int64 c = 0; c < channels; ++c) {
+      const float tl = top_left[c];
+      const float tr = top_right[c];
+      const float bl = bottom_left[c];
+      const float br = bottom_right[c];
+      const float top_value = tl + (tr - tl) * x.lerp;
+      const float bottom_value = bl + (br - bl) * x.lerp;
+      out[c] = top_value + (bottom_value - top_value) * y_lerp;
+    }
+    out += channels;
+  }
+}
+
+// Resizes "input" into "st.output", sharding the output rows of all the
+// images among the CPU worker threads.
+template <int kChannels, typename T>
+struct ResizeImage {
+  void operator()(OpKernelContext* context, const ImageResizerState& st,
+                  const Tensor& input) const {
+    const std::vector<CachedInterpolation> ys =
+        ComputeInterpolation(st.out_height, st.in_height, st.height_scale,
+                             st.in_width * st.channels);
+    const std::vector<CachedInterpolation> xs = ComputeInterpolation(
+        st.out_width, st.in_width, st.width_scale, st.channels);
+
+    const T* input_data = input.flat<T>().data();
+    float* output_data = st.output->flat<float>().data();
+    const int64 in_image_size = st.in_height * st.in_width * st.channels;
+    const int64 out_row_size = st.out_width * st.channels;
+    auto work = [&](int64 start, int64 limit) {
+      for (int64 row = start; row < limit; ++row) {
+        const int64 b = row / st.out_height;
+        const CachedInterpolation& y = ys[row % st.out_height];
+        const T* image = input_data + b * in_image_size;
+        ResizeRow<kChannels>(image + y.lower, image + y.upper, xs, st.channels,
+                             y.lerp, output_data + row * out_row_size);
+      }
+    };
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          st.batch_size * st.out_height, out_row_size * 10, work);
+  }
+};
+
+}  // namespace
+
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
 template <typename Device, typename T>
@@ -45,39 +135,7 @@ class ResizeBilinearOp : public OpKernel {
 
     if (!context->status().ok()) return;
 
-    typename TTypes<T, 4>::ConstTensor input_data = input.tensor<T, 4>();
-    typename TTypes<float, 4>::Tensor output_data =
-        st.output->tensor<float, 4>();
-
-    for (int b = 0; b < st.batch_size; ++b) {
-      for (int y = 0; y < st.out_height; ++y) {
-        const float in_y = y * st.height_scale;
-        const int top_y_index = static_cast<int>(floorf(in_y));
-        const int bottom_y_index =
-            std::min(static_cast<int64>(ceilf(in_y)), (st.in_height - 1));
-        const float y_lerp = in_y - top_y_index;
-        for (int x = 0; x < st.out_width; ++x) {
-          const float in_x = x * st.width_scale;
-          const int left_x_index = static_cast<int>(floorf(in_x));
-          const int right_x_index =
-              std::min(static_cast<int64>(ceilf(in_x)), (st.in_width - 1));
-          const float x_lerp = in_x - left_x_index;
-          for (int c = 0; c < st.channels; ++c) {
-            const float top_left = input_data(b, top_y_index, left_x_index, c);
-            const float top_right =
-                input_data(b, top_y_index, right_x_index, c);
-            const float bottom_left =
-                input_data(b, bottom_y_index, left_x_index, c);
-            const float bottom_right =
-                input_data(b, bottom_y_index, right_x_index, c);
-            const float top = top_left + (top_right - top_left) * x_lerp;
-            const float bottom =
-                bottom_left + (bottom_right - bottom_left) * x_lerp;
-            output_data(b, y, x, c) = top + (bottom - top) * y_lerp;
-          }
-        }
-      }
-    }
+    DispatchChannels<ResizeImage, T>(st.channels, context, st, input);
   }
 
  private:
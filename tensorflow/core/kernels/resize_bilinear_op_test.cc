@@ -282,6 +282,43 @@ TEST_F(ResizeBilinearOpTest, TestBilinear2x2x2To3x3x2) {
   test::ExpectTensorEqual<float>(expected, *GetOutput(0));
 }
 
+TEST_F(ResizeBilinearOpTest, TestBilinear2x2x3To3x3x3Batch2) {
+  // Three channels take a different code path than other counts.
+  AddInputFromArray<float>(
+      TensorShape({2, 2, 2, 3}),
+      {1, -1, 10, 2, -2, 20, 3, -3, 30, 4, -4, 40,
+       4, -4, 40, 3, -3, 30, 2, -2, 20, 1, -1, 10});
+  AddInputFromArray<int32>(TensorShape({2}), {3, 3});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 3, 3, 3}));
+  // clang-format off
+  test::FillValues<float>(&expected,
+    {
+      1,      -1,      10,
+      5.0/3,  -5.0/3,  50.0/3,
+      2,      -2,      20,
+      7.0/3,  -7.0/3,  70.0/3,
+      3,      -3,      30,
+      10.0/3, -10.0/3, 100.0/3,
+      3,      -3,      30,
+      11.0/3, -11.0/3, 110.0/3,
+      4,      -4,      40,
+
+      4,      -4,      40,
+      10.0/3, -10.0/3, 100.0/3,
+      3,      -3,      30,
+      8.0/3,  -8.0/3,  80.0/3,
+      2,      -2,      20,
+      5.0/3,  -5.0/3,  50.0/3,
+      2,      -2,      20,
+      4.0/3,  -4.0/3,  40.0/3,
+      1,      -1,      10
+    });
+  // clang-format on
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
 TEST_F(ResizeBilinearOpTest, TestBilinear2x2To4x4) {
   // Input:
   //  1, 2
@@ -17,6 +17,8 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include <memory>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -26,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/image_resizer_state.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA
 #include "tensorflow/core/kernels/resize_nearest_neighbor_op_gpu.h"
@@ -33,6 +36,68 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// Returns the offset of the nearest source row or column of each of
+// "out_size" output coordinates, in units of "stride" elements, so that
+// they are computed once per row and column instead of once per pixel.
+std::vector<int64> ComputeNearest(int64 out_size, int64 in_size, float scale,
+                                  int64 stride) {
+  std::vector<int64> offsets(out_size);
+  for (int64 i = 0; i < out_size; ++i) {
+    offsets[i] =
+        std::min(static_cast<int64>(floorf(i * scale)), in_size - 1) * stride;
+  }
+  return offsets;
+}
+
+// Copies the output row "out" from the input row "in".  kChannels is as
+// passed by DispatchChannels().
+template <int kChannels, typename T>
+void ResizeRow(const T* in, const std::vector<int64>& xs, int64 channels,
+               T* out) {
+  if (kChannels > 0) channels = kChannels;
+  for (const int64 x : xs) {
+    const T* pixel = in + x;
+    for (int64 c = 0; c < channels; ++c) {
+      out[c] = pixel[c];
+    }
+    out += channels;
+  }
+}
+
+// Resizes "input" into "st.output", sharding the output rows of all the
+// images among the CPU worker threads.
+template <int kChannels, typename T>
+struct ResizeImage {
+  void operator()(OpKernelContext* context, const ImageResizerState& st,
+                  const Tensor& input) const {
+    const std::vector<int64> ys =
+        ComputeNearest(st.out_height, st.in_height, st.height_scale,
+                       st.in_width * st.channels);
+    const std::vector<int64> xs =
+        ComputeNearest(st.out_width, st.in_width, st.width_scale, st.channels);
+
+    const T* input_data = input.flat<T>().data();
+    T* output_data = st.output->flat<T>().data();
+    const int64 in_image_size = st.in_height * st.in_width * st.channels;
+    const int64 out_row_size = st.out_width * st.channels;
+    auto work = [&](int64 start, int64 limit) {
+      for (int64 row = start; row < limit; ++row) {
+        const T* in_row = input_data + (row / st.out_height) * in_image_size +
+                          ys[row % st.out_height];
+        ResizeRow<kChannels>(in_row, xs, st.channels,
+                             output_data + row * out_row_size);
+      }
+    };
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          st.batch_size * st.out_height, out_row_size * 2, work);
+  }
+};
+
+}  // namespace
+
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
 template <typename Device, typename T>
@@ -54,24 +119,7 @@ class ResizeNearestNeighborOp : public OpKernel {
                 errors::InvalidArgument("nearest neighbor requires max height "
                                         "& width of 2^24"));
 
-    typename TTypes<T, 4>::ConstTensor input_data = input.tensor<T, 4>();
-    typename TTypes<T, 4>::Tensor output_data = st.output->tensor<T, 4>();
-
-    for (int b = 0; b < st.batch_size; ++b) {
-      for (int y = 0; y < st.out_height; ++y) {
-        const int in_y =
-            std::min(static_cast<int64>(floorf(y * st.height_scale)),
-                     (st.in_height - 1));
-        for (int x = 0; x < st.out_width; ++x) {
-          const int in_x =
-              std::min(static_cast<int64>(floorf(x * st.width_scale)),
-                       (st.in_width - 1));
-          for (int c = 0; c < st.channels; ++c) {
-            output_data(b, y, x, c) = input_data(b, in_y, in_x, c);
-          }
-        }
-      }
-    }
+    DispatchChannels<ResizeImage, T>(st.channels, context, st, input);
   }
 
  private:
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -49,4 +50,47 @@ static Graph* BM_ResizeNearestNeighbor(int batches, int width, int height) {
 BM_ResizeNearestNeighborDev(cpu, 1, 499, 499);
 BM_ResizeNearestNeighborDev(gpu, 1, 499, 499);
 
+// Resizes a batch of "batches" images of "channels" channels with "op",
+// to twice their size if "upsample", and to a third of it otherwise.
+static Graph* BM_ResizeImage(const string& op, int batches, int width,
+                             int height, int channels, bool upsample) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor in(DT_FLOAT, TensorShape({batches, width, height, channels}));
+  in.flat<float>().setRandom();
+
+  Tensor out_size(DT_INT32, TensorShape({2}));
+  auto out_size_flat = out_size.flat<int32>();
+  out_size_flat(0) = upsample ? width * 2 : width / 3;
+  out_size_flat(1) = upsample ? height * 2 : height / 3;
+
+  Node* ret;
+  NodeBuilder(g->NewName("n"), op)
+      .Input(test::graph::Constant(g, in))
+      .Input(test::graph::Constant(g, out_size))
+      .Finalize(g, &ret);
+  return g;
+}
+
+// Reports the input values resized per second.
+#define BM_ResizeImageDev(OP, B, W, H, C, UP)                                 \
+  static void BM_##OP##_##B##_##W##_##H##_##C##_##UP(int iters) {             \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B * W * H * C);       \
+    test::Benchmark("cpu", BM_ResizeImage(#OP, B, W, H, C, UP)).Run(iters);   \
+  }                                                                           \
+  BENCHMARK(BM_##OP##_##B##_##W##_##H##_##C##_##UP)
+
+#define BM_ResizeImageChannels(OP, B, W, H, UP) \
+  BM_ResizeImageDev(OP, B, W, H, 1, UP);        \
+  BM_ResizeImageDev(OP, B, W, H, 3, UP);        \
+  BM_ResizeImageDev(OP, B, W, H, 4, UP);        \
+  BM_ResizeImageDev(OP, B, W, H, 5, UP)
+
+BM_ResizeImageChannels(ResizeNearestNeighbor, 8, 299, 299, true);
+BM_ResizeImageChannels(ResizeBilinear, 1, 499, 499, true);
+BM_ResizeImageChannels(ResizeBilinear, 8, 299, 299, true);
+BM_ResizeImageChannels(ResizeBilinear, 8, 299, 299, false);
+BM_ResizeImageChannels(ResizeBicubic, 8, 299, 299, true);
+BM_ResizeImageChannels(ResizeArea, 8, 299, 299, true);
+BM_ResizeImageChannels(ResizeArea, 8, 299, 299, false);
+
 }  // namespace tensorflow
@@ -36,11 +36,13 @@ namespace functor {
 // Functor used by ScatterOp to do the computations.
 template <typename Device, typename T, typename Index, scatter_op::UpdateOp op>
 struct ScatterFunctor {
-  // Returns -1 on success or a nonnegative i s.t. indices[i] is a bad index.
+  // Returns -1 on success or a nonnegative i s.t. indices[i] is a bad index,
+  // in which case "*bad_index" is the value of indices[i] that was checked.
   Index operator()(OpKernelContext* c, const Device& d,
                    typename TTypes<T>::Matrix params,
                    typename TTypes<T>::ConstMatrix updates,
-                   typename TTypes<Index>::ConstFlat indices);
+                   typename TTypes<Index>::ConstFlat indices,
+                   Index* bad_index);
 };
 
 }  // namespace functor
@@ -65,7 +65,8 @@ struct ScatterFunctor<GPUDevice, T, Index, op> {
   Index operator()(OpKernelContext* c, const GPUDevice& d,
                    typename TTypes<T>::Matrix params,
                    typename TTypes<T>::ConstMatrix updates,
-                   typename TTypes<Index>::ConstFlat indices) {
+                   typename TTypes<Index>::ConstFlat indices,
+                   Index* bad_index) {
     // TODO: Implement indices range check.  The hardest part is with returning
     // a value after the range check, as we do not want to do device to host
     // memcpy during a stream.
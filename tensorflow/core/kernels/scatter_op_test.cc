@@ -224,6 +224,82 @@ TEST_F(ScatterUpdateOpTest, Error_MismatchedIndicesAndUpdateDimensions) {
       << s;
 }
 
+// Runs the ops with enough updates for them to be partitioned among the
+// worker threads, on machines with more than one core.
+class ScatterManyUpdatesTest : public OpsTestBase {
+ protected:
+  static const int kRows = 100;
+  static const int kCols = 8;
+  static const int kNumUpdates = 20000;
+
+  // Makes "op" and adds its inputs: params of ones, and update i of all
+  // i's to row (7 * i) % kRows, or to "bad_row" for i == "bad_i".
+  void MakeOp(const char* op, int bad_i, int bad_row) {
+    TF_ASSERT_OK(NodeDefBuilder("myop", op)
+                     .Input(FakeInput(DT_FLOAT_REF))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    AddInput<float>(TensorShape({kRows, kCols}),
+                    [](int i) -> float { return 1; });
+    AddInput<int32>(TensorShape({kNumUpdates}), [bad_i, bad_row](int i) {
+      return i == bad_i ? bad_row : (7 * i) % kRows;
+    });
+    AddInput<float>(TensorShape({kNumUpdates, kCols}),
+                    [](int i) -> float { return i / kCols; });
+  }
+
+  // Computes params after ScatterUpdate ("last") and after ScatterAdd
+  // ("sum") when only the updates before "limit" are applied.
+  void Expected(int limit, std::vector<float>* last,
+                std::vector<float>* sum) {
+    last->assign(kRows * kCols, 1);
+    sum->assign(kRows * kCols, 1);
+    for (int i = 0; i < limit; ++i) {
+      const int row = (7 * i) % kRows;
+      for (int j = 0; j < kCols; ++j) {
+        (*last)[row * kCols + j] = i;
+        (*sum)[row * kCols + j] += i;
+      }
+    }
+  }
+
+  void ExpectParams(const std::vector<float>& values) {
+    Tensor expected(allocator(), DT_FLOAT, TensorShape({kRows, kCols}));
+    test::FillValues<float>(&expected, values);
+    test::ExpectTensorEqual<float>(expected, *mutable_input(0).tensor);
+  }
+};
+
+TEST_F(ScatterManyUpdatesTest, UpdateDuplicateIndices) {
+  MakeOp("ScatterUpdate", -1, 0);
+  TF_ASSERT_OK(RunOpKernel());
+  std::vector<float> last, sum;
+  Expected(kNumUpdates, &last, &sum);
+  ExpectParams(last);
+}
+
+TEST_F(ScatterManyUpdatesTest, AddDuplicateIndices) {
+  MakeOp("ScatterAdd", -1, 0);
+  TF_ASSERT_OK(RunOpKernel());
+  std::vector<float> last, sum;
+  Expected(kNumUpdates, &last, &sum);
+  ExpectParams(sum);
+}
+
+TEST_F(ScatterManyUpdatesTest, Error_IndexOutOfRange) {
+  MakeOp("ScatterAdd", 12345, kRows);
+  Status s = RunOpKernel();
+  EXPECT_TRUE(StringPiece(s.ToString())
+                  .contains("indices[12345] = 100 is not in [0, 100)"))
+      << s;
+  // The updates before the bad index are applied, the others are not.
+  std::vector<float> last, sum;
+  Expected(12345, &last, &sum);
+  ExpectParams(sum);
+}
+
 class ScatterUpdateBM : public ScatterUpdateOpTest {
  public:
   virtual void TestBody() {}
@@ -293,5 +369,31 @@ BENCHMARK(BM_ScatterUpdateInt64)->Arg(1)->Arg(10)->Arg(64)->Arg(256)->Arg(1024);
 BENCHMARK(BM_ScatterAddInt32)->Arg(1)->Arg(10)->Arg(64)->Arg(256)->Arg(1024);
 BENCHMARK(BM_ScatterAddInt64)->Arg(1)->Arg(10)->Arg(64)->Arg(256)->Arg(1024);
 
+// ScatterAdd of 100000 rows of "embedding_size" floats into a variable of
+// 100000 rows, with the skewed ids of a sparse feature.
+static void BM_ScatterAddSkewed(int iters, int embedding_size) {
+  testing::StopTiming();
+  const int kRows = 100000;
+  const int kDim = embedding_size;
+  const int kNumUpdates = 100000;
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  ScatterUpdateBM bm;
+  bm.MakeBenchmarkOp("ScatterAdd", DT_INT32);
+  bm.AddInput<float>(TensorShape({kRows, kDim}),
+                     [](int i) -> float { return 0; });
+  bm.AddInput<int32>(TensorShape({kNumUpdates}),
+                     [&rnd](int i) { return rnd.Skewed(16) % kRows; });
+  bm.AddInput<float>(TensorShape({kNumUpdates, kDim}),
+                     [](int i) -> float { return i % 7; });
+  testing::ItemsProcessed(static_cast<int64>(iters) * kNumUpdates * kDim);
+  testing::StartTiming();
+  while (iters-- > 0) {
+    TF_CHECK_OK(bm.RunOpKernel());
+  }
+  testing::StopTiming();
+}
+BENCHMARK(BM_ScatterAddSkewed)->Arg(16)->Arg(64)->Arg(256);
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,131 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_SCATTER_PARTITION_H_
+#define TENSORFLOW_KERNELS_SCATTER_PARTITION_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace scatter_partition {
+
+// Below this estimated cost (in the units of Shard()) the updates are
+// applied on the calling thread without partitioning them.
+const int64 kMinParallelCost = 100000;
+
+// Number of buckets per worker thread, rounded up to a power of two, so
+// that Shard() can even out buckets of different sizes.
+const int kBucketsPerThread = 4;
+
+}  // namespace scatter_partition
+
+// Calls "fn(i, indices(i))" for every i in [0, indices.size()), where
+// each call updates row indices(i) of some tensor(s) with "num_rows" rows
+// using row i of the updates.  The calls are spread over "worker_threads",
+// usually those of the kernel's device, such that all the updates of one
+// row are made by the same thread, in increasing order of i.  Duplicate
+// indices therefore see the same sequence of updates as in a serial loop,
+// and "fn" needs no locking.
+//
+// "cost_per_update" is the estimated cost of one call, as for Shard().
+//
+// Returns the first i for which indices(i) is not in [0, num_rows), after
+// applying all the updates before it and none after, or -1 if all the
+// indices are valid.  In the former case "*bad_index" is set to the value
+// of indices(i) that was checked, which the caller should report rather
+// than reading indices(i) again.
+template <typename Index, typename Fn>
+Index ParallelForEachRow(
+    const DeviceBase::CpuWorkerThreads& worker_threads,
+    typename TTypes<Index>::ConstFlat indices, Index num_rows,
+    int64 cost_per_update, const Fn& fn, Index* bad_index) {
+  const Index N = indices.size();
+  const int num_threads = worker_threads.num_threads;
+  if (num_threads <= 1 ||
+      N * cost_per_update < scatter_partition::kMinParallelCost) {
+    for (Index i = 0; i < N; i++) {
+      // Read every index exactly once, since it could change in between.
+      const Index index = internal::SubtleMustCopy(indices(i));
+      if (!FastBoundsCheck(index, num_rows)) {
+        *bad_index = index;
+        return i;
+      }
+      fn(i, index);
+    }
+    return -1;
+  }
+
+  // Copy and check the indices; only those before the first bad one are
+  // applied.
+  std::vector<Index> rows(N);
+  Index bad_i = -1;
+  for (Index i = 0; i < N; i++) {
+    rows[i] = internal::SubtleMustCopy(indices(i));
+    if (!FastBoundsCheck(rows[i], num_rows)) {
+      *bad_index = rows[i];
+      bad_i = i;
+      break;
+    }
+  }
+  const Index num_valid = bad_i < 0 ? N : bad_i;
+
+  // Counting sort of the updates into buckets by row.  Rows are assigned
+  // round-robin rather than by contiguous range, since the frequent ids of
+  // sparse features tend to be the small ones.  The sort is stable, so each
+  // bucket lists its updates in increasing order of i.
+  int64 num_buckets = 1;
+  while (num_buckets < scatter_partition::kBucketsPerThread * num_threads) {
+    num_buckets <<= 1;
+  }
+  const Index mask = num_buckets - 1;
+  std::vector<Index> bucket_start(num_buckets + 1, 0);
+  for (Index i = 0; i < num_valid; i++) {
+    ++bucket_start[(rows[i] & mask) + 1];
+  }
+  for (int64 b = 0; b < num_buckets; ++b) {
+    bucket_start[b + 1] += bucket_start[b];
+  }
+  std::vector<Index> order(num_valid);
+  {
+    std::vector<Index> next(bucket_start.begin(), bucket_start.end() - 1);
+    for (Index i = 0; i < num_valid; i++) {
+      order[next[rows[i] & mask]++] = i;
+    }
+  }
+
+  auto work = [&fn, &rows, &order, &bucket_start](int64 start, int64 limit) {
+    for (int64 b = start; b < limit; ++b) {
+      for (Index k = bucket_start[b]; k < bucket_start[b + 1]; ++k) {
+        const Index i = order[k];
+        fn(i, rows[i]);
+      }
+    }
+  };
+  Shard(num_threads, worker_threads.workers, num_buckets,
+        std::max<int64>(1, num_valid / num_buckets) * cost_per_update, work);
+  return bad_i;
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_SCATTER_PARTITION_H_
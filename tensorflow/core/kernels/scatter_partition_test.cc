@@ -0,0 +1,147 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/scatter_partition.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// Runs ParallelForEachRow on "num_threads" threads with a cost that makes
+// it partition the updates, and records in "updates" the i's of the
+// updates applied to each row, in order.
+void RunAndRecord(int num_threads, const std::vector<int64>& indices,
+                  int64 num_rows, int64* bad_i, int64* bad_index,
+                  std::vector<std::vector<int64>>* updates) {
+  thread::ThreadPool pool(Env::Default(), "test", num_threads);
+  DeviceBase::CpuWorkerThreads worker_threads;
+  worker_threads.num_threads = num_threads;
+  worker_threads.workers = &pool;
+  const Tensor t = test::AsTensor<int64>(indices);
+  updates->assign(num_rows, {});
+  *bad_i = ParallelForEachRow<int64>(
+      worker_threads, t.flat<int64>(), num_rows, 10000,
+      [updates](int64 i, int64 row) { (*updates)[row].push_back(i); },
+      bad_index);
+}
+
+TEST(ParallelForEachRowTest, KeepsOrderOfDuplicates) {
+  const int64 kRows = 37;
+  std::vector<int64> indices;
+  for (int i = 0; i < 10000; ++i) indices.push_back((i * i) % kRows);
+  for (int num_threads : {1, 2, 4, 16}) {
+    int64 bad_i, bad_index;
+    std::vector<std::vector<int64>> updates;
+    RunAndRecord(num_threads, indices, kRows, &bad_i, &bad_index, &updates);
+    EXPECT_EQ(-1, bad_i);
+    std::vector<std::vector<int64>> expected(kRows);
+    for (int i = 0; i < indices.size(); ++i) {
+      expected[indices[i]].push_back(i);
+    }
+    EXPECT_EQ(expected, updates) << num_threads;
+  }
+}
+
+TEST(ParallelForEachRowTest, StopsAtFirstBadIndex) {
+  const int64 kRows = 1000;
+  std::vector<int64> indices;
+  for (int i = 0; i < 5000; ++i) indices.push_back(i % kRows);
+  indices[1234] = -1;
+  indices[4321] = kRows;
+  for (int num_threads : {1, 4}) {
+    int64 bad_i, bad_index;
+    std::vector<std::vector<int64>> updates;
+    RunAndRecord(num_threads, indices, kRows, &bad_i, &bad_index, &updates);
+    EXPECT_EQ(1234, bad_i);
+    EXPECT_EQ(-1, bad_index);
+    int64 num_updates = 0;
+    for (const auto& row : updates) {
+      for (int64 i : row) EXPECT_LT(i, 1234);
+      num_updates += row.size();
+    }
+    EXPECT_EQ(1234, num_updates);
+  }
+}
+
+TEST(ParallelForEachRowTest, FewerRowsThanThreads) {
+  std::vector<int64> indices(1000, 1);
+  indices[500] = 0;
+  int64 bad_i, bad_index;
+  std::vector<std::vector<int64>> updates;
+  RunAndRecord(8, indices, 2, &bad_i, &bad_index, &updates);
+  EXPECT_EQ(-1, bad_i);
+  EXPECT_EQ(std::vector<int64>({500}), updates[0]);
+  EXPECT_EQ(999, updates[1].size());
+}
+
+// Adds 100000 rows of "dim" floats with skewed ids into a table of 100000
+// rows, on "num_threads" threads.
+static void BM_ScatterAdd(int iters, int num_threads, int dim) {
+  testing::StopTiming();
+  const int64 kRows = 100000;
+  const int64 kNumUpdates = 100000;
+  thread::ThreadPool pool(Env::Default(), "bench", num_threads);
+  DeviceBase::CpuWorkerThreads worker_threads;
+  worker_threads.num_threads = num_threads;
+  worker_threads.workers = &pool;
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<int32> ids(kNumUpdates);
+  for (int32& id : ids) id = rnd.Skewed(16) % kRows;
+  const Tensor indices = test::AsTensor<int32>(ids);
+  Tensor params(DT_FLOAT, TensorShape({kRows, dim}));
+  params.flat<float>().setZero();
+  Tensor updates(DT_FLOAT, TensorShape({kNumUpdates, dim}));
+  updates.flat<float>().setConstant(1);
+  auto p = params.matrix<float>();
+  auto u = updates.matrix<float>();
+  auto add_row = [&p, &u, dim](int32 i, int32 row) {
+    TTypes<float>::UnalignedFlat dst(p.data() + int64{row} * dim, dim);
+    dst += TTypes<float>::UnalignedConstFlat(u.data() + int64{i} * dim, dim);
+  };
+  int32 bad_index;
+  testing::ItemsProcessed(static_cast<int64>(iters) * kNumUpdates * dim);
+  testing::StartTiming();
+  while (iters-- > 0) {
+    CHECK_EQ(-1, ParallelForEachRow<int32>(
+                     worker_threads, indices.flat<int32>(), kRows, 20 + dim,
+                     add_row, &bad_index));
+  }
+}
+
+#define BM_SCATTER_ADD(THREADS, DIM)                          \
+  static void BM_ScatterAdd_##THREADS##_##DIM(int iters) {    \
+    BM_ScatterAdd(iters, THREADS, DIM);                       \
+  }                                                           \
+  BENCHMARK(BM_ScatterAdd_##THREADS##_##DIM);
+
+BM_SCATTER_ADD(1, 16);
+BM_SCATTER_ADD(4, 16);
+BM_SCATTER_ADD(16, 16);
+BM_SCATTER_ADD(1, 128);
+BM_SCATTER_ADD(4, 128);
+BM_SCATTER_ADD(16, 128);
+
+}  // namespace
+}  // namespace tensorflow
@@ -92,6 +92,12 @@ RecvOp::RecvOp(OpKernelConstruction* ctx) : AsyncOpKernel(ctx) {
   OP_REQUIRES_OK(ctx, ctx->GetAttr("tensor_name", &tensor_name));
   key_prefix_ = GetRendezvousKeyPrefix(send_device, recv_device,
                                        send_device_incarnation, tensor_name);
+  // Set by the graph partitioner for tensors received from other tasks.
+  int64 wire_encoding;
+  if (ctx->GetAttr("_wire_encoding", &wire_encoding).ok() &&
+      WireOptions::Encoding_IsValid(wire_encoding)) {
+    wire_encoding_ = static_cast<WireOptions::Encoding>(wire_encoding);
+  }
 }
 
 void RecvOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
@@ -104,6 +110,7 @@ void RecvOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
   Rendezvous::Args args;
   args.device_context = ctx->op_device_context();
   args.alloc_attrs = ctx->output_alloc_attr(0);
+  args.wire_encoding = wire_encoding_;
   ctx->rendezvous()->RecvAsync(
       key, args, [ctx, done](const Status& s, const Rendezvous::Args& send_args,
                              const Rendezvous::Args& recv_args,
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
 
@@ -39,6 +40,7 @@ class RecvOp : public AsyncOpKernel {
 
  private:
   string key_prefix_;
+  WireOptions::Encoding wire_encoding_ = WireOptions::RAW;
 
   TF_DISALLOW_COPY_AND_ASSIGN(RecvOp);
 };
@@ -36,7 +36,7 @@ class TextLineReader : public ReaderBase {
   Status OnWorkStartedLocked() override {
     line_number_ = 0;
     RandomAccessFile* file = nullptr;
-    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(current_work(), &file));
+    TF_RETURN_IF_ERROR(NewRandomAccessFile(env_, current_work(), &file));
     input_buffer_.reset(new io::InputBuffer(file, kBufferSize));
     for (; line_number_ < skip_header_lines_; ++line_number_) {
       string line_contents;
@@ -101,9 +101,17 @@ class TextLineReaderOp : public ReaderOpKernel {
     OP_REQUIRES(context, skip_header_lines >= 0,
                 errors::InvalidArgument("skip_header_lines must be >= 0 not ",
                                         skip_header_lines));
+    int readahead_buffers;
+    int64 readahead_buffer_bytes;
+    OP_REQUIRES_OK(context, GetReadaheadAttrs(context, &readahead_buffers,
+                                              &readahead_buffer_bytes));
     Env* env = context->env();
-    SetReaderFactory([this, skip_header_lines, env]() {
-      return new TextLineReader(name(), skip_header_lines, env);
+    SetReaderFactory([this, skip_header_lines, env, readahead_buffers,
+                      readahead_buffer_bytes]() {
+      TextLineReader* reader =
+          new TextLineReader(name(), skip_header_lines, env);
+      reader->SetReadahead(readahead_buffers, readahead_buffer_bytes);
+      return reader;
     });
   }
 };
@@ -22,26 +22,45 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
 
 class TFRecordReader : public ReaderBase {
  public:
-  TFRecordReader(const string& node_name, Env* env)
+  // If "use_mmap", files are memory mapped and records are copied straight
+  // from the mapping into the output; files that cannot be mapped fall back
+  // to RandomAccessFile reads.  "checksum_mode" only applies to mapped
+  // files.
+  TFRecordReader(const string& node_name, Env* env, bool use_mmap,
+                 io::MappedRecordReader::ChecksumMode checksum_mode)
       : ReaderBase(strings::StrCat("TFRecordReader '", node_name, "'")),
         env_(env),
+        use_mmap_(use_mmap),
+        checksum_mode_(checksum_mode),
         offset_(0) {}
 
   Status OnWorkStartedLocked() override {
     offset_ = 0;
+    if (use_mmap_) {
+      ReadOnlyMemoryRegion* region = nullptr;
+      Status s = env_->NewReadOnlyMemoryRegionFromFile(current_work(), &region);
+      if (s.ok()) {
+        mapped_reader_.reset(new io::MappedRecordReader(region, checksum_mode_));
+        return Status::OK();
+      }
+      VLOG(1) << "Could not map " << current_work() << ", reading it instead: "
+              << s;
+    }
     RandomAccessFile* file = nullptr;
-    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(current_work(), &file));
+    TF_RETURN_IF_ERROR(NewRandomAccessFile(env_, current_work(), &file));
     file_.reset(file);
     reader_.reset(new io::RecordReader(file));
     return Status::OK();
   }
 
   Status OnWorkFinishedLocked() override {
+    mapped_reader_.reset(nullptr);
     reader_.reset(nullptr);
     file_.reset(nullptr);
     return Status::OK();
@@ -50,7 +69,15 @@ class TFRecordReader : public ReaderBase {
   Status ReadLocked(string* key, string* value, bool* produced,
                     bool* at_end) override {
     *key = strings::StrCat(current_work(), ":", offset_);
-    Status status = reader_->ReadRecord(&offset_, value);
+    Status status;
+    if (mapped_reader_) {
+      StringPiece record;
+      status = mapped_reader_->ReadRecord(&offset_, &record);
+      // "value" is the output tensor's string, so this is the only copy.
+      if (status.ok()) value->assign(record.data(), record.size());
+    } else {
+      status = reader_->ReadRecord(&offset_, value);
+    }
     if (errors::IsOutOfRange(status)) {
       *at_end = true;
       return Status::OK();
@@ -62,6 +89,7 @@ class TFRecordReader : public ReaderBase {
 
   Status ResetLocked() override {
     offset_ = 0;
+    mapped_reader_.reset(nullptr);
     reader_.reset(nullptr);
     file_.reset(nullptr);
     return ReaderBase::ResetLocked();
@@ -71,9 +99,12 @@ class TFRecordReader : public ReaderBase {
 
  private:
   Env* const env_;
+  const bool use_mmap_;
+  const io::MappedRecordReader::ChecksumMode checksum_mode_;
   uint64 offset_;
   std::unique_ptr<RandomAccessFile> file_;
   std::unique_ptr<io::RecordReader> reader_;
+  std::unique_ptr<io::MappedRecordReader> mapped_reader_;
 };
 
 class TFRecordReaderOp : public ReaderOpKernel {
@@ -81,7 +112,29 @@ class TFRecordReaderOp : public ReaderOpKernel {
   explicit TFRecordReaderOp(OpKernelConstruction* context)
       : ReaderOpKernel(context) {
     Env* env = context->env();
-    SetReaderFactory([this, env]() { return new TFRecordReader(name(), env); });
+    bool use_mmap;
+    OP_REQUIRES_OK(context, context->GetAttr("use_mmap", &use_mmap));
+    string checksum;
+    OP_REQUIRES_OK(context, context->GetAttr("checksum", &checksum));
+    io::MappedRecordReader::ChecksumMode checksum_mode;
+    if (checksum == "per_record") {
+      checksum_mode = io::MappedRecordReader::kVerifyPerRecord;
+    } else if (checksum == "bulk") {
+      checksum_mode = io::MappedRecordReader::kVerifyBulk;
+    } else {
+      checksum_mode = io::MappedRecordReader::kSkipChecksums;
+    }
+    int readahead_buffers;
+    int64 readahead_buffer_bytes;
+    OP_REQUIRES_OK(context, GetReadaheadAttrs(context, &readahead_buffers,
+                                              &readahead_buffer_bytes));
+    SetReaderFactory([this, env, use_mmap, checksum_mode, readahead_buffers,
+                      readahead_buffer_bytes]() {
+      TFRecordReader* reader =
+          new TFRecordReader(name(), env, use_mmap, checksum_mode);
+      reader->SetReadahead(readahead_buffers, readahead_buffer_bytes);
+      return reader;
+    });
   }
 };
 
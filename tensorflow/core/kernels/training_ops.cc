@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/training_ops.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/kernels/scatter_partition.h"
 
 #include "tensorflow/core/framework/op_kernel.h"
 
@@ -25,6 +26,39 @@ namespace tensorflow {
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
+namespace {
+
+// Row "row" of "m" as a vector.  The sparse updates below work on these
+// rather than on chips of the matrices, which Eigen vectorizes without the
+// stride arithmetic of a chip.
+template <typename T>
+typename TTypes<T>::UnalignedFlat Row(typename TTypes<T>::Matrix m,
+                                      int64 row) {
+  return typename TTypes<T>::UnalignedFlat(m.data() + row * m.dimension(1),
+                                           m.dimension(1));
+}
+
+template <typename T>
+typename TTypes<T>::UnalignedConstFlat ConstRow(
+    typename TTypes<T>::ConstMatrix m, int64 row) {
+  return typename TTypes<T>::UnalignedConstFlat(
+      m.data() + row * m.dimension(1), m.dimension(1));
+}
+
+// The type the sparse updates of T compute in.  Rows of half are widened
+// to float, so that only the stored values are rounded to 16 bits.
+template <typename T>
+struct UpdateType {
+  typedef T type;
+};
+
+template <>
+struct UpdateType<Eigen::half> {
+  typedef float type;
+};
+
+}  // namespace
+
 namespace functor {
 
 template <typename T>
@@ -653,46 +687,52 @@ class SparseApplyAdagradOp : public OpKernel {
     if (N > 0) {
       if (inner_dim > 1) {
         const Tindex first_dim_size = var.dim_size(0);
-        auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat_outer_dims<T>();
         auto accum_flat = accum.flat_outer_dims<T>();
         auto grad_flat = grad.flat_outer_dims<T>();
-        T lr_scalar = lr.scalar<T>()();
-
-        // Note(yonghui): It might be worth multi-threading square() and
-        // rsqrt().
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
-          auto a = accum_flat.template chip<0>(index);
-          auto g = grad_flat.template chip<0>(i);
-          auto v = var_flat.template chip<0>(index);
-          a += g.square();
-          v -= g.constant(lr_scalar) * g * a.rsqrt();
-        }
+        const U lr_scalar = static_cast<U>(lr.scalar<T>()());
+
+        auto update_row = [&](Tindex i, Tindex index) {
+          auto a = Row<T>(accum_flat, index);
+          auto g = ConstRow<T>(grad_flat, i).template cast<U>();
+          auto v = Row<T>(var_flat, index);
+          a = (a.template cast<U>() + g.square()).template cast<T>();
+          v = (v.template cast<U>() -
+               g.constant(lr_scalar) * g * a.template cast<U>().rsqrt())
+                  .template cast<T>();
+        };
+        Tindex bad_index;
+        const Tindex bad_i = ParallelForEachRow<Tindex>(
+            *ctx->device()->tensorflow_cpu_worker_threads(),
+            indices.flat<Tindex>(), first_dim_size, 10 * inner_dim,
+            update_row, &bad_index);
+        OP_REQUIRES(ctx, bad_i < 0,
+                    errors::InvalidArgument(strings::StrCat(
+                        "Index ", bad_index, " at offset ", bad_i,
+                        " in indices is out of range")));
       } else {
         CHECK_EQ(1, inner_dim);
-        auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
         auto accum_flat = accum.flat<T>();
         auto grad_flat = grad.flat<T>();
-        T lr_scalar = lr.scalar<T>()();
+        const U lr_scalar = static_cast<U>(lr.scalar<T>()());
         const Tindex first_dim_size = accum_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
-          T& a = accum_flat(index);
-          const T& g = grad_flat(i);
-          a += g * g;
-          var_flat(index) -= lr_scalar * g / std::sqrt(a);
-        }
+        auto update = [&](Tindex i, Tindex index) {
+          const U g = static_cast<U>(grad_flat(i));
+          const U a = static_cast<U>(accum_flat(index)) + g * g;
+          accum_flat(index) = static_cast<T>(a);
+          var_flat(index) = static_cast<T>(static_cast<U>(var_flat(index)) -
+                                           lr_scalar * g / std::sqrt(a));
+        };
+        Tindex bad_index;
+        const Tindex bad_i = ParallelForEachRow<Tindex>(
+            *ctx->device()->tensorflow_cpu_worker_threads(),
+            indices.flat<Tindex>(), first_dim_size, 10, update, &bad_index);
+        OP_REQUIRES(ctx, bad_i < 0,
+                    errors::InvalidArgument(strings::StrCat(
+                        "Index ", bad_index, " at offset ", bad_i,
+                        " in indices is out of range")));
       }
     }
 
@@ -700,6 +740,8 @@ class SparseApplyAdagradOp : public OpKernel {
   }
 
  private:
+  typedef typename UpdateType<T>::type U;
+
   bool use_exclusive_lock_;
 };
 
@@ -714,6 +756,8 @@ REGISTER_KERNELS(float, int32);
 REGISTER_KERNELS(float, int64);
 REGISTER_KERNELS(double, int32);
 REGISTER_KERNELS(double, int64);
+REGISTER_KERNELS(Eigen::half, int32);
+REGISTER_KERNELS(Eigen::half, int64);
 #undef REGISTER_KERNELS
 
 template <typename Device, typename T>
@@ -882,7 +926,6 @@ class SparseApplyFtrlOp : public OpKernel {
     if (N > 0) {
       if (inner_dim > 1) {
         const Tindex first_dim_size = var.dim_size(0);
-        auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat_outer_dims<T>();
         auto accum_flat = accum.flat_outer_dims<T>();
         auto linear_flat = linear.flat_outer_dims<T>();
@@ -892,16 +935,11 @@ class SparseApplyFtrlOp : public OpKernel {
         T l2_scalar = l2.scalar<T>()();
         T lr_power_scalar = lr_power.scalar<T>()();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
-          auto accum = accum_flat.template chip<0>(index);
-          auto linear = linear_flat.template chip<0>(index);
-          auto grad = grad_flat.template chip<0>(i);
-          auto var = var_flat.template chip<0>(index);
+        auto update_row = [&](Tindex i, Tindex index) {
+          auto accum = Row<T>(accum_flat, index);
+          auto linear = Row<T>(linear_flat, index);
+          auto grad = ConstRow<T>(grad_flat, i);
+          auto var = Row<T>(var_flat, index);
 
           auto new_accum = accum + grad.square();
           if (lr_power_scalar == -0.5) {
@@ -927,10 +965,18 @@ class SparseApplyFtrlOp : public OpKernel {
           var = (linear.abs() > linear.constant(l1_scalar))
                     .select(var, var.constant(0));
           accum += grad.square();
-        }
+        };
+        Tindex bad_index;
+        const Tindex bad_i = ParallelForEachRow<Tindex>(
+            *ctx->device()->tensorflow_cpu_worker_threads(),
+            indices.flat<Tindex>(), first_dim_size, 50 * inner_dim,
+            update_row, &bad_index);
+        OP_REQUIRES(ctx, bad_i < 0,
+                    errors::InvalidArgument(strings::StrCat(
+                        "Index ", bad_index, " at offset ", bad_i,
+                        " in indices is out of range")));
       } else {
         CHECK_EQ(1, inner_dim);
-        auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
         auto accum_flat = accum.flat<T>();
         auto linear_flat = linear.flat<T>();
@@ -941,12 +987,7 @@ class SparseApplyFtrlOp : public OpKernel {
         T lr_power_scalar = lr_power.scalar<T>()();
         const Tindex first_dim_size = accum_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update = [&](Tindex i, Tindex index) {
           T& a = accum_flat(index);
           T& l = linear_flat(index);
           T& v = var_flat(index);
@@ -960,7 +1001,15 @@ class SparseApplyFtrlOp : public OpKernel {
                           lr_power_scalar);
           a = updated_a;
           l = updated_l;
-        }
+        };
+        Tindex bad_index;
+        const Tindex bad_i = ParallelForEachRow<Tindex>(
+            *ctx->device()->tensorflow_cpu_worker_threads(),
+            indices.flat<Tindex>(), first_dim_size, 50, update, &bad_index);
+        OP_REQUIRES(ctx, bad_i < 0,
+                    errors::InvalidArgument(strings::StrCat(
+                        "Index ", bad_index, " at offset ", bad_i,
+                        " in indices is out of range")));
       }
     }
 
@@ -1124,31 +1173,39 @@ class SparseApplyMomentumOp : public OpKernel {
 
     if (N > 0) {
       const Tindex first_dim_size = var.dim_size(0);
-      auto indices_vec = indices.vec<Tindex>();
       auto var_flat = var.flat_outer_dims<T>();
       auto accum_flat = accum.flat_outer_dims<T>();
       auto grad_flat = grad.flat_outer_dims<T>();
-      T lr_scalar = lr.scalar<T>()();
-      T momentum_scalar = momentum.scalar<T>()();
-
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-        OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                    errors::InvalidArgument(
-                        strings::StrCat("Index ", index, " at offset ", i,
-                                        " in indices is out of range")));
-        auto a = accum_flat.template chip<0>(index);
-        auto g = grad_flat.template chip<0>(i);
-        auto v = var_flat.template chip<0>(index);
-        a = a * a.constant(momentum_scalar) + g;
-        v -= a.constant(lr_scalar) * a;
-      }
+      const U lr_scalar = static_cast<U>(lr.scalar<T>()());
+      const U momentum_scalar = static_cast<U>(momentum.scalar<T>()());
+
+      auto update_row = [&](Tindex i, Tindex index) {
+        auto a = Row<T>(accum_flat, index);
+        auto g = ConstRow<T>(grad_flat, i).template cast<U>();
+        auto v = Row<T>(var_flat, index);
+        a = (a.template cast<U>() * g.constant(momentum_scalar) + g)
+                .template cast<T>();
+        v = (v.template cast<U>() -
+             g.constant(lr_scalar) * a.template cast<U>())
+                .template cast<T>();
+      };
+      Tindex bad_index;
+      const Tindex bad_i = ParallelForEachRow<Tindex>(
+          *ctx->device()->tensorflow_cpu_worker_threads(),
+          indices.flat<Tindex>(), first_dim_size,
+          10 * grad_flat.dimension(1), update_row, &bad_index);
+      OP_REQUIRES(ctx, bad_i < 0,
+                  errors::InvalidArgument(strings::StrCat(
+                      "Index ", bad_index, " at offset ", bad_i,
+                      " in indices is out of range")));
     }
 
     ctx->forward_ref_input_to_ref_output(0, 0);
   }
 
  private:
+  typedef typename UpdateType<T>::type U;
+
   bool use_exclusive_lock_;
 };
 
@@ -1163,6 +1220,8 @@ REGISTER_KERNELS(float, int32);
 REGISTER_KERNELS(float, int64);
 REGISTER_KERNELS(double, int32);
 REGISTER_KERNELS(double, int64);
+REGISTER_KERNELS(Eigen::half, int32);
+REGISTER_KERNELS(Eigen::half, int64);
 #undef REGISTER_KERNELS
 
 template <typename Device, typename T>
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session_options.h"
@@ -233,4 +234,126 @@ static void BM_RMSProp(int iters, int params) {
 }
 BENCHMARK(BM_RMSProp)->Arg(128 << 10)->Arg(256 << 10);
 
+static Node* Var(Graph* g, const TensorShape& shape) {
+  return test::graph::Var(g, DT_FLOAT, shape);
+}
+
+static Node* Zeros(Graph* g, const TensorShape& shape) {
+  Tensor data(DT_FLOAT, shape);
+  data.flat<float>().setZero();
+  return test::graph::Constant(g, data);
+}
+
+static Node* Random(Graph* g, const TensorShape& shape) {
+  Tensor data(DT_FLOAT, shape);
+  data.flat<float>().setRandom();
+  return test::graph::Constant(g, data);
+}
+
+// "num_updates" ids of a sparse feature with "num_rows" values; most of
+// them are small.
+static Node* SkewedIndices(Graph* g, int num_rows, int num_updates) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  Tensor data(DT_INT32, TensorShape({num_updates}));
+  for (int i = 0; i < num_updates; ++i) {
+    data.flat<int32>()(i) = rnd.Skewed(17) % num_rows;
+  }
+  return test::graph::Constant(g, data);
+}
+
+// Sparse updates of 10000 rows of a [100000, dim] embedding.
+static const int kSparseRows = 100000;
+static const int kSparseUpdates = 10000;
+
+static void SparseInit(int dim, int num_slots, Graph** init_g) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const TensorShape shape({kSparseRows, dim});
+  // The variables must be created first to get the same names as in the
+  // training graph.
+  std::vector<Node*> vars;
+  for (int i = 0; i < num_slots; ++i) vars.push_back(Var(g, shape));
+  auto zero = Zeros(g, shape);
+  for (Node* var : vars) test::graph::Assign(g, var, zero);
+  *init_g = g;
+}
+
+static void SparseAdagrad(int dim, Graph** init_g, Graph** train_g) {
+  SparseInit(dim, 2, init_g);
+  Graph* g = new Graph(OpRegistry::Global());
+  const TensorShape shape({kSparseRows, dim});
+  auto var = Var(g, shape);
+  auto accum = Var(g, shape);
+  auto lr = Scalar(g, 0.01);
+  auto grad = Random(g, TensorShape({kSparseUpdates, dim}));
+  auto indices = SkewedIndices(g, kSparseRows, kSparseUpdates);
+  test::graph::Multi(g, "SparseApplyAdagrad",
+                     {var, accum, lr, grad, indices});
+  *train_g = g;
+}
+
+static void BM_SparseAdagrad(int iters, int dim) {
+  const int64 tot = static_cast<int64>(iters) * kSparseUpdates * dim;
+  testing::ItemsProcessed(tot);
+  Graph* init;
+  Graph* train;
+  SparseAdagrad(dim, &init, &train);
+  test::Benchmark("cpu", train, GetOptions(), init).Run(iters);
+}
+BENCHMARK(BM_SparseAdagrad)->Arg(1)->Arg(16)->Arg(128);
+
+static void SparseMomentum(int dim, Graph** init_g, Graph** train_g) {
+  SparseInit(dim, 2, init_g);
+  Graph* g = new Graph(OpRegistry::Global());
+  const TensorShape shape({kSparseRows, dim});
+  auto var = Var(g, shape);
+  auto accum = Var(g, shape);
+  auto lr = Scalar(g, 0.01);
+  auto grad = Random(g, TensorShape({kSparseUpdates, dim}));
+  auto indices = SkewedIndices(g, kSparseRows, kSparseUpdates);
+  auto mom = Scalar(g, 0.01);
+  test::graph::Multi(g, "SparseApplyMomentum",
+                     {var, accum, lr, grad, indices, mom});
+  *train_g = g;
+}
+
+static void BM_SparseMomentum(int iters, int dim) {
+  const int64 tot = static_cast<int64>(iters) * kSparseUpdates * dim;
+  testing::ItemsProcessed(tot);
+  Graph* init;
+  Graph* train;
+  SparseMomentum(dim, &init, &train);
+  test::Benchmark("cpu", train, GetOptions(), init).Run(iters);
+}
+BENCHMARK(BM_SparseMomentum)->Arg(1)->Arg(16)->Arg(128);
+
+static void SparseFtrl(int dim, Graph** init_g, Graph** train_g) {
+  SparseInit(dim, 3, init_g);
+  Graph* g = new Graph(OpRegistry::Global());
+  const TensorShape shape({kSparseRows, dim});
+  auto var = Var(g, shape);
+  auto accum = Var(g, shape);
+  auto linear = Var(g, shape);
+  auto grad = Random(g, TensorShape({kSparseUpdates, dim}));
+  auto indices = SkewedIndices(g, kSparseRows, kSparseUpdates);
+  auto lr = Scalar(g, 0.01);
+  auto l1 = Scalar(g, 0.0);
+  auto l2 = Scalar(g, 0.0);
+  auto lr_power = Scalar(g, -0.5);
+  test::graph::Multi(
+      g, "SparseApplyFtrl",
+      {var, accum, linear, grad, indices, lr, l1, l2, lr_power});
+  *train_g = g;
+}
+
+static void BM_SparseFtrl(int iters, int dim) {
+  const int64 tot = static_cast<int64>(iters) * kSparseUpdates * dim;
+  testing::ItemsProcessed(tot);
+  Graph* init;
+  Graph* train;
+  SparseFtrl(dim, &init, &train);
+  test::Benchmark("cpu", train, GetOptions(), init).Run(iters);
+}
+BENCHMARK(BM_SparseFtrl)->Arg(1)->Arg(16)->Arg(128);
+
 }  // end namespace tensorflow
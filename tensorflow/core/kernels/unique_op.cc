@@ -13,19 +13,124 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+namespace {
+
+// Inputs with at least this many elements are split among the worker
+// threads of the device, if it has several.
+const int64 kMinParallelUniqueSize = 1 << 17;
+
+// Estimated cost of hashing one element, and of looking it up in or
+// adding it to a map, in the units of Shard().
+const int64 kHashCost = 10;
+const int64 kInsertCost = 50;
+
+// Sets idx(i) to the index in "*first" of the first element equal to x(i),
+// where "*first" lists the positions of the first occurrences of the
+// distinct elements of x, in increasing order.
+template <typename T>
+void SerialUnique(typename TTypes<T>::ConstVec x,
+                  typename TTypes<int32>::Vec idx, std::vector<int32>* first) {
+  const int32 N = x.size();
+  gtl::FlatMap<T, int32> uniq;
+  for (int32 i = 0; i < N; ++i) {
+    auto it = uniq.insert(
+        std::make_pair(x(i), static_cast<int32>(first->size())));
+    idx(i) = it.first->second;
+    if (it.second) first->push_back(i);
+  }
+}
+
+// Like SerialUnique, on "worker_threads".  The elements are partitioned
+// by hash, and every partition is deduplicated into its own map by one
+// thread.  The ids of the distinct elements are then renumbered in order
+// of first occurrence, so the result is the same as SerialUnique's.
+template <typename T>
+void ParallelUnique(const DeviceBase::CpuWorkerThreads& worker_threads,
+                    typename TTypes<T>::ConstVec x,
+                    typename TTypes<int32>::Vec idx,
+                    std::vector<int32>* first) {
+  typedef gtl::FlatMap<T, int32> Map;
+  const int32 N = x.size();
+  const int num_threads = worker_threads.num_threads;
+  thread::ThreadPool* workers = worker_threads.workers;
+
+  // The partition of an element is taken from the top bits of its hash,
+  // which the maps do not use to pick slots until they are huge.
+  int num_parts = 1;
+  while (num_parts < num_threads && num_parts < 256) num_parts <<= 1;
+  const int shift = sizeof(size_t) * 8 - Log2Floor(num_parts);
+  auto part_of = [num_parts, shift](size_t hash) -> int {
+    return num_parts == 1 ? 0 : hash >> shift;
+  };
+
+  std::vector<size_t> hashes(N);
+  Shard(num_threads, workers, N, kHashCost,
+        [&x, &hashes](int64 start, int64 limit) {
+          const typename Map::hasher hash;
+          for (int64 i = start; i < limit; ++i) hashes[i] = hash(x(i));
+        });
+
+  // Counting sort of the elements by partition, keeping them in order.
+  std::vector<int32> part_start(num_parts + 1, 0);
+  for (int32 i = 0; i < N; ++i) ++part_start[part_of(hashes[i]) + 1];
+  for (int p = 0; p < num_parts; ++p) part_start[p + 1] += part_start[p];
+  std::vector<int32> order(N);
+  {
+    std::vector<int32> next(part_start.begin(), part_start.end() - 1);
+    for (int32 i = 0; i < N; ++i) order[next[part_of(hashes[i])]++] = i;
+  }
+
+  // Sets idx(i) to the id of x(i) within its partition.  Ids are given in
+  // increasing order of i.
+  Shard(num_threads, workers, num_parts, N / num_parts * kInsertCost,
+        [&](int64 start, int64 limit) {
+          for (int64 p = start; p < limit; ++p) {
+            Map uniq;
+            for (int32 k = part_start[p]; k < part_start[p + 1]; ++k) {
+              const int32 i = order[k];
+              const int32 id = uniq.size();
+              idx(i) = uniq.insert_hashed(hashes[i], std::make_pair(x(i), id))
+                           .first->second;
+            }
+          }
+        });
+
+  // x(i) occurs first at i if its id is the next one of its partition.
+  std::vector<std::vector<int32>> ids(num_parts);
+  for (int32 i = 0; i < N; ++i) {
+    std::vector<int32>* part_ids = &ids[part_of(hashes[i])];
+    if (idx(i) == static_cast<int32>(part_ids->size())) {
+      part_ids->push_back(first->size());
+      first->push_back(i);
+    }
+  }
+
+  Shard(num_threads, workers, N, kHashCost,
+        [&idx, &ids, &hashes, &part_of](int64 start, int64 limit) {
+          for (int64 i = start; i < limit; ++i) {
+            idx(i) = ids[part_of(hashes[i])][idx(i)];
+          }
+        });
+}
+
+}  // namespace
+
 template <typename T>
 class UniqueOp : public OpKernel {
  public:
@@ -49,23 +154,22 @@ class UniqueOp : public OpKernel {
     OP_REQUIRES_OK(context, context->allocate_output(1, input.shape(), &idx));
     auto idx_vec = idx->template vec<int32>();
 
-    std::unordered_map<T, int32> uniq;
-    uniq.reserve(2 * N);
-    for (int64 i = 0, j = 0; i < N; ++i) {
-      auto it = uniq.insert(std::make_pair(Tin(i), j));
-      idx_vec(i) = it.first->second;
-      if (it.second) {
-        ++j;
-      }
+    std::vector<int32> first;
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    if (worker_threads.num_threads > 1 && N >= kMinParallelUniqueSize) {
+      ParallelUnique<T>(worker_threads, Tin, idx_vec, &first);
+    } else {
+      SerialUnique<T>(Tin, idx_vec, &first);
     }
-    int64 uniq_size = static_cast<int64>(uniq.size());
+    int64 uniq_size = static_cast<int64>(first.size());
     Tensor* output = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(
                                 0, TensorShape({uniq_size}), &output));
     auto output_vec = output->template vec<T>();
 
-    for (auto it : uniq) {
-      output_vec(it.second) = it.first;
+    for (int64 j = 0; j < uniq_size; ++j) {
+      output_vec(j) = Tin(first[j]);
     }
 
     if (num_outputs() > 2) {
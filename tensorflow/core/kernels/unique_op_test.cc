@@ -15,16 +15,22 @@ limitations under the License.
 
 #include <functional>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -32,6 +38,79 @@ namespace tensorflow {
 
 namespace {
 
+class UniqueOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const string& op, DataType type) {
+    TF_ASSERT_OK(NodeDefBuilder("myop", op)
+                     .Input(FakeInput(type))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(UniqueOpTest, Simple) {
+  MakeOp("Unique", DT_INT32);
+  AddInputFromArray<int32>(TensorShape({7}), {3, 1, 3, 2, 1, 4, 3});
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<int32>(test::AsTensor<int32>({3, 1, 2, 4}),
+                                 *GetOutput(0));
+  test::ExpectTensorEqual<int32>(test::AsTensor<int32>({0, 1, 0, 2, 1, 3, 0}),
+                                 *GetOutput(1));
+}
+
+TEST_F(UniqueOpTest, WithCounts) {
+  MakeOp("UniqueWithCounts", DT_FLOAT);
+  AddInputFromArray<float>(TensorShape({6}), {1.5, -2, 1.5, 0, 0, 1.5});
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({1.5, -2, 0}),
+                                 *GetOutput(0));
+  test::ExpectTensorEqual<int32>(test::AsTensor<int32>({0, 1, 0, 2, 2, 0}),
+                                 *GetOutput(1));
+  test::ExpectTensorEqual<int32>(test::AsTensor<int32>({3, 1, 2}),
+                                 *GetOutput(2));
+}
+
+TEST_F(UniqueOpTest, Empty) {
+  MakeOp("Unique", DT_INT64);
+  AddInputFromArray<int64>(TensorShape({0}), {});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(0, GetOutput(0)->NumElements());
+  EXPECT_EQ(0, GetOutput(1)->NumElements());
+}
+
+// Large enough to be split over the worker threads, if there are several.
+TEST_F(UniqueOpTest, LargeInput) {
+  const int kSize = 1 << 18;
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<int64> x(kSize);
+  for (int64& v : x) v = rnd.Uniform(kSize / 4) * 1000003;
+
+  std::vector<int64> expected_y;
+  std::vector<int32> expected_idx;
+  std::vector<int32> expected_count;
+  std::unordered_map<int64, int32> ids;
+  for (int64 v : x) {
+    auto it = ids.insert({v, expected_y.size()});
+    if (it.second) {
+      expected_y.push_back(v);
+      expected_count.push_back(0);
+    }
+    expected_idx.push_back(it.first->second);
+    ++expected_count[it.first->second];
+  }
+
+  MakeOp("UniqueWithCounts", DT_INT64);
+  AddInputFromArray<int64>(TensorShape({kSize}), x);
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<int64>(test::AsTensor<int64>(expected_y),
+                                 *GetOutput(0));
+  test::ExpectTensorEqual<int32>(test::AsTensor<int32>(expected_idx),
+                                 *GetOutput(1));
+  test::ExpectTensorEqual<int32>(test::AsTensor<int32>(expected_count),
+                                 *GetOutput(2));
+}
+
 static void BM_Unique(int iters, int dim) {
   testing::StopTiming();
   Graph* g = new Graph(OpRegistry::Global());
@@ -60,5 +139,34 @@ BENCHMARK(BM_Unique)
     ->Arg(64 * 1024)
     ->Arg(256 * 1024);
 
+// Input of "dim" int64s, with about 16 copies of each distinct value.
+static void BM_UniqueWithDuplicates(int iters, int dim) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  Tensor input(DT_INT64, TensorShape({dim}));
+  auto x = input.flat<int64>();
+  for (int i = 0; i < dim; ++i) x(i) = rnd.Uniform64(dim / 16 + 1);
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Unique")
+                  .Input(test::graph::Constant(g, input))
+                  .Attr("T", DT_INT64)
+                  .Finalize(g, &node));
+
+  testing::BytesProcessed(static_cast<int64>(iters) * dim * sizeof(int64));
+  testing::UseRealTime();
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+BENCHMARK(BM_UniqueWithDuplicates)
+    ->Arg(1024)
+    ->Arg(64 * 1024)
+    ->Arg(1024 * 1024)
+    ->Arg(4 * 1024 * 1024);
+
 }  // namespace
 }  // namespace tensorflow
@@ -15,6 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/threadpool.h"
 
+#include <atomic>
+#include <deque>
+#include <vector>
+
+#include "tensorflow/core/lib/core/work_stealing_queue.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -24,18 +29,74 @@ limitations under the License.
 namespace tensorflow {
 namespace thread {
 
-struct ThreadPool::Waiter {
-  condition_variable cv;
-  bool ready;
+namespace {
+
+struct Item {
+  std::function<void()> fn;
+  uint64 id;
 };
 
-ThreadPool::ThreadPool(Env* env, const string& name, int num_threads)
-    : ThreadPool(env, ThreadOptions(), name, num_threads) {}
+// Returns an Item for "fn", recording a schedule event if tracing is on.
+Item MakeItem(std::function<void()> fn) {
+  CHECK(fn != nullptr);
+  uint64 id = 0;
+  if (port::Tracing::IsActive()) {
+    id = port::Tracing::UniqueId();
+    port::Tracing::RecordEvent(port::Tracing::EventCategory::kScheduleClosure,
+                               id);
+  }
+  return {std::move(fn), id};
+}
 
-ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
-                       const string& name, int num_threads)
+void RunItem(const Item& item) {
+  if (item.id != 0) {
+    port::Tracing::ScopedActivity region(
+        port::Tracing::EventCategory::kRunClosure, item.id);
+    item.fn();
+  } else {
+    item.fn();
+  }
+}
+
+}  // namespace
+
+class ThreadPool::Impl {
+ public:
+  virtual ~Impl() {}
+  virtual void Schedule(std::function<void()> fn) = 0;
+  virtual bool HasPendingClosures() const = 0;
+};
+
+// The original pool: a single FIFO queue of closures and a LIFO stack of
+// idle workers, both guarded by one mutex.
+class ThreadPool::SharedQueueImpl : public ThreadPool::Impl {
+ public:
+  SharedQueueImpl(Env* env, const ThreadOptions& thread_options,
+                  const string& name, int num_threads);
+  ~SharedQueueImpl() override;
+
+  void Schedule(std::function<void()> fn) override;
+  bool HasPendingClosures() const override;
+
+ private:
+  struct Waiter {
+    condition_variable cv;
+    bool ready;
+  };
+
+  void WorkerLoop();
+
+  const string name_;
+  mutable mutex mu_;
+  std::vector<Thread*> threads_;  // All threads
+  std::vector<Waiter*> waiters_;  // Stack of waiting threads.
+  std::deque<Item> pending_;      // Queue of pending work
+};
+
+ThreadPool::SharedQueueImpl::SharedQueueImpl(
+    Env* env, const ThreadOptions& thread_options, const string& name,
+    int num_threads)
     : name_(name) {
-  CHECK_GE(num_threads, 1);
   string name_prefix = "tf_" + name_;
   for (int i = 0; i < num_threads; i++) {
     threads_.push_back(env->StartThread(thread_options, name_prefix,
@@ -43,7 +104,7 @@ ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
   }
 }
 
-ThreadPool::~ThreadPool() {
+ThreadPool::SharedQueueImpl::~SharedQueueImpl() {
   {
     // Wait for all work to get done.
     mutex_lock l(mu_);
@@ -66,22 +127,16 @@ ThreadPool::~ThreadPool() {
   }
 }
 
-bool ThreadPool::HasPendingClosures() const {
+bool ThreadPool::SharedQueueImpl::HasPendingClosures() const {
   mutex_lock l(mu_);
   return pending_.size() != 0;
 }
 
-void ThreadPool::Schedule(std::function<void()> fn) {
-  CHECK(fn != nullptr);
-  uint64 id = 0;
-  if (port::Tracing::IsActive()) {
-    id = port::Tracing::UniqueId();
-    port::Tracing::RecordEvent(port::Tracing::EventCategory::kScheduleClosure,
-                               id);
-  }
+void ThreadPool::SharedQueueImpl::Schedule(std::function<void()> fn) {
+  Item item = MakeItem(std::move(fn));
 
   mutex_lock l(mu_);
-  pending_.push_back({fn, id});
+  pending_.push_back(std::move(item));
   if (!waiters_.empty()) {
     Waiter* w = waiters_.back();
     waiters_.pop_back();
@@ -90,7 +145,7 @@ void ThreadPool::Schedule(std::function<void()> fn) {
   }
 }
 
-void ThreadPool::WorkerLoop() {
+void ThreadPool::SharedQueueImpl::WorkerLoop() {
   // Set the processor flag to flush denormals to zero
   port::ScopedFlushDenormal flush;
 
@@ -107,22 +162,278 @@ void ThreadPool::WorkerLoop() {
       }
     }
     // Pick up pending work
-    Item item = pending_.front();
+    Item item = std::move(pending_.front());
     pending_.pop_front();
     if (item.fn == nullptr) {
       break;
     }
     mu_.unlock();
-    if (item.id != 0) {
-      port::Tracing::ScopedActivity region(
-          port::Tracing::EventCategory::kRunClosure, item.id);
-      item.fn();
-    } else {
-      item.fn();
-    }
+    RunItem(item);
     mu_.lock();
   }
 }
 
+// Work-stealing pool.
+//
+// Each worker owns a WorkStealingQueue.  Schedule() called from a worker of
+// this pool pushes onto that worker's queue, so the common executor pattern
+// of "finish a node, schedule its successors" never touches shared state.
+// Schedule() called from any other thread (or from a worker whose queue is
+// full) appends to "injection_", a mutex-guarded FIFO.
+//
+// A worker looking for work tries, in order: its own queue (LIFO, for
+// cache locality), the injection queue, and then the other workers' queues
+// starting from a random victim (FIFO, so thieves take the oldest and
+// typically largest pieces of work).  If that fails it spins for a while
+// and finally parks on "park_cv_".
+//
+// Lost wakeups are avoided with a Dekker-style handshake on sequentially
+// consistent atomics: a producer publishes its item and then reads
+// "num_spinning_"/"num_parked_"; a worker announces itself in those
+// counters and then re-scans every queue before blocking.  At least one
+// side is guaranteed to observe the other.  To avoid waking everyone on a
+// burst, a producer only wakes a parked worker when nobody is spinning; a
+// spinner that finds work wakes a replacement if it was the last spinner.
+class ThreadPool::WorkStealingImpl : public ThreadPool::Impl {
+ public:
+  WorkStealingImpl(Env* env, const ThreadOptions& thread_options,
+                   const string& name, int num_threads);
+  ~WorkStealingImpl() override;
+
+  void Schedule(std::function<void()> fn) override;
+  bool HasPendingClosures() const override;
+
+ private:
+  // Per-worker deque capacity.  Overflow goes to the injection queue.
+  static const int64 kQueueCapacity = 1024;
+  // Number of full scans over all queues a worker does before parking.
+  static const int kSpinRounds = 64;
+
+  // Identifies the pool and worker index of the calling thread, if any.
+  struct PerThread {
+    const WorkStealingImpl* pool = nullptr;
+    int index = -1;
+    uint64 rng = 0;
+  };
+  static PerThread* GetPerThread() {
+    static thread_local PerThread per_thread;
+    return &per_thread;
+  }
+
+  void WorkerLoop(int index);
+
+  // Returns the next item for worker "index" from its own queue, the
+  // injection queue or a victim's queue, or nullptr if all are empty.
+  Item* FindWork(int index, uint64* rng);
+  Item* PopInjection();
+  Item* Steal(int index, uint64* rng);
+
+  // Blocks until work is available or the pool is shutting down.  Returns
+  // nullptr only in the latter case.
+  Item* Park(int index, uint64* rng);
+  void WakeOne();
+
+  const string name_;
+  std::vector<std::unique_ptr<WorkStealingQueue<Item>>> queues_;
+  std::vector<Thread*> threads_;
+
+  mutable mutex injection_mu_;
+  std::deque<Item*> injection_ GUARDED_BY(injection_mu_);
+  std::atomic<int64> injection_size_{0};
+
+  std::atomic<int> num_spinning_{0};
+  std::atomic<int> num_parked_{0};
+
+  mutex park_mu_;
+  condition_variable park_cv_;
+  int wakeups_ GUARDED_BY(park_mu_) = 0;
+  bool done_ GUARDED_BY(park_mu_) = false;
+};
+
+ThreadPool::WorkStealingImpl::WorkStealingImpl(
+    Env* env, const ThreadOptions& thread_options, const string& name,
+    int num_threads)
+    : name_(name) {
+  for (int i = 0; i < num_threads; i++) {
+    queues_.emplace_back(new WorkStealingQueue<Item>(kQueueCapacity));
+  }
+  string name_prefix = "tf_" + name_;
+  for (int i = 0; i < num_threads; i++) {
+    threads_.push_back(env->StartThread(thread_options, name_prefix,
+                                        [this, i]() { WorkerLoop(i); }));
+  }
+}
+
+ThreadPool::WorkStealingImpl::~WorkStealingImpl() {
+  {
+    mutex_lock l(park_mu_);
+    done_ = true;
+    park_cv_.notify_all();
+  }
+  // Workers drain every queue before exiting.
+  for (auto t : threads_) {
+    delete t;
+  }
+  CHECK_EQ(injection_size_.load(), 0);
+}
+
+bool ThreadPool::WorkStealingImpl::HasPendingClosures() const {
+  if (injection_size_.load(std::memory_order_relaxed) != 0) return true;
+  for (const auto& q : queues_) {
+    if (!q->Empty()) return true;
+  }
+  return false;
+}
+
+void ThreadPool::WorkStealingImpl::Schedule(std::function<void()> fn) {
+  Item* item = new Item(MakeItem(std::move(fn)));
+
+  PerThread* pt = GetPerThread();
+  if (pt->pool != this || !queues_[pt->index]->Push(item)) {
+    mutex_lock l(injection_mu_);
+    injection_.push_back(item);
+    injection_size_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Pairs with the fence in Park(): either a parked worker's re-scan sees
+  // "item", or we see that worker in num_parked_.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (num_spinning_.load(std::memory_order_seq_cst) == 0 &&
+      num_parked_.load(std::memory_order_seq_cst) > 0) {
+    WakeOne();
+  }
+}
+
+void ThreadPool::WorkStealingImpl::WakeOne() {
+  mutex_lock l(park_mu_);
+  if (wakeups_ < num_parked_.load(std::memory_order_relaxed)) {
+    ++wakeups_;
+    park_cv_.notify_one();
+  }
+}
+
+Item* ThreadPool::WorkStealingImpl::PopInjection() {
+  if (injection_size_.load(std::memory_order_relaxed) == 0) return nullptr;
+  mutex_lock l(injection_mu_);
+  if (injection_.empty()) return nullptr;
+  Item* item = injection_.front();
+  injection_.pop_front();
+  injection_size_.fetch_sub(1, std::memory_order_relaxed);
+  return item;
+}
+
+Item* ThreadPool::WorkStealingImpl::Steal(int index, uint64* rng) {
+  const int n = queues_.size();
+  if (n <= 1) return nullptr;
+  // xorshift64*
+  *rng ^= *rng >> 12;
+  *rng ^= *rng << 25;
+  *rng ^= *rng >> 27;
+  const int start = static_cast<int>((*rng * 2685821657736338717ULL) % n);
+  for (int i = 0; i < n; ++i) {
+    const int victim = (start + i) % n;
+    if (victim == index) continue;
+    Item* item = queues_[victim]->Steal();
+    if (item != nullptr) return item;
+  }
+  return nullptr;
+}
+
+Item* ThreadPool::WorkStealingImpl::FindWork(int index, uint64* rng) {
+  Item* item = queues_[index]->Pop();
+  if (item == nullptr) item = PopInjection();
+  if (item == nullptr) item = Steal(index, rng);
+  return item;
+}
+
+Item* ThreadPool::WorkStealingImpl::Park(int index, uint64* rng) {
+  mutex_lock l(park_mu_);
+  num_parked_.fetch_add(1, std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (true) {
+    Item* item = FindWork(index, rng);
+    if (item != nullptr || done_) {
+      num_parked_.fetch_sub(1, std::memory_order_relaxed);
+      // Consume any wakeup left for us, or WakeOne() would count it against
+      // the workers still parked and skip their notify.
+      if (wakeups_ > 0) --wakeups_;
+      return item;
+    }
+    if (wakeups_ > 0) {
+      // Somebody scheduled work since we last looked; re-scan.
+      --wakeups_;
+      continue;
+    }
+    park_cv_.wait(l);
+  }
+}
+
+void ThreadPool::WorkStealingImpl::WorkerLoop(int index) {
+  // Set the processor flag to flush denormals to zero
+  port::ScopedFlushDenormal flush;
+
+  port::Tracing::RegisterCurrentThread(name_.c_str());
+  PerThread* pt = GetPerThread();
+  pt->pool = this;
+  pt->index = index;
+  pt->rng = 0x9E3779B97F4A7C15ULL * (index + 1);
+  const int num_threads = queues_.size();
+  while (true) {
+    Item* item = FindWork(index, &pt->rng);
+    if (item == nullptr && 2 * num_spinning_.load() < num_threads) {
+      num_spinning_.fetch_add(1, std::memory_order_seq_cst);
+      for (int i = 0; i < kSpinRounds && item == nullptr; ++i) {
+        item = FindWork(index, &pt->rng);
+      }
+      if (num_spinning_.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+          item != nullptr && num_parked_.load(std::memory_order_seq_cst) > 0) {
+        // We were the last spinner; there may be more work behind this item.
+        WakeOne();
+      }
+    }
+    if (item == nullptr) {
+      item = Park(index, &pt->rng);
+      if (item == nullptr) break;  // Shutting down and nothing left to do.
+    }
+    RunItem(*item);
+    delete item;
+  }
+  pt->pool = nullptr;
+  pt->index = -1;
+}
+
+ThreadPool::ThreadPool(Env* env, const string& name, int num_threads)
+    : ThreadPool(env, ThreadOptions(), name, num_threads) {}
+
+ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
+                       const string& name, int num_threads)
+    : ThreadPool(env, thread_options, name, num_threads,
+                 Scheduler::kWorkStealing) {}
+
+ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
+                       const string& name, int num_threads,
+                       Scheduler scheduler) {
+  CHECK_GE(num_threads, 1);
+  switch (scheduler) {
+    case Scheduler::kWorkStealing:
+      impl_.reset(
+          new WorkStealingImpl(env, thread_options, name, num_threads));
+      break;
+    case Scheduler::kSharedQueue:
+      impl_.reset(new SharedQueueImpl(env, thread_options, name, num_threads));
+      break;
+  }
+}
+
+ThreadPool::~ThreadPool() {}
+
+void ThreadPool::Schedule(std::function<void()> fn) {
+  impl_->Schedule(std::move(fn));
+}
+
+bool ThreadPool::HasPendingClosures() const {
+  return impl_->HasPendingClosures();
+}
+
 }  // namespace thread
 }  // namespace tensorflow
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <deque>
 #include <functional>
+#include <memory>
 #include <thread>
 #include <vector>
 #include "tensorflow/core/platform/env.h"
@@ -30,6 +31,18 @@ namespace thread {
 
 class ThreadPool {
  public:
+  // How closures are handed to the worker threads.
+  enum class Scheduler {
+    // Every worker owns a lock-free deque.  Closures scheduled from a
+    // worker go to that worker's deque and are run LIFO by it; idle
+    // workers steal from a randomly chosen victim, spin briefly, and then
+    // park.  Closures scheduled from outside the pool go through a shared
+    // injection queue.
+    kWorkStealing,
+    // All closures go through one mutex-guarded FIFO queue.
+    kSharedQueue,
+  };
+
   // Construct a pool that contains "num_threads" threads with specified "name".
   // env->StartThread() is used to create individual threads.
   //
@@ -43,6 +56,13 @@ class ThreadPool {
   ThreadPool(Env* env, const ThreadOptions& thread_options, const string& name,
              int num_threads);
 
+  // Same as above, but with an explicit scheduling strategy.  The
+  // constructors above use Scheduler::kWorkStealing.
+  //
+  // REQUIRES: num_threads > 0
+  ThreadPool(Env* env, const ThreadOptions& thread_options, const string& name,
+             int num_threads, Scheduler scheduler);
+
   // Wait until all scheduled work has finished and then destroy the
   // set of threads.
   virtual ~ThreadPool();
@@ -53,19 +73,11 @@ class ThreadPool {
   virtual bool HasPendingClosures() const;
 
  private:
-  struct Waiter;
-  struct Item {
-    std::function<void()> fn;
-    uint64 id;
-  };
-
-  void WorkerLoop();
+  class Impl;
+  class SharedQueueImpl;
+  class WorkStealingImpl;
 
-  const string name_;
-  mutable mutex mu_;
-  std::vector<Thread*> threads_;  // All threads
-  std::vector<Waiter*> waiters_;  // Stack of waiting threads.
-  std::deque<Item> pending_;      // Queue of pending work
+  std::unique_ptr<Impl> impl_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ThreadPool);
 };
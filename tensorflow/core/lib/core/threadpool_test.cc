@@ -16,7 +16,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 
 #include <atomic>
+#include <chrono>
 
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -56,8 +58,131 @@ TEST(ThreadPool, DoWork) {
   }
 }
 
-static void BM_Sequential(int iters) {
-  ThreadPool pool(Env::Default(), "test", kNumThreads);
+TEST(ThreadPool, SharedQueueDoWork) {
+  for (int num_threads = 1; num_threads < kNumThreads; num_threads++) {
+    const int kWorkItems = 15;
+    std::atomic<int> work[kWorkItems];
+    for (int i = 0; i < kWorkItems; i++) {
+      work[i] = 0;
+    }
+    {
+      ThreadPool pool(Env::Default(), ThreadOptions(), "test", num_threads,
+                      ThreadPool::Scheduler::kSharedQueue);
+      for (int i = 0; i < kWorkItems; i++) {
+        pool.Schedule([&work, i]() { work[i]++; });
+      }
+    }
+    for (int i = 0; i < kWorkItems; i++) {
+      ASSERT_EQ(1, work[i]);
+    }
+  }
+}
+
+// Closures scheduled from inside the pool land on the worker's own queue
+// and must still all run (and be stolen by the other workers) before the
+// destructor returns.
+TEST(ThreadPool, NestedSchedule) {
+  for (int num_threads = 1; num_threads < kNumThreads; num_threads += 4) {
+    const int kFanout = 8;
+    const int kDepth = 4;  // kFanout^kDepth leaves
+    std::atomic<int64> leaves(0);
+    // Must outlive the pool, whose destructor runs the pending closures.
+    std::function<void(int)> spawn;
+    {
+      ThreadPool pool(Env::Default(), "test", num_threads);
+      spawn = [&pool, &leaves, &spawn](int depth) {
+        if (depth == 0) {
+          leaves++;
+          return;
+        }
+        for (int i = 0; i < kFanout; ++i) {
+          pool.Schedule([&spawn, depth]() { spawn(depth - 1); });
+        }
+      };
+      pool.Schedule([&spawn]() { spawn(kDepth); });
+    }
+    ASSERT_EQ(8 * 8 * 8 * 8, leaves);
+  }
+}
+
+// More closures than a worker's deque can hold spill to the shared queue.
+TEST(ThreadPool, LocalQueueOverflow) {
+  const int kItems = 10000;
+  std::atomic<int> count(0);
+  {
+    ThreadPool pool(Env::Default(), "test", 2);
+    pool.Schedule([&pool, &count]() {
+      for (int i = 0; i < kItems; ++i) {
+        pool.Schedule([&count]() { count++; });
+      }
+    });
+  }
+  ASSERT_EQ(kItems, count);
+}
+
+// A closure that blocks on one it scheduled itself needs another worker
+// to run it, even though that worker went to sleep before either closure
+// was scheduled.
+TEST(ThreadPool, WakesParkedWorkerForNestedClosure) {
+  ThreadPool pool(Env::Default(), "test", 2);
+  for (int round = 0; round < 10; ++round) {
+    // Give both workers time to finish spinning and park.
+    Env::Default()->SleepForMicroseconds(50000);
+    mutex mu;
+    condition_variable cv;
+    bool inner_ran = false;
+    Notification outer_done;
+    pool.Schedule([&pool, &mu, &cv, &inner_ran, &outer_done]() {
+      pool.Schedule([&mu, &cv, &inner_ran]() {
+        mutex_lock l(mu);
+        inner_ran = true;
+        cv.notify_all();
+      });
+      {
+        // Bounded, so that a lost wakeup fails the test instead of hanging.
+        mutex_lock l(mu);
+        for (int i = 0; i < 100 && !inner_ran; ++i) {
+          cv.wait_for(l, std::chrono::milliseconds(100));
+        }
+      }
+      outer_done.Notify();
+    });
+    outer_done.WaitForNotification();
+    mutex_lock l(mu);
+    ASSERT_TRUE(inner_ran) << "round " << round;
+  }
+}
+
+TEST(ThreadPool, HasPendingClosures) {
+  ThreadPool pool(Env::Default(), "test", 1);
+  mutex mu;
+  condition_variable cv;
+  bool release = false;
+  pool.Schedule([&mu, &cv, &release]() {
+    mutex_lock l(mu);
+    while (!release) cv.wait(l);
+  });
+  pool.Schedule([]() {});
+  // The single worker is blocked in the first closure, so the second one
+  // is still queued.
+  EXPECT_TRUE(pool.HasPendingClosures());
+  {
+    mutex_lock l(mu);
+    release = true;
+    cv.notify_all();
+  }
+}
+
+// Benchmarks take the scheduler as their argument so the work-stealing and
+// shared-queue pools can be compared side by side.
+static ThreadPool::Scheduler SchedulerFromArg(int arg) {
+  return arg == 0 ? ThreadPool::Scheduler::kWorkStealing
+                  : ThreadPool::Scheduler::kSharedQueue;
+}
+
+static void BM_Sequential(int iters, int scheduler) {
+  ThreadPool pool(Env::Default(), ThreadOptions(), "test", kNumThreads,
+                  SchedulerFromArg(scheduler));
   // Decrement count sequentially until 0.
   int count = iters;
   mutex done_lock;
@@ -79,10 +204,11 @@ static void BM_Sequential(int iters) {
     done.wait(l);
   }
 }
-BENCHMARK(BM_Sequential);
+BENCHMARK(BM_Sequential)->Arg(0)->Arg(1);
 
-static void BM_Parallel(int iters) {
-  ThreadPool pool(Env::Default(), "test", kNumThreads);
+static void BM_Parallel(int iters, int scheduler) {
+  ThreadPool pool(Env::Default(), ThreadOptions(), "test", kNumThreads,
+                  SchedulerFromArg(scheduler));
   // Decrement count concurrently until 0.
   std::atomic_int_fast32_t count(iters);
   mutex done_lock;
@@ -102,7 +228,37 @@ static void BM_Parallel(int iters) {
     done.wait(l);
   }
 }
-BENCHMARK(BM_Parallel);
+BENCHMARK(BM_Parallel)->Arg(0)->Arg(1);
+
+// Models the executor: every closure running on a worker fans out more
+// small closures from that worker, until "iters" closures have run.
+static void BM_FanOut(int iters, int scheduler) {
+  ThreadPool pool(Env::Default(), ThreadOptions(), "test", kNumThreads,
+                  SchedulerFromArg(scheduler));
+  std::atomic<int64> remaining(iters);
+  mutex done_lock;
+  condition_variable done;
+  bool done_flag = false;
+  // Runs one closure and spawns the closures for the other n - 1.
+  std::function<void(int64)> work = [&pool, &remaining, &done_lock, &done,
+                                     &done_flag, &work](int64 n) {
+    const int64 left = (n - 1) / 2;
+    const int64 right = n - 1 - left;
+    if (left > 0) pool.Schedule([&work, left]() { work(left); });
+    if (right > 0) pool.Schedule([&work, right]() { work(right); });
+    if (remaining.fetch_sub(1) == 1) {
+      mutex_lock l(done_lock);
+      done_flag = true;
+      done.notify_all();
+    }
+  };
+  pool.Schedule([&work, iters]() { work(iters); });
+  mutex_lock l(done_lock);
+  while (!done_flag) {
+    done.wait(l);
+  }
+}
+BENCHMARK(BM_FanOut)->Arg(0)->Arg(1);
 
 }  // namespace thread
 }  // namespace tensorflow
@@ -0,0 +1,131 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LIB_CORE_WORK_STEALING_QUEUE_H_
+#define TENSORFLOW_LIB_CORE_WORK_STEALING_QUEUE_H_
+
+#include <atomic>
+#include <memory>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A fixed-capacity, lock-free, single-producer multi-consumer deque of
+// T* (Chase & Lev, "Dynamic Circular Work-Stealing Deque", SPAA '05,
+// using the C11 memory orderings of Le et al., PPoPP '13).
+//
+// Exactly one thread (the "owner") may call Push() and Pop(); they
+// operate on the bottom of the deque, so the owner sees its own work in
+// LIFO order.  Any thread may call Steal(), which takes the oldest
+// element from the top.
+//
+// The capacity is fixed at construction.  Push() returns false when the
+// deque is full; callers are expected to spill the element elsewhere.
+template <typename T>
+class WorkStealingQueue {
+ public:
+  // REQUIRES: capacity is a power of two.
+  explicit WorkStealingQueue(int64 capacity)
+      : mask_(capacity - 1), buffer_(new std::atomic<T*>[capacity]) {
+    CHECK_GT(capacity, 0);
+    CHECK_EQ(capacity & mask_, 0) << "capacity must be a power of two";
+    for (int64 i = 0; i < capacity; ++i) {
+      buffer_[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  // Owner only.  Appends "item" to the bottom of the deque.  Returns
+  // false, leaving the deque unchanged, if the deque is full.
+  //
+  // REQUIRES: item != nullptr
+  bool Push(T* item) {
+    const int64 b = bottom_.load(std::memory_order_relaxed);
+    const int64 t = top_.load(std::memory_order_acquire);
+    if (b - t > mask_) return false;
+    buffer_[b & mask_].store(item, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Owner only.  Removes and returns the most recently pushed element, or
+  // nullptr if the deque is empty.
+  T* Pop() {
+    const int64 b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64 t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      // Empty.
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T* item = buffer_[b & mask_].load(std::memory_order_relaxed);
+    if (t == b) {
+      // Last element: race against concurrent thieves for it.
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        item = nullptr;
+      }
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Any thread.  Removes and returns the oldest element, or nullptr if the
+  // deque is empty.  Retries internally when it loses a race to another
+  // thief or the owner, so a nullptr return really means "observed empty".
+  T* Steal() {
+    while (true) {
+      int64 t = top_.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const int64 b = bottom_.load(std::memory_order_acquire);
+      if (t >= b) return nullptr;
+      T* item = buffer_[t & mask_].load(std::memory_order_relaxed);
+      if (top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed)) {
+        return item;
+      }
+    }
+  }
+
+  // Any thread.  Returns a racy estimate of the number of elements.
+  int64 Size() const {
+    const int64 b = bottom_.load(std::memory_order_relaxed);
+    const int64 t = top_.load(std::memory_order_relaxed);
+    return b > t ? b - t : 0;
+  }
+
+  bool Empty() const { return Size() == 0; }
+
+  int64 Capacity() const { return mask_ + 1; }
+
+ private:
+  // top_ and bottom_ are written by different threads; keep them on
+  // separate cache lines.
+  alignas(64) std::atomic<int64> top_{0};
+  alignas(64) std::atomic<int64> bottom_{0};
+  const int64 mask_;
+  std::unique_ptr<std::atomic<T*>[]> buffer_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingQueue);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_CORE_WORK_STEALING_QUEUE_H_
@@ -0,0 +1,112 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/core/work_stealing_queue.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(WorkStealingQueue, Empty) {
+  WorkStealingQueue<int> q(4);
+  EXPECT_TRUE(q.Empty());
+  EXPECT_EQ(nullptr, q.Pop());
+  EXPECT_EQ(nullptr, q.Steal());
+  EXPECT_EQ(4, q.Capacity());
+}
+
+TEST(WorkStealingQueue, PopIsLifoStealIsFifo) {
+  int v[4] = {0, 1, 2, 3};
+  WorkStealingQueue<int> q(4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(q.Push(&v[i]));
+  }
+  EXPECT_EQ(4, q.Size());
+  EXPECT_EQ(&v[3], q.Pop());
+  EXPECT_EQ(&v[0], q.Steal());
+  EXPECT_EQ(&v[2], q.Pop());
+  EXPECT_EQ(&v[1], q.Steal());
+  EXPECT_TRUE(q.Empty());
+  EXPECT_EQ(nullptr, q.Pop());
+}
+
+TEST(WorkStealingQueue, Full) {
+  int v[3];
+  WorkStealingQueue<int> q(2);
+  EXPECT_TRUE(q.Push(&v[0]));
+  EXPECT_TRUE(q.Push(&v[1]));
+  EXPECT_FALSE(q.Push(&v[2]));
+  EXPECT_EQ(&v[0], q.Steal());
+  // Wraps around the ring buffer.
+  EXPECT_TRUE(q.Push(&v[2]));
+  EXPECT_EQ(&v[2], q.Pop());
+  EXPECT_EQ(&v[1], q.Pop());
+}
+
+// One owner pushing and popping while several thieves steal: every element
+// must be taken exactly once.
+TEST(WorkStealingQueue, ConcurrentStealing) {
+  const int kItems = 200000;
+  const int kThieves = 4;
+  std::vector<int> items(kItems);
+  std::unique_ptr<std::atomic<int>[]> taken(new std::atomic<int>[kItems]);
+  for (int i = 0; i < kItems; ++i) {
+    items[i] = i;
+    taken[i] = 0;
+  }
+  WorkStealingQueue<int> q(256);
+  std::atomic<bool> done(false);
+  std::vector<std::unique_ptr<Thread>> thieves;
+  for (int t = 0; t < kThieves; ++t) {
+    thieves.emplace_back(Env::Default()->StartThread(
+        ThreadOptions(), "thief", [&q, &done, &taken]() {
+          while (true) {
+            int* item = q.Steal();
+            if (item != nullptr) {
+              taken[*item]++;
+            } else if (done) {
+              break;
+            }
+          }
+        }));
+  }
+  for (int i = 0; i < kItems; ++i) {
+    while (!q.Push(&items[i])) {
+      int* item = q.Pop();
+      if (item != nullptr) taken[*item]++;
+    }
+    if (i % 3 == 0) {
+      int* item = q.Pop();
+      if (item != nullptr) taken[*item]++;
+    }
+  }
+  while (int* item = q.Pop()) {
+    taken[*item]++;
+  }
+  done = true;
+  thieves.clear();
+  for (int i = 0; i < kItems; ++i) {
+    ASSERT_EQ(1, taken[i]) << i;
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
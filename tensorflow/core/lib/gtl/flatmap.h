@@ -0,0 +1,526 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// FlatMap and FlatSet are hash tables with open addressing, meant as
+// drop-in replacements for std::unordered_map and std::unordered_set where
+// lookups are hot.  The elements are stored in one array instead of one
+// heap node each, so building a table does one allocation per growth step
+// rather than one per element, and lookups touch one or two cache lines.
+//
+// Every slot has a control byte that holds 7 bits of the hash of its key,
+// or marks it empty or deleted.  A lookup loads the control bytes of a
+// group of 16 slots and compares them with the hash of the key at once
+// (with SSE2 where available), and only compares keys whose hash bits
+// match.  Groups are probed in a triangular sequence until a group with an
+// empty slot is found.
+//
+// For keys that are expensive to hash or compare, such as strings, the
+// full hash of every key is kept next to the control bytes.  It is checked
+// before comparing keys and reused when the table grows.  Callers that
+// already have the hash of a key can pass it to find_hashed() and
+// insert_hashed().
+//
+// Differences from the standard containers:
+//   - Inserting or erasing invalidates all iterators and references.
+//   - Iteration order is unspecified and changes when the table grows.
+//   - The tables are not copyable.
+//
+// FlatHash is the default hash function; it mixes the bits of std::hash,
+// which is the identity for integers in common implementations.
+
+#ifndef TENSORFLOW_LIB_GTL_FLATMAP_H_
+#define TENSORFLOW_LIB_GTL_FLATMAP_H_
+
+#include <stddef.h>
+#include <string.h>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace gtl {
+
+namespace flat_internal {
+
+// Finalizer of MurmurHash3: every output bit depends on every input bit.
+inline uint64 Mix(uint64 h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+}  // namespace flat_internal
+
+template <typename T>
+struct FlatHash {
+  size_t operator()(const T& x) const {
+    return flat_internal::Mix(std::hash<T>()(x));
+  }
+};
+
+template <>
+struct FlatHash<string> {
+  size_t operator()(const string& s) const { return Hash64(s); }
+};
+
+namespace flat_internal {
+
+typedef int8 ctrl_t;
+
+// Control bytes of slots without an element.  Slots with an element hold
+// the low 7 bits of the hash of its key, which are never negative.
+const ctrl_t kEmpty = -128;
+const ctrl_t kDeleted = -2;
+
+const int kGroupSize = 16;
+
+// The control bytes of a group of kGroupSize slots.  The Match* functions
+// return a mask with bit i set if slot i of the group matches.
+class Group {
+ public:
+#ifdef __SSE2__
+  explicit Group(const ctrl_t* ctrl)
+      : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+  uint32 Match(ctrl_t h) const {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h), ctrl_));
+  }
+  uint32 MatchEmpty() const { return Match(kEmpty); }
+  // Full slots are the ones with a non-negative control byte.
+  uint32 MatchEmptyOrDeleted() const { return _mm_movemask_epi8(ctrl_); }
+
+ private:
+  __m128i ctrl_;
+#else
+  explicit Group(const ctrl_t* ctrl) : ctrl_(ctrl) {}
+
+  uint32 Match(ctrl_t h) const {
+    uint32 mask = 0;
+    for (int i = 0; i < kGroupSize; ++i) {
+      mask |= static_cast<uint32>(ctrl_[i] == h) << i;
+    }
+    return mask;
+  }
+  uint32 MatchEmpty() const { return Match(kEmpty); }
+  uint32 MatchEmptyOrDeleted() const {
+    uint32 mask = 0;
+    for (int i = 0; i < kGroupSize; ++i) {
+      mask |= static_cast<uint32>(ctrl_[i] < 0) << i;
+    }
+    return mask;
+  }
+
+ private:
+  const ctrl_t* ctrl_;
+#endif
+};
+
+// Returns the index of the lowest set bit of "mask", which is not 0.
+inline int LowestBit(uint32 mask) { return Log2Floor(mask & (~mask + 1)); }
+
+// The part of the hash that goes into the control byte, and the part that
+// picks the first group to probe.
+inline ctrl_t H2(size_t hash) { return hash & 0x7f; }
+inline size_t H1(size_t hash) { return hash >> 7; }
+
+// Keeping the full hashes costs 8 bytes per slot, which pays off when
+// hashing or comparing keys is expensive.
+template <typename Key>
+struct StoreHash {
+  static const bool value = !std::is_arithmetic<Key>::value &&
+                            !std::is_enum<Key>::value &&
+                            !std::is_pointer<Key>::value;
+};
+
+struct MapKeyOf {
+  template <typename Pair>
+  const typename Pair::first_type& operator()(const Pair& p) const {
+    return p.first;
+  }
+};
+
+struct SetKeyOf {
+  template <typename Key>
+  const Key& operator()(const Key& k) const {
+    return k;
+  }
+};
+
+// The hash table behind FlatMap and FlatSet.  "Value" is what is stored
+// per element, and KeyOf()(value) returns its key.
+template <typename Key, typename Value, typename KeyOf, typename Hash,
+          typename Eq>
+class FlatTable {
+ public:
+  typedef Key key_type;
+  typedef Value value_type;
+  typedef size_t size_type;
+  typedef Hash hasher;
+  typedef Eq key_equal;
+
+  template <typename V>
+  class Iterator : public std::iterator<std::forward_iterator_tag, V> {
+   public:
+    Iterator() : ctrl_(nullptr), slot_(nullptr), end_(nullptr) {}
+    // Allows conversion of an iterator to a const_iterator.
+    template <typename W>
+    Iterator(const Iterator<W>& it)
+        : ctrl_(it.ctrl_), slot_(it.slot_), end_(it.end_) {}
+
+    V& operator*() const { return *slot_; }
+    V* operator->() const { return slot_; }
+
+    Iterator& operator++() {
+      ++ctrl_;
+      ++slot_;
+      SkipFree();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return slot_ == other.slot_;
+    }
+    bool operator!=(const Iterator& other) const {
+      return slot_ != other.slot_;
+    }
+
+   private:
+    friend class FlatTable;
+    template <typename W>
+    friend class Iterator;
+
+    Iterator(const ctrl_t* ctrl, V* slot, const ctrl_t* end)
+        : ctrl_(ctrl), slot_(slot), end_(end) {}
+
+    void SkipFree() {
+      while (ctrl_ != end_ && *ctrl_ < 0) {
+        ++ctrl_;
+        ++slot_;
+      }
+    }
+
+    const ctrl_t* ctrl_;
+    V* slot_;
+    const ctrl_t* end_;
+  };
+
+  // The elements of sets cannot be modified through iterators.
+  typedef typename std::conditional<std::is_same<Key, Value>::value,
+                                    Iterator<const Value>,
+                                    Iterator<Value>>::type iterator;
+  typedef Iterator<const Value> const_iterator;
+
+  explicit FlatTable(size_t n = 0, const Hash& hash = Hash(),
+                     const Eq& eq = Eq())
+      : hash_(hash), eq_(eq) {
+    reserve(n);
+  }
+
+  ~FlatTable() { Destroy(); }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  // Number of slots, full or not.
+  size_t bucket_count() const { return capacity_; }
+  hasher hash_function() const { return hash_; }
+  key_equal key_eq() const { return eq_; }
+
+  iterator begin() { return MakeIterator(0); }
+  iterator end() { return MakeIterator(capacity_); }
+  const_iterator begin() const { return MakeIterator(0); }
+  const_iterator end() const { return MakeIterator(capacity_); }
+
+  // Makes room for "n" elements without growing.
+  void reserve(size_t n) {
+    if (n > MaxSize(capacity_)) Resize(CapacityFor(n));
+  }
+
+  void clear() {
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (ctrl_[i] >= 0) slots_[i].~Value();
+      ctrl_[i] = kEmpty;
+    }
+    size_ = 0;
+    num_deleted_ = 0;
+  }
+
+  void swap(FlatTable& other) {
+    std::swap(hash_, other.hash_);
+    std::swap(eq_, other.eq_);
+    std::swap(ctrl_, other.ctrl_);
+    std::swap(slots_, other.slots_);
+    std::swap(hashes_, other.hashes_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(size_, other.size_);
+    std::swap(num_deleted_, other.num_deleted_);
+  }
+
+  iterator find(const Key& k) { return find_hashed(hash_(k), k); }
+  const_iterator find(const Key& k) const { return find_hashed(hash_(k), k); }
+  size_t count(const Key& k) const { return find(k) != end() ? 1 : 0; }
+
+  // Like find(k), for "hash" == hash_function()(k).
+  iterator find_hashed(size_t hash, const Key& k) {
+    return MakeIterator(FindIndex(hash, k));
+  }
+  const_iterator find_hashed(size_t hash, const Key& k) const {
+    return MakeIterator(FindIndex(hash, k));
+  }
+
+  // Inserts "v" unless an element with the same key is present.  Returns
+  // an iterator to the element with the key of "v", and whether it was
+  // inserted.
+  std::pair<iterator, bool> insert(const Value& v) {
+    return insert_hashed(hash_(KeyOf()(v)), v);
+  }
+  std::pair<iterator, bool> insert(Value&& v) {
+    const size_t hash = hash_(KeyOf()(v));
+    return insert_hashed(hash, std::move(v));
+  }
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    for (; first != last; ++first) insert(*first);
+  }
+
+  // Like insert(v), for "hash" == hash_function()(key of v).
+  std::pair<iterator, bool> insert_hashed(size_t hash, const Value& v) {
+    return InsertHashed(hash, v);
+  }
+  std::pair<iterator, bool> insert_hashed(size_t hash, Value&& v) {
+    return InsertHashed(hash, std::move(v));
+  }
+
+  size_t erase(const Key& k) {
+    const size_t i = FindIndex(hash_(k), k);
+    if (i == capacity_) return 0;
+    EraseIndex(i);
+    return 1;
+  }
+  void erase(iterator it) { EraseIndex(it.slot_ - slots_); }
+
+ private:
+  static const bool kStoreHash = StoreHash<Key>::value;
+
+  // Tables are filled up to 7/8 before they grow.
+  static size_t MaxSize(size_t capacity) { return capacity - capacity / 8; }
+
+  static size_t CapacityFor(size_t n) {
+    size_t capacity = kGroupSize;
+    while (MaxSize(capacity) < n) capacity *= 2;
+    return capacity;
+  }
+
+  // Returns an iterator to the first element at or after slot i.
+  template <typename It>
+  It MakeIteratorAs(size_t i) const {
+    It it(ctrl_ + i, slots_ + i, ctrl_ + capacity_);
+    it.SkipFree();
+    return it;
+  }
+  iterator MakeIterator(size_t i) { return MakeIteratorAs<iterator>(i); }
+  const_iterator MakeIterator(size_t i) const {
+    return MakeIteratorAs<const_iterator>(i);
+  }
+
+  template <typename V>
+  std::pair<iterator, bool> InsertHashed(size_t hash, V&& v) {
+    size_t i = FindIndex(hash, KeyOf()(v));
+    if (i != capacity_) return {MakeIterator(i), false};
+    if (size_ + num_deleted_ + 1 > MaxSize(capacity_)) {
+      // Grow, or only drop the deleted slots if that leaves the table at
+      // most half full.
+      size_t new_capacity = CapacityFor(size_ + 1);
+      if (new_capacity <= capacity_ && size_ + 1 > MaxSize(capacity_) / 2) {
+        new_capacity = capacity_ * 2;
+      }
+      Resize(new_capacity);
+    }
+    i = FindFreeIndex(hash);
+    if (ctrl_[i] == kDeleted) --num_deleted_;
+    new (&slots_[i]) Value(std::forward<V>(v));
+    SetFull(i, hash);
+    ++size_;
+    return {MakeIterator(i), true};
+  }
+
+  // Returns the index of the element with key "k", or capacity_.
+  size_t FindIndex(size_t hash, const Key& k) const {
+    if (capacity_ == 0) return capacity_;
+    const size_t group_mask = capacity_ / kGroupSize - 1;
+    const ctrl_t h2 = H2(hash);
+    size_t g = H1(hash) & group_mask;
+    for (size_t step = 1;; ++step) {
+      const Group group(ctrl_ + g * kGroupSize);
+      for (uint32 m = group.Match(h2); m != 0; m &= m - 1) {
+        const size_t i = g * kGroupSize + LowestBit(m);
+        if ((!kStoreHash || hashes_[i] == hash) &&
+            eq_(KeyOf()(slots_[i]), k)) {
+          return i;
+        }
+      }
+      if (group.MatchEmpty() != 0) return capacity_;
+      g = (g + step) & group_mask;
+    }
+  }
+
+  // Returns the index of the first empty or deleted slot on the probe
+  // sequence of "hash".  The table must not be full.
+  size_t FindFreeIndex(size_t hash) const {
+    const size_t group_mask = capacity_ / kGroupSize - 1;
+    size_t g = H1(hash) & group_mask;
+    for (size_t step = 1;; ++step) {
+      const uint32 m = Group(ctrl_ + g * kGroupSize).MatchEmptyOrDeleted();
+      if (m != 0) return g * kGroupSize + LowestBit(m);
+      g = (g + step) & group_mask;
+    }
+  }
+
+  void SetFull(size_t i, size_t hash) {
+    ctrl_[i] = H2(hash);
+    if (kStoreHash) hashes_[i] = hash;
+  }
+
+  void EraseIndex(size_t i) {
+    slots_[i].~Value();
+    --size_;
+    // Probes stop at the first group with an empty slot, so the slot can
+    // become empty if its group already has one.
+    const size_t g = i / kGroupSize * kGroupSize;
+    if (Group(ctrl_ + g).MatchEmpty() != 0) {
+      ctrl_[i] = kEmpty;
+    } else {
+      ctrl_[i] = kDeleted;
+      ++num_deleted_;
+    }
+  }
+
+  void Resize(size_t new_capacity) {
+    ctrl_t* old_ctrl = ctrl_;
+    Value* old_slots = slots_;
+    size_t* old_hashes = hashes_;
+    const size_t old_capacity = capacity_;
+
+    ctrl_ = new ctrl_t[new_capacity];
+    memset(ctrl_, kEmpty, new_capacity);
+    slots_ = static_cast<Value*>(::operator new(new_capacity * sizeof(Value)));
+    hashes_ = kStoreHash ? new size_t[new_capacity] : nullptr;
+    capacity_ = new_capacity;
+    num_deleted_ = 0;
+
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old_ctrl[i] < 0) continue;
+      const size_t hash =
+          kStoreHash ? old_hashes[i] : hash_(KeyOf()(old_slots[i]));
+      const size_t j = FindFreeIndex(hash);
+      new (&slots_[j]) Value(std::move(old_slots[i]));
+      old_slots[i].~Value();
+      SetFull(j, hash);
+    }
+    delete[] old_ctrl;
+    ::operator delete(old_slots);
+    delete[] old_hashes;
+  }
+
+  void Destroy() {
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (ctrl_[i] >= 0) slots_[i].~Value();
+    }
+    delete[] ctrl_;
+    ::operator delete(slots_);
+    delete[] hashes_;
+  }
+
+  Hash hash_;
+  Eq eq_;
+  ctrl_t* ctrl_ = nullptr;
+  Value* slots_ = nullptr;
+  size_t* hashes_ = nullptr;  // Only if kStoreHash.
+  size_t capacity_ = 0;       // 0 or a power of two >= kGroupSize.
+  size_t size_ = 0;
+  size_t num_deleted_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FlatTable);
+};
+
+}  // namespace flat_internal
+
+// A hash map from Key to Val.  See the top of this file.
+template <typename Key, typename Val, typename Hash = FlatHash<Key>,
+          typename Eq = std::equal_to<Key>>
+class FlatMap
+    : public flat_internal::FlatTable<Key, std::pair<const Key, Val>,
+                                      flat_internal::MapKeyOf, Hash, Eq> {
+ public:
+  typedef flat_internal::FlatTable<Key, std::pair<const Key, Val>,
+                                   flat_internal::MapKeyOf, Hash, Eq>
+      Base;
+  typedef Val mapped_type;
+
+  explicit FlatMap(size_t n = 0, const Hash& hash = Hash(),
+                   const Eq& eq = Eq())
+      : Base(n, hash, eq) {}
+
+  // Returns the value for "k", inserting a value-initialized one if "k"
+  // is not present.
+  Val& operator[](const Key& k) {
+    const size_t hash = this->hash_function()(k);
+    auto it = this->find_hashed(hash, k);
+    if (it != this->end()) return it->second;
+    return this->insert_hashed(hash, typename Base::value_type(k, Val()))
+        .first->second;
+  }
+};
+
+// A hash set of Key.  See the top of this file.
+template <typename Key, typename Hash = FlatHash<Key>,
+          typename Eq = std::equal_to<Key>>
+class FlatSet : public flat_internal::FlatTable<Key, Key,
+                                                flat_internal::SetKeyOf,
+                                                Hash, Eq> {
+ public:
+  typedef flat_internal::FlatTable<Key, Key, flat_internal::SetKeyOf, Hash,
+                                   Eq>
+      Base;
+
+  explicit FlatSet(size_t n = 0, const Hash& hash = Hash(),
+                   const Eq& eq = Eq())
+      : Base(n, hash, eq) {}
+};
+
+}  // namespace gtl
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_GTL_FLATMAP_H_
@@ -0,0 +1,289 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/gtl/flatmap.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace gtl {
+namespace {
+
+typedef FlatMap<int64, int32> NumMap;
+
+// Returns the contents of "m" sorted by key.
+template <typename Map>
+std::vector<std::pair<typename Map::key_type, typename Map::mapped_type>>
+Contents(const Map& m) {
+  std::vector<std::pair<typename Map::key_type, typename Map::mapped_type>>
+      result(m.begin(), m.end());
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+TEST(FlatMapTest, Empty) {
+  NumMap m;
+  EXPECT_EQ(0, m.size());
+  EXPECT_TRUE(m.empty());
+  EXPECT_TRUE(m.begin() == m.end());
+  EXPECT_TRUE(m.find(1) == m.end());
+  EXPECT_EQ(0, m.count(1));
+  EXPECT_EQ(0, m.erase(1));
+  m.clear();
+  EXPECT_EQ(0, m.bucket_count());
+}
+
+TEST(FlatMapTest, InsertFindErase) {
+  NumMap m;
+  auto r = m.insert({1, 100});
+  EXPECT_TRUE(r.second);
+  EXPECT_EQ(1, r.first->first);
+  EXPECT_EQ(100, r.first->second);
+  r = m.insert({1, 200});
+  EXPECT_FALSE(r.second);
+  EXPECT_EQ(100, r.first->second);
+  EXPECT_EQ(1, m.size());
+
+  m[2] = 300;
+  EXPECT_EQ(0, m[3]);
+  EXPECT_EQ(3, m.size());
+  EXPECT_EQ(300, m.find(2)->second);
+  EXPECT_EQ(1, m.count(3));
+
+  EXPECT_EQ(1, m.erase(1));
+  EXPECT_EQ(0, m.erase(1));
+  EXPECT_TRUE(m.find(1) == m.end());
+  m.erase(m.find(3));
+  EXPECT_EQ((std::vector<std::pair<int64, int32>>{{2, 300}}), Contents(m));
+}
+
+TEST(FlatMapTest, Grow) {
+  NumMap m;
+  for (int i = 0; i < 100000; ++i) {
+    m[i * 7] = i;
+  }
+  EXPECT_EQ(100000, m.size());
+  EXPECT_GE(m.bucket_count(), m.size());
+  for (int i = 0; i < 100000; ++i) {
+    auto it = m.find(i * 7);
+    ASSERT_TRUE(it != m.end());
+    EXPECT_EQ(i, it->second);
+    EXPECT_TRUE(m.find(i * 7 + 1) == m.end());
+  }
+  int64 n = 0;
+  for (const auto& p : m) {
+    EXPECT_EQ(p.first, p.second * 7);
+    ++n;
+  }
+  EXPECT_EQ(100000, n);
+}
+
+TEST(FlatMapTest, Reserve) {
+  NumMap m(1000);
+  const size_t buckets = m.bucket_count();
+  EXPECT_GE(buckets, 1000);
+  for (int i = 0; i < 1000; ++i) m[i] = i;
+  EXPECT_EQ(buckets, m.bucket_count());
+}
+
+// Erasing and inserting different keys over and over must not keep growing
+// the table or leave it without empty slots.
+TEST(FlatMapTest, ChurnDoesNotGrow) {
+  NumMap m;
+  for (int i = 0; i < 100; ++i) m[i] = i;
+  const size_t buckets = m.bucket_count();
+  for (int i = 100; i < 100000; ++i) {
+    EXPECT_EQ(1, m.erase(i - 100));
+    m[i] = i;
+    EXPECT_TRUE(m.find(i - 100) == m.end());
+  }
+  EXPECT_EQ(100, m.size());
+  EXPECT_LE(m.bucket_count(), 2 * buckets);
+  for (int i = 99900; i < 100000; ++i) EXPECT_EQ(i, m[i]);
+}
+
+// Compares against std::unordered_map under random operations.
+TEST(FlatMapTest, MatchesUnorderedMap) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  NumMap m;
+  std::unordered_map<int64, int32> expected;
+  for (int i = 0; i < 200000; ++i) {
+    const int64 k = rnd.Uniform(5000);
+    switch (rnd.Uniform(4)) {
+      case 0:
+      case 1:
+        m[k] = i;
+        expected[k] = i;
+        break;
+      case 2:
+        EXPECT_EQ(expected.erase(k), m.erase(k));
+        break;
+      case 3:
+        EXPECT_EQ(expected.count(k), m.count(k));
+        break;
+    }
+    ASSERT_EQ(expected.size(), m.size());
+  }
+  std::vector<std::pair<int64, int32>> sorted(expected.begin(),
+                                              expected.end());
+  std::sort(sorted.begin(), sorted.end());
+  EXPECT_EQ(sorted, Contents(m));
+}
+
+TEST(FlatMapTest, StringKeys) {
+  FlatMap<string, int> m;
+  for (int i = 0; i < 10000; ++i) {
+    m[strings::StrCat("key", i)] = i;
+  }
+  for (int i = 0; i < 10000; ++i) {
+    EXPECT_EQ(i, m[strings::StrCat("key", i)]);
+  }
+  EXPECT_EQ(10000, m.size());
+  const string k = "key5";
+  const size_t hash = m.hash_function()(k);
+  EXPECT_EQ(5, m.find_hashed(hash, k)->second);
+  EXPECT_FALSE(m.insert_hashed(hash, {k, 6}).second);
+  EXPECT_TRUE(m.find("key") == m.end());
+}
+
+// Keys with equal hashes must still be told apart.
+struct BadHash {
+  size_t operator()(int64 x) const { return x % 3; }
+};
+
+TEST(FlatMapTest, Collisions) {
+  FlatMap<int64, int64, BadHash> m;
+  for (int64 i = 0; i < 1000; ++i) m[i] = -i;
+  for (int64 i = 0; i < 1000; ++i) EXPECT_EQ(-i, m[i]);
+  for (int64 i = 0; i < 1000; i += 2) EXPECT_EQ(1, m.erase(i));
+  EXPECT_EQ(500, m.size());
+  for (int64 i = 0; i < 1000; ++i) EXPECT_EQ(i % 2, m.count(i));
+}
+
+// Values are destroyed exactly once, including when the table grows.
+TEST(FlatMapTest, NonTrivialValues) {
+  std::shared_ptr<int> p(new int(1));
+  {
+    FlatMap<int, std::shared_ptr<int>> m;
+    for (int i = 0; i < 1000; ++i) m[i] = p;
+    EXPECT_EQ(1001, p.use_count());
+    for (int i = 0; i < 500; ++i) m.erase(i);
+    EXPECT_EQ(501, p.use_count());
+    FlatMap<int, std::shared_ptr<int>> other;
+    other[0] = p;
+    m.swap(other);
+    EXPECT_EQ(1, m.size());
+    EXPECT_EQ(500, other.size());
+    other.clear();
+    EXPECT_EQ(2, p.use_count());
+  }
+  EXPECT_EQ(1, p.use_count());
+}
+
+TEST(FlatSetTest, Basic) {
+  FlatSet<string> s;
+  EXPECT_TRUE(s.insert("a").second);
+  EXPECT_TRUE(s.insert("b").second);
+  EXPECT_FALSE(s.insert("a").second);
+  EXPECT_EQ(2, s.size());
+  EXPECT_EQ(1, s.count("a"));
+  EXPECT_EQ(0, s.count("c"));
+  std::vector<string> contents(s.begin(), s.end());
+  std::sort(contents.begin(), contents.end());
+  EXPECT_EQ((std::vector<string>{"a", "b"}), contents);
+  EXPECT_EQ(1, s.erase("a"));
+  EXPECT_EQ(0, s.count("a"));
+}
+
+// Benchmarks of building a table of "n" distinct keys of which half occur
+// twice, and of looking up "n" keys of which half are present, against
+// the standard containers.
+
+std::vector<int64> NumKeys(int n) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<int64> keys(n);
+  for (int64& k : keys) k = rnd.Rand64();
+  for (int i = 0; i < n / 2; ++i) keys[n / 2 + i] = keys[i];
+  return keys;
+}
+
+std::vector<string> StringKeys(int n) {
+  std::vector<string> keys;
+  for (int64 k : NumKeys(n)) keys.push_back(strings::StrCat("feature_", k));
+  return keys;
+}
+
+template <typename Map, typename Key>
+void BM_Insert(int iters, const std::vector<Key>& keys) {
+  testing::ItemsProcessed(static_cast<int64>(iters) * keys.size());
+  testing::StartTiming();
+  while (iters-- > 0) {
+    Map m;
+    m.reserve(keys.size());
+    for (const Key& k : keys) m.insert({k, 0});
+    CHECK_GT(m.size(), 0);
+  }
+}
+
+template <typename Map, typename Key>
+void BM_Find(int iters, const std::vector<Key>& keys) {
+  Map m;
+  for (size_t i = 0; i < keys.size(); i += 2) m.insert({keys[i], 0});
+  testing::ItemsProcessed(static_cast<int64>(iters) * keys.size());
+  testing::StartTiming();
+  int64 found = 0;
+  while (iters-- > 0) {
+    for (const Key& k : keys) found += m.count(k);
+  }
+  CHECK_GT(found, 0);
+}
+
+#define BM_MAP(NAME, MAP, KEY, KEYS)                 \
+  static void BM_Insert_##NAME(int iters, int n) {   \
+    testing::StopTiming();                           \
+    BM_Insert<MAP, KEY>(iters, KEYS(n));             \
+  }                                                  \
+  BENCHMARK(BM_Insert_##NAME)->Arg(1000)->Arg(1000000); \
+  static void BM_Find_##NAME(int iters, int n) {     \
+    testing::StopTiming();                           \
+    BM_Find<MAP, KEY>(iters, KEYS(n));               \
+  }                                                  \
+  BENCHMARK(BM_Find_##NAME)->Arg(1000)->Arg(1000000);
+
+typedef std::unordered_map<int64, int32> StdNumMap;
+typedef std::unordered_map<string, int32> StdStringMap;
+typedef FlatMap<string, int32> StringMap;
+
+BM_MAP(StdInt64, StdNumMap, int64, NumKeys);
+BM_MAP(FlatInt64, NumMap, int64, NumKeys);
+BM_MAP(StdString, StdStringMap, string, StringKeys);
+BM_MAP(FlatString, StringMap, string, StringKeys);
+
+}  // namespace
+}  // namespace gtl
+}  // namespace tensorflow
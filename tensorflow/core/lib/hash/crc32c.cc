@@ -13,14 +13,21 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-// A portable implementation of crc32c, optimized to handle
-// four bytes at a time.
+// An implementation of crc32c that uses the SSE4.2 crc32 instruction
+// when the CPU has it, and a portable implementation that handles eight
+// bytes at a time otherwise.
 
 #include "tensorflow/core/lib/hash/crc32c.h"
 
 #include <stdint.h>
 #include "tensorflow/core/lib/core/coding.h"
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <cpuid.h>
+#include <nmmintrin.h>
+#define TF_CRC32C_SSE42 1
+#endif
+
 namespace tensorflow {
 namespace crc32c {
 
@@ -201,12 +208,87 @@ static const uint32 table3_[256] = {
     0x0302211c, 0xde478ba4, 0x31035088, 0xec46fa30, 0x8e647309, 0x5321d9b1,
     0x4a21617b, 0x9764cbc3, 0xf54642fa, 0x2803e842};
 
+// The crc32c polynomial, bit-reflected.
+static const uint32 kPoly = 0x82f63b78;
+
+// Returns a * b modulo kPoly, where a and b are polynomials over GF(2) in
+// the bit-reflected representation, in which x^0 is the top bit.
+static uint32 MultModP(uint32 a, uint32 b) {
+  uint32 m = 1u << 31;
+  uint32 p = 0;
+  for (;;) {
+    if (a & m) {
+      p ^= b;
+      if ((a & (m - 1)) == 0) break;
+    }
+    m >>= 1;
+    b = (b & 1) ? (b >> 1) ^ kPoly : b >> 1;
+  }
+  return p;
+}
+
+// Returns x^(8 * n) modulo kPoly, the polynomial that appending n zero
+// bytes to a crc register multiplies it by.
+static uint32 ZeroBytesOperator(size_t n) {
+  uint32 power = 1u << 23;  // x^8, then x^16, x^32, ...
+  uint32 p = 1u << 31;      // x^0
+  for (; n != 0; n >>= 1) {
+    if (n & 1) p = MultModP(power, p);
+    power = MultModP(power, power);
+  }
+  return p;
+}
+
+// Multiplies crc registers by the fixed polynomial x^(8 * n) with four
+// table lookups, for combining the registers of consecutive blocks of n
+// bytes.
+class ZeroBytesShift {
+ public:
+  explicit ZeroBytesShift(size_t n) {
+    const uint32 op = ZeroBytesOperator(n);
+    for (int i = 0; i < 4; ++i) {
+      for (uint32 b = 0; b < 256; ++b) {
+        table_[i][b] = MultModP(op, b << (8 * i));
+      }
+    }
+  }
+
+  uint32 operator()(uint32 crc) const {
+    return table_[0][crc & 0xff] ^ table_[1][(crc >> 8) & 0xff] ^
+           table_[2][(crc >> 16) & 0xff] ^ table_[3][crc >> 24];
+  }
+
+ private:
+  uint32 table_[4][256];
+};
+
 // Used to fetch a naturally-aligned 32-bit word in little endian byte-order
 static inline uint32_t LE_LOAD32(const uint8_t *p) {
   return core::DecodeFixed32(reinterpret_cast<const char *>(p));
 }
 
-uint32 Extend(uint32 crc, const char *buf, size_t size) {
+// table4_ to table7_ extend table0_ to table3_ to the crc of one byte
+// followed by four to seven zero bytes.
+struct ExtraTables {
+  ExtraTables() {
+    const uint32 *prev = table3_;
+    for (int t = 0; t < 4; ++t) {
+      for (int i = 0; i < 256; ++i) {
+        table[t][i] = (prev[i] >> 8) ^ table0_[prev[i] & 0xff];
+      }
+      prev = table[t];
+    }
+  }
+  uint32 table[4][256];
+};
+
+static uint32 ExtendPortable(uint32 crc, const char *buf, size_t size) {
+  static const ExtraTables *extra = new ExtraTables;
+  const uint32 *table4_ = extra->table[0];
+  const uint32 *table5_ = extra->table[1];
+  const uint32 *table6_ = extra->table[2];
+  const uint32 *table7_ = extra->table[3];
+
   const uint8 *p = reinterpret_cast<const uint8 *>(buf);
   const uint8 *e = p + size;
   uint32 l = crc ^ 0xffffffffu;
@@ -225,6 +307,17 @@ uint32 Extend(uint32 crc, const char *buf, size_t size) {
         table1_[(c >> 16) & 0xff] ^ table0_[c >> 24];  \
   } while (0)
 
+#define STEP8                                                             \
+  do {                                                                    \
+    uint32 c = l ^ LE_LOAD32(p);                                          \
+    uint32 d = LE_LOAD32(p + 4);                                          \
+    p += 8;                                                               \
+    l = table7_[c & 0xff] ^ table6_[(c >> 8) & 0xff] ^                    \
+        table5_[(c >> 16) & 0xff] ^ table4_[c >> 24] ^                    \
+        table3_[d & 0xff] ^ table2_[(d >> 8) & 0xff] ^                    \
+        table1_[(d >> 16) & 0xff] ^ table0_[d >> 24];                     \
+  } while (0)
+
   // Point x at first 4-byte aligned byte in string.  This might be
   // just past the end of the string.
   const uintptr_t pval = reinterpret_cast<uintptr_t>(p);
@@ -237,10 +330,8 @@ uint32 Extend(uint32 crc, const char *buf, size_t size) {
   }
   // Process bytes 16 at a time
   while ((e - p) >= 16) {
-    STEP4;
-    STEP4;
-    STEP4;
-    STEP4;
+    STEP8;
+    STEP8;
   }
   // Process bytes 4 at a time
   while ((e - p) >= 4) {
@@ -250,10 +341,86 @@ uint32 Extend(uint32 crc, const char *buf, size_t size) {
   while (p != e) {
     STEP1;
   }
+#undef STEP8
 #undef STEP4
 #undef STEP1
   return l ^ 0xffffffffu;
 }
 
+#ifdef TF_CRC32C_SSE42
+
+// Buffers of at least three stripes are split into three streams, whose
+// crc32 instructions are independent and so overlap in the pipeline.
+static const size_t kStripe = 1024;
+
+__attribute__((target("sse4.2"))) static uint32 ExtendSse42(uint32 crc,
+                                                             const char *buf,
+                                                             size_t size) {
+  static const ZeroBytesShift *shift = new ZeroBytesShift(kStripe);
+  const uint8 *p = reinterpret_cast<const uint8 *>(buf);
+  const uint8 *e = p + size;
+  uint64 l = crc ^ 0xffffffffu;
+
+  // Process bytes until finished or p is 8-byte aligned
+  while (p != e && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+    l = _mm_crc32_u8(l, *p++);
+  }
+  // Process three stripes at a time, then append the registers of the
+  // second and third to the first.
+  while (static_cast<size_t>(e - p) >= 3 * kStripe) {
+    uint64 l1 = 0;
+    uint64 l2 = 0;
+    for (size_t i = 0; i < kStripe; i += 8) {
+      l = _mm_crc32_u64(l, core::DecodeFixed64(
+                               reinterpret_cast<const char *>(p + i)));
+      l1 = _mm_crc32_u64(l1, core::DecodeFixed64(reinterpret_cast<const char *>(
+                                 p + kStripe + i)));
+      l2 = _mm_crc32_u64(l2, core::DecodeFixed64(reinterpret_cast<const char *>(
+                                 p + 2 * kStripe + i)));
+    }
+    l = (*shift)(l) ^ l1;
+    l = (*shift)(l) ^ l2;
+    p += 3 * kStripe;
+  }
+  // Process bytes 8 at a time
+  while ((e - p) >= 8) {
+    l = _mm_crc32_u64(l,
+                      core::DecodeFixed64(reinterpret_cast<const char *>(p)));
+    p += 8;
+  }
+  // Process the last few bytes
+  while (p != e) {
+    l = _mm_crc32_u8(l, *p++);
+  }
+  return l ^ 0xffffffffu;
+}
+
+static bool CpuHasSse42() {
+  unsigned int eax, ebx, ecx, edx;
+  return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2) != 0;
+}
+
+#endif  // TF_CRC32C_SSE42
+
+typedef uint32 (*ExtendFunction)(uint32, const char *, size_t);
+
+static ExtendFunction ChooseExtend() {
+#ifdef TF_CRC32C_SSE42
+  if (CpuHasSse42()) return ExtendSse42;
+#endif
+  return ExtendPortable;
+}
+
+uint32 Extend(uint32 crc, const char *buf, size_t size) {
+  static const ExtendFunction extend = ChooseExtend();
+  return extend(crc, buf, size);
+}
+
+uint32 Combine(uint32 crc1, uint32 crc2, size_t len2) {
+  // Appending B to A shifts the register of A by len(B) bytes, and the
+  // initial and final inversions of the crcs of A and B cancel out.
+  return MultModP(ZeroBytesOperator(len2), crc1) ^ crc2;
+}
+
 }  // namespace crc32c
 }  // namespace tensorflow
@@ -30,6 +30,12 @@ extern uint32 Extend(uint32 init_crc, const char* data, size_t n);
 // Return the crc32c of data[0,n-1]
 inline uint32 Value(const char* data, size_t n) { return Extend(0, data, n); }
 
+// Return the crc32c of concat(A, B) where crc1 is the crc32c of some
+// string A, and crc2 is the crc32c of some string B of len2 bytes.
+// Combine() lets the crc32c of a large buffer be computed from the crcs
+// of its pieces, e.g. in parallel.
+extern uint32 Combine(uint32 crc1, uint32 crc2, size_t len2);
+
 static const uint32 kMaskDelta = 0xa282ead8ul;
 
 // Return a masked representation of crc.
@@ -14,7 +14,11 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/lib/hash/crc32c.h"
+
+#include <string>
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace crc32c {
@@ -54,6 +58,56 @@ TEST(CRC, Extend) {
   ASSERT_EQ(Value("hello world", 11), Extend(Value("hello ", 6), "world", 5));
 }
 
+// Computes the crc32c of data[0,n-1] one bit at a time.
+static uint32 BitwiseValue(const char* data, size_t n) {
+  uint32 crc = 0xffffffffu;
+  for (size_t i = 0; i < n; ++i) {
+    crc ^= static_cast<uint8>(data[i]);
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0x82f63b78 : crc >> 1;
+    }
+  }
+  return crc ^ 0xffffffffu;
+}
+
+static string RandomString(size_t n) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  string s(n, 0);
+  for (size_t i = 0; i < n; ++i) s[i] = rnd.Uniform(256);
+  return s;
+}
+
+TEST(CRC, MatchesBitwise) {
+  // Covers every alignment, and buffers long enough to be split into
+  // several streams.
+  const string data = RandomString(10000);
+  for (size_t offset = 0; offset < 8; ++offset) {
+    for (size_t n : {0, 1, 7, 8, 15, 16, 17, 100, 3071, 3072, 3073, 6200,
+                     9990}) {
+      ASSERT_EQ(BitwiseValue(data.data() + offset, n),
+                Value(data.data() + offset, n))
+          << "offset " << offset << " n " << n;
+    }
+  }
+}
+
+TEST(CRC, Combine) {
+  const string data = RandomString(5000);
+  const uint32 crc = Value(data.data(), data.size());
+  for (size_t split : {0, 1, 100, 4096, 4999, 5000}) {
+    uint32 a = Value(data.data(), split);
+    uint32 b = Value(data.data() + split, data.size() - split);
+    ASSERT_EQ(crc, Combine(a, b, data.size() - split)) << split;
+  }
+  // Pieces checksummed independently, e.g. in parallel, combine in order.
+  uint32 combined = 0;
+  for (size_t start = 0; start < data.size(); start += 1000) {
+    combined = Combine(combined, Value(data.data() + start, 1000), 1000);
+  }
+  ASSERT_EQ(crc, combined);
+}
+
 TEST(CRC, Mask) {
   uint32 crc = Value("foo", 3);
   ASSERT_NE(crc, Mask(crc));
@@ -62,5 +116,15 @@ TEST(CRC, Mask) {
   ASSERT_EQ(crc, Unmask(Unmask(Mask(Mask(crc)))));
 }
 
+static void BM_CRC(int iters, int len) {
+  const string input = RandomString(len);
+  testing::BytesProcessed(static_cast<int64>(iters) * len);
+  uint32 crc = 0;
+  while (--iters >= 0) {
+    crc = Extend(crc, input.data(), input.size());
+  }
+}
+BENCHMARK(BM_CRC)->Arg(100)->Arg(4096)->Arg(65536)->Arg(1 << 20);
+
 }  // namespace crc32c
 }  // namespace tensorflow
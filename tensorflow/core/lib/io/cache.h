@@ -0,0 +1,135 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A Cache is an interface that maps keys to values.  It has internal
+// synchronization and may be safely accessed concurrently from
+// multiple threads.  It may automatically evict entries to make room
+// for new entries.  Values have a specified charge against the cache
+// capacity.  For example, a cache where the values are variable
+// length strings, may use the length of the string as the charge for
+// the string.
+//
+// A builtin cache implementation with a least-recently-used eviction
+// policy is provided.  Clients may use their own implementations if
+// they want something more sophisticated (like scan-resistance, a
+// custom eviction policy, variable cache sizing, etc.)
+
+#ifndef TENSORFLOW_LIB_IO_CACHE_H_
+#define TENSORFLOW_LIB_IO_CACHE_H_
+
+#include <stddef.h>
+
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace table {
+
+class Cache;
+
+// Create a new cache with a fixed size capacity.  This implementation
+// of Cache uses a least-recently-used eviction policy.  The cache is
+// split into a number of independently locked shards, so concurrent
+// lookups of different keys rarely contend.
+Cache* NewLRUCache(size_t capacity);
+
+// Returns the process-wide block cache shared by all tables that do not
+// supply their own (see Options::block_cache).  The capacity is
+// kSharedBlockCacheCapacity bytes of uncompressed block data.  The
+// returned cache is never deleted.
+static const size_t kSharedBlockCacheCapacity = 64 << 20;
+Cache* SharedBlockCache();
+
+class Cache {
+ public:
+  Cache() {}
+
+  // Destroys all existing entries by calling the "deleter"
+  // function that was passed to the constructor.
+  virtual ~Cache();
+
+  // Opaque handle to an entry stored in the cache.
+  struct Handle {};
+
+  // Insert a mapping from key->value into the cache and assign it
+  // the specified charge against the total cache capacity.  A mapping
+  // whose charge exceeds the capacity (of the shard it maps to) is not
+  // cached: it is deleted as soon as the returned handle is released.
+  //
+  // Returns a handle that corresponds to the mapping.  The caller
+  // must call this->Release(handle) when the returned mapping is no
+  // longer needed.
+  //
+  // When the inserted entry is no longer needed, the key and
+  // value will be passed to "deleter".
+  virtual Handle* Insert(const StringPiece& key, void* value, size_t charge,
+                         void (*deleter)(const StringPiece& key,
+                                         void* value)) = 0;
+
+  // If the cache has no mapping for "key", returns NULL.
+  //
+  // Else return a handle that corresponds to the mapping.  The caller
+  // must call this->Release(handle) when the returned mapping is no
+  // longer needed.
+  virtual Handle* Lookup(const StringPiece& key) = 0;
+
+  // Release a mapping returned by a previous Lookup().
+  // REQUIRES: handle must not have been released yet.
+  // REQUIRES: handle must have been returned by a method on *this.
+  virtual void Release(Handle* handle) = 0;
+
+  // Return the value encapsulated in a handle returned by a
+  // successful Lookup().
+  // REQUIRES: handle must not have been released yet.
+  // REQUIRES: handle must have been returned by a method on *this.
+  virtual void* Value(Handle* handle) = 0;
+
+  // If the cache contains entry for key, erase it.  Note that the
+  // underlying entry will be kept around until all existing handles
+  // to it have been released.
+  virtual void Erase(const StringPiece& key) = 0;
+
+  // Return a new numeric id.  May be used by multiple clients who are
+  // sharing the same cache to partition the key space.  Typically the
+  // client will allocate a new id at startup and prepend the id to
+  // its cache keys.
+  virtual uint64 NewId() = 0;
+
+  // Remove all cache entries that are not actively in use.
+  virtual void Prune() = 0;
+
+  // Return an estimate of the combined charges of all elements stored in
+  // the cache.
+  virtual size_t TotalCharge() const = 0;
+
+  // Counters accumulated since the cache was created.
+  struct Stats {
+    int64 hits = 0;       // Lookups that found an entry.
+    int64 misses = 0;     // Lookups that found nothing.
+    int64 inserts = 0;    // Calls to Insert().
+    int64 evictions = 0;  // Entries dropped to stay within capacity.
+  };
+  virtual Stats GetStats() const = 0;
+
+ private:
+  // No copying allowed
+  Cache(const Cache&);
+  void operator=(const Cache&);
+};
+
+}  // namespace table
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_IO_CACHE_H_
@@ -0,0 +1,189 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/readahead_file.h"
+
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace io {
+
+namespace {
+
+// Process-wide counterparts of ReadaheadFile::Stats.
+std::atomic<int64> global_buffers_ready(0);
+std::atomic<int64> global_bytes_in_flight(0);
+std::atomic<int64> global_blocked_reads(0);
+std::atomic<int64> global_seeks(0);
+
+}  // namespace
+
+ReadaheadFile::ReadaheadFile(Env* env, RandomAccessFile* file, int num_buffers,
+                             size_t buffer_bytes)
+    : file_(file), num_buffers_(num_buffers), buffer_bytes_(buffer_bytes) {
+  CHECK_GT(num_buffers, 0);
+  CHECK_GT(buffer_bytes, 0);
+  thread_.reset(env->StartThread(ThreadOptions(), "readahead",
+                                 [this]() { ReadaheadLoop(); }));
+}
+
+ReadaheadFile::~ReadaheadFile() {
+  {
+    mutex_lock l(mu_);
+    stopping_ = true;
+    cv_.notify_all();
+  }
+  // Joins the background thread.
+  thread_.reset();
+  global_buffers_ready -= chunks_.size();
+  global_bytes_in_flight -= buffered_bytes_;
+}
+
+void ReadaheadFile::ReadaheadLoop() {
+  string buf;
+  while (true) {
+    uint64 offset;
+    int64 generation;
+    {
+      mutex_lock l(mu_);
+      while (!stopping_ &&
+             (done_ || chunks_.size() >= static_cast<size_t>(num_buffers_))) {
+        cv_.wait(l);
+      }
+      if (stopping_) return;
+      offset = next_offset_;
+      generation = generation_;
+      reading_bytes_ = buffer_bytes_;
+      global_bytes_in_flight += reading_bytes_;
+    }
+
+    buf.resize(buffer_bytes_);
+    StringPiece data;
+    Status s = file_->Read(offset, buffer_bytes_, &data, &buf[0]);
+
+    mutex_lock l(mu_);
+    global_bytes_in_flight -= reading_bytes_;
+    reading_bytes_ = 0;
+    if (generation != generation_) {
+      // The consumer moved elsewhere while we were reading.
+      continue;
+    }
+    if (!data.empty()) {
+      if (data.data() != buf.data()) {
+        memmove(&buf[0], data.data(), data.size());
+      }
+      buf.resize(data.size());
+      chunks_.push_back(Chunk());
+      chunks_.back().offset = offset;
+      chunks_.back().data.swap(buf);
+      next_offset_ += data.size();
+      buffered_bytes_ += data.size();
+      ++global_buffers_ready;
+      global_bytes_in_flight += data.size();
+    }
+    if (!s.ok()) {
+      done_ = true;
+      status_ = s;
+    } else if (data.empty()) {
+      done_ = true;
+      status_ = errors::OutOfRange("eof");
+    }
+    cv_.notify_all();
+  }
+}
+
+Status ReadaheadFile::Read(uint64 offset, size_t n, StringPiece* result,
+                           char* scratch) const {
+  mutex_lock l(mu_);
+  size_t copied = 0;
+  bool blocked = false;
+  while (copied < n) {
+    const uint64 pos = offset + copied;
+
+    // Consumed chunks make room for more readahead.
+    while (!chunks_.empty() &&
+           chunks_.front().offset + chunks_.front().data.size() <= pos) {
+      buffered_bytes_ -= chunks_.front().data.size();
+      global_bytes_in_flight -= chunks_.front().data.size();
+      --global_buffers_ready;
+      chunks_.pop_front();
+      cv_.notify_all();
+    }
+
+    if (!chunks_.empty() && chunks_.front().offset <= pos) {
+      const Chunk& chunk = chunks_.front();
+      const size_t skip = pos - chunk.offset;
+      const size_t len = std::min(n - copied, chunk.data.size() - skip);
+      memcpy(scratch + copied, chunk.data.data() + skip, len);
+      copied += len;
+      continue;
+    }
+
+    if (chunks_.empty() && pos == next_offset_) {
+      if (done_) {
+        // Hit the end of the file or an error.
+        *result = StringPiece(scratch, copied);
+        return status_;
+      }
+      if (!blocked) {
+        blocked = true;
+        ++stats_.blocked_reads;
+        ++global_blocked_reads;
+      }
+      cv_.wait(l);
+      continue;
+    }
+
+    // Not a sequential read: drop what we have and restart at "pos".
+    global_buffers_ready -= chunks_.size();
+    global_bytes_in_flight -= buffered_bytes_;
+    chunks_.clear();
+    buffered_bytes_ = 0;
+    next_offset_ = pos;
+    ++generation_;
+    done_ = false;
+    status_ = Status::OK();
+    ++stats_.seeks;
+    ++global_seeks;
+    cv_.notify_all();
+  }
+  *result = StringPiece(scratch, n);
+  return Status::OK();
+}
+
+ReadaheadFile::Stats ReadaheadFile::GetStats() const {
+  mutex_lock l(mu_);
+  Stats stats = stats_;
+  stats.buffers_ready = chunks_.size();
+  stats.bytes_in_flight = buffered_bytes_ + reading_bytes_;
+  return stats;
+}
+
+ReadaheadFile::Stats ReadaheadFile::GetGlobalStats() {
+  Stats stats;
+  stats.buffers_ready = global_buffers_ready;
+  stats.bytes_in_flight = global_bytes_in_flight;
+  stats.blocked_reads = global_blocked_reads;
+  stats.seeks = global_seeks;
+  return stats;
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,115 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LIB_IO_READAHEAD_FILE_H_
+#define TENSORFLOW_LIB_IO_READAHEAD_FILE_H_
+
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// A RandomAccessFile that reads another file sequentially ahead of its
+// consumer on a background thread.  Up to "num_buffers" chunks of
+// "buffer_bytes" bytes each are kept in memory; with num_buffers == 2 the
+// file is double buffered.  A Read() that continues where the previous one
+// left off is served from those buffers and only blocks if the background
+// thread has fallen behind.  Any other Read() discards the buffers and
+// restarts readahead at its offset.
+//
+// Like every RandomAccessFile, a ReadaheadFile is safe for concurrent use,
+// but readahead only helps a single sequential consumer.
+class ReadaheadFile : public RandomAccessFile {
+ public:
+  // Takes ownership of "file".
+  // REQUIRES: num_buffers > 0, buffer_bytes > 0
+  ReadaheadFile(Env* env, RandomAccessFile* file, int num_buffers,
+                size_t buffer_bytes);
+
+  // Stops the background thread, waiting for an outstanding read.
+  ~ReadaheadFile() override;
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override;
+
+  struct Stats {
+    // Number of chunks read ahead and waiting to be consumed.
+    int64 buffers_ready = 0;
+    // Bytes held in ready chunks plus bytes being read right now.
+    int64 bytes_in_flight = 0;
+    // Reads that had to wait for the background thread.
+    int64 blocked_reads = 0;
+    // Reads that were not sequential and restarted readahead.
+    int64 seeks = 0;
+  };
+
+  // Returns the statistics of this file.
+  Stats GetStats() const;
+
+  // Returns the statistics summed over all live ReadaheadFiles in this
+  // process (blocked_reads and seeks also count files that have since been
+  // closed).
+  static Stats GetGlobalStats();
+
+ private:
+  struct Chunk {
+    uint64 offset;
+    string data;
+  };
+
+  // Body of the background thread.
+  void ReadaheadLoop();
+
+  const std::unique_ptr<RandomAccessFile> file_;
+  const int num_buffers_;
+  const size_t buffer_bytes_;
+
+  mutable mutex mu_;
+  mutable condition_variable cv_;
+  // Chunks read ahead, in file order and contiguous.
+  mutable std::deque<Chunk> chunks_ GUARDED_BY(mu_);
+  // Offset the background thread reads next, i.e. the end of chunks_.
+  mutable uint64 next_offset_ GUARDED_BY(mu_) = 0;
+  // Incremented whenever the consumer seeks, so that the background
+  // thread can discard a chunk it was reading for the old position.
+  mutable int64 generation_ GUARDED_BY(mu_) = 0;
+  // Total size of chunks_.
+  mutable int64 buffered_bytes_ GUARDED_BY(mu_) = 0;
+  // Bytes currently being read by the background thread.
+  int64 reading_bytes_ GUARDED_BY(mu_) = 0;
+  // Set when the background thread has hit the end of the file or an
+  // error, with the status it got (OUT_OF_RANGE at the end of the file).
+  mutable bool done_ GUARDED_BY(mu_) = false;
+  mutable Status status_ GUARDED_BY(mu_);
+  bool stopping_ GUARDED_BY(mu_) = false;
+  mutable Stats stats_ GUARDED_BY(mu_);
+
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ReadaheadFile);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_IO_READAHEAD_FILE_H_
@@ -0,0 +1,156 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/readahead_file.h"
+
+#include <memory>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/inputbuffer.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+// Serves reads from a string, optionally failing at a given offset.
+class StringFile : public RandomAccessFile {
+ public:
+  explicit StringFile(const string& contents, uint64 error_offset = kuint64max)
+      : contents_(contents), error_offset_(error_offset) {}
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    if (offset + n > error_offset_) {
+      *result = StringPiece();
+      return errors::DataLoss("injected error");
+    }
+    if (offset >= contents_.size()) {
+      *result = StringPiece();
+      return errors::OutOfRange("eof");
+    }
+    const size_t len = std::min<size_t>(n, contents_.size() - offset);
+    memcpy(scratch, contents_.data() + offset, len);
+    *result = StringPiece(scratch, len);
+    if (len < n) return errors::OutOfRange("eof");
+    return Status::OK();
+  }
+
+ private:
+  const string contents_;
+  const uint64 error_offset_;
+};
+
+string Contents(int n) {
+  string s;
+  for (int i = 0; i < n; ++i) s.push_back('a' + i % 26);
+  return s;
+}
+
+TEST(ReadaheadFileTest, SequentialReads) {
+  const string contents = Contents(1000);
+  for (int num_buffers : {1, 2, 4}) {
+    for (size_t buffer_bytes : {1, 7, 64, 5000}) {
+      ReadaheadFile file(Env::Default(), new StringFile(contents), num_buffers,
+                         buffer_bytes);
+      string got;
+      char scratch[33];
+      uint64 offset = 0;
+      while (true) {
+        StringPiece result;
+        Status s = file.Read(offset, sizeof(scratch), &result, scratch);
+        got.append(result.data(), result.size());
+        offset += result.size();
+        if (!s.ok()) {
+          EXPECT_TRUE(errors::IsOutOfRange(s)) << s;
+          break;
+        }
+        EXPECT_EQ(sizeof(scratch), result.size());
+      }
+      EXPECT_EQ(contents, got);
+    }
+  }
+}
+
+TEST(ReadaheadFileTest, WorksUnderInputBuffer) {
+  string contents;
+  for (int i = 0; i < 100; ++i) {
+    contents.append(Contents(i));
+    contents.push_back('\n');
+  }
+  InputBuffer in(new ReadaheadFile(Env::Default(), new StringFile(contents), 2,
+                                   100),
+                 16);
+  for (int i = 0; i < 100; ++i) {
+    string line;
+    TF_ASSERT_OK(in.ReadLine(&line));
+    EXPECT_EQ(Contents(i), line);
+  }
+  string line;
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadLine(&line)));
+}
+
+TEST(ReadaheadFileTest, Seeks) {
+  const string contents = Contents(1000);
+  ReadaheadFile file(Env::Default(), new StringFile(contents), 2, 64);
+  char scratch[10];
+  StringPiece result;
+  TF_ASSERT_OK(file.Read(500, 10, &result, scratch));
+  EXPECT_EQ(contents.substr(500, 10), result);
+  TF_ASSERT_OK(file.Read(10, 10, &result, scratch));
+  EXPECT_EQ(contents.substr(10, 10), result);
+  TF_ASSERT_OK(file.Read(20, 10, &result, scratch));
+  EXPECT_EQ(contents.substr(20, 10), result);
+  // Readahead starts at offset 0, so only the first two reads seek.
+  EXPECT_EQ(2, file.GetStats().seeks);
+}
+
+TEST(ReadaheadFileTest, Error) {
+  const string contents = Contents(1000);
+  ReadaheadFile file(Env::Default(), new StringFile(contents, 100), 2, 50);
+  char scratch[80];
+  StringPiece result;
+  TF_ASSERT_OK(file.Read(0, 80, &result, scratch));
+  EXPECT_EQ(contents.substr(0, 80), result);
+  Status s = file.Read(80, 80, &result, scratch);
+  EXPECT_TRUE(errors::IsDataLoss(s)) << s;
+  EXPECT_EQ(contents.substr(80, 20), result);
+}
+
+TEST(ReadaheadFileTest, Stats) {
+  const string contents = Contents(1000);
+  {
+    ReadaheadFile file(Env::Default(), new StringFile(contents), 2, 100);
+    char scratch[10];
+    StringPiece result;
+    TF_ASSERT_OK(file.Read(0, 10, &result, scratch));
+    // Wait for the background thread to fill both buffers.
+    while (file.GetStats().buffers_ready < 2) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    ReadaheadFile::Stats stats = file.GetStats();
+    EXPECT_EQ(2, stats.buffers_ready);
+    EXPECT_EQ(200, stats.bytes_in_flight);
+    EXPECT_EQ(2, ReadaheadFile::GetGlobalStats().buffers_ready);
+    EXPECT_EQ(200, ReadaheadFile::GetGlobalStats().bytes_in_flight);
+  }
+  EXPECT_EQ(0, ReadaheadFile::GetGlobalStats().buffers_ready);
+  EXPECT_EQ(0, ReadaheadFile::GetGlobalStats().bytes_in_flight);
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace tensorflow
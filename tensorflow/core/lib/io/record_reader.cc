@@ -90,5 +90,67 @@ Status RecordReader::ReadRecord(uint64* offset, string* record) {
   return Status::OK();
 }
 
+MappedRecordReader::MappedRecordReader(ReadOnlyMemoryRegion* region,
+                                       ChecksumMode mode)
+    : region_(region),
+      data_(static_cast<const char*>(region->data())),
+      size_(region->length()),
+      mode_(mode) {}
+
+MappedRecordReader::~MappedRecordReader() {}
+
+Status MappedRecordReader::ParseRecord(uint64 offset, bool verify_checksums,
+                                       StringPiece* record,
+                                       uint64* next_offset) const {
+  static const uint64 kHeaderSize = sizeof(uint64) + sizeof(uint32);
+  static const uint64 kFooterSize = sizeof(uint32);
+
+  if (offset >= size_) {
+    return errors::OutOfRange("eof");
+  }
+  if (size_ - offset < kHeaderSize) {
+    return errors::DataLoss("truncated record at ", offset);
+  }
+  const char* header = data_ + offset;
+  if (verify_checksums) {
+    const uint32 masked_crc = core::DecodeFixed32(header + sizeof(uint64));
+    if (crc32c::Unmask(masked_crc) != crc32c::Value(header, sizeof(uint64))) {
+      return errors::DataLoss("corrupted record at ", offset);
+    }
+  }
+  const uint64 length = core::DecodeFixed64(header);
+  const uint64 remaining = size_ - offset - kHeaderSize;
+  if (remaining < kFooterSize || length > remaining - kFooterSize) {
+    return errors::DataLoss("truncated record at ", offset);
+  }
+  const char* data = header + kHeaderSize;
+  if (verify_checksums) {
+    const uint32 masked_crc = core::DecodeFixed32(data + length);
+    if (crc32c::Unmask(masked_crc) != crc32c::Value(data, length)) {
+      return errors::DataLoss("corrupted record at ", offset);
+    }
+  }
+  *record = StringPiece(data, length);
+  *next_offset = offset + kHeaderSize + length + kFooterSize;
+  return Status::OK();
+}
+
+Status MappedRecordReader::VerifyAll() const {
+  uint64 offset = 0;
+  StringPiece record;
+  while (offset < size_) {
+    TF_RETURN_IF_ERROR(ParseRecord(offset, true, &record, &offset));
+  }
+  return Status::OK();
+}
+
+Status MappedRecordReader::ReadRecord(uint64* offset, StringPiece* record) {
+  if (mode_ == kVerifyBulk && !verified_) {
+    TF_RETURN_IF_ERROR(VerifyAll());
+    verified_ = true;
+  }
+  return ParseRecord(*offset, mode_ == kVerifyPerRecord, record, offset);
+}
+
 }  // namespace io
 }  // namespace tensorflow
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_LIB_IO_RECORD_READER_H_
 #define TENSORFLOW_LIB_IO_RECORD_READER_H_
 
+#include <memory>
+
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/platform/macros.h"
@@ -24,6 +26,7 @@ limitations under the License.
 namespace tensorflow {
 
 class RandomAccessFile;
+class ReadOnlyMemoryRegion;
 
 namespace io {
 
@@ -46,6 +49,53 @@ class RecordReader {
   TF_DISALLOW_COPY_AND_ASSIGN(RecordReader);
 };
 
+// Reads records straight out of a read-only memory mapping of a record
+// file (see Env::NewReadOnlyMemoryRegionFromFile).  Records are returned
+// as StringPieces pointing into the mapping, so reading a record costs
+// neither a system call nor a copy.
+class MappedRecordReader {
+ public:
+  enum ChecksumMode {
+    // Verify the length and data checksums of each record as it is read.
+    kVerifyPerRecord,
+    // Verify the checksums of every record in the file in one sequential
+    // pass before the first record is returned.  Reads after that do no
+    // checksum work.  A corrupted file yields no records at all.
+    kVerifyBulk,
+    // Never verify checksums.  Record lengths are still checked against
+    // the size of the mapping.
+    kSkipChecksums,
+  };
+
+  // Takes ownership of "region".
+  MappedRecordReader(ReadOnlyMemoryRegion* region, ChecksumMode mode);
+
+  ~MappedRecordReader();
+
+  // Read the record at "*offset" into *record and update *offset to
+  // point to the offset of the next record.  *record remains valid for
+  // the lifetime of this reader.  Returns OK on success, OUT_OF_RANGE
+  // for end of file, or something else for an error.
+  Status ReadRecord(uint64* offset, StringPiece* record);
+
+ private:
+  // Parses the record at "offset", verifying checksums iff
+  // "verify_checksums", and sets *record and *next_offset.
+  Status ParseRecord(uint64 offset, bool verify_checksums, StringPiece* record,
+                     uint64* next_offset) const;
+
+  // Verifies every record in the mapping.
+  Status VerifyAll() const;
+
+  std::unique_ptr<ReadOnlyMemoryRegion> region_;
+  const char* const data_;
+  const uint64 size_;
+  const ChecksumMode mode_;
+  bool verified_ = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MappedRecordReader);
+};
+
 }  // namespace io
 }  // namespace tensorflow
 
@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <vector>
+
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -256,5 +258,146 @@ TEST_F(RecordioTest, ReadEnd) { CheckOffsetPastEndReturnsNoRecords(0); }
 
 TEST_F(RecordioTest, ReadPastEnd) { CheckOffsetPastEndReturnsNoRecords(5); }
 
+// A ReadOnlyMemoryRegion over a string owned by the caller.
+class StringRegion : public ReadOnlyMemoryRegion {
+ public:
+  explicit StringRegion(const string& s) : s_(s) {}
+  const void* data() override { return s_.data(); }
+  uint64 length() override { return s_.size(); }
+
+ private:
+  const string& s_;
+};
+
+static string WriteRecords(const std::vector<string>& records) {
+  class StringDest : public WritableFile {
+   public:
+    string contents_;
+
+    Status Close() override { return Status::OK(); }
+    Status Flush() override { return Status::OK(); }
+    Status Sync() override { return Status::OK(); }
+    Status Append(const StringPiece& slice) override {
+      contents_.append(slice.data(), slice.size());
+      return Status::OK();
+    }
+  };
+  StringDest dest;
+  RecordWriter writer(&dest);
+  for (const string& r : records) {
+    TF_CHECK_OK(writer.WriteRecord(r));
+  }
+  return dest.contents_;
+}
+
+// Reads every record from "contents", returning them followed by "EOF" or
+// the error that stopped reading.
+static std::vector<string> ReadMapped(const string& contents,
+                                      MappedRecordReader::ChecksumMode mode) {
+  MappedRecordReader reader(new StringRegion(contents), mode);
+  std::vector<string> result;
+  uint64 offset = 0;
+  while (true) {
+    StringPiece record;
+    Status s = reader.ReadRecord(&offset, &record);
+    if (errors::IsOutOfRange(s)) {
+      result.push_back("EOF");
+      break;
+    } else if (!s.ok()) {
+      result.push_back(s.ToString());
+      break;
+    }
+    result.push_back(record.ToString());
+  }
+  return result;
+}
+
+static const MappedRecordReader::ChecksumMode kAllModes[] = {
+    MappedRecordReader::kVerifyPerRecord, MappedRecordReader::kVerifyBulk,
+    MappedRecordReader::kSkipChecksums};
+
+TEST(MappedRecordReaderTest, ReadWrite) {
+  const string contents =
+      WriteRecords({"foo", "bar", "", BigString("x", 10000)});
+  for (auto mode : kAllModes) {
+    EXPECT_EQ(std::vector<string>(
+                  {"foo", "bar", "", BigString("x", 10000), "EOF"}),
+              ReadMapped(contents, mode));
+  }
+}
+
+TEST(MappedRecordReaderTest, Empty) {
+  for (auto mode : kAllModes) {
+    EXPECT_EQ(std::vector<string>({"EOF"}), ReadMapped("", mode));
+  }
+}
+
+TEST(MappedRecordReaderTest, RecordPointsIntoMapping) {
+  const string contents = WriteRecords({"foo", "bar"});
+  MappedRecordReader reader(new StringRegion(contents),
+                            MappedRecordReader::kVerifyPerRecord);
+  uint64 offset = 0;
+  StringPiece record;
+  TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+  TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("bar", record);
+  EXPECT_GE(record.data(), contents.data());
+  EXPECT_LT(record.data(), contents.data() + contents.size());
+  EXPECT_EQ(contents.size(), offset);
+}
+
+TEST(MappedRecordReaderTest, CorruptData) {
+  string contents = WriteRecords({"foo", "bar"});
+  // Corrupt the payload of the second record.
+  contents[contents.size() - 5] += 1;
+
+  std::vector<string> per_record =
+      ReadMapped(contents, MappedRecordReader::kVerifyPerRecord);
+  ASSERT_EQ(2, per_record.size());
+  EXPECT_EQ("foo", per_record[0]);
+  AssertHasSubstr(per_record[1], "Data loss");
+
+  // Bulk verification rejects the file before returning anything.
+  std::vector<string> bulk =
+      ReadMapped(contents, MappedRecordReader::kVerifyBulk);
+  ASSERT_EQ(1, bulk.size());
+  AssertHasSubstr(bulk[0], "Data loss");
+
+  EXPECT_EQ(std::vector<string>({"foo", "bas", "EOF"}),
+            ReadMapped(contents, MappedRecordReader::kSkipChecksums));
+}
+
+TEST(MappedRecordReaderTest, Truncated) {
+  string contents = WriteRecords({"foo", "bar"});
+  contents.resize(contents.size() - 1);
+  for (auto mode : kAllModes) {
+    std::vector<string> result = ReadMapped(contents, mode);
+    AssertHasSubstr(result.back(), "Data loss");
+  }
+}
+
+TEST(MappedRecordReaderTest, FromFile) {
+  Env* env = Env::Default();
+  const string fname = testing::TmpDir() + "/mapped_record_reader_test";
+  const string contents = WriteRecords({"foo", "bar"});
+  {
+    WritableFile* file;
+    TF_ASSERT_OK(env->NewWritableFile(fname, &file));
+    TF_ASSERT_OK(file->Append(contents));
+    TF_ASSERT_OK(file->Close());
+    delete file;
+  }
+  ReadOnlyMemoryRegion* region;
+  TF_ASSERT_OK(env->NewReadOnlyMemoryRegionFromFile(fname, &region));
+  MappedRecordReader reader(region, MappedRecordReader::kVerifyBulk);
+  uint64 offset = 0;
+  StringPiece record;
+  TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("foo", record);
+  TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("bar", record);
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+}
+
 }  // namespace io
 }  // namespace tensorflow
@@ -21,6 +21,8 @@ limitations under the License.
 namespace tensorflow {
 namespace table {
 
+class Cache;
+
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
 // being stored in a file.  The following enum describes which
@@ -60,6 +62,15 @@ struct Options {
   // incompressible, the kSnappyCompression implementation will
   // efficiently detect that and will switch to uncompressed mode.
   CompressionType compression = kSnappyCompression;
+
+  // If non-NULL, use the specified cache for uncompressed data blocks.
+  // Tables opened with the same cache share its capacity; keys are
+  // partitioned per table, so one cache may serve any number of tables.
+  // SharedBlockCache() (see cache.h) returns a process-wide instance.
+  // The cache must outlive every table that uses it.
+  //
+  // If NULL, each lookup re-reads and re-decompresses its block.
+  Cache* block_cache = nullptr;
 };
 
 }  // namespace table
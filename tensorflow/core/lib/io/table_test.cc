@@ -16,11 +16,13 @@ limitations under the License.
 #include "tensorflow/core/lib/io/table.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/block.h"
 #include "tensorflow/core/lib/io/block_builder.h"
+#include "tensorflow/core/lib/io/cache.h"
 #include "tensorflow/core/lib/io/format.h"
 #include "tensorflow/core/lib/io/iterator.h"
 #include "tensorflow/core/lib/io/table_builder.h"
@@ -219,6 +221,7 @@ class TableConstructor : public Constructor {
     // Open the table
     source_ = new StringSource(sink.contents());
     Options table_options;
+    table_options.block_cache = options.block_cache;
     return Table::Open(table_options, source_, sink.contents().size(), &table_);
   }
 
@@ -609,5 +612,42 @@ TEST(TableTest, SeekToFirstKeyDoesNotReadTooMuch) {
   EXPECT_LT(c.BytesRead(), 200);
 }
 
+TEST(TableTest, BlockCacheAvoidsRereads) {
+  std::unique_ptr<Cache> cache(NewLRUCache(1 << 20));
+  TableConstructor c;
+  c.Add("k01", string(2000, 'a'));
+  c.Add("k02", string(2000, 'b'));
+  c.Add("k03", string(2000, 'c'));
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.block_size = 1024;
+  options.compression = kNoCompression;
+  options.block_cache = cache.get();
+  c.Finish(options, &keys, &kvmap);
+
+  Iterator* iter = c.NewIterator();
+  iter->Seek("k02");
+  ASSERT_TRUE(iter->Valid());
+  EXPECT_EQ(string(2000, 'b'), iter->value().ToString());
+  delete iter;
+  const uint64 bytes_after_first_read = c.BytesRead();
+  EXPECT_EQ(0, cache->GetStats().hits);
+  EXPECT_EQ(1, cache->GetStats().misses);
+
+  iter = c.NewIterator();
+  iter->Seek("k02");
+  ASSERT_TRUE(iter->Valid());
+  EXPECT_EQ(string(2000, 'b'), iter->value().ToString());
+  delete iter;
+  EXPECT_EQ(bytes_after_first_read, c.BytesRead());
+  EXPECT_EQ(1, cache->GetStats().hits);
+  EXPECT_EQ(1, cache->GetStats().misses);
+
+  // Entries are released once the iterators are gone.
+  cache->Prune();
+  EXPECT_EQ(0, cache->TotalCharge());
+}
+
 }  // namespace table
 }  // namespace tensorflow
@@ -1487,4 +1487,60 @@ axis: The axis to fill (default: -1, a new inner-most axis).
 output: The one-hot tensor.
 )doc");
 
+// --------------------------------------------------------------------------
+REGISTER_OP("Quantize")
+    .Input("input: float")
+    .Input("min_range: float")
+    .Input("max_range: float")
+    .Output("output: T")
+    .Output("output_min: float")
+    .Output("output_max: float")
+    .Attr("T: {qint8, quint8}")
+    .Doc(R"doc(
+Quantizes 'input' of type float to 'output' of type 'T'.
+
+[min_range, max_range] are scalar floats that specify the range for the
+'input' data.  The range is first widened to include 0 and to be at least
+1/100 of its largest bound wide.  The 2^n values of 'T' are then spread
+evenly over it, with min_range rounded to a multiple of the step so that 0
+is represented exactly:
+
+```
+scale = (max_range - min_range) / (2^n - 1)
+output = round(input / scale) - round(min_range / scale) + lowest(T)
+```
+
+Values outside the range are clamped to lowest(T) and highest(T).
+
+min_range: The minimum scalar value possibly produced for the input.
+max_range: The maximum scalar value possibly produced for the input.
+output: The quantized data produced from the float input.
+output_min: The actual minimum scalar value used for the output.
+output_max: The actual maximum scalar value used for the output.
+)doc");
+
+// --------------------------------------------------------------------------
+REGISTER_OP("Dequantize")
+    .Input("input: T")
+    .Input("min_range: float")
+    .Input("max_range: float")
+    .Output("output: float")
+    .Attr("T: {qint8, quint8, qint32}")
+    .Doc(R"doc(
+Dequantizes 'input' into a float Tensor.
+
+[min_range, max_range] are scalar floats that specify the range of the
+values 'input' stands for, as produced by Quantize or by one of the
+quantized ops.  Each value is mapped back to
+
+```
+scale = (max_range - min_range) / (2^n - 1)
+output = (input - lowest(T) + round(min_range / scale)) * scale
+```
+
+min_range: The minimum scalar value possibly produced for the input.
+max_range: The maximum scalar value possibly produced for the input.
+output: The dequantized data.
+)doc");
+
 }  // namespace tensorflow
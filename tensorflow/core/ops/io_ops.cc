@@ -183,6 +183,8 @@ REGISTER_OP("TextLineReader")
     .Attr("skip_header_lines: int = 0")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
+    .Attr("readahead_buffers: int = 0")
+    .Attr("readahead_buffer_bytes: int = 1048576")
     .SetIsStateful()
     .Doc(R"doc(
 A Reader that outputs the lines of a file delimited by '\n'.
@@ -193,6 +195,11 @@ container: If non-empty, this reader is placed in the given container.
         Otherwise, a default container is used.
 shared_name: If non-empty, this reader is named in the given bucket
              with this shared_name. Otherwise, the node name is used instead.
+readahead_buffers: If positive, a background thread reads each file ahead
+                   of the reader into this many buffers (2 gives double
+                   buffering), so that reads are served from memory.
+                   0 disables readahead.
+readahead_buffer_bytes: Size of each readahead buffer in bytes.
 )doc");
 
 REGISTER_OP("FixedLengthRecordReader")
@@ -202,6 +209,8 @@ REGISTER_OP("FixedLengthRecordReader")
     .Attr("footer_bytes: int = 0")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
+    .Attr("readahead_buffers: int = 0")
+    .Attr("readahead_buffer_bytes: int = 1048576")
     .SetIsStateful()
     .Doc(R"doc(
 A Reader that outputs fixed-length records from a file.
@@ -211,12 +220,21 @@ container: If non-empty, this reader is placed in the given container.
         Otherwise, a default container is used.
 shared_name: If non-empty, this reader is named in the given bucket
              with this shared_name. Otherwise, the node name is used instead.
+readahead_buffers: If positive, a background thread reads each file ahead
+                   of the reader into this many buffers (2 gives double
+                   buffering), so that reads are served from memory.
+                   0 disables readahead.
+readahead_buffer_bytes: Size of each readahead buffer in bytes.
 )doc");
 
 REGISTER_OP("TFRecordReader")
     .Output("reader_handle: Ref(string)")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
+    .Attr("use_mmap: bool = false")
+    .Attr("checksum: {'per_record', 'bulk', 'none'} = 'per_record'")
+    .Attr("readahead_buffers: int = 0")
+    .Attr("readahead_buffer_bytes: int = 1048576")
     .SetIsStateful()
     .Doc(R"doc(
 A Reader that outputs the records from a TensorFlow Records file.
@@ -226,6 +244,18 @@ container: If non-empty, this reader is placed in the given container.
         Otherwise, a default container is used.
 shared_name: If non-empty, this reader is named in the given bucket
              with this shared_name. Otherwise, the node name is used instead.
+use_mmap: If true, memory map each file and read records directly from the
+          mapping instead of issuing reads per record.  Files that cannot be
+          mapped are read normally.
+checksum: How to verify record checksums of memory mapped files.
+          'per_record' checks each record as it is read, 'bulk' checks the
+          whole file before producing its first record, and 'none' skips
+          checksums.
+readahead_buffers: If positive, a background thread reads each file ahead
+                   of the reader into this many buffers (2 gives double
+                   buffering), so that reads are served from memory.
+                   0 disables readahead.
+readahead_buffer_bytes: Size of each readahead buffer in bytes.
 )doc");
 
 REGISTER_OP("IdentityReader")
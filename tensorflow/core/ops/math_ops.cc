@@ -96,6 +96,31 @@ Cast x of type SrcT to y of DstT.
 _HostCast requires its input and produces its output in host memory.
 )doc");
 
+REGISTER_OP("_FusedElementwise")
+    .Input("x: T")
+    .Input("args: N * T")
+    .Output("y: T")
+    .Attr("T: {float, double}")
+    .Attr("N: int >= 0")
+    .Attr("ops: list(string)")
+    .Attr("chain_inputs: list(int)")
+    .Doc(R"doc(
+Applies a chain of elementwise ops to x in one pass over memory.
+
+Each of `ops` is one of Neg, Square, Sqrt, Rsqrt, Exp, Log, Tanh, Sigmoid,
+Relu, Relu6, or of the binary Add, Sub, Mul, Div, Maximum, Minimum and
+BiasAdd, which take the next of `args` as their other operand. The ops are
+applied to blocks of x small enough to stay in cache, so that the chain
+makes no intermediate tensors.
+
+Created by the elementwise fusion graph rewrite; not meant to be built
+directly.
+
+ops: The names of the ops, in the order they are applied.
+chain_inputs: For each op, the input that the result of the previous ops is
+  given as, 0 or 1. Only binary ops other than BiasAdd may use 1.
+)doc");
+
 // --------------------------------------------------------------------------
 
 REGISTER_OP("Abs")
@@ -531,7 +556,7 @@ REGISTER_OP("MatMul")
     .Output("product: T")
     .Attr("transpose_a: bool = false")
     .Attr("transpose_b: bool = false")
-    .Attr("T: {float, double, int32, complex64}")
+    .Attr("T: {half, float, double, int32, complex64}")
     .Doc(R"doc(
 Multiply the matrix "a" by the matrix "b".
 
@@ -1325,4 +1350,69 @@ b: Another tensor, of same type and shape as `a`.
 product: Pairwise cross product of the vectors in `a` and `b`.
 )doc");
 
+// --------------------------------------------------------------------------
+
+REGISTER_OP("QuantizedMatMul")
+    .Input("a: T1")
+    .Input("b: T2")
+    .Input("min_a: float")
+    .Input("max_a: float")
+    .Input("min_b: float")
+    .Input("max_b: float")
+    .Output("out: Toutput")
+    .Output("min_out: float")
+    .Output("max_out: float")
+    .Attr("T1: {qint8, quint8}")
+    .Attr("T2: {qint8, quint8}")
+    .Attr("Toutput: {qint32} = DT_QINT32")
+    .Attr("transpose_a: bool = false")
+    .Attr("transpose_b: bool = false")
+    .Doc(R"doc(
+Perform a quantized matrix multiplication of `a` by the matrix `b`.
+
+The inputs must be two-dimensional matrices and the inner dimension of
+`a` (after being transposed if `transpose_a` is non-zero) must match the
+outer dimension of `b` (after being transposed if `transposed_b` is
+non-zero).  The products are accumulated in 32 bits, and the output range
+is the one in which a step of `out` is the product of the steps of `a` and
+`b`.  Both input ranges must include 0.
+
+a: Must be a two-dimensional tensor.
+b: Must be a two-dimensional tensor.
+transpose_a: If true, `a` is transposed before multiplication.
+transpose_b: If true, `b` is transposed before multiplication.
+min_a: The float value that the lowest quantized `a` value represents.
+max_a: The float value that the highest quantized `a` value represents.
+min_b: The float value that the lowest quantized `b` value represents.
+max_b: The float value that the highest quantized `b` value represents.
+min_out: The float value that the lowest quantized output value represents.
+max_out: The float value that the highest quantized output value represents.
+)doc");
+
+REGISTER_OP("QuantizeDownAndShrinkRange")
+    .Input("input: Tinput")
+    .Input("input_min: float")
+    .Input("input_max: float")
+    .Output("output: out_type")
+    .Output("output_min: float")
+    .Output("output_max: float")
+    .Attr("Tinput: {qint32} = DT_QINT32")
+    .Attr("out_type: {qint8, quint8}")
+    .Doc(R"doc(
+Convert the quantized 'input' tensor into a lower-precision 'output', using the
+actual distribution of the values to maximize the usage of the lower bit depth
+and adjusting the output min and max ranges accordingly.
+
+[input_min, input_max] are scalar floats that specify the range for the float
+interpretation of the 'input' data.  The outputs of QuantizedMatMul and
+QuantizedConv2D use only a small part of the 32-bit range, so the output range
+is instead the range of the values actually present, widened to include 0.
+
+input_min: The float value that the minimum quantized input value represents.
+input_max: The float value that the maximum quantized input value represents.
+out_type: The type of the output. Should be a lower bit depth than Tinput.
+output_min: The float value that the minimum quantized output value represents.
+output_max: The float value that the maximum quantized output value represents.
+)doc");
+
 }  // namespace tensorflow
@@ -167,6 +167,36 @@ class Session {
                       const std::vector<string>& output_names,
                       std::vector<Tensor>* outputs);
 
+  /// \brief Handle to a feed/fetch/target signature set up by
+  /// `MakeCallable()`.
+  typedef int64 CallableHandle;
+
+  /// \brief Prepares the graph once for repeated runs with the feeds
+  /// `feed_names`, the fetches `fetch_names` and the targets
+  /// `target_nodes`, and returns a `handle` for `RunCallable()`.  This
+  /// avoids the per-step work `Run` does to look the signature up.
+  /// NOTE: This API is still experimental and may change.
+  virtual Status MakeCallable(const std::vector<string>& feed_names,
+                              const std::vector<string>& fetch_names,
+                              const std::vector<string>& target_nodes,
+                              CallableHandle* handle);
+
+  /// \brief Runs the graph set up by `MakeCallable()` as `handle`.
+  /// `feed_tensors` are given in the order of `feed_names`, and
+  /// `fetch_tensors` are returned in the order of `fetch_names`.
+  ///
+  /// May be called concurrently with other calls, for the same handle
+  /// or not.
+  /// NOTE: This API is still experimental and may change.
+  virtual Status RunCallable(CallableHandle handle,
+                             const std::vector<Tensor>& feed_tensors,
+                             std::vector<Tensor>* fetch_tensors);
+
+  /// \brief Releases the resources held for `handle`, which must not
+  /// be used afterwards.
+  /// NOTE: This API is still experimental and may change.
+  virtual Status ReleaseCallable(CallableHandle handle);
+
   /// \brief Closes this session.
   ///
   /// Closing a session releases the resources used by this session
@@ -0,0 +1,392 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/example_proto_fast_parsing.h"
+
+#include <string.h>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace example {
+
+namespace {
+
+// Protobuf wire types.
+enum WireType {
+  kVarint = 0,
+  kFixed64 = 1,
+  kLengthDelimited = 2,
+  kFixed32 = 5,
+};
+
+// Longest encoding of a 64-bit varint.
+const int kMaxVarint64Bytes = 10;
+
+// Reads a field tag from [*p, end).  Returns false at the end of the input
+// or if the tag is malformed.
+bool ReadTag(const char** p, const char* end, uint32* field, uint32* wire) {
+  uint64 tag;
+  const char* q = core::GetVarint64Ptr(*p, end, &tag);
+  if (q == nullptr) return false;
+  *p = q;
+  *field = static_cast<uint32>(tag >> 3);
+  *wire = static_cast<uint32>(tag & 7);
+  return *field != 0;
+}
+
+// Reads the contents of a length-delimited field into *value.
+bool ReadLengthDelimited(const char** p, const char* end, StringPiece* value) {
+  uint64 len;
+  const char* q = core::GetVarint64Ptr(*p, end, &len);
+  if (q == nullptr || len > static_cast<uint64>(end - q)) return false;
+  *value = StringPiece(q, len);
+  *p = q + len;
+  return true;
+}
+
+// Skips over the value of a field of the given wire type.  Groups are
+// deprecated and never written for Examples, so they are treated as errors.
+bool SkipField(const char** p, const char* end, uint32 wire) {
+  switch (wire) {
+    case kVarint: {
+      uint64 unused;
+      *p = core::GetVarint64Ptr(*p, end, &unused);
+      return *p != nullptr;
+    }
+    case kFixed64:
+      if (end - *p < 8) return false;
+      *p += 8;
+      return true;
+    case kLengthDelimited: {
+      StringPiece unused;
+      return ReadLengthDelimited(p, end, &unused);
+    }
+    case kFixed32:
+      if (end - *p < 4) return false;
+      *p += 4;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Parses a Feature message, merging its list into *feature.  Setting a
+// different member of the oneof discards whatever was there before, while
+// the same member appearing again is merged, as protobuf would do.
+bool ParseFeature(StringPiece serialized, FeatureView* feature) {
+  const char* p = serialized.data();
+  const char* end = p + serialized.size();
+  while (p < end) {
+    uint32 field, wire;
+    if (!ReadTag(&p, end, &field, &wire)) return false;
+    if (field >= FeatureView::kBytes && field <= FeatureView::kInt64 &&
+        wire == kLengthDelimited) {
+      StringPiece list;
+      if (!ReadLengthDelimited(&p, end, &list)) return false;
+      const FeatureView::Kind kind = static_cast<FeatureView::Kind>(field);
+      if (feature->kind != kind) {
+        feature->kind = kind;
+        feature->lists.clear();
+      }
+      feature->lists.push_back(list);
+    } else if (!SkipField(&p, end, wire)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Parses one entry of the Features.feature map.  A missing key is the empty
+// string and a missing value an empty Feature.
+bool ParseFeatureMapEntry(StringPiece serialized, const FeatureKeyMap& keys,
+                          FeatureView* features) {
+  StringPiece key;
+  gtl::InlinedVector<StringPiece, 1> values;
+  const char* p = serialized.data();
+  const char* end = p + serialized.size();
+  while (p < end) {
+    uint32 field, wire;
+    if (!ReadTag(&p, end, &field, &wire)) return false;
+    if (field == 1 && wire == kLengthDelimited) {
+      if (!ReadLengthDelimited(&p, end, &key)) return false;
+    } else if (field == 2 && wire == kLengthDelimited) {
+      StringPiece value;
+      if (!ReadLengthDelimited(&p, end, &value)) return false;
+      values.push_back(value);
+    } else if (!SkipField(&p, end, wire)) {
+      return false;
+    }
+  }
+  const int slot = keys.Find(key);
+  if (slot < 0) return true;
+  // A later entry with the same key replaces the earlier one.
+  FeatureView* feature = &features[slot];
+  feature->found = true;
+  feature->kind = FeatureView::kNone;
+  feature->lists.clear();
+  for (StringPiece value : values) {
+    if (!ParseFeature(value, feature)) return false;
+  }
+  return true;
+}
+
+// Parses a Features message.
+bool ParseFeatures(StringPiece serialized, const FeatureKeyMap& keys,
+                   FeatureView* features) {
+  const char* p = serialized.data();
+  const char* end = p + serialized.size();
+  while (p < end) {
+    uint32 field, wire;
+    if (!ReadTag(&p, end, &field, &wire)) return false;
+    if (field == 1 && wire == kLengthDelimited) {
+      StringPiece entry;
+      if (!ReadLengthDelimited(&p, end, &entry) ||
+          !ParseFeatureMapEntry(entry, keys, features)) {
+        return false;
+      }
+    } else if (!SkipField(&p, end, wire)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Calls fn(wire, value) for each "value" field (field 1) of the list
+// message "list", where "value" holds the raw bytes of the field: the
+// contents for length-delimited fields and the encoded number otherwise.
+// Other fields are skipped.
+template <typename Fn>
+bool ForEachListValue(StringPiece list, Fn fn) {
+  const char* p = list.data();
+  const char* end = p + list.size();
+  while (p < end) {
+    uint32 field, wire;
+    if (!ReadTag(&p, end, &field, &wire)) return false;
+    if (field != 1) {
+      if (!SkipField(&p, end, wire)) return false;
+      continue;
+    }
+    StringPiece value;
+    if (wire == kLengthDelimited) {
+      if (!ReadLengthDelimited(&p, end, &value)) return false;
+    } else {
+      const char* start = p;
+      if (!SkipField(&p, end, wire)) return false;
+      value = StringPiece(start, p - start);
+    }
+    if (!fn(static_cast<WireType>(wire), value)) return false;
+  }
+  return true;
+}
+
+// Returns the number of varints in "packed", or -1 if it holds anything
+// GetVarint64Ptr would reject, so that decoding cannot fail once counting
+// succeeded.
+int64 CountPackedVarints(StringPiece packed) {
+  int64 n = 0;
+  int run = 0;
+  for (char c : packed) {
+    if (++run > kMaxVarint64Bytes) return -1;
+    if ((c & 0x80) == 0) {
+      ++n;
+      run = 0;
+    }
+  }
+  return run == 0 ? n : -1;
+}
+
+}  // namespace
+
+FeatureKeyMap::FeatureKeyMap(const std::vector<string>& keys) {
+  size_t size = 2;
+  while (size < 2 * keys.size()) size *= 2;
+  mask_ = size - 1;
+  buckets_.assign(size, 0);
+  bucket_hashes_.assign(size, 0);
+  slot_of_.reserve(keys.size());
+  for (const string& key : keys) {
+    const uint64 h = Hash64(key);
+    uint64 b = h & mask_;
+    int slot = -1;
+    while (buckets_[b] != 0) {
+      if (bucket_hashes_[b] == h && slot_keys_[buckets_[b] - 1] == key) {
+        slot = buckets_[b] - 1;
+        break;
+      }
+      b = (b + 1) & mask_;
+    }
+    if (slot < 0) {
+      slot = slot_keys_.size();
+      slot_keys_.push_back(key);
+      buckets_[b] = slot + 1;
+      bucket_hashes_[b] = h;
+    }
+    slot_of_.push_back(slot);
+  }
+}
+
+int FeatureKeyMap::Find(StringPiece key) const {
+  const uint64 h = Hash64(key.data(), key.size());
+  for (uint64 b = h & mask_; buckets_[b] != 0; b = (b + 1) & mask_) {
+    if (bucket_hashes_[b] == h && key == slot_keys_[buckets_[b] - 1]) {
+      return buckets_[b] - 1;
+    }
+  }
+  return -1;
+}
+
+DataType FeatureView::dtype() const {
+  switch (kind) {
+    case kBytes:
+      return DT_STRING;
+    case kFloat:
+      return DT_FLOAT;
+    case kInt64:
+      return DT_INT64;
+    default:
+      return DT_INVALID;
+  }
+}
+
+bool FeatureView::CountValues(int64* num_values) const {
+  int64 n = 0;
+  for (StringPiece list : lists) {
+    bool ok = ForEachListValue(list, [this, &n](WireType wire,
+                                                StringPiece value) {
+      switch (kind) {
+        case kBytes:
+          if (wire != kLengthDelimited) return false;
+          ++n;
+          return true;
+        case kFloat:
+          if (wire == kFixed32) {
+            ++n;
+          } else if (wire == kLengthDelimited && value.size() % 4 == 0) {
+            n += value.size() / 4;
+          } else {
+            return false;
+          }
+          return true;
+        case kInt64:
+          if (wire == kVarint) {
+            ++n;
+          } else if (wire == kLengthDelimited) {
+            const int64 packed = CountPackedVarints(value);
+            if (packed < 0) return false;
+            n += packed;
+          } else {
+            return false;
+          }
+          return true;
+        default:
+          return false;
+      }
+    });
+    if (!ok) return false;
+  }
+  *num_values = n;
+  return true;
+}
+
+bool FeatureView::DecodeFloats(float* out) const {
+  DCHECK_EQ(kind, kFloat);
+  for (StringPiece list : lists) {
+    bool ok = ForEachListValue(list, [&out](WireType wire, StringPiece value) {
+      if (wire != kFixed32 && wire != kLengthDelimited) return false;
+      if (value.size() % 4 != 0) return false;
+      const int64 n = value.size() / 4;
+      if (port::kLittleEndian) {
+        memcpy(out, value.data(), value.size());
+      } else {
+        for (int64 i = 0; i < n; ++i) {
+          const uint32 bits = core::DecodeFixed32(value.data() + 4 * i);
+          memcpy(out + i, &bits, sizeof(bits));
+        }
+      }
+      out += n;
+      return true;
+    });
+    if (!ok) return false;
+  }
+  return true;
+}
+
+bool FeatureView::DecodeInt64s(int64* out) const {
+  DCHECK_EQ(kind, kInt64);
+  for (StringPiece list : lists) {
+    bool ok = ForEachListValue(list, [&out](WireType wire, StringPiece value) {
+      if (wire != kVarint && wire != kLengthDelimited) return false;
+      const char* p = value.data();
+      const char* end = p + value.size();
+      while (p < end) {
+        uint64 v;
+        p = core::GetVarint64Ptr(p, end, &v);
+        if (p == nullptr) return false;
+        *out++ = static_cast<int64>(v);
+      }
+      return true;
+    });
+    if (!ok) return false;
+  }
+  return true;
+}
+
+bool FeatureView::DecodeBytes(string* out) const {
+  DCHECK_EQ(kind, kBytes);
+  for (StringPiece list : lists) {
+    bool ok = ForEachListValue(list, [&out](WireType wire, StringPiece value) {
+      if (wire != kLengthDelimited) return false;
+      (out++)->assign(value.data(), value.size());
+      return true;
+    });
+    if (!ok) return false;
+  }
+  return true;
+}
+
+bool ParseExampleFeatures(StringPiece serialized, const FeatureKeyMap& keys,
+                          FeatureView* features) {
+  for (int i = 0; i < keys.num_slots(); ++i) {
+    features[i].found = false;
+    features[i].kind = FeatureView::kNone;
+    features[i].lists.clear();
+  }
+  const char* p = serialized.data();
+  const char* end = p + serialized.size();
+  while (p < end) {
+    uint32 field, wire;
+    if (!ReadTag(&p, end, &field, &wire)) return false;
+    if (field == 1 && wire == kLengthDelimited) {
+      // Repeated occurrences of Example.features are merged, which for
+      // the map means entries accumulate.
+      StringPiece value;
+      if (!ReadLengthDelimited(&p, end, &value) ||
+          !ParseFeatures(value, keys, features)) {
+        return false;
+      }
+    } else if (!SkipField(&p, end, wire)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace example
+}  // namespace tensorflow
@@ -0,0 +1,102 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Parsing of serialized tensorflow.Example protos straight from the wire
+// format, without building Example messages.  Only the features whose
+// keys were asked for are looked at, and their values are decoded
+// directly into caller-provided buffers.
+//
+// Results match protobuf parsing of the Example: later map entries for a
+// key replace earlier ones, list messages that appear more than once are
+// merged, both packed and unpacked numeric encodings are accepted, and
+// unknown fields are skipped.  The values of features that were not asked
+// for are not looked at, so a malformed one goes unnoticed.  The parser
+// rejects some encodings protobuf would skip (groups, list values with an
+// unexpected wire type) as malformed, so callers should fall back to
+// protobuf parsing when it reports failure.
+
+#ifndef TENSORFLOW_UTIL_EXAMPLE_PROTO_FAST_PARSING_H_
+#define TENSORFLOW_UTIL_EXAMPLE_PROTO_FAST_PARSING_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace example {
+
+// Maps feature keys to small integer slots.  Duplicate keys share a slot.
+class FeatureKeyMap {
+ public:
+  explicit FeatureKeyMap(const std::vector<string>& keys);
+
+  // Returns the slot of "key", or -1 if it is not one of the keys.
+  int Find(StringPiece key) const;
+
+  // Returns the slot of keys[i] as passed to the constructor.
+  int SlotOf(int i) const { return slot_of_[i]; }
+
+  int num_slots() const { return slot_keys_.size(); }
+
+ private:
+  std::vector<string> slot_keys_;
+  std::vector<int> slot_of_;
+  // Open addressing table of slot + 1; 0 marks an empty bucket.
+  std::vector<int> buckets_;
+  std::vector<uint64> bucket_hashes_;
+  uint64 mask_;
+};
+
+// An undecoded Feature value: which list it holds and the serialized
+// contents of that list message.  A Feature may carry its list in
+// several pieces, which protobuf would merge.
+struct FeatureView {
+  enum Kind { kNone = 0, kBytes = 1, kFloat = 2, kInt64 = 3 };
+
+  // Whether the Example had an entry for the key at all.  An entry may
+  // still hold an empty Feature (kind == kNone).
+  bool found = false;
+  Kind kind = kNone;
+  gtl::InlinedVector<StringPiece, 1> lists;
+
+  // Returns the dtype matching "kind", or DT_INVALID for kNone.
+  DataType dtype() const;
+
+  // Sets *num_values to the number of values in the feature.  Returns
+  // false if the list is malformed.
+  bool CountValues(int64* num_values) const;
+
+  // Decode the values into "out", which must have room for
+  // CountValues() elements of the type matching "kind".  Return false if
+  // the list is malformed, which cannot happen once CountValues()
+  // succeeded.
+  bool DecodeFloats(float* out) const;
+  bool DecodeInt64s(int64* out) const;
+  bool DecodeBytes(string* out) const;
+};
+
+// Scans the serialized Example and fills features[slot] for every feature
+// whose key is in "keys" (features must have keys.num_slots() elements,
+// which are reset first).  Returns false if "serialized" is malformed.
+bool ParseExampleFeatures(StringPiece serialized, const FeatureKeyMap& keys,
+                          FeatureView* features);
+
+}  // namespace example
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_UTIL_EXAMPLE_PROTO_FAST_PARSING_H_
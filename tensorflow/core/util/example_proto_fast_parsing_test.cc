@@ -0,0 +1,378 @@
+/* Copyright 2015 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/example_proto_fast_parsing.h"
+
+#include <vector>
+
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace example {
+namespace {
+
+string Serialize(const Example& ex) {
+  string serialized;
+  ex.SerializeToString(&serialized);
+  return serialized;
+}
+
+// Appends a length-delimited field to "out".
+void AppendField(int field, const string& value, string* out) {
+  core::PutVarint32(out, (field << 3) | 2);
+  core::PutVarint32(out, value.size());
+  out->append(value);
+}
+
+// Returns the serialized Features.feature map entry for key/value.
+string MapEntry(const string& key, const string& feature) {
+  string entry;
+  AppendField(1, key, &entry);
+  AppendField(2, feature, &entry);
+  return entry;
+}
+
+// Returns a serialized Example holding the given map entries.
+string ExampleWithEntries(const std::vector<string>& entries) {
+  string features;
+  for (const string& entry : entries) AppendField(1, entry, &features);
+  string example;
+  AppendField(1, features, &example);
+  return example;
+}
+
+std::vector<float> Floats(const FeatureView& f) {
+  int64 n;
+  EXPECT_TRUE(f.CountValues(&n));
+  std::vector<float> values(n);
+  EXPECT_TRUE(f.DecodeFloats(values.data()));
+  return values;
+}
+
+std::vector<int64> Int64s(const FeatureView& f) {
+  int64 n;
+  EXPECT_TRUE(f.CountValues(&n));
+  std::vector<int64> values(n);
+  EXPECT_TRUE(f.DecodeInt64s(values.data()));
+  return values;
+}
+
+std::vector<string> Bytes(const FeatureView& f) {
+  int64 n;
+  EXPECT_TRUE(f.CountValues(&n));
+  std::vector<string> values(n);
+  EXPECT_TRUE(f.DecodeBytes(values.data()));
+  return values;
+}
+
+TEST(FeatureKeyMapTest, FindsKeys) {
+  FeatureKeyMap keys({"a", "b", "a", "c"});
+  EXPECT_EQ(3, keys.num_slots());
+  EXPECT_EQ(keys.SlotOf(0), keys.SlotOf(2));
+  EXPECT_EQ(keys.SlotOf(0), keys.Find("a"));
+  EXPECT_EQ(keys.SlotOf(1), keys.Find("b"));
+  EXPECT_EQ(keys.SlotOf(3), keys.Find("c"));
+  EXPECT_EQ(-1, keys.Find("d"));
+  EXPECT_EQ(-1, keys.Find(""));
+
+  FeatureKeyMap none({});
+  EXPECT_EQ(0, none.num_slots());
+  EXPECT_EQ(-1, none.Find("a"));
+}
+
+TEST(ExampleProtoFastParsingTest, AllKinds) {
+  Example ex;
+  auto& dict = *ex.mutable_features()->mutable_feature();
+  dict["f"].mutable_float_list()->add_value(1.5);
+  dict["f"].mutable_float_list()->add_value(-2);
+  dict["i"].mutable_int64_list()->add_value(-7);
+  dict["i"].mutable_int64_list()->add_value(1LL << 40);
+  dict["s"].mutable_bytes_list()->add_value("hello");
+  dict["s"].mutable_bytes_list()->add_value("");
+  dict["empty"];
+  dict["unused"].mutable_float_list()->add_value(3);
+
+  // The views point into the serialized example.
+  const string serialized = Serialize(ex);
+  FeatureKeyMap keys({"f", "i", "s", "empty", "missing"});
+  std::vector<FeatureView> features(keys.num_slots());
+  ASSERT_TRUE(ParseExampleFeatures(serialized, keys, features.data()));
+
+  const FeatureView& f = features[keys.Find("f")];
+  EXPECT_TRUE(f.found);
+  EXPECT_EQ(DT_FLOAT, f.dtype());
+  EXPECT_EQ(std::vector<float>({1.5, -2}), Floats(f));
+
+  const FeatureView& i = features[keys.Find("i")];
+  EXPECT_EQ(DT_INT64, i.dtype());
+  EXPECT_EQ(std::vector<int64>({-7, 1LL << 40}), Int64s(i));
+
+  const FeatureView& s = features[keys.Find("s")];
+  EXPECT_EQ(DT_STRING, s.dtype());
+  EXPECT_EQ(std::vector<string>({"hello", ""}), Bytes(s));
+
+  const FeatureView& empty = features[keys.Find("empty")];
+  EXPECT_TRUE(empty.found);
+  EXPECT_EQ(DT_INVALID, empty.dtype());
+
+  EXPECT_FALSE(features[keys.Find("missing")].found);
+}
+
+TEST(ExampleProtoFastParsingTest, ResetsFeatures) {
+  Example ex;
+  (*ex.mutable_features()->mutable_feature())["a"]
+      .mutable_int64_list()
+      ->add_value(1);
+  FeatureKeyMap keys({"a", "b"});
+  std::vector<FeatureView> features(keys.num_slots());
+  ASSERT_TRUE(ParseExampleFeatures(Serialize(ex), keys, features.data()));
+  EXPECT_TRUE(features[keys.Find("a")].found);
+
+  ASSERT_TRUE(ParseExampleFeatures("", keys, features.data()));
+  EXPECT_FALSE(features[keys.Find("a")].found);
+  EXPECT_EQ(FeatureView::kNone, features[keys.Find("a")].kind);
+}
+
+// Encodings protobuf accepts but does not write itself must give the same
+// result as protobuf parsing.
+TEST(ExampleProtoFastParsingTest, MatchesProtobuf) {
+  // Unpacked floats and int64s, split across several list messages.
+  string unpacked_floats;
+  core::PutVarint32(&unpacked_floats, (1 << 3) | 5);
+  unpacked_floats.append("\x00\x00\x80\x3f", 4);  // 1.0f
+  string unpacked_ints;
+  core::PutVarint32(&unpacked_ints, (1 << 3) | 0);
+  core::PutVarint64(&unpacked_ints, 300);
+  string packed_ints;
+  AppendField(1, "\x05\x06", &packed_ints);
+
+  string float_feature;
+  AppendField(2, unpacked_floats, &float_feature);
+  AppendField(2, unpacked_floats, &float_feature);
+  string int_feature;
+  AppendField(3, unpacked_ints, &int_feature);
+  AppendField(3, packed_ints, &int_feature);
+  // A later member of the oneof replaces an earlier one.
+  string switched_feature;
+  AppendField(1, "", &switched_feature);
+  AppendField(2, unpacked_floats, &switched_feature);
+  // A later entry replaces an earlier one with the same key.
+  string replaced_first;
+  AppendField(3, unpacked_ints, &replaced_first);
+  string replaced_second;
+  AppendField(1, "", &replaced_second);
+
+  string unknown_field;
+  core::PutVarint32(&unknown_field, (9 << 3) | 0);
+  core::PutVarint32(&unknown_field, 1);
+  string with_unknown = MapEntry("unknown", float_feature);
+  with_unknown.append(unknown_field);
+
+  const string serialized = ExampleWithEntries(
+      {MapEntry("floats", float_feature), MapEntry("ints", int_feature),
+       MapEntry("switched", switched_feature),
+       MapEntry("replaced", replaced_first), with_unknown,
+       MapEntry("replaced", replaced_second)});
+
+  Example ex;
+  ASSERT_TRUE(ParseProtoUnlimited(&ex, serialized));
+  const auto& dict = ex.features().feature();
+
+  FeatureKeyMap keys({"floats", "ints", "switched", "replaced", "unknown"});
+  std::vector<FeatureView> features(keys.num_slots());
+  ASSERT_TRUE(ParseExampleFeatures(serialized, keys, features.data()));
+
+  const auto& floats = dict.at("floats").float_list().value();
+  EXPECT_EQ(std::vector<float>(floats.begin(), floats.end()),
+            Floats(features[keys.Find("floats")]));
+  const auto& ints = dict.at("ints").int64_list().value();
+  EXPECT_EQ(std::vector<int64>(ints.begin(), ints.end()),
+            Int64s(features[keys.Find("ints")]));
+  EXPECT_EQ(Feature::kFloatList, dict.at("switched").kind_case());
+  EXPECT_EQ(DT_FLOAT, features[keys.Find("switched")].dtype());
+  EXPECT_EQ(1, Floats(features[keys.Find("switched")]).size());
+  EXPECT_EQ(Feature::kBytesList, dict.at("replaced").kind_case());
+  EXPECT_EQ(DT_STRING, features[keys.Find("replaced")].dtype());
+  EXPECT_TRUE(Bytes(features[keys.Find("replaced")]).empty());
+  EXPECT_EQ(2, Floats(features[keys.Find("unknown")]).size());
+}
+
+TEST(ExampleProtoFastParsingTest, RandomExamplesMatchProtobuf) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  for (int iter = 0; iter < 100; ++iter) {
+    Example ex;
+    auto& dict = *ex.mutable_features()->mutable_feature();
+    std::vector<string> key_list;
+    for (int k = 0; k < 20; ++k) {
+      const string key = strings::StrCat("key", rnd.Uniform(30));
+      key_list.push_back(key);
+      Feature& f = dict[key];
+      const int n = rnd.Uniform(5);
+      switch (rnd.Uniform(4)) {
+        case 0:
+          for (int i = 0; i < n; ++i) {
+            f.mutable_float_list()->add_value(rnd.RandFloat());
+          }
+          break;
+        case 1:
+          for (int i = 0; i < n; ++i) {
+            f.mutable_int64_list()->add_value(rnd.Rand64());
+          }
+          break;
+        case 2:
+          for (int i = 0; i < n; ++i) {
+            f.mutable_bytes_list()->add_value(strings::StrCat(rnd.Rand32()));
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    const string serialized = Serialize(ex);
+    FeatureKeyMap keys(key_list);
+    std::vector<FeatureView> features(keys.num_slots());
+    ASSERT_TRUE(ParseExampleFeatures(serialized, keys, features.data()));
+    for (const auto& entry : dict) {
+      const FeatureView& view = features[keys.Find(entry.first)];
+      const Feature& f = entry.second;
+      EXPECT_TRUE(view.found);
+      switch (f.kind_case()) {
+        case Feature::kFloatList:
+          EXPECT_EQ(std::vector<float>(f.float_list().value().begin(),
+                                       f.float_list().value().end()),
+                    Floats(view));
+          break;
+        case Feature::kInt64List:
+          EXPECT_EQ(std::vector<int64>(f.int64_list().value().begin(),
+                                       f.int64_list().value().end()),
+                    Int64s(view));
+          break;
+        case Feature::kBytesList:
+          EXPECT_EQ(std::vector<string>(f.bytes_list().value().begin(),
+                                        f.bytes_list().value().end()),
+                    Bytes(view));
+          break;
+        default:
+          EXPECT_EQ(FeatureView::kNone, view.kind);
+      }
+    }
+  }
+}
+
+TEST(ExampleProtoFastParsingTest, RejectsMalformed) {
+  Example ex;
+  (*ex.mutable_features()->mutable_feature())["a"]
+      .mutable_int64_list()
+      ->add_value(-1);
+  const string serialized = Serialize(ex);
+  FeatureKeyMap keys({"a"});
+  std::vector<FeatureView> features(keys.num_slots());
+  // Every proper prefix cuts some message short.
+  for (size_t len = 1; len < serialized.size(); ++len) {
+    EXPECT_FALSE(ParseExampleFeatures(StringPiece(serialized.data(), len), keys,
+                                      features.data()))
+        << len;
+  }
+  // Groups are not supported.
+  EXPECT_FALSE(ParseExampleFeatures("\x0b\x0c", keys, features.data()));
+
+  // A packed list that ends inside a varint cannot be counted.
+  string ints;
+  AppendField(1, "\x05\x86", &ints);
+  string feature;
+  AppendField(3, ints, &feature);
+  const string bad_ints = ExampleWithEntries({MapEntry("a", feature)});
+  ASSERT_TRUE(ParseExampleFeatures(bad_ints, keys, features.data()));
+  int64 n;
+  EXPECT_FALSE(features[0].CountValues(&n));
+}
+
+// Builds "batch" serialized Examples with "num_features" float features of
+// four values each, and the list of their keys.
+void MakeExamples(int batch, int num_features, std::vector<string>* serialized,
+                  std::vector<string>* keys) {
+  keys->clear();
+  for (int i = 0; i < num_features; ++i) {
+    keys->push_back(strings::StrCat("feature_", i));
+  }
+  serialized->clear();
+  for (int b = 0; b < batch; ++b) {
+    Example ex;
+    auto& dict = *ex.mutable_features()->mutable_feature();
+    for (const string& key : *keys) {
+      for (int v = 0; v < 4; ++v) {
+        dict[key].mutable_float_list()->add_value(b + v);
+      }
+    }
+    serialized->push_back(Serialize(ex));
+  }
+}
+
+// What ParseExample did before the fast path: parse into an Example and
+// look every key up in the feature map.
+static void BM_ParseExampleProto(int iters, int num_features) {
+  testing::StopTiming();
+  std::vector<string> serialized;
+  std::vector<string> keys;
+  MakeExamples(64, num_features, &serialized, &keys);
+  std::vector<float> out(4 * num_features);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    for (const string& s : serialized) {
+      Example ex;
+      CHECK(ParseProtoUnlimited(&ex, s));
+      const auto& dict = ex.features().feature();
+      for (int k = 0; k < num_features; ++k) {
+        const auto& values = dict.at(keys[k]).float_list().value();
+        std::copy_n(values.data(), values.size(), &out[4 * k]);
+      }
+    }
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * serialized.size());
+}
+BENCHMARK(BM_ParseExampleProto)->Arg(10)->Arg(200);
+
+static void BM_ParseExampleFast(int iters, int num_features) {
+  testing::StopTiming();
+  std::vector<string> serialized;
+  std::vector<string> keys;
+  MakeExamples(64, num_features, &serialized, &keys);
+  std::vector<float> out(4 * num_features);
+  FeatureKeyMap key_map(keys);
+  std::vector<FeatureView> features(key_map.num_slots());
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    for (const string& s : serialized) {
+      CHECK(ParseExampleFeatures(s, key_map, features.data()));
+      for (int k = 0; k < num_features; ++k) {
+        CHECK(features[key_map.SlotOf(k)].DecodeFloats(&out[4 * k]));
+      }
+    }
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * serialized.size());
+}
+BENCHMARK(BM_ParseExampleFast)->Arg(10)->Arg(200);
+
+}  // namespace
+}  // namespace example
+}  // namespace tensorflow
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/io/cache.h"
 #include "tensorflow/core/lib/io/iterator.h"
 #include "tensorflow/core/lib/io/match.h"
 #include "tensorflow/core/lib/io/table.h"
@@ -76,6 +77,10 @@ Status OpenTableTensorSliceReader(const string& fname,
     s = env->GetFileSize(fname, &file_size);
     if (s.ok()) {
       table::Options options;
+      // Restore ops look up the same blocks repeatedly (once per slice and
+      // once per restore op sharing the reader), so keep them decompressed
+      // in the process-wide cache.
+      options.block_cache = table::SharedBlockCache();
       table::Table* table;
       s = table::Table::Open(options, f, file_size, &table);
       if (s.ok()) {
@@ -15,11 +15,23 @@ limitations under the License.
 
 #include "tensorflow/core/util/work_sharder.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
 
+namespace {
+
+// If total * cost_per_unit is small, it is not worth shard too
+// much. Let us assume each cost unit is 1ns, kMinCostPerShard=10000
+// is 10us.
+const int64 kMinCostPerShard = 10000;
+
+}  // namespace
+
 void Shard(int num_workers, thread::ThreadPool* workers, int64 total,
            int64 cost_per_unit, std::function<void(int64, int64)> work) {
   CHECK_GE(total, 0);
@@ -34,11 +46,6 @@ void Shard(int num_workers, thread::ThreadPool* workers, int64 total,
   cost_per_unit = std::max(1LL, cost_per_unit);
   // We shard [0, total) into "num_shards" shards.
   //   1 <= num_shards <= num worker threads
-  //
-  // If total * cost_per_unit is small, it is not worth shard too
-  // much. Let us assume each cost unit is 1ns, kMinCostPerShard=10000
-  // is 10us.
-  static const int64 kMinCostPerShard = 10000;
   const int num_shards =
       std::max<int>(1, std::min(static_cast<int64>(num_workers),
                                 total * cost_per_unit / kMinCostPerShard));
@@ -70,4 +77,80 @@ void Shard(int num_workers, thread::ThreadPool* workers, int64 total,
   counter.Wait();
 }
 
+ShardCost::ShardCost(int64 initial_cost_per_unit)
+    : cost_per_unit_(std::max<int64>(1, initial_cost_per_unit)),
+      measured_(false) {}
+
+void ShardCost::Record(int64 units, int64 nanos) {
+  // Work too short for the clock to see tells nothing.
+  if (units <= 0 || nanos <= 0) return;
+  const int64 measured = std::max<int64>(1, nanos / units);
+  if (!measured_.exchange(true, std::memory_order_relaxed)) {
+    // Forget the initial guess entirely.
+    cost_per_unit_.store(measured, std::memory_order_relaxed);
+    return;
+  }
+  // An exponential moving average.  Concurrent calls may overwrite each
+  // other's update, which only slows down the adaptation.
+  const int64 old = cost_per_unit_.load(std::memory_order_relaxed);
+  cost_per_unit_.store(std::max<int64>(1, old - old / 4 + measured / 4),
+                       std::memory_order_relaxed);
+}
+
+void AdaptiveShard(int num_workers, thread::ThreadPool* workers, int64 total,
+                   ShardCost* cost, std::function<void(int64, int64)> work) {
+  CHECK_GE(total, 0);
+  if (total == 0) {
+    return;
+  }
+  Env* const env = Env::Default();
+  const int64 cost_per_unit = cost->cost_per_unit();
+  // As in Shard(), but in double to avoid overflowing total * cost.
+  const int num_shards = std::max<int>(
+      1, std::min<double>(num_workers, static_cast<double>(total) *
+                                           cost_per_unit / kMinCostPerShard));
+  if (num_shards == 1) {
+    const uint64 start_micros = env->NowMicros();
+    work(0, total);
+    cost->Record(total, (env->NowMicros() - start_micros) * 1000);
+    return;
+  }
+
+  // The calling thread and num_shards - 1 workers all take chunks off
+  // [next, total) until it is empty.
+  const int64 min_chunk = std::max<int64>(1, kMinCostPerShard / cost_per_unit);
+  std::atomic<int64> next(0);
+  // The wall time each thread spends taking chunks, summed over the
+  // threads.  Env has no per-thread CPU clock, so this includes the time a
+  // thread is descheduled, which only overestimates the cost per unit.
+  std::atomic<int64> wall_nanos(0);
+  auto run = [&]() {
+    const uint64 start_micros = env->NowMicros();
+    int64 start = next.load(std::memory_order_relaxed);
+    while (start < total) {
+      const int64 chunk =
+          std::max(min_chunk, (total - start) / (2 * num_shards));
+      const int64 limit = std::min(total, start + chunk);
+      if (next.compare_exchange_weak(start, limit,
+                                     std::memory_order_relaxed)) {
+        work(start, limit);
+        start = next.load(std::memory_order_relaxed);
+      }
+    }
+    wall_nanos.fetch_add((env->NowMicros() - start_micros) * 1000,
+                         std::memory_order_relaxed);
+  };
+
+  BlockingCounter counter(num_shards - 1);
+  for (int i = 1; i < num_shards; ++i) {
+    workers->Schedule([&run, &counter]() {
+      run();
+      counter.DecrementCount();
+    });
+  }
+  run();
+  counter.Wait();
+  cost->Record(total, wall_nanos.load(std::memory_order_relaxed));
+}
+
 }  // end namespace tensorflow
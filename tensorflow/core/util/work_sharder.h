@@ -16,9 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_UTIL_WORK_SHARDER_H_
 #define TENSORFLOW_UTIL_WORK_SHARDER_H_
 
+#include <atomic>
 #include <functional>
 
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -43,6 +45,57 @@ namespace tensorflow {
 void Shard(int num_workers, thread::ThreadPool* workers, int64 total,
            int64 cost_per_unit, std::function<void(int64, int64)> work);
 
+// The measured cost of a unit of work of one call site of
+// AdaptiveShard(), typically a static or a member of the OpKernel that
+// calls it.  Updated without locking by concurrent calls.
+class ShardCost {
+ public:
+  // "initial_cost_per_unit" is the guess used until the first
+  // measurement, in the units of Shard()'s cost_per_unit (roughly ns).
+  explicit ShardCost(int64 initial_cost_per_unit);
+
+  // Returns the current estimate of the cost of a unit of work, in ns.
+  int64 cost_per_unit() const {
+    return cost_per_unit_.load(std::memory_order_relaxed);
+  }
+
+  // Folds a measurement of "units" units of work taking "nanos" ns of
+  // wall time, summed over the threads that did them, into the estimate.
+  // Recent measurements weigh the most.
+  void Record(int64 units, int64 nanos);
+
+ private:
+  std::atomic<int64> cost_per_unit_;
+  // Whether cost_per_unit_ still holds the initial guess.
+  std::atomic<bool> measured_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardCost);
+};
+
+// Like Shard(), but for work whose cost per unit is not known well in
+// advance or varies from unit to unit:
+//
+//  - The number of threads used is chosen from the cost per unit
+//    measured by previous calls with the same "cost", rather than from a
+//    guess of the caller, and this call's measurement is recorded in it.
+//
+//  - Instead of one equal block per thread, the calling thread and the
+//    workers repeatedly take the next chunk of the remaining units
+//    (guided self-scheduling): chunks start at 1/(2 * num_shards) of the
+//    remaining units and shrink as the work runs out, but never below
+//    ~10us worth of work.  A thread that gets cheap units, or starts
+//    late, simply takes more chunks, so the shards finish together.
+//
+// "work" may thus be called more than num_workers times, each time with
+// a disjoint [start, limit) range.
+//
+// REQUIRES: num_workers >= 0
+// REQUIRES: workers != nullptr
+// REQUIRES: total >= 0
+// REQUIRES: cost != nullptr
+void AdaptiveShard(int num_workers, thread::ThreadPool* workers, int64 total,
+                   ShardCost* cost, std::function<void(int64, int64)> work);
+
 }  // end namespace tensorflow
 
 #endif  // TENSORFLOW_UTIL_WORK_SHARDER_H_
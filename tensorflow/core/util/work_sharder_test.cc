@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/util/work_sharder.h"
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/logging.h"
@@ -78,6 +80,83 @@ TEST(Shard, OverflowTest) {
   }
 }
 
+void RunAdaptiveSharding(int64 num_workers, int64 total, ShardCost* cost) {
+  thread::ThreadPool threads(Env::Default(), "test", 16);
+  mutex mu;
+  int64 num_done_work = 0;
+  std::vector<bool> work(total, false);
+  AdaptiveShard(num_workers, &threads, total, cost,
+                [&mu, &num_done_work, &work](int64 start, int64 limit) {
+                  CHECK_LT(start, limit);
+                  mutex_lock l(mu);
+                  for (; start < limit; ++start) {
+                    EXPECT_FALSE(work[start]);  // No duplicate
+                    ++num_done_work;
+                    work[start] = true;
+                  }
+                });
+  EXPECT_EQ(num_done_work, total);
+}
+
+TEST(AdaptiveShard, Basic) {
+  for (auto workers : {0, 1, 2, 3, 5, 7, 10, 11, 15, 100, 1000}) {
+    for (auto total : {0, 1, 7, 10, 64, 100, 256, 1000, 9999}) {
+      for (auto cost_per_unit : {0, 1, 11, 102, 1003, 10005, 1000007}) {
+        ShardCost cost(cost_per_unit);
+        RunAdaptiveSharding(workers, total, &cost);
+      }
+    }
+  }
+}
+
+TEST(AdaptiveShard, ShrinkingChunks) {
+  thread::ThreadPool threads(Env::Default(), "test", 3);
+  ShardCost cost(1000);
+  mutex mu;
+  std::vector<std::pair<int64, int64>> chunks;
+  AdaptiveShard(4, &threads, 10000, &cost,
+                [&mu, &chunks](int64 start, int64 limit) {
+                  mutex_lock l(mu);
+                  chunks.emplace_back(start, limit);
+                });
+  std::sort(chunks.begin(), chunks.end());
+  ASSERT_GT(chunks.size(), 4);
+  int64 start = 0;
+  for (const auto& chunk : chunks) {
+    EXPECT_EQ(start, chunk.first);
+    // 1/8 of what remains, but at least 10 units of 1us.
+    EXPECT_EQ(std::min<int64>(10000 - start, std::max<int64>(
+                                                 10, (10000 - start) / 8)),
+              chunk.second - chunk.first);
+    start = chunk.second;
+  }
+  EXPECT_EQ(10000, start);
+}
+
+TEST(ShardCost, Record) {
+  ShardCost cost(1000);
+  EXPECT_EQ(1000, cost.cost_per_unit());
+  // Unmeasurable work is ignored.
+  cost.Record(100, 0);
+  EXPECT_EQ(1000, cost.cost_per_unit());
+  // The first measurement replaces the guess.
+  cost.Record(100, 20000);
+  EXPECT_EQ(200, cost.cost_per_unit());
+  // Later ones are averaged in.
+  cost.Record(100, 60000);
+  EXPECT_EQ(300, cost.cost_per_unit());
+}
+
+TEST(ShardCost, Learns) {
+  thread::ThreadPool threads(Env::Default(), "test", 4);
+  // A wild overestimate: 1s per unit.
+  ShardCost cost(1000000000);
+  for (int i = 0; i < 3; ++i) {
+    AdaptiveShard(4, &threads, 1000, &cost, [](int64 start, int64 limit) {});
+  }
+  EXPECT_LT(cost.cost_per_unit(), 1000000);
+}
+
 void BM_Sharding(int iters, int arg) {
   thread::ThreadPool threads(Env::Default(), "test", 16);
   const int64 total = 1LL << 30;
@@ -89,5 +168,74 @@ void BM_Sharding(int iters, int arg) {
 }
 BENCHMARK(BM_Sharding)->Range(1, 128);
 
+// Work that takes roughly "n" times as long as a unit of the uniform
+// benchmarks below.
+void Spin(int64 n) {
+  static std::atomic<float> sink(0);
+  float x = 0;
+  for (int64 i = 0; i < 64 * n; ++i) x = x * 0.999f + 1.0f;
+  sink.store(x, std::memory_order_relaxed);
+}
+
+// "total" units of about 100ns each, like elementwise kernels over rows,
+// with a caller guess of the cost 100x too high.
+void BM_UniformWork(int iters, int num_threads, bool adaptive) {
+  testing::StopTiming();
+  thread::ThreadPool threads(Env::Default(), "test", num_threads);
+  const int64 total = 1 << 14;
+  ShardCost cost(10000);
+  auto work = [](int64 start, int64 limit) { Spin(limit - start); };
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    if (adaptive) {
+      AdaptiveShard(num_threads, &threads, total, &cost, work);
+    } else {
+      Shard(num_threads, &threads, total, 10000, work);
+    }
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * total);
+}
+
+void BM_ShardUniform(int iters, int num_threads) {
+  BM_UniformWork(iters, num_threads, false);
+}
+BENCHMARK(BM_ShardUniform)->Arg(1)->Arg(4)->Arg(16);
+
+void BM_AdaptiveShardUniform(int iters, int num_threads) {
+  BM_UniformWork(iters, num_threads, true);
+}
+BENCHMARK(BM_AdaptiveShardUniform)->Arg(1)->Arg(4)->Arg(16);
+
+// Units whose cost grows linearly with their index, like the rows of a
+// triangular matrix or examples sorted by number of features.
+void BM_ImbalancedWork(int iters, int num_threads, bool adaptive) {
+  testing::StopTiming();
+  thread::ThreadPool threads(Env::Default(), "test", num_threads);
+  const int64 total = 1 << 10;
+  ShardCost cost(total / 16 * 100);
+  auto work = [](int64 start, int64 limit) {
+    for (int64 i = start; i < limit; ++i) Spin(i / 8);
+  };
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    if (adaptive) {
+      AdaptiveShard(num_threads, &threads, total, &cost, work);
+    } else {
+      Shard(num_threads, &threads, total, total / 16 * 100, work);
+    }
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * total);
+}
+
+void BM_ShardImbalanced(int iters, int num_threads) {
+  BM_ImbalancedWork(iters, num_threads, false);
+}
+BENCHMARK(BM_ShardImbalanced)->Arg(1)->Arg(4)->Arg(16);
+
+void BM_AdaptiveShardImbalanced(int iters, int num_threads) {
+  BM_ImbalancedWork(iters, num_threads, true);
+}
+BENCHMARK(BM_AdaptiveShardImbalanced)->Arg(1)->Arg(4)->Arg(16);
+
 }  // namespace
 }  // namespace tensorflow
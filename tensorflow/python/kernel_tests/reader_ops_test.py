@@ -249,9 +249,11 @@ class TextLineReaderTest(tf.test.TestCase):
           f.write(b"\r\n" if crlf else b"\n")
     return filenames
 
-  def _testOneEpoch(self, files):
+  def _testOneEpoch(self, files, readahead_buffers=0):
     with self.test_session() as sess:
-      reader = tf.TextLineReader(name="test_reader")
+      reader = tf.TextLineReader(name="test_reader",
+                                 readahead_buffers=readahead_buffers,
+                                 readahead_buffer_bytes=3)
       queue = tf.FIFOQueue(99, [tf.string], shapes=())
       key, value = reader.read(queue)
 
@@ -270,6 +272,9 @@ class TextLineReaderTest(tf.test.TestCase):
   def testOneEpochLF(self):
     self._testOneEpoch(self._CreateFiles(crlf=False))
 
+  def testOneEpochReadahead(self):
+    self._testOneEpoch(self._CreateFiles(crlf=False), readahead_buffers=2)
+
   def testOneEpochCRLF(self):
     self._testOneEpoch(self._CreateFiles(crlf=True))
 
@@ -362,10 +367,9 @@ class TFRecordReaderTest(tf.test.TestCase):
         writer.write(self._Record(i, j))
     return filenames
 
-  def testOneEpoch(self):
+  def _ReadOneEpoch(self, reader):
     files = self._CreateFiles()
     with self.test_session() as sess:
-      reader = tf.TFRecordReader(name="test_reader")
       queue = tf.FIFOQueue(99, [tf.string], shapes=())
       key, value = reader.read(queue)
 
@@ -381,6 +385,19 @@ class TFRecordReaderTest(tf.test.TestCase):
                                     "\\(requested 1, current size 0\\)"):
         k, v = sess.run([key, value])
 
+  def testOneEpoch(self):
+    self._ReadOneEpoch(tf.TFRecordReader(name="test_reader"))
+
+  def testOneEpochMmap(self):
+    for checksum in ["per_record", "bulk", "none"]:
+      self._ReadOneEpoch(tf.TFRecordReader(name="test_reader", use_mmap=True,
+                                           checksum=checksum))
+
+  def testOneEpochReadahead(self):
+    self._ReadOneEpoch(tf.TFRecordReader(name="test_reader",
+                                         readahead_buffers=2,
+                                         readahead_buffer_bytes=16))
+
 
 class AsyncReaderTest(tf.test.TestCase):
 
@@ -1630,3 +1630,24 @@ def _PlaceholderWithDefaultShape(op):
   # may be *less* precise than `input_shape`.
   input_shape.assert_is_compatible_with(output_shape)
   return [output_shape]
+
+
+@ops.RegisterShape("Quantize")
+def _QuantizeShape(op):
+  """Shape function for the Quantize op."""
+  unused_min_range = op.inputs[1].get_shape().merge_with(
+      tensor_shape.scalar())
+  unused_max_range = op.inputs[2].get_shape().merge_with(
+      tensor_shape.scalar())
+  return [op.inputs[0].get_shape(), tensor_shape.scalar(),
+          tensor_shape.scalar()]
+
+
+@ops.RegisterShape("Dequantize")
+def _DequantizeShape(op):
+  """Shape function for the Dequantize op."""
+  unused_min_range = op.inputs[1].get_shape().merge_with(
+      tensor_shape.scalar())
+  unused_max_range = op.inputs[2].get_shape().merge_with(
+      tensor_shape.scalar())
+  return [op.inputs[0].get_shape()]
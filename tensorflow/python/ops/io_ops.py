@@ -437,16 +437,23 @@ class TextLineReader(ReaderBase):
   """
   # TODO(josh11b): Support serializing and restoring state.
 
-  def __init__(self, skip_header_lines=None, name=None):
+  def __init__(self, skip_header_lines=None, name=None,
+               readahead_buffers=None, readahead_buffer_bytes=None):
     """Create a TextLineReader.
 
     Args:
       skip_header_lines: An optional int. Defaults to 0.  Number of lines
         to skip from the beginning of every file.
       name: A name for the operation (optional).
+      readahead_buffers: An optional int. Defaults to 0. If positive, each
+        file is read ahead on a background thread into this many buffers.
+      readahead_buffer_bytes: An optional int. Defaults to 1MB. Size of each
+        readahead buffer.
     """
-    rr = gen_io_ops._text_line_reader(skip_header_lines=skip_header_lines,
-                                      name=name)
+    rr = gen_io_ops._text_line_reader(
+        skip_header_lines=skip_header_lines,
+        readahead_buffers=readahead_buffers,
+        readahead_buffer_bytes=readahead_buffer_bytes, name=name)
     super(TextLineReader, self).__init__(rr)
 
 
@@ -461,7 +468,7 @@ class FixedLengthRecordReader(ReaderBase):
   # TODO(josh11b): Support serializing and restoring state.
 
   def __init__(self, record_bytes, header_bytes=None, footer_bytes=None,
-               name=None):
+               name=None, readahead_buffers=None, readahead_buffer_bytes=None):
     """Create a FixedLengthRecordReader.
 
     Args:
@@ -469,10 +476,15 @@ class FixedLengthRecordReader(ReaderBase):
       header_bytes: An optional int. Defaults to 0.
       footer_bytes: An optional int. Defaults to 0.
       name: A name for the operation (optional).
+      readahead_buffers: An optional int. Defaults to 0. If positive, each
+        file is read ahead on a background thread into this many buffers.
+      readahead_buffer_bytes: An optional int. Defaults to 1MB. Size of each
+        readahead buffer.
     """
     rr = gen_io_ops._fixed_length_record_reader(
         record_bytes=record_bytes, header_bytes=header_bytes,
-        footer_bytes=footer_bytes, name=name)
+        footer_bytes=footer_bytes, readahead_buffers=readahead_buffers,
+        readahead_buffer_bytes=readahead_buffer_bytes, name=name)
     super(FixedLengthRecordReader, self).__init__(rr)
 
 
@@ -486,13 +498,26 @@ class TFRecordReader(ReaderBase):
   """
   # TODO(josh11b): Support serializing and restoring state.
 
-  def __init__(self, name=None):
+  def __init__(self, name=None, use_mmap=None, checksum=None,
+               readahead_buffers=None, readahead_buffer_bytes=None):
     """Create a TFRecordReader.
 
     Args:
       name: A name for the operation (optional).
+      use_mmap: An optional bool. Defaults to False. If True, files are
+        memory mapped and records are read directly from the mapping.
+      checksum: An optional string from `"per_record", "bulk", "none"`.
+        Defaults to `"per_record"`. How checksums of memory mapped files are
+        verified.
+      readahead_buffers: An optional int. Defaults to 0. If positive, each
+        file is read ahead on a background thread into this many buffers.
+      readahead_buffer_bytes: An optional int. Defaults to 1MB. Size of each
+        readahead buffer.
     """
-    rr = gen_io_ops._tf_record_reader(name=name)
+    rr = gen_io_ops._tf_record_reader(
+        name=name, use_mmap=use_mmap, checksum=checksum,
+        readahead_buffers=readahead_buffers,
+        readahead_buffer_bytes=readahead_buffer_bytes)
     super(TFRecordReader, self).__init__(rr)
 
 
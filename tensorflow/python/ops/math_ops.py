@@ -1034,6 +1034,26 @@ ops.RegisterShape("MatMul")(common_shapes.matmul_shape)
 ops.RegisterShape("SparseMatMul")(common_shapes.matmul_shape)
 
 
+@ops.RegisterShape("QuantizedMatMul")
+def _QuantizedMatMulShape(op):
+  """Shape function for the QuantizedMatMul op."""
+  for i in range(2, 6):
+    unused_range = op.inputs[i].get_shape().merge_with(tensor_shape.scalar())
+  return common_shapes.matmul_shape(op) + [tensor_shape.scalar(),
+                                           tensor_shape.scalar()]
+
+
+@ops.RegisterShape("QuantizeDownAndShrinkRange")
+def _QuantizeDownAndShrinkRangeShape(op):
+  """Shape function for the QuantizeDownAndShrinkRange op."""
+  unused_input_min = op.inputs[1].get_shape().merge_with(
+      tensor_shape.scalar())
+  unused_input_max = op.inputs[2].get_shape().merge_with(
+      tensor_shape.scalar())
+  return [op.inputs[0].get_shape(), tensor_shape.scalar(),
+          tensor_shape.scalar()]
+
+
 @ops.RegisterStatistics("MatMul", "flops")
 def _calc_mat_mul_flops(graph, node):
   """Calculates the compute resources needed for MatMul."""
@@ -451,6 +451,34 @@ ops.RegisterShape("AvgPool")(common_shapes.avg_pool_shape)
 ops.RegisterShape("MaxPool")(common_shapes.max_pool_shape)
 
 
+def _QuantizedShape(shape_fn, range_inputs):
+  """Returns a shape function for an op producing a quantized tensor.
+
+  Args:
+    shape_fn: The shape function of the float op, returning the shape of
+      the first output.
+    range_inputs: The indices of the scalar range inputs.
+
+  Returns:
+    A shape function adding the two scalar range outputs.
+  """
+  def _Shape(op):
+    for i in range_inputs:
+      unused_range = op.inputs[i].get_shape().merge_with(tensor_shape.scalar())
+    return shape_fn(op) + [tensor_shape.scalar(), tensor_shape.scalar()]
+  return _Shape
+
+
+ops.RegisterShape("QuantizedConv2D")(
+    _QuantizedShape(common_shapes.conv2d_shape, range(2, 6)))
+ops.RegisterShape("QuantizedBiasAdd")(
+    _QuantizedShape(common_shapes.bias_add_shape, range(2, 6)))
+ops.RegisterShape("QuantizedRelu")(
+    _QuantizedShape(common_shapes.unchanged_shape, range(1, 3)))
+ops.RegisterShape("QuantizedMaxPool")(
+    _QuantizedShape(common_shapes.max_pool_shape, range(1, 3)))
+
+
 @ops.RegisterShape("MaxPoolWithArgmax")
 def _MaxPoolWithArgMaxShape(op):
   """Shape function for MaxPoolWithArgmax op."""